@@ -8,6 +8,8 @@ uniform float beats[5];
 // uniform float beats4;
 // uniform float beats5;
 uniform float activity;
+// Homes are fractions of the window, so resizing the window moves every home with it.
+uniform vec2 windowSize;
 
 in vec3   iPosition;
 in vec3   iPPostion;
@@ -25,7 +27,8 @@ out float damping;
 out float groupId;
 out float size;
 
-const float dt2 = ( 1.0 / (60.0 * 60.0) );
+// The fixed step length in seconds, squared; set from the step rate.
+uniform float dt2;
 
 // NOISE
 
@@ -337,7 +340,7 @@ void main()
     
     vec3 vel = (position - pposition) * damping;
     pposition = position;
-    vec3 acc = ( (home - position) * 32.0f );
+    vec3 acc = ( (home * vec3( windowSize, 1.0 ) - position) * 32.0f );
     position += ( vel + acc * dt2 ) + ( vec3( xNoise, yNoise, zNoise ) * activity );
     
     applyBeat();
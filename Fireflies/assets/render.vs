@@ -2,6 +2,11 @@
 
 uniform mat4	ciModelViewProjection;
 uniform float   emitterCap;
+// How far the frame is from the previous simulation step to the latest, in [0, 1).
+uniform float   uAlpha;
+// Clip w of the plane the particles are sized for: a particle there is size pixels across, and
+// smaller the further away it is.
+uniform float   uPointScale;
 
 in vec3   iPosition;
 in vec3   iPPostion;
@@ -29,6 +34,12 @@ void main( void )
     groupId =   iGroupId;
     size =      iSize;
     
-    gl_Position	= ciModelViewProjection * vec4( position, 1.0 );
-    gl_PointSize = size;
+    gl_Position	= ciModelViewProjection * vec4( mix( pposition, position, uAlpha ), 1.0 );
+    gl_PointSize = size * uPointScale / gl_Position.w;
+    
+    // Dead pool slots have no size; park them outside the clip volume so they never rasterize.
+    if( size <= 0.0 )
+    {
+        gl_Position = vec4( 2.0, 2.0, 2.0, 1.0 );
+    }
 }
@@ -0,0 +1,188 @@
+//
+//  AnalysisCache.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_AnalysisCache_h
+#define AudioVertexDisplacement_AnalysisCache_h
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "SpectrumAnalyzer.h"
+
+/**
+ Analysis results keyed by playhead position, quantized to the hop size, for sources that loop.
+ The first pass stores each block's spectrum, volume and beats; later passes copy them back out
+ instead of running the FFT again. Storage is a fixed pool sized by a byte budget in setup(), so
+ find() and store() never allocate. Once the pool is full, later positions simply stay uncached:
+ on a loop, evicting old entries would only make every pass miss.
+ Everything stored is tied to a Signature; a different source, gain or analysis setting clears it.
+ */
+class AnalysisCache
+{
+public:
+    //! What the cached results depend on besides the playhead.
+    struct Signature
+    {
+        Signature() : source( nullptr ), sourceFrames( 0 ), gain( 0.0f ), numBands( 0 ), historyDuration( 0.0f ), beatEngine( BeatEngine::ENERGY ),
+            fluxBandScale( SpectralFluxDetector::BandScale::LOG ) {}
+
+        bool operator==( Signature const & other ) const
+        {
+            return source == other.source && sourceFrames == other.sourceFrames && gain == other.gain
+                && numBands == other.numBands && historyDuration == other.historyDuration && beatEngine == other.beatEngine
+                && fluxBandScale == other.fluxBandScale;
+        }
+        bool operator!=( Signature const & other ) const { return !( *this == other ); }
+
+        const void * source;
+        size_t sourceFrames;
+        float gain;
+        size_t numBands;
+        float historyDuration;
+        BeatEngine beatEngine;
+        SpectralFluxDetector::BandScale fluxBandScale;
+    };
+
+    AnalysisCache();
+
+    //! Allocates room for maxKeys positions and an entry of numBands bands for each, or as many as fit
+    //! in budgetBytes if that is less. More bands later means fewer entries fit; nothing is reallocated.
+    //! stereo entries also hold the left, right and side spectra. Not thread safe.
+    void setup( size_t numBins, bool stereo, size_t numBands, size_t maxKeys, size_t budgetBytes );
+    //! Drops every entry unless signature matches the one they were stored under. Returns true if it did.
+    bool validate( Signature const & signature );
+    void clear();
+
+    //! Copies the entry for key into frame and counts a hit, or counts a miss and returns false.
+    bool find( size_t key, AnalysisFrame & frame );
+    //! Stores frame under key, unless key is out of range or the pool is full.
+    void store( size_t key, AnalysisFrame const & frame );
+
+    //! Safe to read from any thread.
+    std::uint64_t getHits() const { return this->mHits.load( std::memory_order_relaxed ); }
+    std::uint64_t getMisses() const { return this->mMisses.load( std::memory_order_relaxed ); }
+    size_t getNumEntries() const { return this->mNumEntries.load( std::memory_order_relaxed ); }
+    size_t getCapacity() const { return this->mCapacity.load( std::memory_order_relaxed ); }
+
+private:
+    static const std::int32_t EMPTY = -1;
+
+    size_t mNumBins;
+    // Spectra per entry: the mono or mid spectrum, then left, right and side in stereo.
+    size_t mNumSpectra;
+    Signature mSignature;
+    // Key to pool slot, or EMPTY.
+    std::vector<std::int32_t> mSlots;
+    // Entries of mStride floats: volume, numBands beats, numBands band energies, mNumSpectra * numBins magnitudes.
+    std::vector<float> mPool;
+    size_t mStride;
+    std::atomic<size_t> mCapacity;
+    std::atomic<size_t> mNumEntries;
+    std::atomic<std::uint64_t> mHits;
+    std::atomic<std::uint64_t> mMisses;
+};
+
+const std::int32_t AnalysisCache::EMPTY;
+
+AnalysisCache::AnalysisCache() :
+    mNumBins( 0 ),
+    mNumSpectra( 1 ),
+    mStride( 1 ),
+    mCapacity( 0 ),
+    mNumEntries( 0 ),
+    mHits( 0 ),
+    mMisses( 0 )
+{
+}
+
+void AnalysisCache::setup( size_t numBins, bool stereo, size_t numBands, size_t maxKeys, size_t budgetBytes )
+{
+    this->mNumBins = numBins;
+    this->mNumSpectra = stereo ? 4 : 1;
+    this->mSlots.assign( maxKeys, EMPTY );
+    // A short track needn't take the whole budget.
+    const size_t entryFloats = 1 + 2 * numBands + this->mNumSpectra * numBins;
+    this->mPool.assign( std::min( budgetBytes / sizeof( float ), maxKeys * entryFloats ), 0.0f );
+    // Shrinks a pool left over from a longer track.
+    this->mPool.shrink_to_fit();
+    this->mSignature = Signature();
+    this->mStride = 1 + this->mNumSpectra * numBins;
+    this->mCapacity = 0;
+    this->mNumEntries = 0;
+    this->mHits = 0;
+    this->mMisses = 0;
+}
+
+bool AnalysisCache::validate( Signature const & signature )
+{
+    if( signature == this->mSignature ) { return false; }
+
+    this->mSignature = signature;
+    // The band count sets the entry size, so the same pool holds more entries when there are fewer bands.
+    this->mStride = 1 + 2 * signature.numBands + this->mNumSpectra * this->mNumBins;
+    this->mCapacity = std::min( this->mPool.size() / this->mStride, this->mSlots.size() );
+    this->clear();
+    return true;
+}
+
+void AnalysisCache::clear()
+{
+    std::fill( this->mSlots.begin(), this->mSlots.end(), EMPTY );
+    this->mNumEntries = 0;
+}
+
+bool AnalysisCache::find( size_t key, AnalysisFrame & frame )
+{
+    if( key >= this->mSlots.size() || this->mSlots[ key ] == EMPTY )
+    {
+        this->mMisses.fetch_add( 1, std::memory_order_relaxed );
+        return false;
+    }
+
+    const size_t numBands = this->mSignature.numBands;
+    const float * entry = &this->mPool[ this->mSlots[ key ] * this->mStride ];
+    frame.volume = entry[ 0 ];
+    std::copy( entry + 1, entry + 1 + numBands, frame.beats.begin() );
+    std::copy( entry + 1 + numBands, entry + 1 + 2 * numBands, frame.bandEnergies.begin() );
+    const float * spectra = entry + 1 + 2 * numBands;
+    std::copy( spectra, spectra + this->mNumBins, frame.magSpectrum.begin() );
+    if( this->mNumSpectra == 4 )
+    {
+        std::copy( spectra + this->mNumBins, spectra + 2 * this->mNumBins, frame.leftSpectrum.begin() );
+        std::copy( spectra + 2 * this->mNumBins, spectra + 3 * this->mNumBins, frame.rightSpectrum.begin() );
+        std::copy( spectra + 3 * this->mNumBins, spectra + 4 * this->mNumBins, frame.sideSpectrum.begin() );
+    }
+    frame.numBands = numBands;
+    this->mHits.fetch_add( 1, std::memory_order_relaxed );
+    return true;
+}
+
+void AnalysisCache::store( size_t key, AnalysisFrame const & frame )
+{
+    const size_t slot = this->mNumEntries.load( std::memory_order_relaxed );
+    if( key >= this->mSlots.size() || this->mSlots[ key ] != EMPTY || slot >= this->getCapacity() ) { return; }
+    if( frame.numBands != this->mSignature.numBands ) { return; }
+
+    const size_t numBands = this->mSignature.numBands;
+    float * entry = &this->mPool[ slot * this->mStride ];
+    entry[ 0 ] = frame.volume;
+    std::copy( frame.beats.begin(), frame.beats.begin() + numBands, entry + 1 );
+    std::copy( frame.bandEnergies.begin(), frame.bandEnergies.begin() + numBands, entry + 1 + numBands );
+    float * spectra = entry + 1 + 2 * numBands;
+    std::copy( frame.magSpectrum.begin(), frame.magSpectrum.end(), spectra );
+    if( this->mNumSpectra == 4 )
+    {
+        std::copy( frame.leftSpectrum.begin(), frame.leftSpectrum.end(), spectra + this->mNumBins );
+        std::copy( frame.rightSpectrum.begin(), frame.rightSpectrum.end(), spectra + 2 * this->mNumBins );
+        std::copy( frame.sideSpectrum.begin(), frame.sideSpectrum.end(), spectra + 3 * this->mNumBins );
+    }
+    this->mSlots[ key ] = static_cast<std::int32_t>( slot );
+    this->mNumEntries = slot + 1;
+}
+
+#endif
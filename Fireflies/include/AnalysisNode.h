@@ -0,0 +1,313 @@
+//
+//  AnalysisNode.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_AnalysisNode_h
+#define AudioVertexDisplacement_AnalysisNode_h
+
+#include "TripleBuffer.h"
+#include "SpectrumAnalyzer.h"
+#include "AnalysisCache.h"
+#include "TempoTracker.h"
+#include "LatencyProbe.h"
+#include "cinder/audio/Node.h"
+#include "cinder/audio/Context.h"
+#include "cinder/audio/NodeEffects.h"
+#include "cinder/audio/SamplePlayerNode.h"
+
+typedef std::shared_ptr<class AnalysisNode> AnalysisNodeRef;
+
+/**
+ Pass-through node that runs a SpectrumAnalyzer inside process() and hands each frame to the
+ render thread through a TripleBuffer. Replaces polling MonitorSpectralNode, whose
+ accessors contend with the audio graph; here neither thread ever waits on the other.
+ Analysis runs every hopSize input frames rather than once per block, so with a hop shorter than
+ the block every hop is analysed and the beat detectors see all of them; the frame published
+ for the block carries the latest spectrum and the strongest beats of its hops. Either way the
+ history spans the same stretch of audio no matter how fast (or unevenly) the render loop runs.
+ */
+class AnalysisNode : public ci::audio::NodeAutoPullable
+{
+public:
+    struct Format : public ci::audio::Node::Format
+    {
+        Format() : mFftSize( 2048 ), mWindowSize( 1024 ), mHopSize( 0 ), mWindow( AnalysisWindow::BLACKMAN ), mStereo( false ), mNumBands( 4 ), mSmoothingFactor( 0.5f ), mHistoryDuration( 1.0f ), mBeatEngine( BeatEngine::ENERGY ), mFluxBandScale( SpectralFluxDetector::BandScale::LOG ) {}
+
+        Format & fftSize( size_t size ) { mFftSize = size; return *this; }
+        Format & windowSize( size_t size ) { mWindowSize = size; return *this; }
+        //! Frames between analyses; 0 (the default) analyses once per block. Capped at the block size.
+        Format & hopSize( size_t size ) { mHopSize = size; return *this; }
+        Format & window( AnalysisWindow window ) { mWindow = window; return *this; }
+        //! Also publish left, right and side spectra, from one paired transform of the first two channels.
+        Format & stereo( bool stereo ) { mStereo = stereo; return *this; }
+        Format & numBands( size_t count ) { mNumBands = count; return *this; }
+        Format & smoothingFactor( float factor ) { mSmoothingFactor = factor; return *this; }
+        //! Seconds of audio each band's average energy is taken over.
+        Format & historyDuration( float seconds ) { mHistoryDuration = seconds; return *this; }
+        Format & beatEngine( BeatEngine engine ) { mBeatEngine = engine; return *this; }
+        //! Log- or Bark-spaced bands for the spectral flux engine.
+        Format & fluxBandScale( SpectralFluxDetector::BandScale scale ) { mFluxBandScale = scale; return *this; }
+
+        size_t getFftSize() const { return mFftSize; }
+        size_t getWindowSize() const { return mWindowSize; }
+        size_t getHopSize() const { return mHopSize; }
+        AnalysisWindow getWindow() const { return mWindow; }
+        bool isStereo() const { return mStereo; }
+        size_t getNumBands() const { return mNumBands; }
+        float getSmoothingFactor() const { return mSmoothingFactor; }
+        float getHistoryDuration() const { return mHistoryDuration; }
+        BeatEngine getBeatEngine() const { return mBeatEngine; }
+        SpectralFluxDetector::BandScale getFluxBandScale() const { return mFluxBandScale; }
+
+    protected:
+        size_t mFftSize;
+        size_t mWindowSize;
+        size_t mHopSize;
+        AnalysisWindow mWindow;
+        bool mStereo;
+        size_t mNumBands;
+        float mSmoothingFactor;
+        float mHistoryDuration;
+        BeatEngine mBeatEngine;
+        SpectralFluxDetector::BandScale mFluxBandScale;
+    };
+
+    //! Longest history setHistoryDuration() accepts; its storage is reserved up front.
+    static const float MAX_HISTORY_DURATION;
+    //! Default memory budget for enableCache(); about four minutes of audio at the default
+    //! settings, or one in stereo.
+    static const size_t DEFAULT_CACHE_BUDGET = 96 * 1024 * 1024;
+
+    AnalysisNode( const Format & format = Format() );
+
+    //! Render thread: the most recently published frame. Never blocks; stable until the next call.
+    AnalysisFrame const & readLatest();
+
+    size_t getFftSize() const { return this->mFftSize; }
+    size_t getWindowSize() const { return this->mWindowSize; }
+    bool isStereo() const { return this->mStereo; }
+    //! Valid once initialized.
+    size_t getHopSize() const { return this->mHopSize; }
+    size_t getNumBins() const { return this->mFftSize / 2; }
+    size_t getNumBands() const { return this->mNumBands.load(); }
+    //! Takes effect from the next audio block; frames already in flight keep the old band count.
+    void setNumBands( size_t numBands ) { this->mNumBands = std::max<size_t>( numBands, 1 ); }
+    float getHistoryDuration() const { return this->mHistoryDuration.load(); }
+    //! Takes effect from the next audio block. Clamped to MAX_HISTORY_DURATION.
+    void setHistoryDuration( float seconds ) { this->mHistoryDuration = ci::math<float>::clamp( seconds, 0.0f, MAX_HISTORY_DURATION ); }
+    BeatEngine getBeatEngine() const { return this->mBeatEngine.load(); }
+    //! Takes effect from the next audio block.
+    void setBeatEngine( BeatEngine engine ) { this->mBeatEngine = engine; }
+    SpectralFluxDetector::BandScale getFluxBandScale() const { return this->mFluxBandScale.load(); }
+    //! Takes effect from the next audio block.
+    void setFluxBandScale( SpectralFluxDetector::BandScale scale ) { this->mFluxBandScale = scale; }
+
+    //! Serves repeat passes over player's looping source from an AnalysisCache keyed by its read position,
+    //! so the FFT goes idle once every position has been seen. gain is the node between the two; changing
+    //! it, the player's buffer or file, or any analysis setting clears the cache.
+    void enableCache( ci::audio::SamplePlayerNodeRef const & player, ci::audio::GainNodeRef const & gain, size_t budgetBytes = DEFAULT_CACHE_BUDGET );
+    void disableCache();
+    //! Hit and miss counters and occupancy; safe to read from any thread.
+    AnalysisCache const & getCache() const { return this->mCache; }
+
+protected:
+    void initialize() override;
+    void process( ci::audio::Buffer * buffer ) override;
+
+private:
+    size_t mFftSize;
+    size_t mWindowSize;
+    size_t mHopSize;
+    AnalysisWindow mWindow;
+    bool mStereo;
+    std::atomic<size_t> mNumBands;
+    float mSmoothingFactor;
+    std::atomic<float> mHistoryDuration;
+    std::atomic<BeatEngine> mBeatEngine;
+    std::atomic<SpectralFluxDetector::BandScale> mFluxBandScale;
+
+    SpectrumAnalyzer mAnalyzer;
+    std::uint64_t mSequence;
+    // One slot per hop that can complete within a block, allocated in initialize().
+    std::vector<AnalysisFrame> mHopFrames;
+
+    TempoTracker mTempo;
+
+    AnalysisCache mCache;
+    ci::audio::SamplePlayerNodeRef mCachePlayer;
+    ci::audio::GainNodeRef mCacheGain;
+    size_t mCacheBudget;
+    // Blocks analysed since the analyzer last started over; results are only cached once it has settled.
+    size_t mCacheWarmBlocks;
+    bool mLastBlockCached;
+
+    void setupCache();
+    //! Whatever the cache player is currently reading from, to notice when it is swapped.
+    const void * getCacheSource() const;
+
+    TripleBuffer<AnalysisFrame> mFrames;
+};
+
+const float AnalysisNode::MAX_HISTORY_DURATION = 10.0f;
+
+AnalysisNode::AnalysisNode( const Format & format ) :
+    NodeAutoPullable( format ),
+    mFftSize( format.getFftSize() ),
+    mWindowSize( format.getWindowSize() ),
+    mHopSize( format.getHopSize() ),
+    mWindow( format.getWindow() ),
+    mStereo( format.isStereo() ),
+    mNumBands( format.getNumBands() ),
+    mSmoothingFactor( format.getSmoothingFactor() ),
+    mHistoryDuration( ci::math<float>::clamp( format.getHistoryDuration(), 0.0f, MAX_HISTORY_DURATION ) ),
+    mBeatEngine( format.getBeatEngine() ),
+    mFluxBandScale( format.getFluxBandScale() ),
+    mSequence( 0 ),
+    mCacheBudget( DEFAULT_CACHE_BUDGET ),
+    mCacheWarmBlocks( 0 ),
+    mLastBlockCached( false )
+{
+}
+
+void AnalysisNode::initialize()
+{
+    // A hop longer than a block would leave some blocks with nothing new to publish.
+    const size_t framesPerBlock = this->getFramesPerBlock();
+    const size_t hopSize = ( this->mHopSize == 0 || this->mHopSize > framesPerBlock ) ? framesPerBlock : this->mHopSize;
+    this->mAnalyzer.setStereo( this->mStereo );
+    this->mAnalyzer.setup( this->mFftSize, this->mWindowSize, this->mWindow, this->mSmoothingFactor, this->getSampleRate(), hopSize, MAX_HISTORY_DURATION );
+    this->mAnalyzer.setNumBands( this->mNumBands );
+    this->mAnalyzer.setHistoryDuration( this->mHistoryDuration );
+    this->mAnalyzer.setBeatEngine( this->mBeatEngine );
+    this->mAnalyzer.setFluxBandScale( this->mFluxBandScale );
+    this->mAnalyzer.reset();
+    this->mFftSize = this->mAnalyzer.getFftSize();
+    this->mWindowSize = this->mAnalyzer.getWindowSize();
+    this->mHopSize = this->mAnalyzer.getHopSize();
+    this->mNumBands = this->mAnalyzer.getNumBands();
+    this->mSequence = 0;
+    // Onsets describe the middle of the window, half a window before the end of the block.
+    this->mTempo.setup( this->mAnalyzer.getNumBins(), this->getSampleRate() / static_cast<float>( this->getFramesPerBlock() ),
+                        0.5f * this->mWindowSize / this->getSampleRate() );
+    if( this->mCachePlayer ) { this->setupCache(); }
+
+    AnalysisFrame frame;
+    this->mAnalyzer.makeFrame( frame );
+    this->mFrames.reset( frame );
+    this->mHopFrames.assign( ( framesPerBlock + hopSize - 1 ) / hopSize, frame );
+}
+
+void AnalysisNode::enableCache( ci::audio::SamplePlayerNodeRef const & player, ci::audio::GainNodeRef const & gain, size_t budgetBytes )
+{
+    std::lock_guard<std::mutex> lock( this->getContext()->getMutex() );
+    this->mCachePlayer = player;
+    this->mCacheGain = gain;
+    this->mCacheBudget = budgetBytes;
+    if( this->isInitialized() ) { this->setupCache(); }
+}
+
+void AnalysisNode::disableCache()
+{
+    std::lock_guard<std::mutex> lock( this->getContext()->getMutex() );
+    this->mCachePlayer.reset();
+    this->mCacheGain.reset();
+    this->mCache.setup( 0, false, 0, 0, 0 );
+}
+
+void AnalysisNode::setupCache()
+{
+    size_t maxKeys = this->mCachePlayer->getNumFrames() / this->getFramesPerBlock() + 1;
+    size_t numBands = std::min( this->mNumBands.load(), this->mAnalyzer.getNumBins() );
+    this->mCache.setup( this->mAnalyzer.getNumBins(), this->mStereo, numBands, maxKeys, this->mCacheBudget );
+    this->mCacheWarmBlocks = 0;
+    this->mLastBlockCached = false;
+}
+
+const void * AnalysisNode::getCacheSource() const
+{
+    if( auto bufferPlayer = dynamic_cast<ci::audio::BufferPlayerNode *>( this->mCachePlayer.get() ) )
+    {
+        return bufferPlayer->getBuffer().get();
+    }
+    if( auto filePlayer = dynamic_cast<ci::audio::FilePlayerNode *>( this->mCachePlayer.get() ) )
+    {
+        return filePlayer->getSourceFile().get();
+    }
+    return this->mCachePlayer.get();
+}
+
+AnalysisFrame const & AnalysisNode::readLatest()
+{
+    this->mFrames.update();
+    return this->mFrames.getReadBuffer();
+}
+
+void AnalysisNode::process( ci::audio::Buffer * buffer )
+{
+    // Settings may have changed on another thread; the analyzer applies them without allocating.
+    this->mAnalyzer.setNumBands( this->mNumBands.load( std::memory_order_relaxed ) );
+    this->mAnalyzer.setHistoryDuration( this->mHistoryDuration.load( std::memory_order_relaxed ) );
+    this->mAnalyzer.setBeatEngine( this->mBeatEngine.load( std::memory_order_relaxed ) );
+    this->mAnalyzer.setFluxBandScale( this->mFluxBandScale.load( std::memory_order_relaxed ) );
+
+    AnalysisFrame & frame = this->mFrames.getWriteBuffer();
+    const bool useCache = this->mCachePlayer && this->mCachePlayer->isEnabled();
+    bool cached = false;
+    size_t key = 0;
+    if( useCache )
+    {
+        AnalysisCache::Signature signature;
+        signature.source = this->getCacheSource();
+        signature.sourceFrames = this->mCachePlayer->getNumFrames();
+        signature.gain = this->mCacheGain ? this->mCacheGain->getValue() : 1.0f;
+        signature.numBands = std::min( this->mAnalyzer.getNumBands(), this->mAnalyzer.getNumBins() );
+        signature.historyDuration = this->mAnalyzer.getHistoryDuration();
+        signature.beatEngine = this->mAnalyzer.getBeatEngine();
+        signature.fluxBandScale = this->mAnalyzer.getFluxBandScale();
+        if( this->mCache.validate( signature ) ) { this->mCacheWarmBlocks = 0; }
+
+        // The player has already rendered this block, so its read position is where the block ends.
+        key = this->mCachePlayer->getReadPosition() / this->getFramesPerBlock();
+        cached = this->mCache.find( key, frame );
+    }
+    else
+    {
+        // Paused (or uncached) audio isn't what the cache's positions hold.
+        this->mCacheWarmBlocks = 0;
+    }
+
+    if( !cached )
+    {
+        // After a run of hits the analyzer hasn't heard the audio in between; start it over.
+        if( this->mLastBlockCached )
+        {
+            this->mAnalyzer.reset();
+            this->mCacheWarmBlocks = 0;
+        }
+        // Hops never exceed a block, so every block completes at least one.
+        size_t numHops = this->mAnalyzer.processHops( *buffer, 0, buffer->getNumFrames(), this->mHopFrames.data(), this->mHopFrames.size() );
+        SpectrumAnalyzer::merge( this->mHopFrames.data(), std::min( numHops, this->mHopFrames.size() ), frame );
+        if( useCache && ++this->mCacheWarmBlocks > this->mAnalyzer.getWarmupBlocks() ) { this->mCache.store( key, frame ); }
+    }
+    this->mLastBlockCached = cached;
+
+    frame.sampleTime = this->getContext()->getNumProcessedFrames();
+    frame.time = frame.sampleTime / static_cast<double>( this->getSampleRate() );
+
+    // Cached or not, the spectrum describes this block's audio, so the tempo keeps tracking through hits.
+    this->mTempo.process( frame.magSpectrum.data() );
+    frame.bpm = this->mTempo.getBpm();
+    frame.tempoConfidence = this->mTempo.getConfidence();
+    frame.nextBeatTime = frame.time + this->mTempo.getTimeToNextBeat();
+    frame.sequence = ++this->mSequence;
+    // Once published the frame belongs to the render thread; keep what the probe needs.
+    const std::uint64_t sampleTime = frame.sampleTime;
+    this->mFrames.publish();
+    LatencyProbe::instance().mark( LatencyProbe::ANALYSIS, sampleTime );
+}
+
+#endif
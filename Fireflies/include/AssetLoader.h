@@ -0,0 +1,259 @@
+//
+//  AssetLoader.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_AssetLoader_h
+#define AudioVertexDisplacement_AssetLoader_h
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ Runs asset file I/O and decoding on worker threads so startup doesn't wait on it. load() queues the
+ work and returns a future; the owner polls isReady() each frame and, once it is, does whatever needs
+ the GL context (texture upload, shader compile) itself, through finalize(). Every asset is timed from
+ the moment it is queued to the end of its finalize step, and a line is printed for it then.
+ */
+class AssetLoader
+{
+public:
+    static AssetLoader & instance();
+
+    //! numThreads workers; 0 uses one per hardware thread, and at least two.
+    explicit AssetLoader( size_t numThreads = 0 );
+    ~AssetLoader();
+
+    //! Queues work() on a worker. The future holds its result, or whatever it threw; name labels it in the report.
+    template<typename T>
+    std::future<T> load( std::string const & name, std::function<T()> const & work );
+
+    //! True once future holds a result or an exception, so get() won't block.
+    template<typename T>
+    static bool isReady( std::future<T> const & future );
+
+    //! Runs work() on the calling thread as name's finalize step, timing it and printing name's line.
+    template<typename F>
+    auto finalize( std::string const & name, F work ) -> decltype( work() );
+
+    //! One line per asset, in ms since the loader started: when it was queued, how long it waited for a
+    //! worker, loaded and finalized, and when it was ready.
+    void report( std::ostream & stream ) const;
+
+private:
+    struct Record
+    {
+        std::string name;
+        double queued;
+        double started;
+        double loaded;
+        double finalizeStarted;
+        double finalized;
+    };
+
+    // Finishes name's record however finalize()'s work leaves.
+    class FinalizeTimer
+    {
+    public:
+        FinalizeTimer( AssetLoader & loader, std::string const & name ) : mLoader( loader ), mName( name ), mStart( loader.now() ) {}
+        ~FinalizeTimer() { this->mLoader.finish( this->mName, this->mStart, this->mLoader.now() ); }
+
+    private:
+        AssetLoader & mLoader;
+        std::string mName;
+        double mStart;
+    };
+
+    // Stamps one of a record's times however the scope leaves.
+    class StampOnExit
+    {
+    public:
+        StampOnExit( AssetLoader & loader, size_t index, double Record::* time ) : mLoader( loader ), mIndex( index ), mTime( time ) {}
+        ~StampOnExit() { this->mLoader.stamp( this->mIndex, this->mTime ); }
+
+    private:
+        AssetLoader & mLoader;
+        size_t mIndex;
+        double Record::* mTime;
+    };
+
+    std::chrono::steady_clock::time_point mEpoch;
+    mutable std::mutex mMutex;
+    std::condition_variable mWake;
+    std::deque<std::function<void()>> mQueue;
+    std::vector<Record> mRecords;
+    std::vector<std::thread> mThreads;
+    bool mStopping;
+
+    //! Seconds since the loader was created.
+    double now() const;
+    void run();
+    //! Sets one of record index's times to now.
+    void stamp( size_t index, double Record::* time );
+    //! Adds a record for name and returns its index.
+    size_t begin( std::string const & name );
+    void finish( std::string const & name, double started, double finished );
+    static void print( std::ostream & stream, Record const & record );
+};
+
+template<typename T>
+std::future<T> AssetLoader::load( std::string const & name, std::function<T()> const & work )
+{
+    std::future<T> future;
+    {
+        std::lock_guard<std::mutex> lock( this->mMutex );
+        const size_t index = this->begin( name );
+        // The load is stamped inside the task, before its result or exception is stored, so the
+        // future can't be seen ready before the record says it loaded.
+        // packaged_task is move-only and std::function needs a copy, hence the shared_ptr.
+        auto task = std::make_shared<std::packaged_task<T()>>( [this, work, index]
+        {
+            StampOnExit loaded( *this, index, &Record::loaded );
+            return work();
+        } );
+        future = task->get_future();
+        this->mQueue.push_back( [this, task, index]
+        {
+            this->stamp( index, &Record::started );
+            ( *task )();
+        } );
+    }
+    this->mWake.notify_one();
+    return future;
+}
+
+template<typename T>
+bool AssetLoader::isReady( std::future<T> const & future )
+{
+    return future.valid() && future.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready;
+}
+
+template<typename F>
+auto AssetLoader::finalize( std::string const & name, F work ) -> decltype( work() )
+{
+    FinalizeTimer timer( *this, name );
+    return work();
+}
+
+AssetLoader & AssetLoader::instance()
+{
+    static AssetLoader loader;
+    return loader;
+}
+
+AssetLoader::AssetLoader( size_t numThreads ) :
+    mEpoch( std::chrono::steady_clock::now() ),
+    mStopping( false )
+{
+    if( numThreads == 0 )
+    {
+        numThreads = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
+    }
+    for( size_t i = 0; i < numThreads; ++i )
+    {
+        this->mThreads.emplace_back( &AssetLoader::run, this );
+    }
+}
+
+AssetLoader::~AssetLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock( this->mMutex );
+        this->mStopping = true;
+    }
+    this->mWake.notify_all();
+    for( auto & thread : this->mThreads )
+    {
+        thread.join();
+    }
+}
+
+double AssetLoader::now() const
+{
+    return std::chrono::duration<double>( std::chrono::steady_clock::now() - this->mEpoch ).count();
+}
+
+void AssetLoader::run()
+{
+    for( ;; )
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock( this->mMutex );
+            this->mWake.wait( lock, [this] { return this->mStopping || !this->mQueue.empty(); } );
+            // Queued loads are abandoned on shutdown; their futures report broken promises.
+            if( this->mStopping ) { return; }
+            job = std::move( this->mQueue.front() );
+            this->mQueue.pop_front();
+        }
+        job();
+    }
+}
+
+size_t AssetLoader::begin( std::string const & name )
+{
+    Record record = { name, this->now(), -1.0, -1.0, -1.0, -1.0 };
+    this->mRecords.push_back( record );
+    return this->mRecords.size() - 1;
+}
+
+void AssetLoader::stamp( size_t index, double Record::* time )
+{
+    std::lock_guard<std::mutex> lock( this->mMutex );
+    this->mRecords[ index ].*time = this->now();
+}
+
+void AssetLoader::finish( std::string const & name, double started, double finished )
+{
+    Record record;
+    {
+        std::lock_guard<std::mutex> lock( this->mMutex );
+        auto found = std::find_if( this->mRecords.rbegin(), this->mRecords.rend(), [&]( Record const & r ) { return r.name == name; } );
+        if( found == this->mRecords.rend() ) { return; }
+        found->finalizeStarted = started;
+        found->finalized = finished;
+        record = *found;
+    }
+    print( std::cout, record );
+}
+
+void AssetLoader::report( std::ostream & stream ) const
+{
+    std::lock_guard<std::mutex> lock( this->mMutex );
+    for( Record const & record : this->mRecords )
+    {
+        print( stream, record );
+    }
+}
+
+void AssetLoader::print( std::ostream & stream, Record const & record )
+{
+    // Stages that haven't happened yet print as "-".
+    auto ms = [&]( double from, double to ) -> std::string
+    {
+        if( from < 0.0 || to < 0.0 ) { return "-"; }
+        std::ostringstream text;
+        text << std::fixed << std::setprecision( 1 ) << 1e3 * ( to - from );
+        return text.str();
+    };
+    stream << "Asset " << record.name << ": queued at " << ms( 0.0, record.queued ) << " ms, waited " << ms( record.queued, record.started )
+        << " ms, loaded in " << ms( record.started, record.loaded ) << " ms, finalized in " << ms( record.finalizeStarted, record.finalized )
+        << " ms, ready at " << ms( 0.0, record.finalized ) << " ms" << std::endl;
+}
+
+#endif
@@ -10,13 +10,18 @@
 #define AudioVertexDisplacement_AudioComponent_h
 
 #include "IComponent.h"
+#include "AnalysisNode.h"
+#include "AssetLoader.h"
+#include "FeatureTimeline.h"
+#include "ImpulseNode.h"
 #include "cinder/audio/Context.h"
 #include "cinder/audio/NodeEffects.h"
 #include "cinder/audio/Source.h"
-#include "cinder/audio/MonitorNode.h"
 #include "cinder/audio/SamplePlayerNode.h"
 #include "cinder/audio/Utilities.h"
 #include "cinder/CinderMath.h"
+#include "cinder/Timer.h"
+#include <sys/resource.h>
 
 using namespace ci;
 using namespace ci::app;
@@ -29,8 +34,39 @@ public:
     virtual ~AudioComponent() {}
     
     float getVolume();
-    std::vector<float> getBeats();
+    std::vector<float> const & getBeats() const;
     std::vector<float> const & getMagSpectrum() const;
+    //! One channel's spectrum; empty unless stereo analysis is on, except MID, which is getMagSpectrum().
+    std::vector<float> const & getSpectrum( StereoChannel channel ) const;
+    //! Audio clock time, in seconds, of the block the current beats and spectrum came from.
+    double getAnalysisTime() const;
+    //! The same, in frames; what LatencyProbe stages identify blocks by.
+    std::uint64_t getAnalysisSampleTime() const;
+    //! Current audio clock time, in seconds; what getNextBeatTime() is measured against.
+    double getAudioTime() const;
+    //! Tracked tempo, 0 until one is found (and always 0 when playing from a timeline).
+    float getBpm() const;
+    float getTempoConfidence() const;
+    //! Audio clock time the next beat is predicted to land at.
+    double getNextBeatTime() const;
+    
+    //! Number of equal-width spectrum bands used for beat detection. Safe to change while running.
+    void setNumBands( int numBands );
+    //! Seconds of audio each band's average energy is taken over. Safe to change while running.
+    void setHistoryDuration( float seconds );
+    //! Call before setup(). Reads features from a pre-baked timeline by playhead position instead of
+    //! analysing live, baking it first if it is missing or stale. Band count and history are fixed at bake time.
+    void setUseTimeline( bool useTimeline ) { this->mUseTimeline = useTimeline; }
+    //! Call before setup(). Streams the track from disk through a FilePlayerNode instead of decoding
+    //! all of it into memory first; starts faster and keeps memory flat for long sets.
+    void setStreaming( bool streaming ) { this->mStreaming = streaming; }
+    //! Call before setup(). Injects a click into the graph every half second and times it through
+    //! analysis, update and draw with the LatencyProbe; L prints the histograms. Analyses live and
+    //! uncached, since neither a timeline nor the cache has heard the clicks.
+    void setMeasureLatency( bool measureLatency ) { this->mMeasureLatency = measureLatency; }
+    //! Call before setup(). Analyses left and right as a pair, for per-channel spectra at about the
+    //! cost of the mono analysis. Live analysis only; timelines hold no spectra.
+    void setStereo( bool stereo ) { this->mStereo = stereo; }
     
     virtual void setup();
     virtual void mouseDown( MouseEvent event ) {}
@@ -41,73 +77,255 @@ public:
     virtual void resize() {}
     
 private:
+    //! What the loader hands back: the opened file and, unless streaming, all of it decoded.
+    struct DecodedTrack
+    {
+        audio::SourceFileRef source;
+        audio::BufferRef buffer;
+        //! The file it was decoded from; empty if the resource isn't a file.
+        fs::path path;
+        //! A baked timeline matching the track and settings; empty unless one is wanted and could be made.
+        fs::path timeline;
+    };
+    
+    //! What the GainNode ahead of the analysis scales the track by; timelines are baked with it too.
+    static const float GAIN;
+    
     GainNodeRef	mGain;
-    BufferPlayerNodeRef mBufferPlayerNode;
-    MonitorSpectralNodeRef mSpectralMonitor;
+    SamplePlayerNodeRef mPlayerNode;
+    AnalysisNodeRef mAnalysis;
     InputDeviceNodeRef mInputDeviceNode;
+    AnalysisFrame const * mFrame;
+    bool mUseTimeline;
+    bool mStreaming;
+    bool mMeasureLatency;
+    bool mStereo;
+    ImpulseNodeRef mImpulse;
+    FeatureTimeline mTimeline;
+    AnalysisFrame mTimelineFrame;
+    // The track being opened and decoded on the AssetLoader; the graph is built once it arrives.
+    std::future<DecodedTrack> mTrack;
+    Timer mStartupTimer;
     
-    int mHistorySize;
+    float mHistoryDuration;
     int mNumGroups;
-    std::map<int, std::vector<float> > mEnergyHistory;
-    std::vector<float> mEnergyAverages;
+    std::vector<float> mBeats;
+    
+    //! Analysis settings for the live node and for baking.
+    AnalysisNode::Format makeFormat() const;
+    //! Loader side of setUseTimeline(): returns path if the timeline there matches track, baking it
+    //! first if not, or an empty path if it couldn't be baked.
+    static fs::path prepareTimeline( DecodedTrack const & track, fs::path const & path, float sampleRate, size_t hopFrames,
+                                     AnalysisNode::Format const & format );
+    //! Builds and starts the graph around the loaded track.
+    void startPlayback( DecodedTrack const & track );
+    //! High-water mark of the process's resident memory, in bytes.
+    static size_t getPeakResidentBytes();
 };
 
+const float AudioComponent::GAIN = 0.5f;
+
 AudioComponent::AudioComponent() :
-    mHistorySize( 43 ),
+    mFrame( nullptr ),
+    mUseTimeline( false ),
+    mStreaming( false ),
+    mMeasureLatency( false ),
+    mStereo( false ),
+    mHistoryDuration( 1.0f ),
     mNumGroups( 4 ),
-    mEnergyAverages( mNumGroups, 0.0f )
+    mBeats( mNumGroups, 0.0f )
 {}
 
 float AudioComponent::getVolume()
 {
-    return this->mSpectralMonitor->getVolume();
+    return this->mFrame ? this->mFrame->volume : 0.0f;
+}
+
+std::vector<float> const & AudioComponent::getBeats() const
+{
+    return this->mBeats;
+}
+
+void AudioComponent::setNumBands( int numBands )
+{
+    this->mNumGroups = std::max( numBands, 1 );
+    this->mBeats.assign( this->mNumGroups, 0.0f );
+    if( this->mAnalysis ) { this->mAnalysis->setNumBands( this->mNumGroups ); }
 }
 
-std::vector<float> AudioComponent::getBeats()
+void AudioComponent::setHistoryDuration( float seconds )
 {
-    std::vector<float> beats( this->mNumGroups, 0.0f );
-    for( int i = 0; i < this->mNumGroups; ++i )
+    this->mHistoryDuration = seconds;
+    if( this->mAnalysis ) { this->mAnalysis->setHistoryDuration( seconds ); }
+}
+
+std::vector<float> const & AudioComponent::getMagSpectrum() const
+{
+    static const std::vector<float> empty;
+    return this->mFrame ? this->mFrame->magSpectrum : empty;
+}
+
+std::vector<float> const & AudioComponent::getSpectrum( StereoChannel channel ) const
+{
+    static const std::vector<float> empty;
+    if( !this->mFrame ) { return empty; }
+    switch( channel )
     {
-        std::vector<float> & energyHistory = this->mEnergyHistory[ i ];
-        float instantEnergy = energyHistory[ this->mHistorySize - 1 ];
-        float averageEnergy = this->mEnergyAverages[ i ];
-        
-        float energyRatio = ci::math<float>::clamp( ( instantEnergy / averageEnergy ) - 1.0f, 0.0f, 0.35f );
-        beats[ i ] = energyRatio;
-        
-        // std::cout << instantEnergy << "/" << averageEnergy << "=" << beats[ i ] << " * ";
+        case StereoChannel::LEFT: return this->mFrame->leftSpectrum;
+        case StereoChannel::RIGHT: return this->mFrame->rightSpectrum;
+        case StereoChannel::SIDE: return this->mFrame->sideSpectrum;
+        default: return this->mFrame->magSpectrum;
     }
-    std::cout << std::endl;
-    return beats;
 }
 
-std::vector<float> const & AudioComponent::getMagSpectrum() const
+double AudioComponent::getAnalysisTime() const
+{
+    return this->mFrame ? this->mFrame->time : 0.0;
+}
+
+std::uint64_t AudioComponent::getAnalysisSampleTime() const
+{
+    return this->mFrame ? this->mFrame->sampleTime : 0;
+}
+
+size_t AudioComponent::getPeakResidentBytes()
+{
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+#if defined( __APPLE__ )
+    return static_cast<size_t>( usage.ru_maxrss );
+#else
+    return static_cast<size_t>( usage.ru_maxrss ) * 1024;
+#endif
+}
+
+double AudioComponent::getAudioTime() const
+{
+    return audio::Context::master()->getNumProcessedSeconds();
+}
+
+float AudioComponent::getBpm() const
+{
+    return this->mFrame ? this->mFrame->bpm : 0.0f;
+}
+
+float AudioComponent::getTempoConfidence() const
+{
+    return this->mFrame ? this->mFrame->tempoConfidence : 0.0f;
+}
+
+double AudioComponent::getNextBeatTime() const
 {
-    return this->mSpectralMonitor->getMagSpectrum();
+    return this->mFrame ? this->mFrame->nextBeatTime : 0.0;
 }
 
 void AudioComponent::setup()
 {
-    for( int i = 0; i < this->mNumGroups; ++i )
+    this->mStartupTimer.start();
+    
+    // The clicks aren't in a timeline.
+    if( this->mMeasureLatency ) { this->mUseTimeline = false; }
+    
+    // Opening and decoding the MP3, and baking its timeline if it needs one, are the slow parts of
+    // startup, so they happen on a worker while the scene starts drawing; update() builds the graph
+    // once they're done.
+    DataSourceRef resource = loadResource( "sample.mp3" );
+    auto ctx = audio::Context::master();
+    const size_t sampleRate = ctx->getSampleRate();
+    const size_t hopFrames = ctx->getFramesPerBlock();
+    const bool streaming = this->mStreaming;
+    const fs::path timelinePath = this->mUseTimeline ? getAppPath() / "sample.features" : fs::path();
+    const AnalysisNode::Format format = this->makeFormat();
+    this->mTrack = AssetLoader::instance().load<DecodedTrack>( "sample.mp3", [resource, sampleRate, hopFrames, streaming, timelinePath, format]
     {
-        this->mEnergyHistory[ i ] = std::vector<float>( this->mHistorySize, 0.0f );
-    }
+        // create a SourceFile and set its output samplerate to match the Context.
+        DecodedTrack track;
+        track.source = audio::load( resource, sampleRate );
+        track.path = resource->getFilePath();
+        // load the entire sound file into a BufferRef, unless it's to be streamed.
+        if( !streaming ) { track.buffer = track.source->loadBuffer(); }
+        if( !timelinePath.empty() ) { track.timeline = prepareTimeline( track, timelinePath, sampleRate, hopFrames, format ); }
+        return track;
+    } );
+}
+
+AnalysisNode::Format AudioComponent::makeFormat() const
+{
+    return AnalysisNode::Format()
+        .fftSize( 2048 )
+        .windowSize( 1024 )
+        .hopSize( 256 )
+        .stereo( this->mStereo )
+        .numBands( this->mNumGroups )
+        .historyDuration( this->mHistoryDuration );
+}
+
+fs::path AudioComponent::prepareTimeline( DecodedTrack const & track, fs::path const & path, float sampleRate, size_t hopFrames,
+                                          AnalysisNode::Format const & format )
+{
+    // Baked timelines live beside the app and are reused until the source or settings change.
+    const size_t sourceFrames = track.buffer ? track.buffer->getNumFrames() : track.source->getNumFrames();
+    FeatureTimeline timeline;
+    if( timeline.open( path ) && timeline.matches( sampleRate, hopFrames, format, GAIN, sourceFrames, track.path ) ) { return path; }
+    timeline.close();
     
+    Timer timer( true );
+    // Baking needs the whole track; when streaming, it is decoded just for this and released after.
+    audio::BufferRef bakeBuffer = track.buffer ? track.buffer : track.source->clone()->loadBuffer();
+    if( !FeatureTimeline::bake( *bakeBuffer, track.path, sampleRate, hopFrames, format, GAIN, path ) ) { return fs::path(); }
+    std::cout << "Baked " << path << " in " << timer.getSeconds() << "s" << std::endl;
+    return path;
+}
+
+void AudioComponent::startPlayback( DecodedTrack const & track )
+{
     // Audio
     auto ctx = audio::Context::master();
+    audio::SourceFileRef sourceFile = track.source;
     
-    // create a SourceFile and set its output samplerate to match the Context.
-    audio::SourceFileRef sourceFile = audio::load( loadResource( "sample.mp3" ), ctx->getSampleRate() );
-    
-    // load the entire sound file into a BufferRef, and construct a BufferPlayerNode with this.
-    audio::BufferRef buffer = sourceFile->loadBuffer();
-    mBufferPlayerNode = ctx->makeNode( new audio::BufferPlayerNode( buffer ) );
-    mSpectralMonitor = ctx->makeNode( new MonitorSpectralNode( MonitorSpectralNode::Format()
-                                                              .fftSize( 2048 )
-                                                              .windowSize( 1024 ) ) );
+    audio::BufferRef buffer = track.buffer;
+    if( this->mStreaming )
+    {
+        // FilePlayerNode decodes on a background thread into a small ring buffer just ahead of playback.
+        mPlayerNode = ctx->makeNode( new audio::FilePlayerNode( sourceFile ) );
+    }
+    else
+    {
+        // construct a BufferPlayerNode with the decoded track.
+        mPlayerNode = ctx->makeNode( new audio::BufferPlayerNode( buffer ) );
+    }
     
     // add a Gain to reduce the volume
-    mGain = ctx->makeNode( new audio::GainNode( 0.5f ) );
+    mGain = ctx->makeNode( new audio::GainNode( GAIN ) );
+    
+    if( this->mMeasureLatency )
+    {
+        mImpulse = ctx->makeNode( new ImpulseNode() );
+        LatencyProbe::instance().setEnabled( true );
+    }
+    
+    if( this->mUseTimeline )
+    {
+        // The loader checked or baked it along with the decode; all that's left is to map it.
+        if( !track.timeline.empty() && this->mTimeline.open( track.timeline ) )
+        {
+            this->mTimelineFrame.beats.assign( this->mTimeline.getNumBands(), 0.0f );
+            this->mTimelineFrame.bandEnergies.assign( this->mTimeline.getNumBands(), 0.0f );
+            this->mTimelineFrame.numBands = this->mTimeline.getNumBands();
+        }
+        else
+        {
+            std::cout << "Couldn't bake or open the feature timeline; analysing live" << std::endl;
+            this->mUseTimeline = false;
+        }
+    }
+    
+    if( !this->mUseTimeline )
+    {
+        mAnalysis = ctx->makeNode( new AnalysisNode( this->makeFormat() ) );
+        // The track loops, so after the first pass its analysis comes from the cache.
+        if( !this->mMeasureLatency ) { mAnalysis->enableCache( mPlayerNode, mGain ); }
+    }
     
     //*
     std::vector<DeviceRef> audioDevices = ci::audio::Device::getOutputDevices();
@@ -127,86 +345,115 @@ void AudioComponent::setup()
     ctx->setOutput( output );
     
     // connect and enable the Context
-    mBufferPlayerNode >> mGain >> output;
-    mGain >> mSpectralMonitor;
+    if( mImpulse ) { mPlayerNode >> mImpulse >> mGain >> output; }
+    else { mPlayerNode >> mGain >> output; }
+    if( mAnalysis ) { mGain >> mAnalysis; }
     ctx->enable();
     
-    mBufferPlayerNode->setLoopEnabled( true );
-    mBufferPlayerNode->start();
-    
-    std::cout << "FFT Size: " << this->mSpectralMonitor->getFftSize() << "\n"
-        << "Frames per block: " << this->mSpectralMonitor->getFramesPerBlock() << "\n"
-        << "Num bins: " << this->mSpectralMonitor->getNumBins() << "\n"
-        << "Num channels: " << this->mSpectralMonitor->getNumChannels() << "\n"
-        << "Num connected inputs: " << this->mSpectralMonitor->getNumConnectedInputs() << "\n"
-        << "Num connected outputs: " << this->mSpectralMonitor->getNumConnectedOutputs() << "\n"
-        << "Sample rate: " << this->mSpectralMonitor->getSampleRate() << "\n"
-        << "Window size: " << this->mSpectralMonitor->getWindowSize() << "\n"
+    mPlayerNode->setLoopEnabled( true );
+    mPlayerNode->start();
+    
+    std::cout << "Playback: " << ( this->mStreaming ? "streaming" : "buffered" )
+        << ", startup " << this->mStartupTimer.getSeconds() << "s"
+        << ", peak resident memory " << getPeakResidentBytes() / ( 1024 * 1024 ) << " MB" << std::endl;
+    
+    if( this->mUseTimeline )
+    {
+        std::cout << "Feature timeline: " << this->mTimeline.getNumRecords() << " records, "
+            << this->mTimeline.getNumBands() << " bands\n" << std::endl;
+        return;
+    }
+    
+    std::cout << "FFT Size: " << this->mAnalysis->getFftSize() << "\n"
+        << "Frames per block: " << this->mAnalysis->getFramesPerBlock() << "\n"
+        << "Num bins: " << this->mAnalysis->getNumBins() << "\n"
+        << "Num channels: " << this->mAnalysis->getNumChannels() << "\n"
+        << "Num connected inputs: " << this->mAnalysis->getNumConnectedInputs() << "\n"
+        << "Num connected outputs: " << this->mAnalysis->getNumConnectedOutputs() << "\n"
+        << "Sample rate: " << this->mAnalysis->getSampleRate() << "\n"
+        << "Window size: " << this->mAnalysis->getWindowSize() << "\n"
+        << "Hop size: " << this->mAnalysis->getHopSize() << "\n"
+        << "Stereo: " << ( this->mAnalysis->isStereo() ? "yes" : "no" ) << "\n"
+        << "DSP kernels: " << kernels::getIsaName() << "\n"
         << std::endl;
 }
 
 void AudioComponent::keyDown( KeyEvent event )
 {
     static size_t lastBufferReadPos = 0;
+    if( !mPlayerNode ) { return; }
     
     if( event.getCode() == KeyEvent::KEY_SPACE )
     {
-        if( mBufferPlayerNode->isEnabled() )
+        if( mPlayerNode->isEnabled() )
         {
-            lastBufferReadPos = mBufferPlayerNode->getReadPosition();
-            mBufferPlayerNode->stop();
+            lastBufferReadPos = mPlayerNode->getReadPosition();
+            mPlayerNode->stop();
         }
         else
         {
-            mBufferPlayerNode->start();
-            // mBufferPlayerNode->seek( lastBufferReadPos );
+            mPlayerNode->start();
+            // mPlayerNode->seek( lastBufferReadPos );
         }
     }
+    else if( event.getCode() == KeyEvent::KEY_b && this->mAnalysis )
+    {
+        bool flux = this->mAnalysis->getBeatEngine() == BeatEngine::SPECTRAL_FLUX;
+        this->mAnalysis->setBeatEngine( flux ? BeatEngine::ENERGY : BeatEngine::SPECTRAL_FLUX );
+        std::cout << "Beat engine: " << ( flux ? "energy" : "spectral flux" ) << std::endl;
+    }
+    else if( event.getCode() == KeyEvent::KEY_k && this->mAnalysis )
+    {
+        bool bark = this->mAnalysis->getFluxBandScale() == SpectralFluxDetector::BandScale::BARK;
+        this->mAnalysis->setFluxBandScale( bark ? SpectralFluxDetector::BandScale::LOG : SpectralFluxDetector::BandScale::BARK );
+        std::cout << "Spectral flux bands: " << ( bark ? "log" : "Bark" ) << " spaced" << std::endl;
+    }
+    else if( event.getCode() == KeyEvent::KEY_c && this->mAnalysis )
+    {
+        AnalysisCache const & cache = this->mAnalysis->getCache();
+        std::cout << "Analysis cache: " << cache.getHits() << " hits, " << cache.getMisses() << " misses, "
+            << cache.getNumEntries() << "/" << cache.getCapacity() << " entries" << std::endl;
+    }
+    else if( event.getCode() == KeyEvent::KEY_l && this->mMeasureLatency )
+    {
+        LatencyProbe::instance().report( std::cout );
+    }
 }
 
 void AudioComponent::update()
 {
-    std::vector<float> magSpectrum( this->mSpectralMonitor->getMagSpectrum() );
-    audio::linearToDecibel( &magSpectrum[0], magSpectrum.size() );
-    
-    // Calculate instant energies
-    std::vector<float> instantEnergies( this->mNumGroups, 0.0f );
-    int binsPerGroup = magSpectrum.size() / this->mNumGroups;
-    float energy = 0.0;
-    for( int i = 0, j = 0; i < magSpectrum.size(); ++i )
+    if( !mPlayerNode )
     {
-        if( i > 0 && i % binsPerGroup == 0 )
-        {
-            instantEnergies[ j ] = powf( energy, 2.0f );
-            ++j;
-            energy = 0.0f;
-        }
-        
-        energy += magSpectrum[ i ];
+        // Silent until the track is decoded; the getters read as no audio meanwhile.
+        if( !AssetLoader::isReady( this->mTrack ) ) { return; }
+        AssetLoader::instance().finalize( "sample.mp3", [this] { this->startPlayback( this->mTrack.get() ); } );
     }
     
-    // Add instant energies to energy history
-    for( int i = 0; i < instantEnergies.size(); ++i )
+    if( this->mUseTimeline )
     {
-        float instantEnergy = instantEnergies[ i ];
-        std::vector<float> & energyHistory = this->mEnergyHistory[ i ];
-        if( energyHistory.size() + 1 > this->mHistorySize ) { energyHistory.erase( energyHistory.begin() ); }
-        energyHistory.push_back( instantEnergy );
+        // Everything was analysed ahead of time; just look up the record under the playhead.
+        size_t readPosition = this->mPlayerNode->getReadPosition();
+        size_t index = this->mTimeline.getIndex( readPosition );
+        size_t numBands = this->mTimeline.getNumBands();
+        this->mTimelineFrame.volume = this->mTimeline.getVolume( index );
+        std::copy( this->mTimeline.getBeats( index ), this->mTimeline.getBeats( index ) + numBands, this->mTimelineFrame.beats.begin() );
+        std::copy( this->mTimeline.getBandEnergies( index ), this->mTimeline.getBandEnergies( index ) + numBands, this->mTimelineFrame.bandEnergies.begin() );
+        this->mTimelineFrame.sampleTime = readPosition;
+        this->mTimelineFrame.time = readPosition / static_cast<double>( this->mTimeline.getHeader().sampleRate );
+        this->mTimelineFrame.sequence = index;
+        this->mFrame = &this->mTimelineFrame;
         
-        // std::cout << i << ":" << instantEnergy << " ";
-        
-        // Update energy averages
-        float energyAverage = 0.0f;
-        for( int j = 0; j < energyHistory.size(); ++j )
-        {
-            energyAverage += energyHistory[ j ];
-        }
-        energyAverage /= energyHistory.size();
-        this->mEnergyAverages[ i ] = energyAverage;
-        // std::cout << "avg=" << energyAverage << " | ";
+        std::copy( this->mTimelineFrame.beats.begin(), this->mTimelineFrame.beats.begin() + std::min( numBands, this->mBeats.size() ), this->mBeats.begin() );
+        return;
     }
-
-    std::cout << "\n" << std::endl;
+    
+    // Beats are detected on the audio thread; all that's left here is one non-blocking read.
+    this->mFrame = &this->mAnalysis->readLatest();
+    LatencyProbe::instance().mark( LatencyProbe::AUDIO_UPDATE, this->mFrame->sampleTime );
+    
+    // The audio thread picks up band count changes a block late; hold the last beats until it does.
+    if( this->mFrame->numBands != this->mBeats.size() ) { return; }
+    std::copy( this->mFrame->beats.begin(), this->mFrame->beats.begin() + this->mFrame->numBands, this->mBeats.begin() );
 }
 
 #endif
@@ -0,0 +1,243 @@
+//
+//  CounterRng.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_CounterRng_h
+#define AudioVertexDisplacement_CounterRng_h
+
+#include <cstddef>
+#include <cstdint>
+#include "DspKernels.h"
+
+/**
+ Counter-based random numbers: Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as
+ 1, 2, 3", SC11), which hashes a 128-bit counter under a 64-bit key into four 32-bit words. There is
+ no state to advance, so the numbers for any index can be made on any thread, in any order, and
+ always come out the same. Counters here are ( index, stream, block ): index picks the particle,
+ stream keeps unrelated uses apart, and block gives the same index more than four words.
+ */
+class CounterRng
+{
+public:
+    explicit CounterRng( std::uint64_t seed = 0 ) : mSeed( seed ) {}
+
+    void setSeed( std::uint64_t seed ) { this->mSeed = seed; }
+    std::uint64_t getSeed() const { return this->mSeed; }
+
+    //! Four random words for ( index, stream, block ).
+    void generate( std::uint64_t index, std::uint32_t stream, std::uint32_t block, std::uint32_t out[ 4 ] ) const;
+    //! The same four words as floats in [0, 1).
+    void uniform( std::uint64_t index, std::uint32_t stream, std::uint32_t block, float out[ 4 ] ) const;
+    //! uniform() for indices first to first + count - 1, four floats per index, in index order.
+    void uniform( std::uint64_t first, size_t count, std::uint32_t stream, std::uint32_t block, float * out ) const;
+
+    //! The top 24 bits of word over 2^24: every float in [0, 1) that step apart, equally likely.
+    static float toUnitFloat( std::uint32_t word ) { return ( word >> 8 ) * ( 1.0f / 16777216.0f ); }
+
+private:
+    std::uint64_t mSeed;
+};
+
+namespace kernels {
+
+//! Philox4x32-10 of counters ( first + i, stream, block ) under key, as uniform floats:
+//! out[ 4 * i + w ] = CounterRng::toUnitFloat( word w ) for i < count.
+void philoxUniform( std::uint64_t key, std::uint64_t first, std::uint32_t stream, std::uint32_t block, size_t count, float * out );
+
+namespace detail {
+
+const std::uint32_t PHILOX_M0 = 0xD2511F53u;
+const std::uint32_t PHILOX_M1 = 0xCD9E8D57u;
+// Weyl sequence the key is bumped by each round: the golden ratio and sqrt( 3 ) - 1.
+const std::uint32_t PHILOX_W0 = 0x9E3779B9u;
+const std::uint32_t PHILOX_W1 = 0xBB67AE85u;
+const int PHILOX_ROUNDS = 10;
+
+void philox4x32( std::uint32_t const counter[ 4 ], std::uint64_t key, std::uint32_t out[ 4 ] )
+{
+    std::uint32_t c0 = counter[ 0 ], c1 = counter[ 1 ], c2 = counter[ 2 ], c3 = counter[ 3 ];
+    std::uint32_t k0 = static_cast<std::uint32_t>( key ), k1 = static_cast<std::uint32_t>( key >> 32 );
+    for( int round = 0; round < PHILOX_ROUNDS; ++round )
+    {
+        const std::uint64_t p0 = static_cast<std::uint64_t>( PHILOX_M0 ) * c0;
+        const std::uint64_t p1 = static_cast<std::uint64_t>( PHILOX_M1 ) * c2;
+        const std::uint32_t n0 = static_cast<std::uint32_t>( p1 >> 32 ) ^ c1 ^ k0;
+        const std::uint32_t n2 = static_cast<std::uint32_t>( p0 >> 32 ) ^ c3 ^ k1;
+        c1 = static_cast<std::uint32_t>( p1 );
+        c3 = static_cast<std::uint32_t>( p0 );
+        c0 = n0;
+        c2 = n2;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[ 0 ] = c0;
+    out[ 1 ] = c1;
+    out[ 2 ] = c2;
+    out[ 3 ] = c3;
+}
+
+void philoxUniformScalar( std::uint64_t key, std::uint64_t first, std::uint32_t stream, std::uint32_t block, size_t count, float * out )
+{
+    for( size_t i = 0; i < count; ++i )
+    {
+        const std::uint64_t index = first + i;
+        const std::uint32_t counter[ 4 ] = { static_cast<std::uint32_t>( index ), static_cast<std::uint32_t>( index >> 32 ), stream, block };
+        std::uint32_t words[ 4 ];
+        philox4x32( counter, key, words );
+        for( int w = 0; w < 4; ++w )
+        {
+            out[ 4 * i + w ] = CounterRng::toUnitFloat( words[ w ] );
+        }
+    }
+}
+
+#if DSP_KERNELS_X86
+
+// Both versions run one counter per 32-bit lane, with the four counter words in four registers.
+// mul_epu32 multiplies the even lanes into 64-bit products; shifting the odd lanes down covers the rest.
+
+void philoxUniformSse2( std::uint64_t key, std::uint64_t first, std::uint32_t stream, std::uint32_t block, size_t count, float * out )
+{
+    const __m128i m0 = _mm_set1_epi32( static_cast<int>( PHILOX_M0 ) );
+    const __m128i m1 = _mm_set1_epi32( static_cast<int>( PHILOX_M1 ) );
+    const __m128i highHalves = _mm_set1_epi64x( static_cast<long long>( 0xFFFFFFFF00000000ull ) );
+    const __m128 scale = _mm_set1_ps( 1.0f / 16777216.0f );
+    size_t i = 0;
+    // The low index word mustn't wrap inside a batch, since the high word is shared.
+    for( ; i + 4 <= count && static_cast<std::uint32_t>( first + i ) <= 0xFFFFFFFFu - 3; i += 4 )
+    {
+        const std::uint64_t index = first + i;
+        const int low = static_cast<int>( static_cast<std::uint32_t>( index ) );
+        __m128i c0 = _mm_add_epi32( _mm_set1_epi32( low ), _mm_set_epi32( 3, 2, 1, 0 ) );
+        __m128i c1 = _mm_set1_epi32( static_cast<int>( index >> 32 ) );
+        __m128i c2 = _mm_set1_epi32( static_cast<int>( stream ) );
+        __m128i c3 = _mm_set1_epi32( static_cast<int>( block ) );
+        std::uint32_t k0 = static_cast<std::uint32_t>( key ), k1 = static_cast<std::uint32_t>( key >> 32 );
+        for( int round = 0; round < PHILOX_ROUNDS; ++round )
+        {
+            const __m128i even0 = _mm_mul_epu32( c0, m0 );
+            const __m128i odd0 = _mm_mul_epu32( _mm_srli_epi64( c0, 32 ), m0 );
+            const __m128i even1 = _mm_mul_epu32( c2, m1 );
+            const __m128i odd1 = _mm_mul_epu32( _mm_srli_epi64( c2, 32 ), m1 );
+            const __m128i hi0 = _mm_or_si128( _mm_srli_epi64( even0, 32 ), _mm_and_si128( odd0, highHalves ) );
+            const __m128i lo0 = _mm_or_si128( _mm_andnot_si128( highHalves, even0 ), _mm_slli_epi64( odd0, 32 ) );
+            const __m128i hi1 = _mm_or_si128( _mm_srli_epi64( even1, 32 ), _mm_and_si128( odd1, highHalves ) );
+            const __m128i lo1 = _mm_or_si128( _mm_andnot_si128( highHalves, even1 ), _mm_slli_epi64( odd1, 32 ) );
+            c0 = _mm_xor_si128( _mm_xor_si128( hi1, c1 ), _mm_set1_epi32( static_cast<int>( k0 ) ) );
+            c2 = _mm_xor_si128( _mm_xor_si128( hi0, c3 ), _mm_set1_epi32( static_cast<int>( k1 ) ) );
+            c1 = lo1;
+            c3 = lo0;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        __m128 w0 = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srli_epi32( c0, 8 ) ), scale );
+        __m128 w1 = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srli_epi32( c1, 8 ) ), scale );
+        __m128 w2 = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srli_epi32( c2, 8 ) ), scale );
+        __m128 w3 = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srli_epi32( c3, 8 ) ), scale );
+        _MM_TRANSPOSE4_PS( w0, w1, w2, w3 );
+        _mm_storeu_ps( out + 4 * i, w0 );
+        _mm_storeu_ps( out + 4 * i + 4, w1 );
+        _mm_storeu_ps( out + 4 * i + 8, w2 );
+        _mm_storeu_ps( out + 4 * i + 12, w3 );
+    }
+    philoxUniformScalar( key, first + i, stream, block, count - i, out + 4 * i );
+}
+
+__attribute__(( target( "avx2" ) ))
+void philoxUniformAvx2( std::uint64_t key, std::uint64_t first, std::uint32_t stream, std::uint32_t block, size_t count, float * out )
+{
+    const __m256i m0 = _mm256_set1_epi32( static_cast<int>( PHILOX_M0 ) );
+    const __m256i m1 = _mm256_set1_epi32( static_cast<int>( PHILOX_M1 ) );
+    const __m256 scale = _mm256_set1_ps( 1.0f / 16777216.0f );
+    size_t i = 0;
+    for( ; i + 8 <= count && static_cast<std::uint32_t>( first + i ) <= 0xFFFFFFFFu - 7; i += 8 )
+    {
+        const std::uint64_t index = first + i;
+        const int low = static_cast<int>( static_cast<std::uint32_t>( index ) );
+        __m256i c0 = _mm256_add_epi32( _mm256_set1_epi32( low ), _mm256_set_epi32( 7, 6, 5, 4, 3, 2, 1, 0 ) );
+        __m256i c1 = _mm256_set1_epi32( static_cast<int>( index >> 32 ) );
+        __m256i c2 = _mm256_set1_epi32( static_cast<int>( stream ) );
+        __m256i c3 = _mm256_set1_epi32( static_cast<int>( block ) );
+        std::uint32_t k0 = static_cast<std::uint32_t>( key ), k1 = static_cast<std::uint32_t>( key >> 32 );
+        for( int round = 0; round < PHILOX_ROUNDS; ++round )
+        {
+            const __m256i even0 = _mm256_mul_epu32( c0, m0 );
+            const __m256i odd0 = _mm256_mul_epu32( _mm256_srli_epi64( c0, 32 ), m0 );
+            const __m256i even1 = _mm256_mul_epu32( c2, m1 );
+            const __m256i odd1 = _mm256_mul_epu32( _mm256_srli_epi64( c2, 32 ), m1 );
+            const __m256i hi0 = _mm256_blend_epi32( _mm256_srli_epi64( even0, 32 ), odd0, 0xAA );
+            const __m256i lo0 = _mm256_blend_epi32( even0, _mm256_slli_epi64( odd0, 32 ), 0xAA );
+            const __m256i hi1 = _mm256_blend_epi32( _mm256_srli_epi64( even1, 32 ), odd1, 0xAA );
+            const __m256i lo1 = _mm256_blend_epi32( even1, _mm256_slli_epi64( odd1, 32 ), 0xAA );
+            c0 = _mm256_xor_si256( _mm256_xor_si256( hi1, c1 ), _mm256_set1_epi32( static_cast<int>( k0 ) ) );
+            c2 = _mm256_xor_si256( _mm256_xor_si256( hi0, c3 ), _mm256_set1_epi32( static_cast<int>( k1 ) ) );
+            c1 = lo1;
+            c3 = lo0;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        const __m256 w0 = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_srli_epi32( c0, 8 ) ), scale );
+        const __m256 w1 = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_srli_epi32( c1, 8 ) ), scale );
+        const __m256 w2 = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_srli_epi32( c2, 8 ) ), scale );
+        const __m256 w3 = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_srli_epi32( c3, 8 ) ), scale );
+        // Transpose eight counters of four words into counter order.
+        const __m256 t0 = _mm256_unpacklo_ps( w0, w1 );
+        const __m256 t1 = _mm256_unpackhi_ps( w0, w1 );
+        const __m256 t2 = _mm256_unpacklo_ps( w2, w3 );
+        const __m256 t3 = _mm256_unpackhi_ps( w2, w3 );
+        const __m256 u0 = _mm256_shuffle_ps( t0, t2, 0x44 );
+        const __m256 u1 = _mm256_shuffle_ps( t0, t2, 0xEE );
+        const __m256 u2 = _mm256_shuffle_ps( t1, t3, 0x44 );
+        const __m256 u3 = _mm256_shuffle_ps( t1, t3, 0xEE );
+        _mm256_storeu_ps( out + 4 * i, _mm256_permute2f128_ps( u0, u1, 0x20 ) );
+        _mm256_storeu_ps( out + 4 * i + 8, _mm256_permute2f128_ps( u2, u3, 0x20 ) );
+        _mm256_storeu_ps( out + 4 * i + 16, _mm256_permute2f128_ps( u0, u1, 0x31 ) );
+        _mm256_storeu_ps( out + 4 * i + 24, _mm256_permute2f128_ps( u2, u3, 0x31 ) );
+    }
+    philoxUniformSse2( key, first + i, stream, block, count - i, out + 4 * i );
+}
+
+#endif
+
+} // namespace detail
+
+void philoxUniform( std::uint64_t key, std::uint64_t first, std::uint32_t stream, std::uint32_t block, size_t count, float * out )
+{
+    switch( getIsa() )
+    {
+#if DSP_KERNELS_X86
+        case Isa::AVX2: detail::philoxUniformAvx2( key, first, stream, block, count, out ); break;
+        case Isa::SSE2: detail::philoxUniformSse2( key, first, stream, block, count, out ); break;
+#endif
+        default: detail::philoxUniformScalar( key, first, stream, block, count, out ); break;
+    }
+}
+
+} // namespace kernels
+
+void CounterRng::generate( std::uint64_t index, std::uint32_t stream, std::uint32_t block, std::uint32_t out[ 4 ] ) const
+{
+    const std::uint32_t counter[ 4 ] = { static_cast<std::uint32_t>( index ), static_cast<std::uint32_t>( index >> 32 ), stream, block };
+    kernels::detail::philox4x32( counter, this->mSeed, out );
+}
+
+void CounterRng::uniform( std::uint64_t index, std::uint32_t stream, std::uint32_t block, float out[ 4 ] ) const
+{
+    std::uint32_t words[ 4 ];
+    this->generate( index, stream, block, words );
+    for( int w = 0; w < 4; ++w )
+    {
+        out[ w ] = toUnitFloat( words[ w ] );
+    }
+}
+
+void CounterRng::uniform( std::uint64_t first, size_t count, std::uint32_t stream, std::uint32_t block, float * out ) const
+{
+    kernels::philoxUniform( this->mSeed, first, stream, block, count, out );
+}
+
+#endif
@@ -0,0 +1,410 @@
+//
+//  DspKernels.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_DspKernels_h
+#define AudioVertexDisplacement_DspKernels_h
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+    #define DSP_KERNELS_X86 1
+    #include <emmintrin.h>
+    #include <immintrin.h>
+#endif
+
+/**
+ Vectorized spectrum kernels shared by both sketches. Each kernel has a scalar reference, an SSE2
+ and an AVX2 version; the widest one the CPU supports is picked once, on first use.
+ */
+namespace kernels {
+
+enum class Isa { SCALAR, SSE2, AVX2 };
+
+Isa getIsa();
+const char * getIsaName();
+
+//! out[i] = ci::audio::linearToDecibel( in[i] ): 0 below 1e-5, otherwise 20 * log10( x ) + 100. In-place is fine.
+void linearToDecibel( const float * in, float * out, size_t length );
+//! Sparse matrix times vector, for a matrix whose rows are each one contiguous run of columns:
+//! out[r] = sum over j < offsets[r + 1] - offsets[r] of weights[ offsets[r] + j ] * in[ starts[r] + j ].
+void sparseMultiply( const float * in, const float * weights, const std::uint32_t * starts, const std::uint32_t * offsets, size_t numRows, float * out );
+//! out[i] = in[i] * in[i]. In-place is fine.
+void square( const float * in, float * out, size_t length );
+//! out[i] = lmap( in[i], inMin, inMax, outMin, outMax ), clamped to [outMin, outMax]. In-place is fine.
+void mapClamped( const float * in, float * out, size_t length, float inMin, float inMax, float outMin, float outMax );
+//! out[i] = ln( 1 + gain * in[i] ) for in[i] >= 0; the usual magnitude compression for onset detection. In-place is fine.
+void logCompress( const float * in, float * out, size_t length, float gain );
+
+namespace detail {
+
+struct Table
+{
+    Isa isa;
+    void ( *linearToDecibel )( const float *, float *, size_t );
+    void ( *sparseMultiply )( const float *, const float *, const std::uint32_t *, const std::uint32_t *, size_t, float * );
+    void ( *square )( const float *, float *, size_t );
+    void ( *mapClamped )( const float *, float *, size_t, float, float, float, float );
+    void ( *logCompress )( const float *, float *, size_t, float );
+};
+
+const float DECIBEL_FLOOR = 1e-5f;
+// 20 / ln( 10 ): converts natural log to decibels.
+const float DECIBELS_PER_NEPER = 8.68588963806503655f;
+
+// Scalar reference
+
+void linearToDecibelScalar( const float * in, float * out, size_t length )
+{
+    for( size_t i = 0; i < length; ++i )
+    {
+        out[ i ] = in[ i ] < DECIBEL_FLOOR ? 0.0f : 20.0f * log10f( in[ i ] ) + 100.0f;
+    }
+}
+
+void sparseMultiplyScalar( const float * in, const float * weights, const std::uint32_t * starts, const std::uint32_t * offsets, size_t numRows, float * out )
+{
+    for( size_t row = 0; row < numRows; ++row )
+    {
+        const float * bins = in + starts[ row ];
+        const float * w = weights + offsets[ row ];
+        const size_t count = offsets[ row + 1 ] - offsets[ row ];
+        float sum = 0.0f;
+        for( size_t i = 0; i < count; ++i )
+        {
+            sum += w[ i ] * bins[ i ];
+        }
+        out[ row ] = sum;
+    }
+}
+
+void squareScalar( const float * in, float * out, size_t length )
+{
+    for( size_t i = 0; i < length; ++i )
+    {
+        out[ i ] = in[ i ] * in[ i ];
+    }
+}
+
+void mapClampedScalar( const float * in, float * out, size_t length, float inMin, float inMax, float outMin, float outMax )
+{
+    const float scale = ( outMax - outMin ) / ( inMax - inMin );
+    const float lo = std::min( outMin, outMax );
+    const float hi = std::max( outMin, outMax );
+    for( size_t i = 0; i < length; ++i )
+    {
+        out[ i ] = std::min( std::max( ( in[ i ] - inMin ) * scale + outMin, lo ), hi );
+    }
+}
+
+void logCompressScalar( const float * in, float * out, size_t length, float gain )
+{
+    for( size_t i = 0; i < length; ++i )
+    {
+        out[ i ] = std::log1p( gain * in[ i ] );
+    }
+}
+
+#if DSP_KERNELS_X86
+
+// Natural log of four/eight positive floats: split off the exponent, then the Cephes logf polynomial
+// on the mantissa in [sqrt(1/2), sqrt(2)). Accurate to a couple of ulps for normal inputs.
+#define DSP_KERNELS_LOG_POLY( V, MUL, ADD, SET1, x ) \
+    V y = SET1( 7.0376836292e-2f ); \
+    y = ADD( MUL( y, x ), SET1( -1.1514610310e-1f ) ); \
+    y = ADD( MUL( y, x ), SET1( 1.1676998740e-1f ) ); \
+    y = ADD( MUL( y, x ), SET1( -1.2420140846e-1f ) ); \
+    y = ADD( MUL( y, x ), SET1( 1.4249322787e-1f ) ); \
+    y = ADD( MUL( y, x ), SET1( -1.6668057665e-1f ) ); \
+    y = ADD( MUL( y, x ), SET1( 2.0000714765e-1f ) ); \
+    y = ADD( MUL( y, x ), SET1( -2.4999993993e-1f ) ); \
+    y = ADD( MUL( y, x ), SET1( 3.3333331174e-1f ) );
+
+inline __m128 logSse2( __m128 x )
+{
+    const __m128 one = _mm_set1_ps( 1.0f );
+    __m128i bits = _mm_castps_si128( x );
+    __m128 e = _mm_cvtepi32_ps( _mm_sub_epi32( _mm_srli_epi32( bits, 23 ), _mm_set1_epi32( 0x7e ) ) );
+    // Mantissa in [0.5, 1).
+    x = _mm_castsi128_ps( _mm_or_si128( _mm_and_si128( bits, _mm_set1_epi32( 0x007fffff ) ), _mm_set1_epi32( 0x3f000000 ) ) );
+    __m128 mask = _mm_cmplt_ps( x, _mm_set1_ps( 0.707106781186547524f ) );
+    __m128 tmp = _mm_and_ps( x, mask );
+    x = _mm_sub_ps( x, one );
+    e = _mm_sub_ps( e, _mm_and_ps( one, mask ) );
+    x = _mm_add_ps( x, tmp );
+
+    __m128 z = _mm_mul_ps( x, x );
+    DSP_KERNELS_LOG_POLY( __m128, _mm_mul_ps, _mm_add_ps, _mm_set1_ps, x )
+    y = _mm_mul_ps( _mm_mul_ps( y, x ), z );
+    y = _mm_add_ps( y, _mm_mul_ps( e, _mm_set1_ps( -2.12194440e-4f ) ) );
+    y = _mm_sub_ps( y, _mm_mul_ps( z, _mm_set1_ps( 0.5f ) ) );
+    x = _mm_add_ps( x, y );
+    return _mm_add_ps( x, _mm_mul_ps( e, _mm_set1_ps( 0.693359375f ) ) );
+}
+
+void linearToDecibelSse2( const float * in, float * out, size_t length )
+{
+    const __m128 floor = _mm_set1_ps( DECIBEL_FLOOR );
+    const __m128 scale = _mm_set1_ps( DECIBELS_PER_NEPER );
+    const __m128 offset = _mm_set1_ps( 100.0f );
+    size_t i = 0;
+    for( ; i + 4 <= length; i += 4 )
+    {
+        __m128 x = _mm_loadu_ps( in + i );
+        __m128 audible = _mm_cmpge_ps( x, floor );
+        __m128 db = _mm_add_ps( _mm_mul_ps( logSse2( _mm_max_ps( x, floor ) ), scale ), offset );
+        _mm_storeu_ps( out + i, _mm_and_ps( db, audible ) );
+    }
+    linearToDecibelScalar( in + i, out + i, length - i );
+}
+
+void sparseMultiplySse2( const float * in, const float * weights, const std::uint32_t * starts, const std::uint32_t * offsets, size_t numRows, float * out )
+{
+    for( size_t row = 0; row < numRows; ++row )
+    {
+        const float * bins = in + starts[ row ];
+        const float * w = weights + offsets[ row ];
+        const size_t count = offsets[ row + 1 ] - offsets[ row ];
+        __m128 acc = _mm_setzero_ps();
+        size_t i = 0;
+        for( ; i + 4 <= count; i += 4 )
+        {
+            acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps( w + i ), _mm_loadu_ps( bins + i ) ) );
+        }
+        acc = _mm_add_ps( acc, _mm_movehl_ps( acc, acc ) );
+        acc = _mm_add_ss( acc, _mm_shuffle_ps( acc, acc, 1 ) );
+        float sum = _mm_cvtss_f32( acc );
+        for( ; i < count; ++i )
+        {
+            sum += w[ i ] * bins[ i ];
+        }
+        out[ row ] = sum;
+    }
+}
+
+void squareSse2( const float * in, float * out, size_t length )
+{
+    size_t i = 0;
+    for( ; i + 4 <= length; i += 4 )
+    {
+        __m128 x = _mm_loadu_ps( in + i );
+        _mm_storeu_ps( out + i, _mm_mul_ps( x, x ) );
+    }
+    squareScalar( in + i, out + i, length - i );
+}
+
+void mapClampedSse2( const float * in, float * out, size_t length, float inMin, float inMax, float outMin, float outMax )
+{
+    const __m128 scale = _mm_set1_ps( ( outMax - outMin ) / ( inMax - inMin ) );
+    const __m128 vInMin = _mm_set1_ps( inMin );
+    const __m128 vOutMin = _mm_set1_ps( outMin );
+    const __m128 lo = _mm_set1_ps( std::min( outMin, outMax ) );
+    const __m128 hi = _mm_set1_ps( std::max( outMin, outMax ) );
+    size_t i = 0;
+    for( ; i + 4 <= length; i += 4 )
+    {
+        __m128 x = _mm_add_ps( _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( in + i ), vInMin ), scale ), vOutMin );
+        _mm_storeu_ps( out + i, _mm_min_ps( _mm_max_ps( x, lo ), hi ) );
+    }
+    mapClampedScalar( in + i, out + i, length - i, inMin, inMax, outMin, outMax );
+}
+
+void logCompressSse2( const float * in, float * out, size_t length, float gain )
+{
+    const __m128 vGain = _mm_set1_ps( gain );
+    const __m128 one = _mm_set1_ps( 1.0f );
+    size_t i = 0;
+    for( ; i + 4 <= length; i += 4 )
+    {
+        __m128 x = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( in + i ), vGain ), one );
+        _mm_storeu_ps( out + i, logSse2( x ) );
+    }
+    logCompressScalar( in + i, out + i, length - i, gain );
+}
+
+__attribute__(( target( "avx2" ) ))
+inline __m256 logAvx2( __m256 x )
+{
+    const __m256 one = _mm256_set1_ps( 1.0f );
+    __m256i bits = _mm256_castps_si256( x );
+    __m256 e = _mm256_cvtepi32_ps( _mm256_sub_epi32( _mm256_srli_epi32( bits, 23 ), _mm256_set1_epi32( 0x7e ) ) );
+    x = _mm256_castsi256_ps( _mm256_or_si256( _mm256_and_si256( bits, _mm256_set1_epi32( 0x007fffff ) ), _mm256_set1_epi32( 0x3f000000 ) ) );
+    __m256 mask = _mm256_cmp_ps( x, _mm256_set1_ps( 0.707106781186547524f ), _CMP_LT_OQ );
+    __m256 tmp = _mm256_and_ps( x, mask );
+    x = _mm256_sub_ps( x, one );
+    e = _mm256_sub_ps( e, _mm256_and_ps( one, mask ) );
+    x = _mm256_add_ps( x, tmp );
+
+    __m256 z = _mm256_mul_ps( x, x );
+    DSP_KERNELS_LOG_POLY( __m256, _mm256_mul_ps, _mm256_add_ps, _mm256_set1_ps, x )
+    y = _mm256_mul_ps( _mm256_mul_ps( y, x ), z );
+    y = _mm256_add_ps( y, _mm256_mul_ps( e, _mm256_set1_ps( -2.12194440e-4f ) ) );
+    y = _mm256_sub_ps( y, _mm256_mul_ps( z, _mm256_set1_ps( 0.5f ) ) );
+    x = _mm256_add_ps( x, y );
+    return _mm256_add_ps( x, _mm256_mul_ps( e, _mm256_set1_ps( 0.693359375f ) ) );
+}
+
+__attribute__(( target( "avx2" ) ))
+void linearToDecibelAvx2( const float * in, float * out, size_t length )
+{
+    const __m256 floor = _mm256_set1_ps( DECIBEL_FLOOR );
+    const __m256 scale = _mm256_set1_ps( DECIBELS_PER_NEPER );
+    const __m256 offset = _mm256_set1_ps( 100.0f );
+    size_t i = 0;
+    for( ; i + 8 <= length; i += 8 )
+    {
+        __m256 x = _mm256_loadu_ps( in + i );
+        __m256 audible = _mm256_cmp_ps( x, floor, _CMP_GE_OQ );
+        __m256 db = _mm256_add_ps( _mm256_mul_ps( logAvx2( _mm256_max_ps( x, floor ) ), scale ), offset );
+        _mm256_storeu_ps( out + i, _mm256_and_ps( db, audible ) );
+    }
+    linearToDecibelSse2( in + i, out + i, length - i );
+}
+
+__attribute__(( target( "avx2" ) ))
+void sparseMultiplyAvx2( const float * in, const float * weights, const std::uint32_t * starts, const std::uint32_t * offsets, size_t numRows, float * out )
+{
+    for( size_t row = 0; row < numRows; ++row )
+    {
+        const float * bins = in + starts[ row ];
+        const float * w = weights + offsets[ row ];
+        const size_t count = offsets[ row + 1 ] - offsets[ row ];
+        __m256 acc = _mm256_setzero_ps();
+        size_t i = 0;
+        for( ; i + 8 <= count; i += 8 )
+        {
+            acc = _mm256_add_ps( acc, _mm256_mul_ps( _mm256_loadu_ps( w + i ), _mm256_loadu_ps( bins + i ) ) );
+        }
+        __m128 half = _mm_add_ps( _mm256_castps256_ps128( acc ), _mm256_extractf128_ps( acc, 1 ) );
+        half = _mm_add_ps( half, _mm_movehl_ps( half, half ) );
+        half = _mm_add_ss( half, _mm_shuffle_ps( half, half, 1 ) );
+        float sum = _mm_cvtss_f32( half );
+        for( ; i < count; ++i )
+        {
+            sum += w[ i ] * bins[ i ];
+        }
+        out[ row ] = sum;
+    }
+}
+
+__attribute__(( target( "avx2" ) ))
+void squareAvx2( const float * in, float * out, size_t length )
+{
+    size_t i = 0;
+    for( ; i + 8 <= length; i += 8 )
+    {
+        __m256 x = _mm256_loadu_ps( in + i );
+        _mm256_storeu_ps( out + i, _mm256_mul_ps( x, x ) );
+    }
+    squareSse2( in + i, out + i, length - i );
+}
+
+__attribute__(( target( "avx2" ) ))
+void mapClampedAvx2( const float * in, float * out, size_t length, float inMin, float inMax, float outMin, float outMax )
+{
+    const __m256 scale = _mm256_set1_ps( ( outMax - outMin ) / ( inMax - inMin ) );
+    const __m256 vInMin = _mm256_set1_ps( inMin );
+    const __m256 vOutMin = _mm256_set1_ps( outMin );
+    const __m256 lo = _mm256_set1_ps( std::min( outMin, outMax ) );
+    const __m256 hi = _mm256_set1_ps( std::max( outMin, outMax ) );
+    size_t i = 0;
+    for( ; i + 8 <= length; i += 8 )
+    {
+        __m256 x = _mm256_add_ps( _mm256_mul_ps( _mm256_sub_ps( _mm256_loadu_ps( in + i ), vInMin ), scale ), vOutMin );
+        _mm256_storeu_ps( out + i, _mm256_min_ps( _mm256_max_ps( x, lo ), hi ) );
+    }
+    mapClampedSse2( in + i, out + i, length - i, inMin, inMax, outMin, outMax );
+}
+
+__attribute__(( target( "avx2" ) ))
+void logCompressAvx2( const float * in, float * out, size_t length, float gain )
+{
+    const __m256 vGain = _mm256_set1_ps( gain );
+    const __m256 one = _mm256_set1_ps( 1.0f );
+    size_t i = 0;
+    for( ; i + 8 <= length; i += 8 )
+    {
+        __m256 x = _mm256_add_ps( _mm256_mul_ps( _mm256_loadu_ps( in + i ), vGain ), one );
+        _mm256_storeu_ps( out + i, logAvx2( x ) );
+    }
+    logCompressSse2( in + i, out + i, length - i, gain );
+}
+
+#undef DSP_KERNELS_LOG_POLY
+
+#endif
+
+Table makeTable()
+{
+#if DSP_KERNELS_X86
+    if( __builtin_cpu_supports( "avx2" ) )
+    {
+        Table table = { Isa::AVX2, linearToDecibelAvx2, sparseMultiplyAvx2, squareAvx2, mapClampedAvx2, logCompressAvx2 };
+        return table;
+    }
+    // SSE2 is baseline on x86_64.
+    Table table = { Isa::SSE2, linearToDecibelSse2, sparseMultiplySse2, squareSse2, mapClampedSse2, logCompressSse2 };
+#else
+    Table table = { Isa::SCALAR, linearToDecibelScalar, sparseMultiplyScalar, squareScalar, mapClampedScalar, logCompressScalar };
+#endif
+    return table;
+}
+
+const Table & getTable()
+{
+    static const Table table = makeTable();
+    return table;
+}
+
+} // namespace detail
+
+Isa getIsa()
+{
+    return detail::getTable().isa;
+}
+
+const char * getIsaName()
+{
+    switch( getIsa() )
+    {
+        case Isa::AVX2: return "AVX2";
+        case Isa::SSE2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+void linearToDecibel( const float * in, float * out, size_t length )
+{
+    detail::getTable().linearToDecibel( in, out, length );
+}
+
+void sparseMultiply( const float * in, const float * weights, const std::uint32_t * starts, const std::uint32_t * offsets, size_t numRows, float * out )
+{
+    detail::getTable().sparseMultiply( in, weights, starts, offsets, numRows, out );
+}
+
+void square( const float * in, float * out, size_t length )
+{
+    detail::getTable().square( in, out, length );
+}
+
+void mapClamped( const float * in, float * out, size_t length, float inMin, float inMax, float outMin, float outMax )
+{
+    detail::getTable().mapClamped( in, out, length, inMin, inMax, outMin, outMax );
+}
+
+void logCompress( const float * in, float * out, size_t length, float gain )
+{
+    detail::getTable().logCompress( in, out, length, gain );
+}
+
+} // namespace kernels
+
+#endif
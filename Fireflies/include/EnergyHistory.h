@@ -0,0 +1,144 @@
+//
+//  EnergyHistory.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_EnergyHistory_h
+#define AudioVertexDisplacement_EnergyHistory_h
+
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+
+/**
+ Fixed-capacity ring buffer of per-band energies with a running sum and sum of squares per band,
+ so pushing a new reading and querying the average or variance are O(1) regardless of history length.
+ The history starts out full of zeros, matching the old zero-filled std::vector histories.
+ */
+class EnergyHistory
+{
+public:
+    EnergyHistory( size_t numBands = 4, size_t historySize = 43 );
+
+    //! Preallocates for up to maxBands x maxHistorySize so later resize() calls within that never allocate.
+    void reserve( size_t maxBands, size_t maxHistorySize );
+    //! Resizes and clears the history. Only allocates when growing past what reserve() set aside.
+    void resize( size_t numBands, size_t historySize );
+    //! Zeroes every band without reallocating.
+    void clear();
+
+    //! Pushes one energy per band (getNumBands() values), evicting the oldest reading.
+    void push( const float * energies );
+
+    float getInstant( size_t band ) const;
+    float getAverage( size_t band ) const;
+    float getVariance( size_t band ) const;
+
+    size_t getNumBands() const { return this->mNumBands; }
+    size_t getHistorySize() const { return this->mHistorySize; }
+
+private:
+    size_t mNumBands;
+    size_t mHistorySize;
+    // Slot of the next write; the newest reading sits just behind it.
+    size_t mHead;
+    // Band-major: band b occupies [b * mHistorySize, (b + 1) * mHistorySize).
+    std::vector<float> mValues;
+    std::vector<double> mSums;
+    std::vector<double> mSumSquares;
+
+    void resum();
+};
+
+EnergyHistory::EnergyHistory( size_t numBands, size_t historySize ) :
+    mNumBands( 0 ),
+    mHistorySize( 0 ),
+    mHead( 0 )
+{
+    this->resize( numBands, historySize );
+}
+
+void EnergyHistory::reserve( size_t maxBands, size_t maxHistorySize )
+{
+    this->mValues.reserve( maxBands * maxHistorySize );
+    this->mSums.reserve( maxBands );
+    this->mSumSquares.reserve( maxBands );
+}
+
+void EnergyHistory::resize( size_t numBands, size_t historySize )
+{
+    this->mNumBands = numBands;
+    this->mHistorySize = std::max<size_t>( historySize, 1 );
+    this->mValues.assign( this->mNumBands * this->mHistorySize, 0.0f );
+    this->mSums.assign( this->mNumBands, 0.0 );
+    this->mSumSquares.assign( this->mNumBands, 0.0 );
+    this->mHead = 0;
+}
+
+void EnergyHistory::clear()
+{
+    std::fill( this->mValues.begin(), this->mValues.end(), 0.0f );
+    std::fill( this->mSums.begin(), this->mSums.end(), 0.0 );
+    std::fill( this->mSumSquares.begin(), this->mSumSquares.end(), 0.0 );
+    this->mHead = 0;
+}
+
+void EnergyHistory::push( const float * energies )
+{
+    for( size_t band = 0; band < this->mNumBands; ++band )
+    {
+        float & slot = this->mValues[ band * this->mHistorySize + this->mHead ];
+        double evicted = slot;
+        double added = energies[ band ];
+        this->mSums[ band ] += added - evicted;
+        this->mSumSquares[ band ] += added * added - evicted * evicted;
+        slot = energies[ band ];
+    }
+
+    if( ++this->mHead == this->mHistorySize )
+    {
+        this->mHead = 0;
+        // Once per lap, recompute the sums exactly so rounding from the running updates can't accumulate.
+        this->resum();
+    }
+}
+
+float EnergyHistory::getInstant( size_t band ) const
+{
+    size_t newest = ( this->mHead == 0 ? this->mHistorySize : this->mHead ) - 1;
+    return this->mValues[ band * this->mHistorySize + newest ];
+}
+
+float EnergyHistory::getAverage( size_t band ) const
+{
+    return static_cast<float>( this->mSums[ band ] / this->mHistorySize );
+}
+
+float EnergyHistory::getVariance( size_t band ) const
+{
+    double mean = this->mSums[ band ] / this->mHistorySize;
+    double variance = this->mSumSquares[ band ] / this->mHistorySize - mean * mean;
+    return static_cast<float>( std::max( variance, 0.0 ) );
+}
+
+void EnergyHistory::resum()
+{
+    for( size_t band = 0; band < this->mNumBands; ++band )
+    {
+        const float * values = &this->mValues[ band * this->mHistorySize ];
+        double sum = 0.0;
+        double sumSquares = 0.0;
+        for( size_t i = 0; i < this->mHistorySize; ++i )
+        {
+            sum += values[ i ];
+            sumSquares += static_cast<double>( values[ i ] ) * values[ i ];
+        }
+        this->mSums[ band ] = sum;
+        this->mSumSquares[ band ] = sumSquares;
+    }
+}
+
+#endif
@@ -0,0 +1,297 @@
+//
+//  FeatureTimeline.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_FeatureTimeline_h
+#define AudioVertexDisplacement_FeatureTimeline_h
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "AnalysisNode.h"
+#include "cinder/Filesystem.h"
+
+/**
+ Pre-baked analysis of a whole audio file, one record per block, memory-mapped for playback.
+ bake() decodes nothing itself: it takes the decoded buffer, analyses it on every core with the
+ same SpectrumAnalyzer AnalysisNode uses, and writes a flat binary file. open() maps that file so
+ features can be looked up by playhead position with no FFT cost at all.
+
+ File layout: a Header, then numRecords records of recordSize floats each:
+ volume, beats[ numBands ], bandEnergies[ numBands ]. The header records the settings and the
+ size and modification time of the file the audio was decoded from, so a replaced file is rebaked
+ even when it decodes to the same length.
+ */
+class FeatureTimeline
+{
+public:
+    struct Header
+    {
+        char magic[ 4 ];
+        std::uint32_t version;
+        std::uint32_t sampleRate;
+        std::uint32_t hopFrames;
+        std::uint32_t fftSize;
+        std::uint32_t windowSize;
+        std::uint32_t numBands;
+        std::uint32_t beatEngine;
+        std::uint32_t fluxBandScale;
+        std::uint32_t window;
+        float historyDuration;
+        float smoothingFactor;
+        float gain;
+        std::uint32_t recordSize;
+        std::uint64_t numRecords;
+        std::uint64_t sourceFrames;
+        std::uint64_t sourceSize;
+        //! Nanoseconds since the epoch.
+        std::int64_t sourceModified;
+    };
+
+    static const std::uint32_t VERSION = 4;
+    //! Records per work item. Fixed, so the output doesn't depend on how many cores baked it.
+    static const size_t CHUNK_RECORDS = 1024;
+
+    FeatureTimeline();
+    ~FeatureTimeline();
+
+    //! Analyses source, decoded from the file at sourcePath, in hopFrames blocks with format's settings
+    //! and writes the timeline to path. gain scales the input the same way a GainNode ahead of the live
+    //! AnalysisNode would. numThreads 0 uses every hardware thread. Returns false if the file couldn't be written.
+    static bool bake( ci::audio::Buffer const & source, ci::fs::path const & sourcePath, float sampleRate, size_t hopFrames,
+                      AnalysisNode::Format const & format, float gain, ci::fs::path const & path, size_t numThreads = 0 );
+
+    //! Maps a baked timeline. Returns false, leaving the timeline closed, if it is missing or malformed.
+    bool open( ci::fs::path const & path );
+    void close();
+    bool isOpen() const { return this->mHeader != nullptr; }
+
+    //! True if the open timeline was baked from sourceFrames frames of the file at sourcePath, as it is
+    //! now, with exactly these settings. Always false if sourcePath can't be stat'ed.
+    bool matches( float sampleRate, size_t hopFrames, AnalysisNode::Format const & format, float gain, size_t sourceFrames,
+                  ci::fs::path const & sourcePath ) const;
+
+    Header const & getHeader() const { return *this->mHeader; }
+    size_t getNumRecords() const { return static_cast<size_t>( this->mHeader->numRecords ); }
+    size_t getNumBands() const { return this->mHeader->numBands; }
+    //! Record whose analysis window ends at or before samplePosition, i.e. what the live node would have published by then.
+    size_t getIndex( size_t samplePosition ) const;
+    //! Start of the record's frame, in source samples.
+    size_t getSamplePosition( size_t index ) const { return index * this->mHeader->hopFrames; }
+
+    float getVolume( size_t index ) const { return this->getRecord( index )[ 0 ]; }
+    const float * getBeats( size_t index ) const { return this->getRecord( index ) + 1; }
+    const float * getBandEnergies( size_t index ) const { return this->getRecord( index ) + 1 + this->mHeader->numBands; }
+
+private:
+    Header const * mHeader;
+    const float * mRecords;
+    void * mMapping;
+    size_t mMappingSize;
+
+    const float * getRecord( size_t index ) const { return this->mRecords + index * this->mHeader->recordSize; }
+
+    static Header makeHeader( float sampleRate, size_t hopFrames, AnalysisNode::Format const & format, float gain, size_t sourceFrames );
+    //! Fills header's source size and modification time from the file at path; false if it can't be stat'ed.
+    static bool stampSource( ci::fs::path const & path, Header & header );
+    static void bakeChunks( ci::audio::Buffer const & source, Header const & header, AnalysisNode::Format const & format,
+                            std::atomic<size_t> & nextChunk, float * records );
+};
+
+FeatureTimeline::FeatureTimeline() :
+    mHeader( nullptr ),
+    mRecords( nullptr ),
+    mMapping( nullptr ),
+    mMappingSize( 0 )
+{
+}
+
+FeatureTimeline::~FeatureTimeline()
+{
+    this->close();
+}
+
+FeatureTimeline::Header FeatureTimeline::makeHeader( float sampleRate, size_t hopFrames, AnalysisNode::Format const & format, float gain, size_t sourceFrames )
+{
+    Header header;
+    std::memset( &header, 0, sizeof( header ) );
+    std::memcpy( header.magic, "FFTL", 4 );
+    header.version = VERSION;
+    header.sampleRate = static_cast<std::uint32_t>( sampleRate );
+    header.hopFrames = static_cast<std::uint32_t>( std::max<size_t>( hopFrames, 1 ) );
+    header.fftSize = static_cast<std::uint32_t>( format.getFftSize() );
+    header.windowSize = static_cast<std::uint32_t>( format.getWindowSize() );
+    header.numBands = static_cast<std::uint32_t>( std::max<size_t>( format.getNumBands(), 1 ) );
+    header.beatEngine = static_cast<std::uint32_t>( format.getBeatEngine() );
+    header.fluxBandScale = static_cast<std::uint32_t>( format.getFluxBandScale() );
+    header.window = static_cast<std::uint32_t>( format.getWindow() );
+    header.historyDuration = format.getHistoryDuration();
+    header.smoothingFactor = format.getSmoothingFactor();
+    header.gain = gain;
+    header.recordSize = 1 + 2 * header.numBands;
+    header.numRecords = ( sourceFrames + header.hopFrames - 1 ) / header.hopFrames;
+    header.sourceFrames = sourceFrames;
+    return header;
+}
+
+bool FeatureTimeline::stampSource( ci::fs::path const & path, Header & header )
+{
+    struct stat info;
+    if( path.empty() || ::stat( path.string().c_str(), &info ) != 0 ) { return false; }
+    header.sourceSize = static_cast<std::uint64_t>( info.st_size );
+#if defined( __APPLE__ )
+    const struct timespec & modified = info.st_mtimespec;
+#else
+    const struct timespec & modified = info.st_mtim;
+#endif
+    header.sourceModified = static_cast<std::int64_t>( modified.tv_sec ) * 1000000000 + modified.tv_nsec;
+    return true;
+}
+
+void FeatureTimeline::bakeChunks( ci::audio::Buffer const & source, Header const & header, AnalysisNode::Format const & format,
+                                  std::atomic<size_t> & nextChunk, float * records )
+{
+    SpectrumAnalyzer analyzer;
+    // Records are one hop apart, so the analysis hop is the record spacing whatever format's hop is.
+    analyzer.setup( header.fftSize, header.windowSize, format.getWindow(), header.smoothingFactor, header.sampleRate, header.hopFrames,
+                    AnalysisNode::MAX_HISTORY_DURATION );
+    analyzer.setNumBands( header.numBands );
+    analyzer.setHistoryDuration( header.historyDuration );
+    analyzer.setBeatEngine( format.getBeatEngine() );
+    analyzer.setFluxBandScale( format.getFluxBandScale() );
+    AnalysisFrame frame;
+    analyzer.makeFrame( frame );
+
+    // Lead each chunk in with enough blocks that its first record comes out the same as if the
+    // whole file had been run in order.
+    const size_t hop = header.hopFrames;
+    const size_t warmup = analyzer.getWarmupBlocks();
+    const size_t numChunks = ( header.numRecords + CHUNK_RECORDS - 1 ) / CHUNK_RECORDS;
+
+    for( size_t chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++ )
+    {
+        const size_t first = chunk * CHUNK_RECORDS;
+        const size_t last = std::min<size_t>( first + CHUNK_RECORDS, header.numRecords );
+        analyzer.reset();
+
+        for( size_t block = first - std::min( first, warmup ); block < last; ++block )
+        {
+            const size_t offset = block * hop;
+            const size_t numFrames = std::min<size_t>( hop, header.sourceFrames - offset );
+            analyzer.process( source, offset, numFrames, frame, header.gain );
+            if( block < first ) { continue; }
+
+            float * record = records + block * header.recordSize;
+            record[ 0 ] = frame.volume;
+            std::copy( frame.beats.begin(), frame.beats.begin() + header.numBands, record + 1 );
+            std::copy( frame.bandEnergies.begin(), frame.bandEnergies.begin() + header.numBands, record + 1 + header.numBands );
+        }
+    }
+}
+
+bool FeatureTimeline::bake( ci::audio::Buffer const & source, ci::fs::path const & sourcePath, float sampleRate, size_t hopFrames,
+                            AnalysisNode::Format const & format, float gain, ci::fs::path const & path, size_t numThreads )
+{
+    Header header = makeHeader( sampleRate, hopFrames, format, gain, source.getNumFrames() );
+    // Unstamped, the timeline still plays, but matches() never accepts it, so it is rebaked next time.
+    stampSource( sourcePath, header );
+    std::vector<float> records( header.numRecords * header.recordSize, 0.0f );
+
+    if( numThreads == 0 ) { numThreads = std::max<size_t>( std::thread::hardware_concurrency(), 1 ); }
+    std::atomic<size_t> nextChunk( 0 );
+    std::vector<std::thread> workers;
+    for( size_t i = 1; i < numThreads; ++i )
+    {
+        workers.push_back( std::thread( &FeatureTimeline::bakeChunks, std::cref( source ), std::cref( header ), std::cref( format ),
+                                        std::ref( nextChunk ), records.data() ) );
+    }
+    bakeChunks( source, header, format, nextChunk, records.data() );
+    for( auto & worker : workers )
+    {
+        worker.join();
+    }
+
+    // Write beside the target and rename, so a reader never maps a half-written file.
+    std::string tempPath = path.string() + ".tmp";
+    FILE * file = std::fopen( tempPath.c_str(), "wb" );
+    if( !file ) { return false; }
+    bool written = std::fwrite( &header, sizeof( header ), 1, file ) == 1
+        && std::fwrite( records.data(), sizeof( float ), records.size(), file ) == records.size();
+    written = ( std::fclose( file ) == 0 ) && written;
+    if( !written || std::rename( tempPath.c_str(), path.string().c_str() ) != 0 )
+    {
+        std::remove( tempPath.c_str() );
+        return false;
+    }
+    return true;
+}
+
+bool FeatureTimeline::open( ci::fs::path const & path )
+{
+    this->close();
+
+    int fd = ::open( path.string().c_str(), O_RDONLY );
+    if( fd < 0 ) { return false; }
+    struct stat info;
+    if( fstat( fd, &info ) != 0 || static_cast<size_t>( info.st_size ) < sizeof( Header ) )
+    {
+        ::close( fd );
+        return false;
+    }
+
+    void * mapping = mmap( nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    ::close( fd );
+    if( mapping == MAP_FAILED ) { return false; }
+
+    Header const * header = static_cast<Header const *>( mapping );
+    size_t expected = sizeof( Header ) + header->numRecords * header->recordSize * sizeof( float );
+    if( std::memcmp( header->magic, "FFTL", 4 ) != 0 || header->version != VERSION || header->numRecords == 0
+        || header->recordSize != 1 + 2 * header->numBands || static_cast<size_t>( info.st_size ) != expected )
+    {
+        munmap( mapping, info.st_size );
+        return false;
+    }
+
+    this->mMapping = mapping;
+    this->mMappingSize = info.st_size;
+    this->mHeader = header;
+    this->mRecords = reinterpret_cast<const float *>( header + 1 );
+    return true;
+}
+
+void FeatureTimeline::close()
+{
+    if( this->mMapping ) { munmap( this->mMapping, this->mMappingSize ); }
+    this->mMapping = nullptr;
+    this->mMappingSize = 0;
+    this->mHeader = nullptr;
+    this->mRecords = nullptr;
+}
+
+bool FeatureTimeline::matches( float sampleRate, size_t hopFrames, AnalysisNode::Format const & format, float gain, size_t sourceFrames,
+                               ci::fs::path const & sourcePath ) const
+{
+    if( !this->isOpen() ) { return false; }
+    Header wanted = makeHeader( sampleRate, hopFrames, format, gain, sourceFrames );
+    if( !stampSource( sourcePath, wanted ) ) { return false; }
+    return std::memcmp( &wanted, this->mHeader, sizeof( Header ) ) == 0;
+}
+
+size_t FeatureTimeline::getIndex( size_t samplePosition ) const
+{
+    size_t blocks = samplePosition / this->mHeader->hopFrames;
+    return std::min<size_t>( blocks > 0 ? blocks - 1 : 0, this->mHeader->numRecords - 1 );
+}
+
+#endif
@@ -0,0 +1,201 @@
+//
+//  Filterbank.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_Filterbank_h
+#define AudioVertexDisplacement_Filterbank_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "DspKernels.h"
+
+//! How filterbank outputs are spaced along the spectrum.
+enum class FilterScale { LINEAR, MEL, CONSTANT_Q };
+
+/**
+ Maps a magnitude spectrum onto a smaller set of outputs (display columns, analysis bands)
+ through a sparse weight matrix built once per (bin count, output count, scale).
+ LINEAR rows are equal runs of bins, bins / numOutputs each with the remainder dropped, so an
+ unnormalized LINEAR bank sums bands exactly as SpectrumAnalyzer always has. MEL and CONSTANT_Q rows are overlapping triangles
+ spaced evenly on the mel or log-frequency axis; a row too narrow to contain a bin centre
+ interpolates between the two nearest bins instead, so low columns are never blank.
+ Each row is one contiguous run of bins, stored CSR-style, and apply() is a single
+ kernels::sparseMultiply() pass. setup() rebuilds only when an argument changes and never
+ allocates within what reserve() set aside.
+ */
+class Filterbank
+{
+public:
+    Filterbank();
+
+    //! Preallocates for up to maxOutputs outputs over numBins bins, so setup() within that never allocates.
+    void reserve( size_t numBins, size_t maxOutputs );
+    //! Builds the weight matrix; with normalize, each row's weights sum to one (a weighted average
+    //! rather than a sum). Returns false without touching anything if nothing changed.
+    bool setup( size_t numBins, float sampleRate, size_t numOutputs, FilterScale scale, bool normalize = true );
+
+    //! Reads getNumBins() values from in and writes getNumOutputs() values to out.
+    void apply( const float * in, float * out ) const;
+
+    size_t getNumBins() const { return this->mNumBins; }
+    size_t getNumOutputs() const { return this->mNumOutputs; }
+    FilterScale getScale() const { return this->mScale; }
+    //! Non-zero weights across all rows.
+    size_t getNumWeights() const { return this->mWeights.size(); }
+
+    //! Lowest MEL and CONSTANT_Q frequency, in Hz; matches SpectralFluxDetector::MIN_FREQUENCY.
+    static const float MIN_FREQUENCY;
+
+private:
+    size_t mNumBins;
+    size_t mNumOutputs;
+    float mSampleRate;
+    FilterScale mScale;
+    bool mNormalize;
+    // Row r weights in[ mStarts[r] ... ] with mWeights[ mOffsets[r], mOffsets[r + 1] ).
+    std::vector<std::uint32_t> mStarts;
+    std::vector<std::uint32_t> mOffsets;
+    std::vector<float> mWeights;
+
+    void buildLinear();
+    void buildTriangles();
+
+    static float warp( float hz, FilterScale scale );
+    static float unwarp( float value, FilterScale scale );
+};
+
+const float Filterbank::MIN_FREQUENCY = 30.0f;
+
+Filterbank::Filterbank() :
+    mNumBins( 0 ),
+    mNumOutputs( 0 ),
+    mSampleRate( 0.0f ),
+    mScale( FilterScale::LINEAR ),
+    mNormalize( true )
+{
+}
+
+float Filterbank::warp( float hz, FilterScale scale )
+{
+    return scale == FilterScale::MEL ? 2595.0f * std::log10( 1.0f + hz / 700.0f ) : std::log( hz );
+}
+
+float Filterbank::unwarp( float value, FilterScale scale )
+{
+    return scale == FilterScale::MEL ? 700.0f * ( std::pow( 10.0f, value / 2595.0f ) - 1.0f ) : std::exp( value );
+}
+
+void Filterbank::reserve( size_t numBins, size_t maxOutputs )
+{
+    // Adjacent triangles overlap pairwise, so a bin lands in at most two rows; a fallback row holds two.
+    this->mStarts.reserve( maxOutputs );
+    this->mOffsets.reserve( maxOutputs + 1 );
+    this->mWeights.reserve( 2 * numBins + 2 * maxOutputs );
+}
+
+bool Filterbank::setup( size_t numBins, float sampleRate, size_t numOutputs, FilterScale scale, bool normalize )
+{
+    // Only LINEAR needs a bin per output; triangles narrower than a bin interpolate.
+    numOutputs = std::max<size_t>( scale == FilterScale::LINEAR ? std::min( numOutputs, numBins ) : numOutputs, 1 );
+    if( numBins == this->mNumBins && numOutputs == this->mNumOutputs && scale == this->mScale
+        && normalize == this->mNormalize && ( scale == FilterScale::LINEAR || sampleRate == this->mSampleRate ) )
+    {
+        return false;
+    }
+
+    this->mNumBins = numBins;
+    this->mNumOutputs = numOutputs;
+    this->mSampleRate = sampleRate;
+    this->mScale = scale;
+    this->mNormalize = normalize;
+
+    this->mStarts.clear();
+    this->mOffsets.assign( 1, 0 );
+    this->mWeights.clear();
+    if( scale == FilterScale::LINEAR )
+    {
+        this->buildLinear();
+    }
+    else
+    {
+        this->buildTriangles();
+    }
+    return true;
+}
+
+void Filterbank::buildLinear()
+{
+    const size_t binsPerRow = this->mNumBins / this->mNumOutputs;
+    const float weight = this->mNormalize ? 1.0f / binsPerRow : 1.0f;
+    for( size_t row = 0; row < this->mNumOutputs; ++row )
+    {
+        this->mStarts.push_back( static_cast<std::uint32_t>( row * binsPerRow ) );
+        this->mWeights.insert( this->mWeights.end(), binsPerRow, weight );
+        this->mOffsets.push_back( static_cast<std::uint32_t>( this->mWeights.size() ) );
+    }
+}
+
+void Filterbank::buildTriangles()
+{
+    const float binWidth = this->mSampleRate / ( 2.0f * this->mNumBins );
+    const float minHz = std::min( MIN_FREQUENCY, this->mSampleRate * 0.25f );
+    const float minWarped = warp( minHz, this->mScale );
+    const float step = ( warp( this->mSampleRate * 0.5f, this->mScale ) - minWarped ) / ( this->mNumOutputs + 1 );
+
+    // Row r rises from point r to its peak at point r + 1 and falls back to zero at point r + 2.
+    std::vector<float> & weights = this->mWeights;
+    for( size_t row = 0; row < this->mNumOutputs; ++row )
+    {
+        const float lower = unwarp( minWarped + step * row, this->mScale ) / binWidth;
+        const float centre = unwarp( minWarped + step * ( row + 1 ), this->mScale ) / binWidth;
+        const float upper = unwarp( minWarped + step * ( row + 2 ), this->mScale ) / binWidth;
+
+        const size_t first = static_cast<size_t>( std::floor( lower ) ) + 1;
+        const size_t last = std::min( static_cast<size_t>( std::ceil( upper ) ), this->mNumBins );
+        const size_t offset = weights.size();
+        float sum = 0.0f;
+        for( size_t bin = first; bin < last; ++bin )
+        {
+            float weight = bin < centre ? ( bin - lower ) / ( centre - lower ) : ( upper - bin ) / ( upper - centre );
+            weights.push_back( std::max( weight, 0.0f ) );
+            sum += weights.back();
+        }
+
+        if( sum > 0.0f )
+        {
+            if( this->mNormalize )
+            {
+                for( size_t i = offset; i < weights.size(); ++i )
+                {
+                    weights[ i ] /= sum;
+                }
+            }
+            this->mStarts.push_back( static_cast<std::uint32_t>( first ) );
+        }
+        else
+        {
+            // No bin centre inside the triangle: read the spectrum at the peak frequency instead.
+            weights.resize( offset );
+            const size_t below = std::min( static_cast<size_t>( centre ), this->mNumBins - 2 );
+            const float fraction = std::min( centre - below, 1.0f );
+            weights.push_back( 1.0f - fraction );
+            weights.push_back( fraction );
+            this->mStarts.push_back( static_cast<std::uint32_t>( below ) );
+        }
+        this->mOffsets.push_back( static_cast<std::uint32_t>( weights.size() ) );
+    }
+}
+
+void Filterbank::apply( const float * in, float * out ) const
+{
+    kernels::sparseMultiply( in, this->mWeights.data(), this->mStarts.data(), this->mOffsets.data(), this->mNumOutputs, out );
+}
+
+#endif
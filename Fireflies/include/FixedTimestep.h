@@ -0,0 +1,113 @@
+//
+//  FixedTimestep.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_FixedTimestep_h
+#define AudioVertexDisplacement_FixedTimestep_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ Decides how many fixed simulation steps each rendered frame runs, so the simulation advances with
+ the clock rather than with the frame rate. Frame durations go into an accumulator and whole
+ steps come out; what is left over, as a fraction of a step, is how far the frame is between the
+ last two simulated states. A frame long enough for more than getMaxSubsteps() steps runs that
+ many and drops the rest, so one stall costs a moment of the show instead of snowballing.
+ */
+class FixedTimestep
+{
+public:
+    explicit FixedTimestep( double stepRate = 60.0, size_t maxSubsteps = 8 );
+
+    //! Steps per second of simulated time. Takes effect from the next advance().
+    void setStepRate( double stepRate );
+    double getStepRate() const { return 1.0 / this->mStepDuration; }
+    double getStepDuration() const { return this->mStepDuration; }
+    void setMaxSubsteps( size_t maxSubsteps ) { this->mMaxSubsteps = std::max<size_t>( maxSubsteps, 1 ); }
+    size_t getMaxSubsteps() const { return this->mMaxSubsteps; }
+
+    //! Adds a frame of frameSeconds (negative counts as none) and returns how many steps are due.
+    //! They are numbered on from getNumSteps() as it was before the call.
+    size_t advance( double frameSeconds );
+    //! How far past the last step the clock is, in steps, in [0, 1): the weight of the latest state
+    //! against the one before it when drawing.
+    float getAlpha() const;
+
+    //! Steps handed out since the last reset().
+    std::uint64_t getNumSteps() const { return this->mNumSteps; }
+    //! Simulated seconds at the end of step index (counting from 0).
+    double getStepTime( std::uint64_t index ) const { return ( index + 1 ) * this->mStepDuration; }
+    //! Steps given up to the substep cap since the last reset().
+    std::uint64_t getNumDropped() const { return this->mNumDropped; }
+
+    void reset();
+
+private:
+    double mStepDuration;
+    size_t mMaxSubsteps;
+    double mAccumulator;
+    std::uint64_t mNumSteps;
+    std::uint64_t mNumDropped;
+};
+
+FixedTimestep::FixedTimestep( double stepRate, size_t maxSubsteps ) :
+    mStepDuration( 1.0 / 60.0 ),
+    mMaxSubsteps( 1 ),
+    mAccumulator( 0.0 ),
+    mNumSteps( 0 ),
+    mNumDropped( 0 )
+{
+    this->setStepRate( stepRate );
+    this->setMaxSubsteps( maxSubsteps );
+}
+
+void FixedTimestep::setStepRate( double stepRate )
+{
+    if( stepRate > 0.0 )
+    {
+        // Keep the same fraction of a step in hand, so a change doesn't jump the interpolation.
+        const double alpha = this->mAccumulator / this->mStepDuration;
+        this->mStepDuration = 1.0 / stepRate;
+        this->mAccumulator = alpha * this->mStepDuration;
+    }
+}
+
+size_t FixedTimestep::advance( double frameSeconds )
+{
+    this->mAccumulator += std::max( frameSeconds, 0.0 );
+    const double due = std::floor( this->mAccumulator / this->mStepDuration );
+    this->mAccumulator -= due * this->mStepDuration;
+    // Rounding can leave a hair under zero or a whole step; either way it belongs to the next frame.
+    this->mAccumulator = std::min( std::max( this->mAccumulator, 0.0 ), std::nextafter( this->mStepDuration, 0.0 ) );
+
+    size_t steps = static_cast<size_t>( due );
+    if( due > this->mMaxSubsteps )
+    {
+        this->mNumDropped += static_cast<std::uint64_t>( due ) - this->mMaxSubsteps;
+        steps = this->mMaxSubsteps;
+    }
+    this->mNumSteps += steps;
+    return steps;
+}
+
+float FixedTimestep::getAlpha() const
+{
+    // A hair under a whole step can still round up to 1 as a float.
+    return std::min( static_cast<float>( this->mAccumulator / this->mStepDuration ), std::nextafter( 1.0f, 0.0f ) );
+}
+
+void FixedTimestep::reset()
+{
+    this->mAccumulator = 0.0;
+    this->mNumSteps = 0;
+    this->mNumDropped = 0;
+}
+
+#endif
@@ -0,0 +1,96 @@
+//
+//  ImpulseNode.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_ImpulseNode_h
+#define AudioVertexDisplacement_ImpulseNode_h
+
+#include <algorithm>
+#include <cstdint>
+#include "LatencyProbe.h"
+#include "cinder/audio/Buffer.h"
+#include "cinder/audio/Node.h"
+#include "cinder/audio/Context.h"
+
+/**
+ Adds a short full-scale click to every channel once per period and tells the LatencyProbe which
+ block it went into. Kept apart from ImpulseNode so the headless harness can drive it without a Context.
+ */
+class ImpulseGenerator
+{
+public:
+    //! Clicks are this many frames of a decaying square wave; broadband enough to move every band.
+    static const size_t IMPULSE_LENGTH = 64;
+
+    ImpulseGenerator( size_t periodFrames = 22050 ) : mPeriodFrames( periodFrames ), mCountdown( periodFrames ) {}
+
+    void setPeriod( size_t periodFrames ) { this->mPeriodFrames = std::max( periodFrames, IMPULSE_LENGTH ); }
+    size_t getPeriod() const { return this->mPeriodFrames; }
+
+    //! Adds any click due in this block. blockSampleTime is the sample clock the analysis will stamp the block with.
+    void process( ci::audio::Buffer * buffer, std::uint64_t blockSampleTime );
+
+private:
+    size_t mPeriodFrames;
+    size_t mCountdown;
+};
+
+void ImpulseGenerator::process( ci::audio::Buffer * buffer, std::uint64_t blockSampleTime )
+{
+    const size_t numFrames = buffer->getNumFrames();
+    if( this->mCountdown >= numFrames )
+    {
+        this->mCountdown -= numFrames;
+        return;
+    }
+
+    // Clicks near the end of a block are clipped rather than carried over; the timing is per block anyway.
+    const size_t start = this->mCountdown;
+    const size_t end = std::min( start + IMPULSE_LENGTH, numFrames );
+    for( size_t ch = 0; ch < buffer->getNumChannels(); ++ch )
+    {
+        float * channel = buffer->getChannel( ch );
+        for( size_t i = start; i < end; ++i )
+        {
+            float decay = 1.0f - static_cast<float>( i - start ) / IMPULSE_LENGTH;
+            channel[ i ] += ( ( i - start ) & 1 ? -1.0f : 1.0f ) * decay;
+        }
+    }
+    LatencyProbe::instance().inject( blockSampleTime );
+    this->mCountdown = this->mPeriodFrames - ( numFrames - start );
+}
+
+typedef std::shared_ptr<class ImpulseNode> ImpulseNodeRef;
+
+/**
+ Pass-through node that injects ImpulseGenerator clicks into the graph, for latency measurement.
+ */
+class ImpulseNode : public ci::audio::Node
+{
+public:
+    ImpulseNode( float periodSeconds = 0.5f, const Format & format = Format() ) :
+        Node( format ),
+        mPeriodSeconds( periodSeconds )
+    {}
+
+protected:
+    void initialize() override
+    {
+        this->mGenerator.setPeriod( static_cast<size_t>( this->mPeriodSeconds * this->getSampleRate() ) );
+    }
+
+    void process( ci::audio::Buffer * buffer ) override
+    {
+        this->mGenerator.process( buffer, this->getContext()->getNumProcessedFrames() );
+    }
+
+private:
+    float mPeriodSeconds;
+    ImpulseGenerator mGenerator;
+};
+
+#endif
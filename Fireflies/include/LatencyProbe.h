@@ -0,0 +1,214 @@
+//
+//  LatencyProbe.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_LatencyProbe_h
+#define AudioVertexDisplacement_LatencyProbe_h
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+
+/**
+ Fixed-bucket histogram of latencies in milliseconds. Buckets are atomic so one thread can add
+ while another reports.
+ */
+class LatencyHistogram
+{
+public:
+    static const size_t NUM_BUCKETS = 500;
+    //! Bucket width, in ms; the last bucket also collects everything past the range.
+    static const double BUCKET_WIDTH;
+
+    LatencyHistogram() { this->clear(); }
+
+    void add( double milliseconds );
+    void clear();
+
+    std::uint32_t getCount() const;
+    //! Upper edge of the bucket holding the given fraction (0 to 1) of samples, capped at the max, in ms.
+    double getPercentile( double fraction ) const;
+    double getMax() const { return this->mMax.load( std::memory_order_relaxed ); }
+
+private:
+    std::atomic<std::uint32_t> mBuckets[ NUM_BUCKETS ];
+    std::atomic<double> mMax;
+};
+
+const double LatencyHistogram::BUCKET_WIDTH = 0.5;
+
+void LatencyHistogram::add( double milliseconds )
+{
+    size_t bucket = milliseconds > 0.0 ? static_cast<size_t>( milliseconds / BUCKET_WIDTH ) : 0;
+    this->mBuckets[ std::min( bucket, NUM_BUCKETS - 1 ) ].fetch_add( 1, std::memory_order_relaxed );
+    if( milliseconds > this->mMax.load( std::memory_order_relaxed ) ) { this->mMax.store( milliseconds, std::memory_order_relaxed ); }
+}
+
+void LatencyHistogram::clear()
+{
+    for( auto & bucket : this->mBuckets )
+    {
+        bucket.store( 0, std::memory_order_relaxed );
+    }
+    this->mMax.store( 0.0, std::memory_order_relaxed );
+}
+
+std::uint32_t LatencyHistogram::getCount() const
+{
+    std::uint32_t count = 0;
+    for( auto const & bucket : this->mBuckets )
+    {
+        count += bucket.load( std::memory_order_relaxed );
+    }
+    return count;
+}
+
+double LatencyHistogram::getPercentile( double fraction ) const
+{
+    std::uint32_t count = this->getCount();
+    if( count == 0 ) { return 0.0; }
+
+    std::uint32_t target = static_cast<std::uint32_t>( std::ceil( fraction * count ) );
+    std::uint32_t seen = 0;
+    for( size_t i = 0; i < NUM_BUCKETS; ++i )
+    {
+        seen += this->mBuckets[ i ].load( std::memory_order_relaxed );
+        if( seen >= std::max<std::uint32_t>( target, 1 ) ) { return std::min( ( i + 1 ) * BUCKET_WIDTH, this->getMax() ); }
+    }
+    return this->getMax();
+}
+
+/**
+ Times a synthetic impulse from the moment it enters the audio graph to each stage that reacts to it.
+ Stages identify what they are handling by the sample clock of the analysed block, so the first time
+ each stage touches a block at or after the impulse's block, that stage's latency is recorded.
+ Only one impulse is in flight at a time; inject them further apart than the slowest stage takes.
+ Every call is a cheap no-op while the probe is disabled.
+ */
+class LatencyProbe
+{
+public:
+    enum Stage { ANALYSIS, AUDIO_UPDATE, SCENE_UPDATE, DRAW, NUM_STAGES };
+
+    static LatencyProbe & instance();
+
+    void setEnabled( bool enabled ) { this->mEnabled.store( enabled, std::memory_order_relaxed ); }
+    bool isEnabled() const { return this->mEnabled.load( std::memory_order_relaxed ); }
+
+    //! Audio thread: an impulse went into the block whose sample clock is blockSampleTime.
+    void inject( std::uint64_t blockSampleTime );
+    //! Any thread: stage is handling the analysis of the block at sampleTime.
+    void mark( Stage stage, std::uint64_t sampleTime );
+
+    LatencyHistogram const & getHistogram( Stage stage ) const { return this->mHistograms[ stage ]; }
+    std::uint32_t getNumInjected() const { return this->mNumInjected.load( std::memory_order_relaxed ); }
+    void clear();
+    //! One line per stage: count and p50 / p90 / p99 / max latency since injection, in ms.
+    void report( std::ostream & stream ) const;
+
+    static const char * getStageName( Stage stage );
+
+private:
+    LatencyProbe();
+
+    static std::int64_t now();
+
+    std::atomic<bool> mEnabled;
+    // Sample clock of the block the pending impulse went into, or max() when none is pending.
+    std::atomic<std::uint64_t> mImpulseSample;
+    std::atomic<std::int64_t> mInjectedAt;
+    // One bit per stage already recorded for the pending impulse.
+    std::atomic<std::uint32_t> mMarked;
+    std::atomic<std::uint32_t> mNumInjected;
+    LatencyHistogram mHistograms[ NUM_STAGES ];
+};
+
+LatencyProbe & LatencyProbe::instance()
+{
+    static LatencyProbe probe;
+    return probe;
+}
+
+LatencyProbe::LatencyProbe() :
+    mEnabled( false ),
+    mImpulseSample( std::numeric_limits<std::uint64_t>::max() ),
+    mInjectedAt( 0 ),
+    mMarked( 0 ),
+    mNumInjected( 0 )
+{
+}
+
+std::int64_t LatencyProbe::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+void LatencyProbe::inject( std::uint64_t blockSampleTime )
+{
+    if( !this->isEnabled() ) { return; }
+
+    // Park the clock while the new impulse is set up, so no stage pairs the old time with the new block.
+    this->mImpulseSample.store( std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed );
+    this->mMarked.store( 0, std::memory_order_relaxed );
+    this->mInjectedAt.store( now(), std::memory_order_relaxed );
+    this->mImpulseSample.store( blockSampleTime, std::memory_order_release );
+    this->mNumInjected.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void LatencyProbe::mark( Stage stage, std::uint64_t sampleTime )
+{
+    if( !this->isEnabled() ) { return; }
+    if( sampleTime < this->mImpulseSample.load( std::memory_order_acquire ) ) { return; }
+
+    std::uint32_t bit = 1u << stage;
+    if( this->mMarked.fetch_or( bit, std::memory_order_relaxed ) & bit ) { return; }
+    this->mHistograms[ stage ].add( ( now() - this->mInjectedAt.load( std::memory_order_relaxed ) ) * 1e-6 );
+}
+
+void LatencyProbe::clear()
+{
+    for( auto & histogram : this->mHistograms )
+    {
+        histogram.clear();
+    }
+    this->mNumInjected.store( 0, std::memory_order_relaxed );
+}
+
+const char * LatencyProbe::getStageName( Stage stage )
+{
+    switch( stage )
+    {
+        case ANALYSIS: return "analysis";
+        case AUDIO_UPDATE: return "audio update";
+        case SCENE_UPDATE: return "scene update";
+        case DRAW: return "draw";
+        default: return "?";
+    }
+}
+
+void LatencyProbe::report( std::ostream & stream ) const
+{
+    stream << "Latency from impulse injection (" << this->getNumInjected() << " impulses), ms:\n";
+    stream << std::fixed << std::setprecision( 1 );
+    for( int i = 0; i < NUM_STAGES; ++i )
+    {
+        LatencyHistogram const & histogram = this->mHistograms[ i ];
+        stream << "  " << std::left << std::setw( 14 ) << getStageName( static_cast<Stage>( i ) ) << std::right
+            << " n " << std::setw( 5 ) << histogram.getCount()
+            << "  p50 " << std::setw( 6 ) << histogram.getPercentile( 0.5 )
+            << "  p90 " << std::setw( 6 ) << histogram.getPercentile( 0.9 )
+            << "  p99 " << std::setw( 6 ) << histogram.getPercentile( 0.99 )
+            << "  max " << std::setw( 6 ) << histogram.getMax() << "\n";
+    }
+}
+
+#endif
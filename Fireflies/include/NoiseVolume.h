@@ -0,0 +1,189 @@
+//
+//  NoiseVolume.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_NoiseVolume_h
+#define AudioVertexDisplacement_NoiseVolume_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "DspKernels.h"
+#include "SimplexNoise.h"
+#include "ThreadPool.h"
+
+/**
+ Cached stand-in for the shader's noise, for when the exact field doesn't matter: pnoise() is
+ evaluated once on a resolution^3 grid spanning one period and read back by trilinear
+ interpolation, so a lookup is eight neighbouring floats instead of a full noise evaluation. The
+ noise repeats every period along each axis, and so does the volume, so any point can be sampled.
+ */
+class NoiseVolume
+{
+public:
+    //! resolution is rounded up to a power of two, period (in noise units) to a whole number.
+    explicit NoiseVolume( size_t resolution = 64, float period = 16.0f );
+
+    //! Fills the grid, split across threads. Until then every sample reads zero.
+    void build( ThreadPool & threads );
+    bool isBuilt() const { return this->mBuilt; }
+
+    //! Trilinearly interpolated noise at ( x, y, z ), which should be finite.
+    float sample( float x, float y, float z ) const;
+    //! out[i] = sample( x[i], y[i], z[i] ) for i < count.
+    void sample( float const * x, float const * y, float const * z, float * out, size_t count ) const;
+
+    size_t getResolution() const { return this->mResolution; }
+    float getPeriod() const { return this->mPeriod; }
+    //! Bytes held by the grid.
+    size_t getSize() const { return this->mSamples.size() * sizeof(float); }
+
+private:
+    size_t mResolution;
+    float mPeriod;
+    // Grid cells per noise unit.
+    float mScale;
+    bool mBuilt;
+    // ( resolution + 1 )^3 samples, x fastest. The last layer along each axis repeats the first,
+    // so a cell's far corners never need wrapping.
+    std::vector<float> mSamples;
+
+    //! Index of the sample below coordinate, wrapped into [0, resolution), and the fraction past it.
+    size_t locate( float coordinate, float & fraction ) const;
+};
+
+namespace kernels {
+namespace detail {
+
+#if DSP_KERNELS_X86
+
+//! NoiseVolume::sample() eight points at a time, gathering each corner of the eight cells at once.
+//! samples is the ( resolution + 1 )^3 grid; the tail is left to the caller.
+__attribute__(( target( "avx2" ) ))
+size_t sampleVolumeAvx2( float const * samples, size_t resolution, float scale, float const * x, float const * y, float const * z, float * out, size_t count )
+{
+    const int row = static_cast<int>( resolution ) + 1;
+    const int slice = row * row;
+    const __m256 s = _mm256_set1_ps( scale );
+    const __m256i mask = _mm256_set1_epi32( static_cast<int>( resolution ) - 1 );
+    const __m256i rowStride = _mm256_set1_epi32( row );
+    size_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    {
+        const __m256 ux = _mm256_mul_ps( _mm256_loadu_ps( x + i ), s );
+        const __m256 uy = _mm256_mul_ps( _mm256_loadu_ps( y + i ), s );
+        const __m256 uz = _mm256_mul_ps( _mm256_loadu_ps( z + i ), s );
+        const __m256 fx = _mm256_floor_ps( ux ), fy = _mm256_floor_ps( uy ), fz = _mm256_floor_ps( uz );
+        const __m256 tx = _mm256_sub_ps( ux, fx ), ty = _mm256_sub_ps( uy, fy ), tz = _mm256_sub_ps( uz, fz );
+        const __m256i ix = _mm256_and_si256( _mm256_cvttps_epi32( fx ), mask );
+        const __m256i iy = _mm256_and_si256( _mm256_cvttps_epi32( fy ), mask );
+        const __m256i iz = _mm256_and_si256( _mm256_cvttps_epi32( fz ), mask );
+        const __m256i base = _mm256_add_epi32( _mm256_mullo_epi32( _mm256_add_epi32( _mm256_mullo_epi32( iz, rowStride ), iy ), rowStride ), ix );
+
+        __m256 c[ 8 ];
+        const int offsets[ 8 ] = { 0, 1, row, row + 1, slice, slice + 1, slice + row, slice + row + 1 };
+        for( int k = 0; k < 8; ++k )
+        {
+            c[ k ] = _mm256_i32gather_ps( samples + offsets[ k ], base, 4 );
+        }
+        const __m256 c00 = _mm256_add_ps( c[ 0 ], _mm256_mul_ps( _mm256_sub_ps( c[ 1 ], c[ 0 ] ), tx ) );
+        const __m256 c10 = _mm256_add_ps( c[ 2 ], _mm256_mul_ps( _mm256_sub_ps( c[ 3 ], c[ 2 ] ), tx ) );
+        const __m256 c01 = _mm256_add_ps( c[ 4 ], _mm256_mul_ps( _mm256_sub_ps( c[ 5 ], c[ 4 ] ), tx ) );
+        const __m256 c11 = _mm256_add_ps( c[ 6 ], _mm256_mul_ps( _mm256_sub_ps( c[ 7 ], c[ 6 ] ), tx ) );
+        const __m256 c0 = _mm256_add_ps( c00, _mm256_mul_ps( _mm256_sub_ps( c10, c00 ), ty ) );
+        const __m256 c1 = _mm256_add_ps( c01, _mm256_mul_ps( _mm256_sub_ps( c11, c01 ), ty ) );
+        _mm256_storeu_ps( out + i, _mm256_add_ps( c0, _mm256_mul_ps( _mm256_sub_ps( c1, c0 ), tz ) ) );
+    }
+    return i;
+}
+
+#endif
+
+} // namespace detail
+} // namespace kernels
+
+NoiseVolume::NoiseVolume( size_t resolution, float period ) :
+    mResolution( 2 ),
+    mPeriod( std::max( std::round( period ), 1.0f ) ),
+    mBuilt( false )
+{
+    while( this->mResolution < resolution )
+    {
+        this->mResolution *= 2;
+    }
+    this->mScale = static_cast<float>( this->mResolution ) / this->mPeriod;
+    const size_t side = this->mResolution + 1;
+    this->mSamples.assign( side * side * side, 0.0f );
+}
+
+void NoiseVolume::build( ThreadPool & threads )
+{
+    const size_t side = this->mResolution + 1;
+    const size_t mask = this->mResolution - 1;
+    const float spacing = this->mPeriod / static_cast<float>( this->mResolution );
+    const float period = this->mPeriod;
+    float * samples = this->mSamples.data();
+    threads.parallelFor( side, 1, [&]( size_t begin, size_t end )
+    {
+        for( size_t k = begin; k < end; ++k )
+        {
+            for( size_t j = 0; j < side; ++j )
+            {
+                float * row = samples + ( k * side + j ) * side;
+                for( size_t i = 0; i < side; ++i )
+                {
+                    // The wrapped layers are evaluated at the first layer's coordinates, so they match it exactly.
+                    row[ i ] = noise::pnoise( ( i & mask ) * spacing, ( j & mask ) * spacing, ( k & mask ) * spacing, period, period, period );
+                }
+            }
+        }
+    } );
+    this->mBuilt = true;
+}
+
+size_t NoiseVolume::locate( float coordinate, float & fraction ) const
+{
+    const float cell = std::floor( coordinate * this->mScale );
+    fraction = coordinate * this->mScale - cell;
+    return static_cast<size_t>( static_cast<std::int64_t>( cell ) ) & ( this->mResolution - 1 );
+}
+
+float NoiseVolume::sample( float x, float y, float z ) const
+{
+    float tx, ty, tz;
+    const size_t ix = this->locate( x, tx ), iy = this->locate( y, ty ), iz = this->locate( z, tz );
+    const size_t row = this->mResolution + 1;
+    const size_t slice = row * row;
+    float const * c = this->mSamples.data() + ( iz * row + iy ) * row + ix;
+
+    const float c00 = c[ 0 ] + ( c[ 1 ] - c[ 0 ] ) * tx;
+    const float c10 = c[ row ] + ( c[ row + 1 ] - c[ row ] ) * tx;
+    const float c01 = c[ slice ] + ( c[ slice + 1 ] - c[ slice ] ) * tx;
+    const float c11 = c[ slice + row ] + ( c[ slice + row + 1 ] - c[ slice + row ] ) * tx;
+    const float c0 = c00 + ( c10 - c00 ) * ty;
+    const float c1 = c01 + ( c11 - c01 ) * ty;
+    return c0 + ( c1 - c0 ) * tz;
+}
+
+void NoiseVolume::sample( float const * x, float const * y, float const * z, float * out, size_t count ) const
+{
+    size_t i = 0;
+#if DSP_KERNELS_X86
+    if( kernels::getIsa() == kernels::Isa::AVX2 )
+    {
+        i = kernels::detail::sampleVolumeAvx2( this->mSamples.data(), this->mResolution, this->mScale, x, y, z, out, count );
+    }
+#endif
+    for( ; i < count; ++i )
+    {
+        out[ i ] = this->sample( x[ i ], y[ i ], z[ i ] );
+    }
+}
+
+#endif
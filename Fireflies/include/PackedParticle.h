@@ -0,0 +1,231 @@
+//
+//  PackedParticle.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_PackedParticle_h
+#define AudioVertexDisplacement_PackedParticle_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "DspKernels.h"
+#include "Particle.h"
+
+/**
+ Particle in 44 bytes instead of 64, for streaming the CPU simulation to the GPU. Position and
+ previous position stay float, since the Verlet step differences them; everything else is
+ quantized to what drawing and the simulation can use:
+ - color as half floats, because alpha carries the beat envelope, which runs past 1 and decays
+   in steps too small for 8 bits;
+ - home and size as half floats, home only steering the simulation and size being a point size;
+ - damping as 16-bit unorm, as it always lies in [0, 1];
+ - groupId as a byte.
+ Every field starts on a multiple of its own size, and the stride is a multiple of 4.
+ */
+struct PackedParticle
+{
+    float           pos[ 3 ];
+    float           ppos[ 3 ];
+    std::uint16_t   color[ 4 ];
+    std::uint16_t   home[ 3 ];
+    std::uint16_t   size;
+    std::uint16_t   damping;
+    std::uint8_t    groupId;
+    std::uint8_t    padding;
+};
+
+static_assert( sizeof(PackedParticle) == 44, "PackedParticle should pack without padding" );
+
+//! PackedParticle as render.vs reads it; the same locations as PARTICLE_ATTRIBUTES, so either layout draws.
+const ParticleAttribute PACKED_PARTICLE_ATTRIBUTES[ NUM_PARTICLE_ATTRIBUTES ] = {
+    { 0, 3, ParticleAttribute::FLOAT, false, offsetof( PackedParticle, pos ) },
+    { 1, 3, ParticleAttribute::FLOAT, false, offsetof( PackedParticle, ppos ) },
+    { 2, 3, ParticleAttribute::HALF_FLOAT, false, offsetof( PackedParticle, home ) },
+    { 3, 4, ParticleAttribute::HALF_FLOAT, false, offsetof( PackedParticle, color ) },
+    { 4, 1, ParticleAttribute::UNSIGNED_SHORT, true, offsetof( PackedParticle, damping ) },
+    { 5, 1, ParticleAttribute::UNSIGNED_BYTE, false, offsetof( PackedParticle, groupId ) },
+    { 6, 1, ParticleAttribute::HALF_FLOAT, false, offsetof( PackedParticle, size ) }
+};
+
+namespace packing {
+
+//! IEEE half float, rounded to nearest even. Overflow goes to infinity and NaN stays NaN.
+std::uint16_t toHalf( float value );
+float fromHalf( std::uint16_t half );
+//! value clamped to [0, 1] and rounded to 16 bits, as GL normalizes unsigned shorts.
+std::uint16_t toUnorm16( float value );
+float fromUnorm16( std::uint16_t unorm );
+
+PackedParticle encode( Particle const & particle );
+Particle decode( PackedParticle const & packed );
+
+namespace detail {
+
+std::uint32_t bitsOf( float value )
+{
+    std::uint32_t bits;
+    std::memcpy( &bits, &value, sizeof(bits) );
+    return bits;
+}
+
+float floatOf( std::uint32_t bits )
+{
+    float value;
+    std::memcpy( &value, &bits, sizeof(value) );
+    return value;
+}
+
+} // namespace detail
+
+std::uint16_t toHalf( float value )
+{
+    using namespace detail;
+    std::uint32_t bits = bitsOf( value );
+    const std::uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+    
+    std::uint32_t half;
+    if( bits >= 0x47800000u )
+    {
+        // 65536 and up, infinity or NaN.
+        half = bits > 0x7f800000u ? 0x7e00u : 0x7c00u;
+    }
+    else if( bits < 0x38800000u )
+    {
+        // Below the smallest normal half: adding 0.5 lines the half's subnormal bits up with the
+        // bottom of the float mantissa, and the FPU does the rounding.
+        half = bitsOf( floatOf( bits ) + 0.5f ) - bitsOf( 0.5f );
+    }
+    else
+    {
+        // Rebias the exponent, then round the 13 dropped mantissa bits to nearest even.
+        const std::uint32_t odd = ( bits >> 13 ) & 1u;
+        bits += ( ( 15u - 127u ) << 23 ) + 0xfffu + odd;
+        half = bits >> 13;
+    }
+    return static_cast<std::uint16_t>( half | ( sign >> 16 ) );
+}
+
+float fromHalf( std::uint16_t half )
+{
+    using namespace detail;
+    const std::uint32_t exponent = half & 0x7c00u;
+    std::uint32_t bits = static_cast<std::uint32_t>( half & 0x7fffu ) << 13;
+    if( exponent == 0x7c00u )
+    {
+        bits += ( 255u - 31u ) << 23;
+    }
+    else if( exponent == 0 )
+    {
+        // Subnormal: the mantissa is a multiple of 2^-24.
+        bits = bitsOf( floatOf( bits + ( 113u << 23 ) ) - floatOf( 113u << 23 ) );
+    }
+    else
+    {
+        bits += ( 127u - 15u ) << 23;
+    }
+    return floatOf( bits | ( static_cast<std::uint32_t>( half & 0x8000u ) << 16 ) );
+}
+
+std::uint16_t toUnorm16( float value )
+{
+    return static_cast<std::uint16_t>( std::min( std::max( value, 0.0f ), 1.0f ) * 65535.0f + 0.5f );
+}
+
+float fromUnorm16( std::uint16_t unorm )
+{
+    return unorm * ( 1.0f / 65535.0f );
+}
+
+PackedParticle encode( Particle const & particle )
+{
+    PackedParticle packed;
+    for( int c = 0; c < 3; ++c )
+    {
+        packed.pos[ c ] = particle.pos[ c ];
+        packed.ppos[ c ] = particle.ppos[ c ];
+        packed.home[ c ] = toHalf( particle.home[ c ] );
+    }
+    packed.color[ 0 ] = toHalf( particle.color.r );
+    packed.color[ 1 ] = toHalf( particle.color.g );
+    packed.color[ 2 ] = toHalf( particle.color.b );
+    packed.color[ 3 ] = toHalf( particle.color.a );
+    packed.size = toHalf( particle.size );
+    packed.damping = toUnorm16( particle.damping );
+    packed.groupId = static_cast<std::uint8_t>( particle.groupId );
+    packed.padding = 0;
+    return packed;
+}
+
+Particle decode( PackedParticle const & packed )
+{
+    Particle particle;
+    particle.pos = ci::vec3( packed.pos[ 0 ], packed.pos[ 1 ], packed.pos[ 2 ] );
+    particle.ppos = ci::vec3( packed.ppos[ 0 ], packed.ppos[ 1 ], packed.ppos[ 2 ] );
+    particle.home = ci::vec3( fromHalf( packed.home[ 0 ] ), fromHalf( packed.home[ 1 ] ), fromHalf( packed.home[ 2 ] ) );
+    particle.color = ci::ColorA( fromHalf( packed.color[ 0 ] ), fromHalf( packed.color[ 1 ] ), fromHalf( packed.color[ 2 ] ), fromHalf( packed.color[ 3 ] ) );
+    particle.size = fromHalf( packed.size );
+    particle.damping = fromUnorm16( packed.damping );
+    particle.groupId = packed.groupId;
+    return particle;
+}
+
+} // namespace packing
+
+namespace kernels {
+
+//! out[i] = packing::toHalf( in[i] ), bit for bit.
+void toHalf( float const * in, std::uint16_t * out, size_t count );
+
+namespace detail {
+
+void toHalfScalar( float const * in, std::uint16_t * out, size_t count )
+{
+    for( size_t i = 0; i < count; ++i )
+    {
+        out[ i ] = packing::toHalf( in[ i ] );
+    }
+}
+
+#if DSP_KERNELS_X86
+
+// VCVTPS2PH rounds to nearest even like packing::toHalf.
+__attribute__(( target( "avx2,f16c" ) ))
+void toHalfF16c( float const * in, std::uint16_t * out, size_t count )
+{
+    size_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    {
+        __m128i half = _mm256_cvtps_ph( _mm256_loadu_ps( in + i ), _MM_FROUND_TO_NEAREST_INT );
+        _mm_storeu_si128( reinterpret_cast<__m128i *>( out + i ), half );
+    }
+    toHalfScalar( in + i, out + i, count - i );
+}
+
+#endif
+
+} // namespace detail
+
+void toHalf( float const * in, std::uint16_t * out, size_t count )
+{
+#if DSP_KERNELS_X86
+    // Conversion instructions came separately from AVX2, though every AVX2 CPU has them.
+    static const bool hasF16c = getIsa() == Isa::AVX2 && __builtin_cpu_supports( "f16c" );
+    if( hasF16c )
+    {
+        detail::toHalfF16c( in, out, count );
+        return;
+    }
+#endif
+    detail::toHalfScalar( in, out, count );
+}
+
+} // namespace kernels
+
+#endif
@@ -0,0 +1,60 @@
+//
+//  Particle.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_Particle_h
+#define AudioVertexDisplacement_Particle_h
+
+#include <cstddef>
+#include "cinder/Color.h"
+#include "cinder/Vector.h"
+
+/**
+ Particle type holds information for rendering and simulation.
+ Used to buffer initial simulation values. pos and ppos are in pixels; home is a fraction of the
+ window's width and height (z stays in pixels), so the particles follow the window when it resizes.
+ */
+struct Particle
+{
+    ci::vec3    pos;
+    ci::vec3    ppos;
+    ci::vec3    home;
+    ci::ColorA  color;
+    float       damping;
+    float       groupId;
+    float       size;
+};
+
+/**
+ One vertex attribute of a particle buffer, in the terms glVertexAttribPointer takes, so each
+ particle layout can describe itself without pulling in GL. Locations are the ones the shaders bind.
+ */
+struct ParticleAttribute
+{
+    enum Type { FLOAT, HALF_FLOAT, UNSIGNED_SHORT, UNSIGNED_BYTE };
+    
+    unsigned int    location;
+    int             components;
+    Type            type;
+    bool            normalized;
+    size_t          offset;
+};
+
+const size_t NUM_PARTICLE_ATTRIBUTES = 7;
+
+//! Particle as particleUpdate.vs and render.vs read it: everything float.
+const ParticleAttribute PARTICLE_ATTRIBUTES[ NUM_PARTICLE_ATTRIBUTES ] = {
+    { 0, 3, ParticleAttribute::FLOAT, false, offsetof( Particle, pos ) },
+    { 1, 3, ParticleAttribute::FLOAT, false, offsetof( Particle, ppos ) },
+    { 2, 3, ParticleAttribute::FLOAT, false, offsetof( Particle, home ) },
+    { 3, 4, ParticleAttribute::FLOAT, false, offsetof( Particle, color ) },
+    { 4, 1, ParticleAttribute::FLOAT, false, offsetof( Particle, damping ) },
+    { 5, 1, ParticleAttribute::FLOAT, false, offsetof( Particle, groupId ) },
+    { 6, 1, ParticleAttribute::FLOAT, false, offsetof( Particle, size ) }
+};
+
+#endif
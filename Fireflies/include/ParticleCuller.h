@@ -0,0 +1,405 @@
+//
+//  ParticleCuller.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_ParticleCuller_h
+#define AudioVertexDisplacement_ParticleCuller_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "DspKernels.h"
+#include "PackedParticle.h"
+#include "ParticleSimulator.h"
+#include "ThreadPool.h"
+
+/**
+ Picks out the CPU simulation's particles worth drawing from where the camera is, and packs only
+ those into a draw list. A particle is dropped when its centre is outside the clip volume (GL
+ discards such a point whole, however large) or when render.vs would make it less than
+ getMinPixelSize() pixels across. Particles drawn smaller than getLodPixelSize() are thinned out
+ instead: for each halving below it, one in four is kept at twice the size, up to getMaxLodLevel()
+ halvings, so a distant group becomes fewer, larger sprites covering the same area. The blend is
+ additive, so that is the same light too. Which particles survive thinning depends only on their
+ slot, so the same ones are kept from frame to frame. Both passes, classifying and then packing,
+ split the particles across a ThreadPool in fixed chunks; the chunks' survivors are laid end to end,
+ so the draw list keeps slot order whatever the number of threads.
+ */
+class ParticleCuller
+{
+public:
+    //! What the last cull() did with the particles; the counts add up to numParticles.
+    struct Stats
+    {
+        size_t numParticles;
+        //! Dead pool slots, which have no size.
+        size_t numEmpty;
+        size_t numOutside;
+        size_t numSubPixel;
+        //! Thinned out, and drawn as part of a larger sprite.
+        size_t numMerged;
+        size_t numDrawn;
+    };
+
+    ParticleCuller();
+
+    //! viewProjection is the column-major matrix the particles are drawn with (ciModelViewProjection);
+    //! pointScale is render.vs's uPointScale, so a particle is size * pointScale / w pixels across.
+    void setView( float const * viewProjection, float pointScale );
+    //! Particles projecting smaller than this many pixels are not drawn at all.
+    void setMinPixelSize( float pixels ) { this->mMinPixelSize = pixels; }
+    float getMinPixelSize() const { return this->mMinPixelSize; }
+    //! Particles projecting smaller than this many pixels are thinned out into larger sprites.
+    void setLodPixelSize( float pixels ) { this->mLodPixelSize = pixels; }
+    float getLodPixelSize() const { return this->mLodPixelSize; }
+    //! How many times a particle may be doubled in size; 0 turns thinning off.
+    void setMaxLodLevel( int level ) { this->mMaxLodLevel = std::min( std::max( level, 0 ), MAX_LOD_LEVEL ); }
+    int getMaxLodLevel() const { return this->mMaxLodLevel; }
+
+    //! Culls the simulator's particles where render.vs draws them, alpha of the way from their previous
+    //! positions to their current ones, and packs the rest into drawList, which must have room for
+    //! simulator.getNumParticles(). Returns how many were packed.
+    size_t cull( ParticleSimulator const & simulator, float alpha, PackedParticle * drawList, ThreadPool & threads );
+    Stats const & getStats() const { return this->mStats; }
+
+    //! Particles each chunk classifies and packs; also the smallest share worth a thread.
+    static const size_t CHUNK_SIZE = 4096;
+    //! Past this a particle would be one in 65536, drawn 256 times the size.
+    static const int MAX_LOD_LEVEL = 8;
+
+private:
+    float mViewProjection[ 16 ];
+    float mPointScale;
+    float mMinPixelSize;
+    float mLodPixelSize;
+    int mMaxLodLevel;
+    Stats mStats;
+    // Survivors of each chunk and how many times each is doubled, from the chunk's first slot on.
+    std::vector<std::uint32_t> mIndices;
+    std::vector<std::uint8_t> mLevels;
+    std::vector<Stats> mChunkStats;
+    // Where each chunk's survivors start in the draw list.
+    std::vector<size_t> mOffsets;
+
+    //! Classifies particles [begin, end), writing the survivors from mIndices[ begin ] on.
+    void classify( ParticleSimulator const & simulator, float alpha, size_t begin, size_t end, Stats & stats );
+    //! Packs count survivors listed from mIndices[ first ] on into drawList.
+    void pack( ParticleSimulator const & simulator, size_t first, size_t count, PackedParticle * drawList ) const;
+};
+
+namespace kernels {
+namespace detail {
+
+//! Whether slot index is one of the one in 4^level kept when thinning at level.
+bool keepsWhenThinned( std::uint32_t index, int level )
+{
+    // Fibonacci hashing spreads consecutive slots evenly over the top bits, so every stretch of slots,
+    // and so every group, is thinned alike; one in four stays with each level, and those kept at a
+    // level are kept at every level below it.
+    return level == 0 || ( index * 0x9E3779B9u ) >> ( 32 - 2 * level ) == 0;
+}
+
+//! ParticleCuller's verdict on particles [begin, end) of the simulator's fields: counted into stats,
+//! and the survivors appended from indices[ stats.numDrawn ] and levels[ stats.numDrawn ] on.
+void classifyParticlesScalar( float const * const pos[ 3 ], float const * const ppos[ 3 ], float const * size, size_t begin, size_t end,
+                              float const * viewProjection, float alpha, float pointScale, float minPixels, float lodPixels, int maxLevel,
+                              std::uint32_t * indices, std::uint8_t * levels, ParticleCuller::Stats & stats )
+{
+    float const * m = viewProjection;
+    const float beta = 1.0f - alpha;
+    for( size_t i = begin; i < end; ++i )
+    {
+        if( !( size[ i ] > 0.0f ) )
+        {
+            ++stats.numEmpty;
+            continue;
+        }
+        // mix( pposition, position, uAlpha ), then ciModelViewProjection, as render.vs does.
+        const float x = ppos[ 0 ][ i ] * beta + pos[ 0 ][ i ] * alpha;
+        const float y = ppos[ 1 ][ i ] * beta + pos[ 1 ][ i ] * alpha;
+        const float z = ppos[ 2 ][ i ] * beta + pos[ 2 ][ i ] * alpha;
+        const float cx = m[ 0 ] * x + m[ 4 ] * y + m[ 8 ] * z + m[ 12 ];
+        const float cy = m[ 1 ] * x + m[ 5 ] * y + m[ 9 ] * z + m[ 13 ];
+        const float cz = m[ 2 ] * x + m[ 6 ] * y + m[ 10 ] * z + m[ 14 ];
+        const float cw = m[ 3 ] * x + m[ 7 ] * y + m[ 11 ] * z + m[ 15 ];
+        // Written so that NaN lands outside.
+        if( !( cw > 0.0f && std::abs( cx ) <= cw && std::abs( cy ) <= cw && std::abs( cz ) <= cw ) )
+        {
+            ++stats.numOutside;
+            continue;
+        }
+        float pixels = size[ i ] * pointScale / cw;
+        if( pixels < minPixels )
+        {
+            ++stats.numSubPixel;
+            continue;
+        }
+        int level = 0;
+        while( pixels < lodPixels && level < maxLevel )
+        {
+            pixels *= 2.0f;
+            ++level;
+        }
+        if( !keepsWhenThinned( static_cast<std::uint32_t>( i ), level ) )
+        {
+            ++stats.numMerged;
+            continue;
+        }
+        indices[ stats.numDrawn ] = static_cast<std::uint32_t>( i );
+        levels[ stats.numDrawn ] = static_cast<std::uint8_t>( level );
+        ++stats.numDrawn;
+    }
+}
+
+#if DSP_KERNELS_X86
+
+//! classifyParticlesScalar() eight particles at a time, with the same arithmetic. Returns where it
+//! stopped; the tail is left to the caller.
+__attribute__(( target( "avx2" ) ))
+size_t classifyParticlesAvx2( float const * const pos[ 3 ], float const * const ppos[ 3 ], float const * size, size_t begin, size_t end,
+                              float const * viewProjection, float alpha, float pointScale, float minPixels, float lodPixels, int maxLevel,
+                              std::uint32_t * indices, std::uint8_t * levels, ParticleCuller::Stats & stats )
+{
+    __m256 m[ 16 ];
+    for( int k = 0; k < 16; ++k )
+    {
+        m[ k ] = _mm256_set1_ps( viewProjection[ k ] );
+    }
+    const __m256 a = _mm256_set1_ps( alpha );
+    const __m256 b = _mm256_set1_ps( 1.0f - alpha );
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 absMask = _mm256_castsi256_ps( _mm256_set1_epi32( 0x7fffffff ) );
+    const __m256 scale = _mm256_set1_ps( pointScale );
+    const __m256 minimum = _mm256_set1_ps( minPixels );
+    const __m256 lod = _mm256_set1_ps( lodPixels );
+    const __m256 two = _mm256_set1_ps( 2.0f );
+    const __m256i one = _mm256_set1_epi32( 1 );
+    const __m256i thirtyTwo = _mm256_set1_epi32( 32 );
+    const __m256i lanes = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+    const __m256i golden = _mm256_set1_epi32( static_cast<int>( 0x9E3779B9u ) );
+    size_t i = begin;
+    for( ; i + 8 <= end; i += 8 )
+    {
+        __m256 p[ 3 ];
+        for( int c = 0; c < 3; ++c )
+        {
+            p[ c ] = _mm256_add_ps( _mm256_mul_ps( _mm256_loadu_ps( ppos[ c ] + i ), b ), _mm256_mul_ps( _mm256_loadu_ps( pos[ c ] + i ), a ) );
+        }
+        __m256 clip[ 4 ];
+        for( int r = 0; r < 4; ++r )
+        {
+            clip[ r ] = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( m[ r ], p[ 0 ] ), _mm256_mul_ps( m[ 4 + r ], p[ 1 ] ) ),
+                                                      _mm256_mul_ps( m[ 8 + r ], p[ 2 ] ) ), m[ 12 + r ] );
+        }
+        const __m256 s = _mm256_loadu_ps( size + i );
+        const __m256 alive = _mm256_cmp_ps( s, zero, _CMP_GT_OQ );
+        __m256 inside = _mm256_cmp_ps( clip[ 3 ], zero, _CMP_GT_OQ );
+        for( int r = 0; r < 3; ++r )
+        {
+            inside = _mm256_and_ps( inside, _mm256_cmp_ps( _mm256_and_ps( clip[ r ], absMask ), clip[ 3 ], _CMP_LE_OQ ) );
+        }
+        __m256 pixels = _mm256_div_ps( _mm256_mul_ps( s, scale ), clip[ 3 ] );
+        const __m256 bigEnough = _mm256_cmp_ps( pixels, minimum, _CMP_NLT_UQ );
+        __m256i level = _mm256_setzero_si256();
+        for( int k = 0; k < maxLevel; ++k )
+        {
+            const __m256 small = _mm256_cmp_ps( pixels, lod, _CMP_LT_OQ );
+            pixels = _mm256_blendv_ps( pixels, _mm256_mul_ps( pixels, two ), small );
+            level = _mm256_add_epi32( level, _mm256_and_si256( _mm256_castps_si256( small ), one ) );
+        }
+        // A shift by 32 or more gives 0, so level 0 always keeps.
+        const __m256i index = _mm256_add_epi32( _mm256_set1_epi32( static_cast<int>( i ) ), lanes );
+        const __m256i shift = _mm256_sub_epi32( thirtyTwo, _mm256_add_epi32( level, level ) );
+        const __m256i dropped = _mm256_srlv_epi32( _mm256_mullo_epi32( index, golden ), shift );
+        const __m256 keeps = _mm256_castsi256_ps( _mm256_cmpeq_epi32( dropped, _mm256_setzero_si256() ) );
+
+        const int aliveBits = _mm256_movemask_ps( alive );
+        const int insideBits = aliveBits & _mm256_movemask_ps( inside );
+        const int visibleBits = insideBits & _mm256_movemask_ps( bigEnough );
+        int keptBits = visibleBits & _mm256_movemask_ps( keeps );
+        stats.numEmpty += 8 - __builtin_popcount( aliveBits );
+        stats.numOutside += __builtin_popcount( aliveBits & ~insideBits );
+        stats.numSubPixel += __builtin_popcount( insideBits & ~visibleBits );
+        stats.numMerged += __builtin_popcount( visibleBits & ~keptBits );
+
+        std::uint32_t laneLevels[ 8 ];
+        _mm256_storeu_si256( reinterpret_cast<__m256i *>( laneLevels ), level );
+        while( keptBits != 0 )
+        {
+            const int lane = __builtin_ctz( keptBits );
+            indices[ stats.numDrawn ] = static_cast<std::uint32_t>( i + lane );
+            levels[ stats.numDrawn ] = static_cast<std::uint8_t>( laneLevels[ lane ] );
+            ++stats.numDrawn;
+            keptBits &= keptBits - 1;
+        }
+    }
+    return i;
+}
+
+#endif
+
+} // namespace detail
+} // namespace kernels
+
+const size_t ParticleCuller::CHUNK_SIZE;
+const int ParticleCuller::MAX_LOD_LEVEL;
+
+ParticleCuller::ParticleCuller() :
+    mPointScale( 1.0f ),
+    mMinPixelSize( 0.5f ),
+    mLodPixelSize( 2.0f ),
+    mMaxLodLevel( 2 ),
+    mStats()
+{
+    // Until setView(), the identity: clip space is world space.
+    for( int i = 0; i < 16; ++i )
+    {
+        this->mViewProjection[ i ] = i % 5 == 0 ? 1.0f : 0.0f;
+    }
+}
+
+void ParticleCuller::setView( float const * viewProjection, float pointScale )
+{
+    std::copy( viewProjection, viewProjection + 16, this->mViewProjection );
+    this->mPointScale = pointScale;
+}
+
+void ParticleCuller::classify( ParticleSimulator const & simulator, float alpha, size_t begin, size_t end, Stats & stats )
+{
+    typedef ParticleSimulator F;
+    float const * pos[ 3 ] = { simulator.getField( F::POS_X ), simulator.getField( F::POS_Y ), simulator.getField( F::POS_Z ) };
+    float const * ppos[ 3 ] = { simulator.getField( F::PPOS_X ), simulator.getField( F::PPOS_Y ), simulator.getField( F::PPOS_Z ) };
+    float const * size = simulator.getField( F::SIZE );
+    std::uint32_t * indices = this->mIndices.data() + begin;
+    std::uint8_t * levels = this->mLevels.data() + begin;
+
+    stats = Stats();
+    stats.numParticles = end - begin;
+    size_t i = begin;
+#if DSP_KERNELS_X86
+    if( kernels::getIsa() == kernels::Isa::AVX2 )
+    {
+        i = kernels::detail::classifyParticlesAvx2( pos, ppos, size, begin, end, this->mViewProjection, alpha, this->mPointScale,
+                                                    this->mMinPixelSize, this->mLodPixelSize, this->mMaxLodLevel, indices, levels, stats );
+    }
+#endif
+    kernels::detail::classifyParticlesScalar( pos, ppos, size, i, end, this->mViewProjection, alpha, this->mPointScale,
+                                              this->mMinPixelSize, this->mLodPixelSize, this->mMaxLodLevel, indices, levels, stats );
+}
+
+void ParticleCuller::pack( ParticleSimulator const & simulator, size_t first, size_t count, PackedParticle * drawList ) const
+{
+    typedef ParticleSimulator F;
+    // Fields converted to half float, in PackedParticle order: color, home, size; as ParticleSimulator::store().
+    const F::Field halfFields[] = { F::COLOR_R, F::COLOR_G, F::COLOR_B, F::COLOR_A, F::HOME_X, F::HOME_Y, F::HOME_Z, F::SIZE };
+    const size_t numHalfFields = sizeof(halfFields) / sizeof(halfFields[ 0 ]);
+    const size_t blockSize = ParticleSimulator::BLOCK_SIZE;
+    float gathered[ numHalfFields ][ blockSize ];
+    std::uint16_t halves[ numHalfFields ][ blockSize ];
+    float const * pos[ 3 ] = { simulator.getField( F::POS_X ), simulator.getField( F::POS_Y ), simulator.getField( F::POS_Z ) };
+    float const * ppos[ 3 ] = { simulator.getField( F::PPOS_X ), simulator.getField( F::PPOS_Y ), simulator.getField( F::PPOS_Z ) };
+    float const * damping = simulator.getField( F::DAMPING );
+    float const * groupId = simulator.getField( F::GROUP_ID );
+    std::uint32_t const * indices = this->mIndices.data() + first;
+    std::uint8_t const * levels = this->mLevels.data() + first;
+
+    for( size_t start = 0; start < count; start += blockSize )
+    {
+        const size_t n = std::min( count - start, blockSize );
+        std::uint32_t const * block = indices + start;
+        // Indices only go up, so a block spanning n slots is a run of them, and converts straight
+        // from the fields as store() does; mostly the case when little is culled.
+        const bool run = block[ n - 1 ] - block[ 0 ] == n - 1;
+        for( size_t h = 0; h < numHalfFields; ++h )
+        {
+            float const * field = simulator.getField( halfFields[ h ] );
+            if( run && halfFields[ h ] != F::SIZE )
+            {
+                kernels::toHalf( field + block[ 0 ], halves[ h ], n );
+                continue;
+            }
+            for( size_t j = 0; j < n; ++j )
+            {
+                gathered[ h ][ j ] = field[ block[ j ] ];
+            }
+            if( halfFields[ h ] == F::SIZE )
+            {
+                for( size_t j = 0; j < n; ++j )
+                {
+                    // A thinned particle stands in for the ones dropped around it.
+                    gathered[ h ][ j ] *= static_cast<float>( 1u << levels[ start + j ] );
+                }
+            }
+            kernels::toHalf( gathered[ h ], halves[ h ], n );
+        }
+        PackedParticle * out = drawList + start;
+        for( size_t j = 0; j < n; ++j )
+        {
+            const size_t i = block[ j ];
+            PackedParticle & p = out[ j ];
+            for( int c = 0; c < 3; ++c )
+            {
+                p.pos[ c ] = pos[ c ][ i ];
+                p.ppos[ c ] = ppos[ c ][ i ];
+                p.home[ c ] = halves[ 4 + c ][ j ];
+            }
+            for( int c = 0; c < 4; ++c )
+            {
+                p.color[ c ] = halves[ c ][ j ];
+            }
+            p.size = halves[ 7 ][ j ];
+            p.damping = packing::toUnorm16( damping[ i ] );
+            p.groupId = static_cast<std::uint8_t>( groupId[ i ] );
+            p.padding = 0;
+        }
+    }
+}
+
+size_t ParticleCuller::cull( ParticleSimulator const & simulator, float alpha, PackedParticle * drawList, ThreadPool & threads )
+{
+    const size_t count = simulator.getNumParticles();
+    const size_t numChunks = ( count + CHUNK_SIZE - 1 ) / CHUNK_SIZE;
+    this->mIndices.resize( count );
+    this->mLevels.resize( count );
+    this->mChunkStats.resize( numChunks );
+    this->mOffsets.resize( numChunks );
+
+    threads.parallelFor( numChunks, 1, [&]( size_t begin, size_t end )
+    {
+        for( size_t c = begin; c < end; ++c )
+        {
+            this->classify( simulator, alpha, c * CHUNK_SIZE, std::min( ( c + 1 ) * CHUNK_SIZE, count ), this->mChunkStats[ c ] );
+        }
+    } );
+
+    // Each chunk's survivors go where the chunks before it leave off.
+    this->mStats = Stats();
+    for( size_t c = 0; c < numChunks; ++c )
+    {
+        Stats const & chunk = this->mChunkStats[ c ];
+        this->mOffsets[ c ] = this->mStats.numDrawn;
+        this->mStats.numParticles += chunk.numParticles;
+        this->mStats.numEmpty += chunk.numEmpty;
+        this->mStats.numOutside += chunk.numOutside;
+        this->mStats.numSubPixel += chunk.numSubPixel;
+        this->mStats.numMerged += chunk.numMerged;
+        this->mStats.numDrawn += chunk.numDrawn;
+    }
+
+    threads.parallelFor( numChunks, 1, [&]( size_t begin, size_t end )
+    {
+        for( size_t c = begin; c < end; ++c )
+        {
+            this->pack( simulator, c * CHUNK_SIZE, this->mChunkStats[ c ].numDrawn, drawList + this->mOffsets[ c ] );
+        }
+    } );
+    return this->mStats.numDrawn;
+}
+
+#endif
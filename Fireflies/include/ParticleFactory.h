@@ -0,0 +1,181 @@
+//
+//  ParticleFactory.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_ParticleFactory_h
+#define AudioVertexDisplacement_ParticleFactory_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "cinder/CinderMath.h"
+#include "cinder/Color.h"
+#include "cinder/Vector.h"
+#include "CounterRng.h"
+#include "Particle.h"
+#include "ThreadPool.h"
+
+// Seed the scene starts from unless told otherwise.
+const std::uint64_t DEFAULT_PARTICLE_SEED = 0x5EED;
+
+/**
+ Makes the scene's particles from a CounterRng instead of the global Rand state. Particle index of
+ the steady population is a function of the seed and index alone, so any range of them can be made
+ on any thread, in any order, and a given seed always lays out the same scene. Bursts are numbered
+ too and work the same way.
+ */
+class ParticleFactory
+{
+public:
+    explicit ParticleFactory( std::uint64_t seed = DEFAULT_PARTICLE_SEED );
+
+    void setSeed( std::uint64_t seed ) { this->mRng.setSeed( seed ); }
+    std::uint64_t getSeed() const { return this->mRng.getSeed(); }
+    //! Window the particles are scattered over, in pixels, and how many groups they are dealt into.
+    void setLayout( float windowWidth, float windowHeight, int numGroups );
+
+    //! Particle index of the steady population: at a random spot in the window with a small random
+    //! velocity, as SceneComponent has always made them, in group index % numGroups. SceneComponent
+    //! used to deal groups out in contiguous blocks of size / numGroups; round robin keeps a particle's
+    //! group independent of the population size, so the groups stay even as it grows and shrinks.
+    Particle makeParticle( std::uint64_t index ) const;
+    //! particles[ i ] = makeParticle( first + i ) for i < count, drawing the random numbers in batches.
+    void makeParticles( std::uint64_t first, size_t count, Particle * particles ) const;
+    //! The same, split across threads. The particles don't depend on how the range is split.
+    void makeParticles( std::uint64_t first, size_t count, Particle * particles, ThreadPool & threads ) const;
+
+    //! Random spot in the window, in pixels, that burst number burst is thrown from.
+    ci::vec3 makeBurstCenter( std::uint64_t burst ) const;
+    //! Particle i of burst number burst: at rest on center, with a home up to radius pixels away.
+    //! lifetime gets the fraction of the full burst lifetime it lives, in [0.5, 1).
+    Particle makeBurstParticle( std::uint64_t burst, std::uint32_t i, int group, ci::vec3 const & center, float radius, float & lifetime ) const;
+
+private:
+    // Counter streams, so the uses can't overlap.
+    static const std::uint32_t STREAM_PARTICLES = 0;
+    static const std::uint32_t STREAM_BURST_CENTERS = 1;
+    static const std::uint32_t STREAM_BURSTS = 2;
+    // Particles per batch in makeParticles().
+    static const size_t BATCH_SIZE = 256;
+
+    CounterRng mRng;
+    float mWindowWidth;
+    float mWindowHeight;
+    int mNumGroups;
+
+    //! Fills in particle index from its six uniforms.
+    void build( std::uint64_t index, float const * u0, float const * u1, Particle & particle ) const;
+    //! The group's hue, dimmed for the bigger sizes.
+    ci::ColorA colorFor( int group, float size ) const;
+};
+
+const std::uint32_t ParticleFactory::STREAM_PARTICLES;
+const std::uint32_t ParticleFactory::STREAM_BURST_CENTERS;
+const std::uint32_t ParticleFactory::STREAM_BURSTS;
+const size_t ParticleFactory::BATCH_SIZE;
+
+ParticleFactory::ParticleFactory( std::uint64_t seed ) :
+    mRng( seed ),
+    mWindowWidth( 1.0f ),
+    mWindowHeight( 1.0f ),
+    mNumGroups( 1 )
+{
+}
+
+void ParticleFactory::setLayout( float windowWidth, float windowHeight, int numGroups )
+{
+    this->mWindowWidth = windowWidth;
+    this->mWindowHeight = windowHeight;
+    this->mNumGroups = std::max( numGroups, 1 );
+}
+
+Particle ParticleFactory::makeParticle( std::uint64_t index ) const
+{
+    float u0[ 4 ], u1[ 4 ];
+    this->mRng.uniform( index, STREAM_PARTICLES, 0, u0 );
+    this->mRng.uniform( index, STREAM_PARTICLES, 1, u1 );
+    Particle particle;
+    this->build( index, u0, u1, particle );
+    return particle;
+}
+
+void ParticleFactory::makeParticles( std::uint64_t first, size_t count, Particle * particles ) const
+{
+    float u0[ 4 * BATCH_SIZE ], u1[ 4 * BATCH_SIZE ];
+    for( size_t begin = 0; begin < count; begin += BATCH_SIZE )
+    {
+        const size_t n = std::min( BATCH_SIZE, count - begin );
+        this->mRng.uniform( first + begin, n, STREAM_PARTICLES, 0, u0 );
+        this->mRng.uniform( first + begin, n, STREAM_PARTICLES, 1, u1 );
+        for( size_t i = 0; i < n; ++i )
+        {
+            this->build( first + begin + i, u0 + 4 * i, u1 + 4 * i, particles[ begin + i ] );
+        }
+    }
+}
+
+void ParticleFactory::makeParticles( std::uint64_t first, size_t count, Particle * particles, ThreadPool & threads ) const
+{
+    threads.parallelFor( count, 4 * BATCH_SIZE, [&]( size_t begin, size_t end )
+    {
+        this->makeParticles( first + begin, end - begin, particles + begin );
+    } );
+}
+
+ci::vec3 ParticleFactory::makeBurstCenter( std::uint64_t burst ) const
+{
+    float u[ 4 ];
+    this->mRng.uniform( burst, STREAM_BURST_CENTERS, 0, u );
+    return ci::vec3( u[ 0 ] * this->mWindowWidth, u[ 1 ] * this->mWindowHeight, 0 );
+}
+
+Particle ParticleFactory::makeBurstParticle( std::uint64_t burst, std::uint32_t i, int group, ci::vec3 const & center, float radius, float & lifetime ) const
+{
+    float u[ 8 ];
+    this->mRng.uniform( burst, STREAM_BURSTS, 2 * i, u );
+    this->mRng.uniform( burst, STREAM_BURSTS, 2 * i + 1, u + 4 );
+    // Everything starts at the centre at rest; the home spring flings it out to its spot.
+    const float angle = u[ 0 ] * 2.0f * static_cast<float>( M_PI );
+    const float distance = u[ 1 ] * radius;
+    Particle particle;
+    particle.groupId = group;
+    particle.pos = center;
+    particle.ppos = center;
+    particle.home = ci::vec3( ( center.x + distance * std::cos( angle ) ) / this->mWindowWidth, ( center.y + distance * std::sin( angle ) ) / this->mWindowHeight, center.z );
+    particle.damping = 0.7f + 0.25f * u[ 2 ];
+    particle.size = 2.0f + 22.0f * u[ 3 ];
+    // Shaded like a steady particle of any size, not just the small ones bursts are.
+    particle.color = this->colorFor( group, 2.0f + 62.0f * u[ 4 ] );
+    lifetime = 0.5f + 0.5f * u[ 5 ];
+    return particle;
+}
+
+void ParticleFactory::build( std::uint64_t index, float const * u0, float const * u1, Particle & particle ) const
+{
+    const int group = static_cast<int>( index % static_cast<std::uint64_t>( this->mNumGroups ) );
+    particle.groupId = group;
+    particle.pos = ci::vec3( u0[ 0 ] * this->mWindowWidth, u0[ 1 ] * this->mWindowHeight, 0 );
+    particle.home = ci::vec3( u0[ 0 ], u0[ 1 ], 0 );
+    // Random initial velocity, uniform on the unit sphere like Rand::randVec3().
+    const float phi = u0[ 2 ] * 2.0f * static_cast<float>( M_PI );
+    const float cosTheta = 2.0f * u0[ 3 ] - 1.0f;
+    const float rho = std::sqrt( std::max( 1.0f - cosTheta * cosTheta, 0.0f ) );
+    particle.ppos = particle.pos + ci::vec3( rho * std::cos( phi ), rho * std::sin( phi ), cosTheta );
+    particle.damping = 0.7f + 0.25f * u1[ 0 ];
+    particle.size = 2.0f + 62.0f * u1[ 1 ];
+    particle.color = this->colorFor( group, particle.size );
+}
+
+ci::ColorA ParticleFactory::colorFor( int group, float size ) const
+{
+    const float numGroups = static_cast<float>( this->mNumGroups );
+    const float hue = ci::lmap<float>( static_cast<float>( group ) / numGroups, 0.0f, numGroups, 0.14f, 0.4f );
+    return ci::Color( ci::CM_HSV, hue, 1.0f, ci::math<float>::clamp( 32.0f / size ) );
+}
+
+#endif
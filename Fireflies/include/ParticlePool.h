@@ -0,0 +1,213 @@
+//
+//  ParticlePool.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_ParticlePool_h
+#define AudioVertexDisplacement_ParticlePool_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+#include "Particle.h"
+
+/**
+ Slot bookkeeping for a particle set that grows and shrinks at runtime.
+ The particles themselves live in the simulation (GPU buffers or ParticleSimulator); the pool
+ decides which slot each new particle goes in and queues the writes. Slots [0, getExtent())
+ hold every live particle, with dead ones in between: emit() refills the lowest dead slot
+ before appending, and the extent drops back as the top slots die, so the range that has to
+ be simulated and drawn stays tight. Dead slots are written with size 0, which render.vs skips.
+ Capacity doubles when the extent outgrows it and halves once the extent fits in a quarter, so
+ buffers are reallocated a logarithmic number of times, never per burst.
+ */
+class ParticlePool
+{
+public:
+    ParticlePool();
+
+    //! Kills everything and forgets queued writes. Capacity is kept.
+    void clear();
+
+    //! Places particle in a free slot and returns the slot. A lifetime of 0 lives until kill().
+    size_t emit( Particle const & particle, double now = 0.0, double lifetime = 0.0 );
+    void kill( size_t slot );
+    //! Kills every particle whose lifetime has run out by now; returns how many.
+    size_t expire( double now );
+
+    bool isAlive( size_t slot ) const { return slot < this->mExtent && this->mAlive[ slot ]; }
+    size_t getLiveCount() const { return this->mLiveCount; }
+    //! Slots to simulate and draw: one past the highest live slot.
+    size_t getExtent() const { return this->mExtent; }
+    //! Slots the backing buffers should hold; changes only when the extent outgrows it or falls to a quarter of it.
+    size_t getCapacity() const { return this->mCapacity; }
+
+    //! Hands over the writes queued since the last flush as runs of consecutive slots, lowest first,
+    //! through write( firstSlot, particles, count ). A slot written twice only reports the last write.
+    void flush( std::function<void( size_t, Particle const *, size_t )> const & write );
+    bool hasPendingWrites() const { return !this->mPending.empty(); }
+
+    //! Capacity never drops below this.
+    static const size_t MIN_CAPACITY = 1024;
+
+private:
+    struct Expiry
+    {
+        double time;
+        size_t slot;
+        std::uint32_t generation;
+        bool operator>( Expiry const & other ) const { return this->time > other.time; }
+    };
+
+    size_t mExtent;
+    size_t mCapacity;
+    size_t mLiveCount;
+    std::vector<std::uint8_t> mAlive;
+    // Bumped whenever a slot is reused, so a stale expiry can't kill its new occupant.
+    std::vector<std::uint32_t> mGeneration;
+    // Dead slots, lowest first. Entries may be stale (reused, or above the extent) and are skipped on the way out.
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> mFree;
+    std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry>> mExpiries;
+    std::vector<std::pair<size_t, Particle>> mPending;
+    // Contiguous copy of one run, for flush().
+    std::vector<Particle> mRun;
+
+    void resizeCapacity( size_t capacity );
+};
+
+const size_t ParticlePool::MIN_CAPACITY;
+
+ParticlePool::ParticlePool() :
+    mExtent( 0 ),
+    mCapacity( 0 ),
+    mLiveCount( 0 )
+{
+    this->resizeCapacity( MIN_CAPACITY );
+}
+
+void ParticlePool::resizeCapacity( size_t capacity )
+{
+    this->mCapacity = capacity;
+    this->mAlive.resize( capacity, 0 );
+    this->mGeneration.resize( capacity, 0 );
+}
+
+void ParticlePool::clear()
+{
+    std::fill( this->mAlive.begin(), this->mAlive.end(), 0 );
+    this->mExtent = 0;
+    this->mLiveCount = 0;
+    this->mFree = decltype( this->mFree )();
+    this->mExpiries = decltype( this->mExpiries )();
+    this->mPending.clear();
+}
+
+size_t ParticlePool::emit( Particle const & particle, double now, double lifetime )
+{
+    size_t slot = this->mExtent;
+    while( !this->mFree.empty() )
+    {
+        size_t candidate = this->mFree.top();
+        this->mFree.pop();
+        if( candidate < this->mExtent && !this->mAlive[ candidate ] )
+        {
+            slot = candidate;
+            break;
+        }
+    }
+
+    if( slot == this->mExtent )
+    {
+        ++this->mExtent;
+        if( this->mExtent > this->mCapacity )
+        {
+            this->resizeCapacity( this->mCapacity * 2 );
+        }
+    }
+
+    this->mAlive[ slot ] = 1;
+    ++this->mGeneration[ slot ];
+    ++this->mLiveCount;
+    if( lifetime > 0.0 )
+    {
+        Expiry expiry = { now + lifetime, slot, this->mGeneration[ slot ] };
+        this->mExpiries.push( expiry );
+    }
+    this->mPending.push_back( std::make_pair( slot, particle ) );
+    return slot;
+}
+
+void ParticlePool::kill( size_t slot )
+{
+    if( !this->isAlive( slot ) ) { return; }
+
+    this->mAlive[ slot ] = 0;
+    --this->mLiveCount;
+    this->mFree.push( slot );
+
+    Particle dead = Particle();
+    dead.size = 0.0f;
+    this->mPending.push_back( std::make_pair( slot, dead ) );
+
+    while( this->mExtent > 0 && !this->mAlive[ this->mExtent - 1 ] )
+    {
+        --this->mExtent;
+    }
+    size_t capacity = this->mCapacity;
+    while( capacity > MIN_CAPACITY && this->mExtent <= capacity / 4 )
+    {
+        capacity /= 2;
+    }
+    if( capacity != this->mCapacity )
+    {
+        this->resizeCapacity( capacity );
+    }
+}
+
+size_t ParticlePool::expire( double now )
+{
+    size_t killed = 0;
+    while( !this->mExpiries.empty() && this->mExpiries.top().time <= now )
+    {
+        Expiry expiry = this->mExpiries.top();
+        this->mExpiries.pop();
+        if( this->isAlive( expiry.slot ) && this->mGeneration[ expiry.slot ] == expiry.generation )
+        {
+            this->kill( expiry.slot );
+            ++killed;
+        }
+    }
+    return killed;
+}
+
+void ParticlePool::flush( std::function<void( size_t, Particle const *, size_t )> const & write )
+{
+    // Later writes to a slot win; slots past the extent are dead and no longer drawn.
+    std::stable_sort( this->mPending.begin(), this->mPending.end(),
+        []( std::pair<size_t, Particle> const & a, std::pair<size_t, Particle> const & b ) { return a.first < b.first; } );
+
+    size_t i = 0;
+    while( i < this->mPending.size() && this->mPending[ i ].first < this->mExtent )
+    {
+        size_t first = this->mPending[ i ].first;
+        this->mRun.clear();
+        while( i < this->mPending.size() && this->mPending[ i ].first == first + this->mRun.size() && this->mPending[ i ].first < this->mExtent )
+        {
+            size_t slot = this->mPending[ i ].first;
+            while( i + 1 < this->mPending.size() && this->mPending[ i + 1 ].first == slot ) { ++i; }
+            this->mRun.push_back( this->mPending[ i ].second );
+            ++i;
+        }
+        write( first, this->mRun.data(), this->mRun.size() );
+    }
+    this->mPending.clear();
+}
+
+#endif
@@ -0,0 +1,362 @@
+//
+//  ParticleSimulator.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_ParticleSimulator_h
+#define AudioVertexDisplacement_ParticleSimulator_h
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "DspKernels.h"
+#include "NoiseVolume.h"
+#include "PackedParticle.h"
+#include "Particle.h"
+#include "SimplexNoise.h"
+#include "ThreadPool.h"
+
+/**
+ CPU implementation of particleUpdate.vs, for machines without transform feedback and for
+ profiling the simulation on its own. Particles are held as structure of arrays, one array per
+ float of Particle, and each step splits them across a ThreadPool. Within a thread, particles go
+ through in blocks: the three snoise() calls per particle fill a small scratch block, a block
+ at a time through the batch noise kernel, then a vectorized kernel runs the Verlet step per axis
+ and a scalar pass applies the beat decay. Arithmetic follows the shader's order of operations,
+ so results track the GPU path.
+ */
+class ParticleSimulator
+{
+public:
+    //! One array per float of Particle, in the same order.
+    enum Field
+    {
+        POS_X, POS_Y, POS_Z,
+        PPOS_X, PPOS_Y, PPOS_Z,
+        HOME_X, HOME_Y, HOME_Z,
+        COLOR_R, COLOR_G, COLOR_B, COLOR_A,
+        DAMPING, GROUP_ID, SIZE,
+        NUM_FIELDS
+    };
+
+    //! numThreads counts the calling thread; 0 uses every hardware thread.
+    explicit ParticleSimulator( size_t numThreads = 0 );
+
+    //! Copies particles in, replacing the current set.
+    void load( Particle const * particles, size_t count );
+    //! Preallocates room for capacity particles, so resize() within that never allocates.
+    void reserve( size_t capacity );
+    //! Changes the number of particles stepped, keeping the state of the first min( count, getNumParticles() ).
+    void resize( size_t count );
+    //! Overwrites particles [first, first + count), which must be below getNumParticles().
+    void write( size_t first, Particle const * particles, size_t count );
+    //! Copies the current state out as getNumParticles() interleaved particles, ready to upload.
+    void store( Particle * particles );
+    //! The same, quantized to PackedParticle: 44 bytes per particle to upload instead of 64.
+    void store( PackedParticle * particles );
+
+    //! One shader invocation per particle, with the same uniforms: uTime, dt2 (the step length in
+    //! seconds, squared), activity, beats[] and windowSize. Beats past numBeats read as zero, as unset uniforms do.
+    void step( float time, float dt2, float activity, float const * beats, size_t numBeats, float windowWidth, float windowHeight );
+
+    //! Samples a NoiseVolume instead of evaluating snoise(): several times cheaper, but a different
+    //! (tileable, interpolated Perlin) field, so the GPU path is no longer matched. The volume is
+    //! built on first use. Off by default.
+    void setCachedNoise( bool cached );
+    bool getCachedNoise() const { return this->mCachedNoise; }
+
+    size_t getNumParticles() const { return this->mNumParticles; }
+    size_t getNumThreads() const { return this->mPool.getNumThreads(); }
+    //! The simulation's workers, for other passes over its particles between steps.
+    ThreadPool & getThreadPool() { return this->mPool; }
+    float const * getField( Field field ) const { return this->mFields[ field ].data(); }
+
+    //! Size of the uniform beats[] array in particleUpdate.vs.
+    static const size_t MAX_BEATS = 5;
+    //! One 60 Hz step, squared: dt2 at the default step rate.
+    static const float DT2;
+    //! Strength of the spring pulling each particle back to its home.
+    static const float HOME_STIFFNESS;
+    //! Fraction of the way alpha falls towards a lower beat each step.
+    static const float BEAT_DECAY;
+    //! Particles per noise block, and the smallest share of particles worth a thread.
+    static const size_t BLOCK_SIZE = 256;
+
+private:
+    ThreadPool mPool;
+    size_t mNumParticles;
+    std::vector<float> mFields[ NUM_FIELDS ];
+    bool mCachedNoise;
+    NoiseVolume mNoiseVolume;
+
+    void stepRange( size_t begin, size_t end, float time, float dt2, float activity, float const * beats, float const * homeScale );
+};
+
+namespace kernels {
+
+//! One axis of the Verlet step in particleUpdate.vs, for count particles:
+//! vel = ( pos - ppos ) * damping; ppos = pos; pos += ( vel + ( home * homeScale - pos ) * stiffness * dt2 ) + noise * activity.
+void integrateAxis( float * pos, float * ppos, float const * home, float const * damping, float const * noise, size_t count,
+                    float homeScale, float stiffness, float dt2, float activity );
+
+namespace detail {
+
+void integrateAxisScalar( float * pos, float * ppos, float const * home, float const * damping, float const * noise, size_t count,
+                          float homeScale, float stiffness, float dt2, float activity )
+{
+    for( size_t i = 0; i < count; ++i )
+    {
+        float vel = ( pos[ i ] - ppos[ i ] ) * damping[ i ];
+        float acc = ( home[ i ] * homeScale - pos[ i ] ) * stiffness;
+        ppos[ i ] = pos[ i ];
+        pos[ i ] = pos[ i ] + ( ( vel + acc * dt2 ) + noise[ i ] * activity );
+    }
+}
+
+#if DSP_KERNELS_X86
+
+void integrateAxisSse2( float * pos, float * ppos, float const * home, float const * damping, float const * noise, size_t count,
+                        float homeScale, float stiffness, float dt2, float activity )
+{
+    const __m128 scale = _mm_set1_ps( homeScale );
+    const __m128 k = _mm_set1_ps( stiffness );
+    const __m128 dt = _mm_set1_ps( dt2 );
+    const __m128 a = _mm_set1_ps( activity );
+    size_t i = 0;
+    for( ; i + 4 <= count; i += 4 )
+    {
+        __m128 p = _mm_loadu_ps( pos + i );
+        __m128 vel = _mm_mul_ps( _mm_sub_ps( p, _mm_loadu_ps( ppos + i ) ), _mm_loadu_ps( damping + i ) );
+        __m128 acc = _mm_mul_ps( _mm_sub_ps( _mm_mul_ps( _mm_loadu_ps( home + i ), scale ), p ), k );
+        __m128 delta = _mm_add_ps( _mm_add_ps( vel, _mm_mul_ps( acc, dt ) ), _mm_mul_ps( _mm_loadu_ps( noise + i ), a ) );
+        _mm_storeu_ps( ppos + i, p );
+        _mm_storeu_ps( pos + i, _mm_add_ps( p, delta ) );
+    }
+    integrateAxisScalar( pos + i, ppos + i, home + i, damping + i, noise + i, count - i, homeScale, stiffness, dt2, activity );
+}
+
+__attribute__(( target( "avx2" ) ))
+void integrateAxisAvx2( float * pos, float * ppos, float const * home, float const * damping, float const * noise, size_t count,
+                        float homeScale, float stiffness, float dt2, float activity )
+{
+    const __m256 scale = _mm256_set1_ps( homeScale );
+    const __m256 k = _mm256_set1_ps( stiffness );
+    const __m256 dt = _mm256_set1_ps( dt2 );
+    const __m256 a = _mm256_set1_ps( activity );
+    size_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    {
+        __m256 p = _mm256_loadu_ps( pos + i );
+        __m256 vel = _mm256_mul_ps( _mm256_sub_ps( p, _mm256_loadu_ps( ppos + i ) ), _mm256_loadu_ps( damping + i ) );
+        __m256 acc = _mm256_mul_ps( _mm256_sub_ps( _mm256_mul_ps( _mm256_loadu_ps( home + i ), scale ), p ), k );
+        __m256 delta = _mm256_add_ps( _mm256_add_ps( vel, _mm256_mul_ps( acc, dt ) ), _mm256_mul_ps( _mm256_loadu_ps( noise + i ), a ) );
+        _mm256_storeu_ps( ppos + i, p );
+        _mm256_storeu_ps( pos + i, _mm256_add_ps( p, delta ) );
+    }
+    integrateAxisSse2( pos + i, ppos + i, home + i, damping + i, noise + i, count - i, homeScale, stiffness, dt2, activity );
+}
+
+#endif
+
+} // namespace detail
+
+void integrateAxis( float * pos, float * ppos, float const * home, float const * damping, float const * noise, size_t count,
+                    float homeScale, float stiffness, float dt2, float activity )
+{
+    switch( getIsa() )
+    {
+#if DSP_KERNELS_X86
+        case Isa::AVX2: detail::integrateAxisAvx2( pos, ppos, home, damping, noise, count, homeScale, stiffness, dt2, activity ); break;
+        case Isa::SSE2: detail::integrateAxisSse2( pos, ppos, home, damping, noise, count, homeScale, stiffness, dt2, activity ); break;
+#endif
+        default: detail::integrateAxisScalar( pos, ppos, home, damping, noise, count, homeScale, stiffness, dt2, activity ); break;
+    }
+}
+
+} // namespace kernels
+
+const float ParticleSimulator::DT2 = 1.0f / ( 60.0f * 60.0f );
+const float ParticleSimulator::HOME_STIFFNESS = 32.0f;
+const float ParticleSimulator::BEAT_DECAY = 0.065f;
+const size_t ParticleSimulator::MAX_BEATS;
+const size_t ParticleSimulator::BLOCK_SIZE;
+
+ParticleSimulator::ParticleSimulator( size_t numThreads ) :
+    mPool( numThreads ),
+    mNumParticles( 0 ),
+    mCachedNoise( false )
+{
+}
+
+void ParticleSimulator::setCachedNoise( bool cached )
+{
+    if( cached && !this->mNoiseVolume.isBuilt() )
+    {
+        this->mNoiseVolume.build( this->mPool );
+    }
+    this->mCachedNoise = cached;
+}
+
+void ParticleSimulator::load( Particle const * particles, size_t count )
+{
+    this->resize( count );
+    this->write( 0, particles, count );
+}
+
+void ParticleSimulator::reserve( size_t capacity )
+{
+    for( auto & field : this->mFields )
+    {
+        field.reserve( capacity );
+    }
+}
+
+void ParticleSimulator::resize( size_t count )
+{
+    this->mNumParticles = count;
+    for( auto & field : this->mFields )
+    {
+        field.resize( count );
+    }
+}
+
+void ParticleSimulator::write( size_t first, Particle const * particles, size_t count )
+{
+    this->mPool.parallelFor( count, BLOCK_SIZE, [&]( size_t begin, size_t end )
+    {
+        for( size_t i = begin; i < end; ++i )
+        {
+            Particle const & p = particles[ i ];
+            const float values[ NUM_FIELDS ] = {
+                p.pos.x, p.pos.y, p.pos.z, p.ppos.x, p.ppos.y, p.ppos.z, p.home.x, p.home.y, p.home.z,
+                p.color.r, p.color.g, p.color.b, p.color.a, p.damping, p.groupId, p.size };
+            for( size_t f = 0; f < NUM_FIELDS; ++f )
+            {
+                this->mFields[ f ][ first + i ] = values[ f ];
+            }
+        }
+    } );
+}
+
+void ParticleSimulator::store( Particle * particles )
+{
+    this->mPool.parallelFor( this->mNumParticles, BLOCK_SIZE, [&]( size_t begin, size_t end )
+    {
+        std::vector<float> const * f = this->mFields;
+        for( size_t i = begin; i < end; ++i )
+        {
+            Particle & p = particles[ i ];
+            p.pos = ci::vec3( f[ POS_X ][ i ], f[ POS_Y ][ i ], f[ POS_Z ][ i ] );
+            p.ppos = ci::vec3( f[ PPOS_X ][ i ], f[ PPOS_Y ][ i ], f[ PPOS_Z ][ i ] );
+            p.home = ci::vec3( f[ HOME_X ][ i ], f[ HOME_Y ][ i ], f[ HOME_Z ][ i ] );
+            p.color = ci::ColorA( f[ COLOR_R ][ i ], f[ COLOR_G ][ i ], f[ COLOR_B ][ i ], f[ COLOR_A ][ i ] );
+            p.damping = f[ DAMPING ][ i ];
+            p.groupId = f[ GROUP_ID ][ i ];
+            p.size = f[ SIZE ][ i ];
+        }
+    } );
+}
+
+void ParticleSimulator::store( PackedParticle * particles )
+{
+    // Fields converted to half float, in PackedParticle order: color, home, size.
+    const Field halfFields[] = { COLOR_R, COLOR_G, COLOR_B, COLOR_A, HOME_X, HOME_Y, HOME_Z, SIZE };
+    const size_t numHalfFields = sizeof(halfFields) / sizeof(halfFields[ 0 ]);
+    this->mPool.parallelFor( this->mNumParticles, BLOCK_SIZE, [&]( size_t begin, size_t end )
+    {
+        std::vector<float> const * f = this->mFields;
+        std::uint16_t halves[ numHalfFields ][ BLOCK_SIZE ];
+        for( size_t start = begin; start < end; start += BLOCK_SIZE )
+        {
+            const size_t count = std::min( end - start, BLOCK_SIZE );
+            for( size_t h = 0; h < numHalfFields; ++h )
+            {
+                kernels::toHalf( f[ halfFields[ h ] ].data() + start, halves[ h ], count );
+            }
+            for( size_t j = 0; j < count; ++j )
+            {
+                const size_t i = start + j;
+                PackedParticle & p = particles[ i ];
+                for( int c = 0; c < 3; ++c )
+                {
+                    p.pos[ c ] = f[ POS_X + c ][ i ];
+                    p.ppos[ c ] = f[ PPOS_X + c ][ i ];
+                    p.home[ c ] = halves[ 4 + c ][ j ];
+                }
+                for( int c = 0; c < 4; ++c )
+                {
+                    p.color[ c ] = halves[ c ][ j ];
+                }
+                p.size = halves[ 7 ][ j ];
+                p.damping = packing::toUnorm16( f[ DAMPING ][ i ] );
+                p.groupId = static_cast<std::uint8_t>( f[ GROUP_ID ][ i ] );
+                p.padding = 0;
+            }
+        }
+    } );
+}
+
+void ParticleSimulator::step( float time, float dt2, float activity, float const * beats, size_t numBeats, float windowWidth, float windowHeight )
+{
+    float uniformBeats[ MAX_BEATS ] = {};
+    std::copy( beats, beats + std::min( numBeats, MAX_BEATS ), uniformBeats );
+    // vec3( windowSize, 1.0 ) in the shader.
+    const float homeScale[ 3 ] = { windowWidth, windowHeight, 1.0f };
+
+    this->mPool.parallelFor( this->mNumParticles, BLOCK_SIZE, [&]( size_t begin, size_t end )
+    {
+        this->stepRange( begin, end, time, dt2, activity, uniformBeats, homeScale );
+    } );
+}
+
+void ParticleSimulator::stepRange( size_t begin, size_t end, float time, float dt2, float activity, float const * beats, float const * homeScale )
+{
+    std::vector<float> * f = this->mFields;
+    float noise[ 3 ][ BLOCK_SIZE ];
+    float times[ BLOCK_SIZE ];
+    std::fill( times, times + BLOCK_SIZE, time );
+    for( size_t start = begin; start < end; start += BLOCK_SIZE )
+    {
+        const size_t count = std::min( end - start, BLOCK_SIZE );
+        float const * x = f[ POS_X ].data() + start;
+        float const * y = f[ POS_Y ].data() + start;
+        float const * z = f[ POS_Z ].data() + start;
+        if( this->mCachedNoise )
+        {
+            this->mNoiseVolume.sample( x, y, times, noise[ 0 ], count );
+            this->mNoiseVolume.sample( y, z, times, noise[ 1 ], count );
+            this->mNoiseVolume.sample( x, z, times, noise[ 2 ], count );
+        }
+        else
+        {
+            kernels::snoise( x, y, times, noise[ 0 ], count );
+            kernels::snoise( y, z, times, noise[ 1 ], count );
+            kernels::snoise( x, z, times, noise[ 2 ], count );
+        }
+
+        for( size_t axis = 0; axis < 3; ++axis )
+        {
+            kernels::integrateAxis( f[ POS_X + axis ].data() + start, f[ PPOS_X + axis ].data() + start, f[ HOME_X + axis ].data() + start,
+                                    f[ DAMPING ].data() + start, noise[ axis ], count, homeScale[ axis ], HOME_STIFFNESS, dt2, activity );
+        }
+
+        // applyBeat(): alpha jumps up to a louder beat and decays towards a quieter one.
+        float * alpha = f[ COLOR_A ].data() + start;
+        float const * group = f[ GROUP_ID ].data() + start;
+        for( size_t i = 0; i < count; ++i )
+        {
+            size_t index = static_cast<size_t>( group[ i ] );
+            float beat = index < MAX_BEATS ? beats[ index ] : 0.0f;
+            if( beat < alpha[ i ] )
+            {
+                beat = alpha[ i ] * ( 1.0f - BEAT_DECAY ) + beat * BEAT_DECAY;
+            }
+            alpha[ i ] = beat;
+        }
+    }
+}
+
+#endif
@@ -10,38 +10,78 @@
 #define AudioVertexDisplacement_VizComponent_h
 
 #include "IComponent.h"
+#include "AssetLoader.h"
+#include "AudioComponent.h"
+#include "FixedTimestep.h"
+#include "PackedParticle.h"
+#include "Particle.h"
+#include "ParticleCuller.h"
+#include "ParticleFactory.h"
+#include "ParticlePool.h"
+#include "ParticleSimulator.h"
+#include "SplatRenderer.h"
 #include "cinder/app/App.h"
-#include "cinder/Rand.h"
 #include "cinder/CinderMath.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Utilities.h"
 
 using namespace ci;
 using namespace ci::app;
 
-// How many particles to create.
-const int NUM_PARTICLES = 1024;
+// How many particles to create unless told otherwise.
+const size_t DEFAULT_NUM_PARTICLES = 1024;
+// Particles thrown out when a group's beat crosses BURST_THRESHOLD, and how many seconds they live.
+const size_t BURST_SIZE = 96;
+const double BURST_LIFETIME = 2.0;
+const float BURST_THRESHOLD = 0.25f;
+// Pixels a burst spreads over.
+const float BURST_RADIUS = 120.0f;
+// Seconds a scheduled beat pulse takes to decay to 1/e.
+const float PULSE_DECAY = 0.08f;
+// Below this tempo confidence, beats are only shown as they are detected.
+const float MIN_TEMPO_CONFIDENCE = 0.3f;
+// Simulation steps per second unless told otherwise; particleUpdate.vs is tuned for 60.
+const double DEFAULT_STEP_RATE = 60.0;
+// uTime per simulated second: the noise field drifts slowly under the particles.
+const double NOISE_TIME_SCALE = 0.001;
 
-/**
- Particle type holds information for rendering and simulation.
- Used to buffer initial simulation values.
- */
-struct Particle
-{
-    vec3	pos;
-    vec3	ppos;
-    vec3	home;
-    ColorA  color;
-    float	damping;
-    float   groupId;
-    float   size;
-};
+//! Where particleUpdate.vs runs: on the GPU through transform feedback, or on the CPU through ParticleSimulator.
+enum class SimulationBackend { GPU, CPU };
 
 class SceneComponent : public IComponent
 {
 public:
     SceneComponent( App * app );
-    void setMagSpectrum( std::vector<float> const & spectrum );
-    void setBeats( std::vector<float> const & beats );
-    void setVolume( float volume );
+    //! Audio features are read straight from the component each update(); nothing is copied in.
+    void setAudio( std::shared_ptr<AudioComponent> const & audio );
+    //! Can be switched at any time; the particles carry on from where they are.
+    void setBackend( SimulationBackend backend );
+    SimulationBackend getBackend() const { return this->mBackend; }
+    //! Whether the CPU backend samples a cached noise volume instead of evaluating the shader's
+    //! noise exactly (see ParticleSimulator::setCachedNoise()). No effect on the GPU backend.
+    void setCachedNoise( bool cached );
+    bool getCachedNoise() const { return this->mCachedNoise; }
+    //! Simulation steps per second, whatever the display's refresh rate. Frames between steps are
+    //! drawn interpolated between the last two. Each step integrates the home spring over its real
+    //! length; damping, noise and the beat decay are still applied once a step, as tuned at 60 Hz.
+    void setStepRate( double stepRate ) { this->mTimestep.setStepRate( stepRate ); }
+    double getStepRate() const { return this->mTimestep.getStepRate(); }
+    //! Whether the CPU backend draws only the particles the camera can see, thinning out the ones
+    //! too small to make out (see ParticleCuller). On by default; no effect on the GPU backend.
+    void setCulling( bool culling ) { this->mCulling = culling; }
+    bool getCulling() const { return this->mCulling; }
+    //! What culling did with the particles drawn last frame.
+    ParticleCuller::Stats const & getCullStats() const { return this->mCuller.getStats(); }
+    //! Draws the CPU backend's next frame in software as well (see SplatRenderer) and writes it to
+    //! path as an image. No effect on the GPU backend, whose particles never leave the GPU.
+    void requestSnapshot( fs::path const & path ) { this->mSnapshotPath = path; }
+    //! Size of the steady population, on top of which beats add short-lived bursts. Takes effect
+    //! without a reload; the buffers only reallocate when the pool's capacity changes.
+    void setNumParticles( size_t numParticles );
+    size_t getNumParticles() const { return this->mNumParticles; }
+    //! The same seed lays out the same scene; takes effect at the next setup().
+    void setSeed( std::uint64_t seed ) { this->mFactory.setSeed( seed ); }
+    std::uint64_t getSeed() const { return this->mFactory.getSeed(); }
     
     virtual void setup();
     virtual void mouseDown( MouseEvent event ) {}
@@ -53,13 +93,50 @@ public:
     
 private:
     bool mIsFullscreen;
+    // Pulse on the tempo tracker's predicted beats, not just on detected ones.
+    bool mPredictBeats;
     int mNumGroups;
-    float mVolume;
-    std::vector<float> mMagSpectrum;
+    // Scratch for the beat uniforms; reused every frame.
     std::vector<float> mBeats;
+    // Last frame's beats, to spot the rising edges that trigger bursts.
+    std::vector<float> mPreviousBeats;
+    size_t mNumParticles;
+    ParticlePool mPool;
+    // Slots of the steady population, oldest first. Base particle i is mFactory.makeParticle( i ).
+    std::vector<size_t> mBaseSlots;
+    ParticleFactory mFactory;
+    // Bursts thrown since setup(); numbers the next one for mFactory.
+    std::uint64_t mNumBursts;
+    std::shared_ptr<AudioComponent> mAudio;
     App * mApp;
+    SimulationBackend mBackend;
+    bool mCachedNoise;
+    bool mCulling;
+    ParticleCuller mCuller;
+    FixedTimestep mTimestep;
+    // getElapsedSeconds() at the last update(), or negative before the first.
+    double mLastFrameTime;
+    // Created the first time the CPU backend is used.
+    std::unique_ptr<ParticleSimulator> mSimulator;
+    // Full-precision copy of the CPU simulation, for handing it to and from the GPU backend.
+    std::vector<Particle> mStaging;
+    // Quantized copy of the CPU simulation, or of the part of it worth drawing, streamed to
+    // mPackedBuffer each frame.
+    std::vector<PackedParticle> mPackedStaging;
+    // Particles in mPackedBuffer.
+    size_t mNumPacked;
+    // Draws mPackedStaging in software for snapshots, over mSmokeSurface.
+    SplatRenderer mSplatRenderer;
+    // Where to write the next frame's snapshot; empty when none is wanted.
+    fs::path mSnapshotPath;
     
     gl::TextureRef					mSmokeTexture;
+    // smoke_blur.png as decoded, kept for mSplatRenderer.
+    Surface8u                       mSmokeSurface;
+    // Decoded and read on AssetLoader's workers; turned into GL objects by finishLoading().
+    std::future<Surface8u>          mSmokeImage;
+    std::future<std::string>        mUpdateSource;
+    std::future<std::pair<std::string, std::string>> mRenderSources;
     
     // Transform Feedback
     
@@ -69,6 +146,11 @@ private:
     gl::VaoRef		mAttributes[2];
     // Buffers holding raw particle data on GPU.
     gl::VboRef		mParticleBuffer[2];
+    // What the CPU backend draws from; transform feedback can only write the float layout.
+    gl::VaoRef		mPackedAttributes;
+    gl::VboRef		mPackedBuffer;
+    // Particles each buffer holds; follows mPool.getCapacity().
+    size_t          mBufferCapacity     = 0;
     
     // Current source and destination buffers for transform feedback.
     // Source and destination are swapped each frame after update.
@@ -77,73 +159,227 @@ private:
 
     // ~Transform Feedback
     
-    void loadTexture();
+    //! Queues the texture and shader sources on the AssetLoader.
+    void loadAssets();
+    //! Creates the texture and programs whose data has arrived; true once all of them exist.
+    bool finishLoading();
+    bool isLoaded() const { return mSmokeTexture && mUpdateProg && mRenderProg; }
+    //! (Re)creates both buffers and their layouts at capacity, keeping the source buffer's particles.
+    void setupBuffers( size_t capacity );
+    //! Points the attribute locations at the currently bound buffer, in the given layout.
+    void describeParticles( ParticleAttribute const * attributes, size_t stride );
+    //! Grows the steady population to numParticles, making the new particles across threads.
+    void addBaseParticles( size_t numParticles );
+    //! Throws out a burst of short-lived particles around a random point.
+    void emitBurst( int group, double now );
+    //! Follows the pool's capacity and hands its queued writes to whichever backend is running.
+    void syncPool();
+    //! One fixed step of particleUpdate.vs at time uTime, dt2 long squared, through transform feedback.
+    void stepOnGpu( float time, float dt2, float activity );
+    //! Uploads the CPU simulation's latest state for drawing with the current matrices, culled
+    //! unless culling is off; pointScale is render.vs's uPointScale.
+    void uploadFromCpu( float pointScale );
+    //! Draws what uploadFromCpu() last uploaded with mSplatRenderer, as draw() is about to draw it,
+    //! and writes it to mSnapshotPath.
+    void writeSnapshot( mat4 const & viewProjection, float pointScale );
+    //! Strength of the scheduled beat pulse right now, in the same range as detected beats.
+    float getBeatPulse() const;
 };
 
 SceneComponent::SceneComponent( App * app ) :
     mIsFullscreen( false ),
+    mPredictBeats( true ),
     mApp( app ),
-    mNumGroups( 4 )
+    mBackend( SimulationBackend::GPU ),
+    mCachedNoise( false ),
+    mCulling( true ),
+    mTimestep( DEFAULT_STEP_RATE ),
+    mLastFrameTime( -1.0 ),
+    mNumGroups( 4 ),
+    mNumParticles( DEFAULT_NUM_PARTICLES ),
+    mNumBursts( 0 ),
+    mNumPacked( 0 )
 {
 }
 
-void SceneComponent::loadTexture()
+void SceneComponent::loadAssets()
 {
-    gl::Texture::Format mTextureFormat;
-    mTextureFormat.magFilter( GL_LINEAR ).minFilter( GL_LINEAR ).mipmap().internalFormat( GL_RGBA );
-    mSmokeTexture = gl::Texture::create( loadImage( loadAsset( "smoke_blur.png" ) ), mTextureFormat );
+    // Assets are looked up here, so a missing one still fails at startup; reading and decoding happen on the workers.
+    AssetLoader & loader = AssetLoader::instance();
+    DataSourceRef smoke = loadAsset( "smoke_blur.png" );
+    this->mSmokeImage = loader.load<Surface8u>( "smoke_blur.png", [smoke] { return Surface8u( loadImage( smoke ) ); } );
+    DataSourceRef update = loadAsset( "particleUpdate.vs" );
+    this->mUpdateSource = loader.load<std::string>( "particleUpdate.vs", [update] { return loadString( update ); } );
+    DataSourceRef vertex = loadAsset( "render.vs" );
+    DataSourceRef fragment = loadAsset( "render.fs" );
+    this->mRenderSources = loader.load<std::pair<std::string, std::string>>( "render.vs + render.fs", [vertex, fragment]
+    {
+        return std::make_pair( loadString( vertex ), loadString( fragment ) );
+    } );
 }
 
-void SceneComponent::setVolume( float volume )
+bool SceneComponent::finishLoading()
 {
-    this->mVolume = volume;
+    AssetLoader & loader = AssetLoader::instance();
+    if( !mSmokeTexture && AssetLoader::isReady( this->mSmokeImage ) )
+    {
+        mSmokeTexture = loader.finalize( "smoke_blur.png", [this]
+        {
+            gl::Texture::Format mTextureFormat;
+            mTextureFormat.magFilter( GL_LINEAR ).minFilter( GL_LINEAR ).mipmap().internalFormat( GL_RGBA );
+            this->mSmokeSurface = this->mSmokeImage.get();
+            return gl::Texture::create( this->mSmokeSurface, mTextureFormat );
+        } );
+    }
+    
+    // Load our update program.
+    // Match up our attribute locations with the description we gave.
+    if( !mUpdateProg && AssetLoader::isReady( this->mUpdateSource ) )
+    {
+        mUpdateProg = loader.finalize( "particleUpdate.vs", [this]
+        {
+            return gl::GlslProg::create( gl::GlslProg::Format().vertex( this->mUpdateSource.get() )
+                .feedbackFormat( GL_INTERLEAVED_ATTRIBS )
+                .feedbackVaryings( { "position", "pposition", "home", "color", "damping", "groupId", "size" } )
+                                               .attribLocation( "iPosition", 0 )
+                                               .attribLocation( "iPPosition", 1 )
+                                               .attribLocation( "iHome", 2 )
+                                               .attribLocation( "iColor", 3 )
+                                               .attribLocation( "iDamping", 4 )
+                                               .attribLocation( "iGroupId", 5 )
+                                               .attribLocation( "iSize", 6 )
+                );
+        } );
+    }
+    
+    // Load our render program.
+    // mRenderProg = gl::getStockShader( gl::ShaderDef().color() );
+    if( !mRenderProg && AssetLoader::isReady( this->mRenderSources ) )
+    {
+        mRenderProg = loader.finalize( "render.vs + render.fs", [this]
+        {
+            std::pair<std::string, std::string> sources = this->mRenderSources.get();
+            return gl::GlslProg::create( gl::GlslProg::Format()
+                                               .vertex( sources.first )
+                                               .feedbackFormat( GL_INTERLEAVED_ATTRIBS )
+                                               .feedbackVaryings( { "position", "pposition", "home", "color", "damping", "groupId", "size" } )
+                                               .attribLocation( "iPosition", 0 )
+                                               .attribLocation( "iPPosition", 1 )
+                                               .attribLocation( "iHome", 2 )
+                                               .attribLocation( "iColor", 3 )
+                                               .attribLocation( "iDamping", 4 )
+                                               .attribLocation( "iGroupId", 5 )
+                                               .attribLocation( "iSize", 6 )
+                                               .fragment( sources.second ) );
+        } );
+    }
+    
+    return this->isLoaded();
 }
 
-void SceneComponent::setBeats( const std::vector<float> & beats )
+void SceneComponent::setAudio( std::shared_ptr<AudioComponent> const & audio )
 {
-    this->mBeats.assign( beats.begin(), beats.end() );
+    this->mAudio = audio;
 }
 
-void SceneComponent::setMagSpectrum( const std::vector<float> &spectrum )
+void SceneComponent::setBackend( SimulationBackend backend )
 {
-    this->mMagSpectrum.assign( spectrum.begin(), spectrum.end() );
+    if( backend == SimulationBackend::CPU && !this->mSimulator )
+    {
+        this->mSimulator.reset( new ParticleSimulator() );
+        this->mSimulator->setCachedNoise( this->mCachedNoise );
+    }
+    // Hand the latest state over at full precision, whichever way we're switching.
+    if( backend != this->mBackend && this->mParticleBuffer[ mSourceIndex ] )
+    {
+        this->syncPool();
+        this->mStaging.resize( this->mPool.getExtent() );
+        if( backend == SimulationBackend::CPU )
+        {
+            this->mParticleBuffer[ mSourceIndex ]->getBufferSubData( 0, this->mStaging.size() * sizeof(Particle), this->mStaging.data() );
+            this->mSimulator->reserve( this->mPool.getCapacity() );
+            this->mSimulator->load( this->mStaging.data(), this->mStaging.size() );
+        }
+        else
+        {
+            this->mSimulator->store( this->mStaging.data() );
+            this->mParticleBuffer[ mSourceIndex ]->bufferSubData( 0, this->mStaging.size() * sizeof(Particle), this->mStaging.data() );
+        }
+    }
+    this->mBackend = backend;
 }
 
-void SceneComponent::setup()
+void SceneComponent::setCachedNoise( bool cached )
 {
-    loadTexture();
+    this->mCachedNoise = cached;
+    if( this->mSimulator )
+    {
+        this->mSimulator->setCachedNoise( cached );
+    }
+}
+
+void SceneComponent::setNumParticles( size_t numParticles )
+{
+    this->mNumParticles = numParticles;
+    // Before setup() there is nothing to change yet.
+    if( !this->mParticleBuffer[ mSourceIndex ] ) { return; }
     
-    // Create initial particle layout.
-    std::vector<Particle> particles;
-    particles.assign( NUM_PARTICLES, Particle() );
-    vec3 center = vec3( 0, 0, 0 );
+    this->addBaseParticles( numParticles );
+    while( this->mBaseSlots.size() > numParticles )
+    {
+        this->mPool.kill( this->mBaseSlots.back() );
+        this->mBaseSlots.pop_back();
+    }
+}
+
+void SceneComponent::addBaseParticles( size_t numParticles )
+{
+    if( this->mBaseSlots.size() >= numParticles ) { return; }
     
-    int groupSize = particles.size() / this->mNumGroups;
-    for( int i = 0, j = 0; i < particles.size(); ++i )
+    // New particles go where the window is now; the ones already out keep their homes.
+    this->mFactory.setLayout( this->mApp->getWindowWidth(), this->mApp->getWindowHeight(), this->mNumGroups );
+    const size_t first = this->mBaseSlots.size();
+    std::vector<Particle> particles( numParticles - first );
     {
-        if( i > 0 && i % groupSize == 0 ) { ++j; }
-        
-        // assign starting values to particles.
-        float x = Rand::randFloat() * this->mApp->getWindowWidth(); //
-        float y = Rand::randFloat() * this->mApp->getWindowHeight(); //
-        float z = 0;
-        
-        auto &p = particles.at( i );
-        p.groupId = j;
-        p.pos = center + vec3( x, y, z );
-        p.home = p.pos;
-        p.ppos = p.home + ( Rand::randVec3() ); // random initial velocity
-        p.damping = Rand::randFloat( 0.7f, 0.95f ); // 0.965f, 0.985f );
-        p.size = Rand::randFloat( 2.0f, 64.0f );
-        float hue = lmap<float>( ( (float)j / (float)this->mNumGroups ), 0.0f, (float)this->mNumGroups, 0.14f, 0.4f );
-        p.color = Color( CM_HSV, hue, 1.0f, math<float>::clamp( 32.0f / p.size ) );
+        // Only kept for the layout, which happens at setup and when the population grows.
+        ThreadPool threads;
+        this->mFactory.makeParticles( first, particles.size(), particles.data(), threads );
+    }
+    for( Particle const & particle : particles )
+    {
+        this->mBaseSlots.push_back( this->mPool.emit( particle ) );
     }
+}
+
+void SceneComponent::emitBurst( int group, double now )
+{
+    this->mFactory.setLayout( this->mApp->getWindowWidth(), this->mApp->getWindowHeight(), this->mNumGroups );
+    const std::uint64_t burst = this->mNumBursts++;
+    vec3 center = this->mFactory.makeBurstCenter( burst );
+    for( size_t i = 0; i < BURST_SIZE; ++i )
+    {
+        float lifetime;
+        Particle p = this->mFactory.makeBurstParticle( burst, i, group, center, BURST_RADIUS, lifetime );
+        this->mPool.emit( p, now, BURST_LIFETIME * lifetime );
+    }
+}
+
+void SceneComponent::setupBuffers( size_t capacity )
+{
+    gl::VboRef source = gl::Vbo::create( GL_ARRAY_BUFFER, capacity * sizeof(Particle), nullptr, GL_DYNAMIC_DRAW );
+    gl::VboRef destination = gl::Vbo::create( GL_ARRAY_BUFFER, capacity * sizeof(Particle), nullptr, GL_DYNAMIC_DRAW );
+    
+    // Only the source buffer is current; the destination is rewritten by the next update.
+    if( this->mParticleBuffer[ mSourceIndex ] )
+    {
+        gl::ScopedBuffer read( GL_COPY_READ_BUFFER, this->mParticleBuffer[ mSourceIndex ]->getId() );
+        gl::ScopedBuffer write( GL_COPY_WRITE_BUFFER, source->getId() );
+        glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, std::min( capacity, this->mBufferCapacity ) * sizeof(Particle) );
+    }
+    mParticleBuffer[mSourceIndex] = source;
+    mParticleBuffer[mDestinationIndex] = destination;
+    this->mBufferCapacity = capacity;
     
-    // Create particle buffers on GPU and copy data into the first buffer.
-    // Mark as static since we only write from the CPU once.
-    mParticleBuffer[mSourceIndex] = gl::Vbo::create( GL_ARRAY_BUFFER, particles.size() * sizeof(Particle), particles.data(), GL_STATIC_DRAW );
-    mParticleBuffer[mDestinationIndex] = gl::Vbo::create( GL_ARRAY_BUFFER, particles.size() * sizeof(Particle), nullptr, GL_STATIC_DRAW );
-        
     for( int i = 0; i < 2; ++i )
     {
         // Describe the particle layout for OpenGL.
@@ -152,55 +388,81 @@ void SceneComponent::setup()
         
         // Define attributes as offsets into the bound particle buffer
         gl::ScopedBuffer buffer( mParticleBuffer[i] );
-        gl::enableVertexAttribArray( 0 );
-        gl::enableVertexAttribArray( 1 );
-        gl::enableVertexAttribArray( 2 );
-        gl::enableVertexAttribArray( 3 );
-        gl::enableVertexAttribArray( 4 );
-        gl::enableVertexAttribArray( 5 );
-        gl::enableVertexAttribArray( 6 );
-        gl::vertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, sizeof(Particle), (const GLvoid*)offsetof(Particle, pos) );
-        gl::vertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, sizeof(Particle), (const GLvoid*)offsetof(Particle, ppos) );
-        gl::vertexAttribPointer( 2, 3, GL_FLOAT, GL_FALSE, sizeof(Particle), (const GLvoid*)offsetof(Particle, home) );
-        gl::vertexAttribPointer( 3, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (const GLvoid*)offsetof(Particle, color) );
-        gl::vertexAttribPointer( 4, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), (const GLvoid*)offsetof(Particle, damping) );
-        gl::vertexAttribPointer( 5, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), (const GLvoid*)offsetof(Particle, groupId) );
-        gl::vertexAttribPointer( 6, 1, GL_FLOAT, GL_FALSE, sizeof(Particle), (const GLvoid*)offsetof(Particle, size) );
+        this->describeParticles( PARTICLE_ATTRIBUTES, sizeof(Particle) );
+    }
+}
+
+void SceneComponent::describeParticles( ParticleAttribute const * attributes, size_t stride )
+{
+    for( size_t i = 0; i < NUM_PARTICLE_ATTRIBUTES; ++i )
+    {
+        ParticleAttribute const & attribute = attributes[ i ];
+        GLenum type = GL_FLOAT;
+        switch( attribute.type )
+        {
+            case ParticleAttribute::HALF_FLOAT: type = GL_HALF_FLOAT; break;
+            case ParticleAttribute::UNSIGNED_SHORT: type = GL_UNSIGNED_SHORT; break;
+            case ParticleAttribute::UNSIGNED_BYTE: type = GL_UNSIGNED_BYTE; break;
+            default: break;
+        }
+        gl::enableVertexAttribArray( attribute.location );
+        gl::vertexAttribPointer( attribute.location, attribute.components, type, attribute.normalized ? GL_TRUE : GL_FALSE,
+                                 (GLsizei)stride, (const GLvoid*)attribute.offset );
+    }
+}
+
+void SceneComponent::syncPool()
+{
+    if( this->mPool.getCapacity() != this->mBufferCapacity )
+    {
+        this->setupBuffers( this->mPool.getCapacity() );
     }
     
-    // Load our update program.
-    // Match up our attribute locations with the description we gave.
-    mUpdateProg = gl::GlslProg::create( gl::GlslProg::Format().vertex( loadAsset( "particleUpdate.vs" ) )
-        .feedbackFormat( GL_INTERLEAVED_ATTRIBS )
-        .feedbackVaryings( { "position", "pposition", "home", "color", "damping", "groupId", "size" } )
-                                       .attribLocation( "iPosition", 0 )
-                                       .attribLocation( "iPPosition", 1 )
-                                       .attribLocation( "iHome", 2 )
-                                       .attribLocation( "iColor", 3 )
-                                       .attribLocation( "iDamping", 4 )
-                                       .attribLocation( "iGroupId", 5 )
-                                       .attribLocation( "iSize", 6 )
-        );
+    bool onCpu = this->mBackend == SimulationBackend::CPU;
+    if( onCpu )
+    {
+        this->mSimulator->reserve( this->mPool.getCapacity() );
+        this->mSimulator->resize( this->mPool.getExtent() );
+        this->mPackedStaging.reserve( this->mPool.getCapacity() );
+        this->mPackedStaging.resize( this->mPool.getExtent() );
+    }
+    this->mPool.flush( [&]( size_t first, Particle const * particles, size_t count )
+    {
+        if( onCpu )
+        {
+            this->mSimulator->write( first, particles, count );
+        }
+        else
+        {
+            this->mParticleBuffer[mSourceIndex]->bufferSubData( first * sizeof(Particle), count * sizeof(Particle), particles );
+        }
+    } );
+}
+
+void SceneComponent::setup()
+{
+    // The texture and programs arrive over the first few frames; until then draw() shows a placeholder.
+    this->loadAssets();
     
-    // Load our render program.
-    // mRenderProg = gl::getStockShader( gl::ShaderDef().color() );
-    mRenderProg = gl::GlslProg::create( gl::GlslProg::Format()
-                                       .vertex( loadAsset( "render.vs" ) )
-                                       .feedbackFormat( GL_INTERLEAVED_ATTRIBS )
-                                       .feedbackVaryings( { "position", "pposition", "home", "color", "damping", "groupId", "size" } )
-                                       .attribLocation( "iPosition", 0 )
-                                       .attribLocation( "iPPosition", 1 )
-                                       .attribLocation( "iHome", 2 )
-                                       .attribLocation( "iColor", 3 )
-                                       .attribLocation( "iDamping", 4 )
-                                       .attribLocation( "iGroupId", 5 )
-                                       .attribLocation( "iSize", 6 )
-                                       .fragment( loadAsset( "render.fs" ) ) );
+    // Create initial particle layout. A full setup starts the show over, from the same seed.
+    this->mPool.clear();
+    this->mBaseSlots.clear();
+    this->mNumBursts = 0;
+    this->mTimestep.reset();
+    this->mLastFrameTime = -1.0;
+    this->addBaseParticles( this->mNumParticles );
+    
+    // Create particle buffers on GPU and copy data into the source buffer.
+    mParticleBuffer[mSourceIndex].reset();
+    mParticleBuffer[mDestinationIndex].reset();
+    this->mBufferCapacity = 0;
+    this->syncPool();
 }
 
 void SceneComponent::resize()
 {
-    this->setup();
+    // Nothing to rebuild: homes scale with the windowSize uniform and draw() sets the matrices from
+    // the window every frame, so the particles just drift over to their new spots.
 }
 
 void SceneComponent::keyDown( KeyEvent event )
@@ -210,26 +472,161 @@ void SceneComponent::keyDown( KeyEvent event )
         this->mIsFullscreen = !this->mIsFullscreen;
         setFullScreen( this->mIsFullscreen );
     }
+    else if( event.getCode() == KeyEvent::KEY_t )
+    {
+        this->mPredictBeats = !this->mPredictBeats;
+    }
+    else if( event.getCode() == KeyEvent::KEY_s )
+    {
+        this->setBackend( this->mBackend == SimulationBackend::GPU ? SimulationBackend::CPU : SimulationBackend::GPU );
+        console() << "Simulating on the " << ( this->mBackend == SimulationBackend::GPU ? "GPU" : "CPU" ) << std::endl;
+    }
+    else if( event.getCode() == KeyEvent::KEY_EQUALS || event.getCode() == KeyEvent::KEY_MINUS )
+    {
+        size_t count = event.getCode() == KeyEvent::KEY_EQUALS ? this->mNumParticles * 2 : std::max<size_t>( this->mNumParticles / 2, 1 );
+        this->setNumParticles( count );
+        console() << "Particles: " << this->mNumParticles << " (pool capacity " << this->mPool.getCapacity() << ")" << std::endl;
+    }
+    else if( event.getCode() == KeyEvent::KEY_v )
+    {
+        this->setCulling( !this->mCulling );
+        ParticleCuller::Stats const & stats = this->getCullStats();
+        console() << "Culling " << ( this->mCulling ? "on" : "off" ) << "; last culled frame drew " << stats.numDrawn << " of "
+            << stats.numParticles << ": " << stats.numOutside << " outside the view, " << stats.numSubPixel << " under "
+            << this->mCuller.getMinPixelSize() << " px, " << stats.numMerged << " thinned out, " << stats.numEmpty << " empty slots" << std::endl;
+    }
+    else if( event.getCode() == KeyEvent::KEY_p )
+    {
+        if( this->mBackend == SimulationBackend::CPU )
+        {
+            this->requestSnapshot( getDocumentsDirectory() / ( "Fireflies " + toString( getElapsedFrames() ) + ".png" ) );
+        }
+        else
+        {
+            console() << "Snapshots are drawn from the CPU simulation; switch to it with s first" << std::endl;
+        }
+    }
+}
+
+float SceneComponent::getBeatPulse() const
+{
+    float bpm = this->mAudio->getBpm();
+    if( !this->mPredictBeats || bpm <= 0.0f || this->mAudio->getTempoConfidence() < MIN_TEMPO_CONFIDENCE ) { return 0.0f; }
+    
+    // Extrapolate from the latest prediction to now, so the pulse lands on the beat instead of a block
+    // and a frame after it.
+    double period = 60.0 / bpm;
+    double sinceBeat = std::fmod( this->mAudio->getAudioTime() - this->mAudio->getNextBeatTime(), period );
+    if( sinceBeat < 0.0 ) { sinceBeat += period; }
+    return 0.35f * expf( -static_cast<float>( sinceBeat ) / PULSE_DECAY );
 }
 
 void SceneComponent::update()
 {
-    // Update particles on the GPU
-    gl::ScopedGlslProg prog( mUpdateProg );
-    gl::ScopedState rasterizer( GL_RASTERIZER_DISCARD, true );	// turn off fragment stage
+    if( !this->finishLoading() ) { return; }
     
-    static float uTime = 0.0f;
-    uTime += ( 1.0f / 60.0f ) * 0.001f;
-    mUpdateProg->uniform( "uTime", uTime );
+    // However long the frame took, the simulation catches up in fixed steps.
+    double now = getElapsedSeconds();
+    const double frameSeconds = this->mLastFrameTime < 0.0 ? 0.0 : now - this->mLastFrameTime;
+    this->mLastFrameTime = now;
     
+    std::vector<float> const & beats = this->mAudio->getBeats();
+    this->mBeats.assign( beats.begin(), beats.begin() + std::min<size_t>( beats.size(), this->mNumGroups ) );
+    float pulse = this->getBeatPulse();
     for( int i = 0; i < this->mBeats.size(); ++i )
     {
-        this->mBeats[ i ] = this->mBeats[ i ] + 0.1f;
+        this->mBeats[ i ] = std::max( this->mBeats[ i ], pulse ) + 0.1f;
     }
-    mUpdateProg->uniform( "beats", this->mBeats.data(), this->mBeats.size() );
     
-    float activity = powf( lmap<float>( this->mVolume, 0.0f, 1.0f, 0.1f, 10.0f ), 2.0f );
+    float activity = powf( lmap<float>( this->mAudio->getVolume(), 0.0f, 1.0f, 0.1f, 10.0f ), 2.0f );
+    LatencyProbe::instance().mark( LatencyProbe::SCENE_UPDATE, this->mAudio->getAnalysisSampleTime() );
+    
+    // Retire old bursts and start new ones on each group's rising beat, then bring the buffers up to date.
+    this->mPool.expire( now );
+    this->mPreviousBeats.resize( this->mBeats.size(), 0.0f );
+    for( int i = 0; i < this->mBeats.size(); ++i )
+    {
+        if( this->mBeats[ i ] - 0.1f >= BURST_THRESHOLD && this->mPreviousBeats[ i ] - 0.1f < BURST_THRESHOLD )
+        {
+            this->emitBurst( i, now );
+        }
+        this->mPreviousBeats[ i ] = this->mBeats[ i ];
+    }
+    this->syncPool();
+    
+    // This frame's audio drives every step it runs.
+    const std::uint64_t firstStep = this->mTimestep.getNumSteps();
+    const size_t numSteps = this->mTimestep.advance( frameSeconds );
+    const float dt2 = static_cast<float>( 1.0 / ( this->mTimestep.getStepRate() * this->mTimestep.getStepRate() ) );
+    for( size_t i = 0; i < numSteps; ++i )
+    {
+        const float time = static_cast<float>( this->mTimestep.getStepTime( firstStep + i ) * NOISE_TIME_SCALE );
+        if( this->mBackend == SimulationBackend::CPU )
+        {
+            this->mSimulator->step( time, dt2, activity, this->mBeats.data(), this->mBeats.size(), getWindowWidth(), getWindowHeight() );
+        }
+        else
+        {
+            this->stepOnGpu( time, dt2, activity );
+            // Swap source and destination for the next step
+            std::swap( mSourceIndex, mDestinationIndex );
+        }
+    }
+}
+
+void SceneComponent::uploadFromCpu( float pointScale )
+{
+    if( !this->mPackedBuffer )
+    {
+        this->mPackedBuffer = gl::Vbo::create( GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW );
+        this->mPackedAttributes = gl::Vao::create();
+        gl::ScopedVao vao( this->mPackedAttributes );
+        gl::ScopedBuffer buffer( this->mPackedBuffer );
+        this->describeParticles( PACKED_PARTICLE_ATTRIBUTES, sizeof(PackedParticle) );
+    }
+    
+    // Every frame, not just those that step: syncPool() may have written new particles, and the
+    // interpolation and the camera move on between steps.
+    if( this->mCulling )
+    {
+        const mat4 viewProjection = gl::getModelViewProjection();
+        this->mCuller.setView( &viewProjection[ 0 ][ 0 ], pointScale );
+        this->mNumPacked = this->mCuller.cull( *this->mSimulator, this->mTimestep.getAlpha(), this->mPackedStaging.data(), this->mSimulator->getThreadPool() );
+    }
+    else
+    {
+        this->mSimulator->store( this->mPackedStaging.data() );
+        this->mNumPacked = this->mSimulator->getNumParticles();
+    }
+    // Respecifying the whole store orphans last frame's copy instead of waiting for its draw to finish.
+    this->mPackedBuffer->bufferData( this->mNumPacked * sizeof(PackedParticle), this->mPackedStaging.data(), GL_STREAM_DRAW );
+}
+
+void SceneComponent::writeSnapshot( mat4 const & viewProjection, float pointScale )
+{
+    this->mSplatRenderer.setSize( getWindowWidth(), getWindowHeight() );
+    this->mSplatRenderer.setSprite( this->mSmokeSurface );
+    this->mSplatRenderer.setView( &viewProjection[ 0 ][ 0 ], pointScale );
+    this->mSplatRenderer.render( this->mPackedStaging.data(), this->mNumPacked, this->mTimestep.getAlpha(), this->mSimulator->getThreadPool() );
+    Surface8u surface( getWindowWidth(), getWindowHeight(), false );
+    this->mSplatRenderer.copyTo( surface );
+    writeImage( this->mSnapshotPath, surface );
+    console() << "Wrote " << this->mSnapshotPath << ": " << this->mSplatRenderer.getNumSprites() << " sprites, "
+        << this->mSplatRenderer.getNumFragments() << " fragments" << std::endl;
+    this->mSnapshotPath.clear();
+}
+
+void SceneComponent::stepOnGpu( float time, float dt2, float activity )
+{
+    // Update particles on the GPU
+    gl::ScopedGlslProg prog( mUpdateProg );
+    gl::ScopedState rasterizer( GL_RASTERIZER_DISCARD, true );	// turn off fragment stage
+    
+    mUpdateProg->uniform( "uTime", time );
+    mUpdateProg->uniform( "dt2", dt2 );
+    mUpdateProg->uniform( "beats", this->mBeats.data(), this->mBeats.size() );
     mUpdateProg->uniform( "activity", activity );
+    mUpdateProg->uniform( "windowSize", vec2( getWindowSize() ) );
     
     // Bind the source data (Attributes refer to specific buffers).
     gl::ScopedVao source( mAttributes[mSourceIndex] );
@@ -238,12 +635,9 @@ void SceneComponent::update()
     gl::beginTransformFeedback( GL_POINTS );
     
     // Draw source into destination, performing our vertex transformations.
-    gl::drawArrays( GL_POINTS, 0, NUM_PARTICLES );
+    gl::drawArrays( GL_POINTS, 0, this->mPool.getExtent() );
     
     gl::endTransformFeedback();
-    
-    // Swap source and destination for next loop
-    std::swap( mSourceIndex, mDestinationIndex );
 }
 
 void SceneComponent::draw()
@@ -252,14 +646,40 @@ void SceneComponent::draw()
     gl::setMatricesWindowPersp( getWindowSize() );
     gl::enableAlphaBlending();
     
-    gl::ScopedVao           vao( mAttributes[mSourceIndex] );
+    if( !this->isLoaded() )
+    {
+        // Still loading: a slow pulse in the middle of the window.
+        gl::ScopedColor color( ColorA( 1.0f, 0.8f, 0.2f, 0.5f + 0.5f * sinf( getElapsedSeconds() * 4.0f ) ) );
+        gl::drawSolidCircle( getWindowCenter(), 6.0f );
+        return;
+    }
+    
+    // How far setMatricesWindowPersp() puts the eye from the window's plane, with its 60 degree field
+    // of view: particles there, where their homes are, are drawn their size in pixels.
+    const float pointScale = getWindowHeight() * 0.5f / tanf( toRadians( 30.0f ) );
+    const bool onCpu = this->mBackend == SimulationBackend::CPU;
+    if( onCpu )
+    {
+        this->uploadFromCpu( pointScale );
+        if( !this->mSnapshotPath.empty() )
+        {
+            this->writeSnapshot( gl::getModelViewProjection(), pointScale );
+        }
+    }
+    
+    gl::ScopedVao           vao( onCpu ? mPackedAttributes : mAttributes[mSourceIndex] );
     gl::ScopedGlslProg      render( mRenderProg );
     gl::ScopedTextureBind	texScope( mSmokeTexture );
     gl::ScopedBlend			blendScope( GL_SRC_ALPHA, GL_ONE );
     gl::ScopedState         stateScope( GL_PROGRAM_POINT_SIZE, true );
     
+    // Each particle's previous position is the one from the step before, so that's all it takes to draw in between.
+    mRenderProg->uniform( "uAlpha", this->mTimestep.getAlpha() );
+    mRenderProg->uniform( "uPointScale", pointScale );
     gl::context()->setDefaultShaderVars();
-    gl::drawArrays( GL_POINTS, 0, NUM_PARTICLES );
+    gl::drawArrays( GL_POINTS, 0, onCpu ? this->mNumPacked : this->mPool.getExtent() );
+    // Submission, not scan-out: the swap and the display add up to a frame or two more.
+    LatencyProbe::instance().mark( LatencyProbe::DRAW, this->mAudio->getAnalysisSampleTime() );
 }
 
 #endif
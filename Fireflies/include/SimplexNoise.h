@@ -0,0 +1,486 @@
+//
+//  SimplexNoise.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_SimplexNoise_h
+#define AudioVertexDisplacement_SimplexNoise_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "DspKernels.h"
+
+/**
+ CPU port of the noise in particleUpdate.vs (Ashima Arts' textureless simplex and classic Perlin
+ noise, MIT licensed, https://github.com/ashima/webgl-noise). Every step is the shader's, in single
+ precision and in the shader's order of operations, so the CPU simulation follows the GPU one.
+ */
+namespace noise {
+
+//! snoise( vec3( x, y, z ) ) from particleUpdate.vs; roughly [-1, 1].
+float snoise( float x, float y, float z );
+//! cnoise( vec3( x, y, z ) ) from particleUpdate.vs: classic Perlin noise; roughly [-1, 1].
+float cnoise( float x, float y, float z );
+//! pnoise( vec3( x, y, z ), vec3( repX, repY, repZ ) ): classic Perlin noise that repeats every
+//! rep along each axis. The periods should be whole numbers.
+float pnoise( float x, float y, float z, float repX, float repY, float repZ );
+
+namespace detail {
+
+float mod289( float x )
+{
+    return x - std::floor( x * ( 1.0f / 289.0f ) ) * 289.0f;
+}
+
+float permute( float x )
+{
+    return mod289( ( ( x * 34.0f ) + 1.0f ) * x );
+}
+
+float taylorInvSqrt( float r )
+{
+    return 1.79284291400159f - 0.85373472095314f * r;
+}
+
+//! GLSL step( edge, x ).
+float step( float edge, float x )
+{
+    return x < edge ? 0.0f : 1.0f;
+}
+
+//! GLSL fract( x ).
+float fract( float x )
+{
+    return x - std::floor( x );
+}
+
+//! GLSL mod( x, y ).
+float mod( float x, float y )
+{
+    return x - y * std::floor( x / y );
+}
+
+//! GLSL mix( x, y, a ).
+float mix( float x, float y, float a )
+{
+    return x * ( 1.0f - a ) + y * a;
+}
+
+float fade( float t )
+{
+    return t * t * t * ( t * ( t * 6.0f - 15.0f ) + 10.0f );
+}
+
+//! What cnoise() and pnoise() share once they have P's lattice cell: its corners pi0 and pi1,
+//! already reduced mod 289.
+float perlin( float const p[ 3 ], float const pi0[ 3 ], float const pi1[ 3 ] );
+
+} // namespace detail
+
+float snoise( float vx, float vy, float vz )
+{
+    using namespace detail;
+    const float Cx = 1.0f / 6.0f;
+    const float Cy = 1.0f / 3.0f;
+
+    // First corner
+    const float s = vx * Cy + vy * Cy + vz * Cy;
+    float ix = std::floor( vx + s );
+    float iy = std::floor( vy + s );
+    float iz = std::floor( vz + s );
+    const float t = ix * Cx + iy * Cx + iz * Cx;
+    const float x0[ 3 ] = { vx - ix + t, vy - iy + t, vz - iz + t };
+
+    // Other corners
+    const float gx = step( x0[ 1 ], x0[ 0 ] );
+    const float gy = step( x0[ 2 ], x0[ 1 ] );
+    const float gz = step( x0[ 0 ], x0[ 2 ] );
+    const float lx = 1.0f - gx;
+    const float ly = 1.0f - gy;
+    const float lz = 1.0f - gz;
+    const float i1[ 3 ] = { std::min( gx, lz ), std::min( gy, lx ), std::min( gz, ly ) };
+    const float i2[ 3 ] = { std::max( gx, lz ), std::max( gy, lx ), std::max( gz, ly ) };
+
+    // Offsets of the four corners, rows x0 to x3.
+    float corners[ 4 ][ 3 ];
+    for( int c = 0; c < 3; ++c )
+    {
+        corners[ 0 ][ c ] = x0[ c ];
+        corners[ 1 ][ c ] = x0[ c ] - i1[ c ] + Cx;
+        corners[ 2 ][ c ] = x0[ c ] - i2[ c ] + Cy;
+        corners[ 3 ][ c ] = x0[ c ] - 0.5f;
+    }
+
+    // Permutations
+    ix = mod289( ix );
+    iy = mod289( iy );
+    iz = mod289( iz );
+    const float ox[ 4 ] = { 0.0f, i1[ 0 ], i2[ 0 ], 1.0f };
+    const float oy[ 4 ] = { 0.0f, i1[ 1 ], i2[ 1 ], 1.0f };
+    const float oz[ 4 ] = { 0.0f, i1[ 2 ], i2[ 2 ], 1.0f };
+
+    // Gradients: 7x7 points over a square, mapped onto an octahedron.
+    const float n_ = 0.142857142857f;
+    const float nsx = n_ * 2.0f;
+    const float nsy = n_ * 0.5f - 1.0f;
+    const float nsz = n_;
+
+    float result = 0.0f;
+    for( int k = 0; k < 4; ++k )
+    {
+        const float p = permute( permute( permute( iz + oz[ k ] ) + iy + oy[ k ] ) + ix + ox[ k ] );
+        const float j = p - 49.0f * std::floor( p * nsz * nsz );
+        const float x_ = std::floor( j * nsz );
+        const float y_ = std::floor( j - 7.0f * x_ );
+        const float x = x_ * nsx + nsy;
+        const float y = y_ * nsx + nsy;
+        const float h = 1.0f - std::fabs( x ) - std::fabs( y );
+        const float sh = -step( h, 0.0f );
+
+        float gradient[ 3 ] = {
+            x + ( std::floor( x ) * 2.0f + 1.0f ) * sh,
+            y + ( std::floor( y ) * 2.0f + 1.0f ) * sh,
+            h };
+        const float norm = taylorInvSqrt( gradient[ 0 ] * gradient[ 0 ] + gradient[ 1 ] * gradient[ 1 ] + gradient[ 2 ] * gradient[ 2 ] );
+        gradient[ 0 ] *= norm;
+        gradient[ 1 ] *= norm;
+        gradient[ 2 ] *= norm;
+
+        // Mix final noise value
+        const float * corner = corners[ k ];
+        float m = std::max( 0.6f - ( corner[ 0 ] * corner[ 0 ] + corner[ 1 ] * corner[ 1 ] + corner[ 2 ] * corner[ 2 ] ), 0.0f );
+        m = m * m;
+        result += ( m * m ) * ( gradient[ 0 ] * corner[ 0 ] + gradient[ 1 ] * corner[ 1 ] + gradient[ 2 ] * corner[ 2 ] );
+    }
+    return 42.0f * result;
+}
+
+float detail::perlin( float const p[ 3 ], float const pi0[ 3 ], float const pi1[ 3 ] )
+{
+    float pf0[ 3 ], pf1[ 3 ];
+    for( int c = 0; c < 3; ++c )
+    {
+        pf0[ c ] = fract( p[ c ] );
+        pf1[ c ] = pf0[ c ] - 1.0f;
+    }
+
+    // The shader takes the corners four at a time; per corner the steps are the same. Corner
+    // dx + 2 * dy + 4 * dz is the shader's n000, n100, n010, n110, n001, ... in that order.
+    float n[ 8 ];
+    for( int corner = 0; corner < 8; ++corner )
+    {
+        const int dx = corner & 1, dy = ( corner >> 1 ) & 1, dz = corner >> 2;
+        const float hash = permute( permute( permute( dx ? pi1[ 0 ] : pi0[ 0 ] ) + ( dy ? pi1[ 1 ] : pi0[ 1 ] ) ) + ( dz ? pi1[ 2 ] : pi0[ 2 ] ) );
+
+        float gx = hash * ( 1.0f / 7.0f );
+        float gy = fract( std::floor( gx ) * ( 1.0f / 7.0f ) ) - 0.5f;
+        gx = fract( gx );
+        const float gz = 0.5f - std::fabs( gx ) - std::fabs( gy );
+        const float sz = step( gz, 0.0f );
+        gx -= sz * ( step( 0.0f, gx ) - 0.5f );
+        gy -= sz * ( step( 0.0f, gy ) - 0.5f );
+
+        const float norm = taylorInvSqrt( gx * gx + gy * gy + gz * gz );
+        n[ corner ] = ( gx * norm ) * ( dx ? pf1[ 0 ] : pf0[ 0 ] ) + ( gy * norm ) * ( dy ? pf1[ 1 ] : pf0[ 1 ] ) + ( gz * norm ) * ( dz ? pf1[ 2 ] : pf0[ 2 ] );
+    }
+
+    const float fx = fade( pf0[ 0 ] ), fy = fade( pf0[ 1 ] ), fz = fade( pf0[ 2 ] );
+    float nz[ 4 ];
+    for( int i = 0; i < 4; ++i )
+    {
+        nz[ i ] = mix( n[ i ], n[ i + 4 ], fz );
+    }
+    return 2.2f * mix( mix( nz[ 0 ], nz[ 2 ], fy ), mix( nz[ 1 ], nz[ 3 ], fy ), fx );
+}
+
+float cnoise( float x, float y, float z )
+{
+    using namespace detail;
+    const float p[ 3 ] = { x, y, z };
+    float pi0[ 3 ], pi1[ 3 ];
+    for( int c = 0; c < 3; ++c )
+    {
+        pi0[ c ] = std::floor( p[ c ] );
+        pi1[ c ] = mod289( pi0[ c ] + 1.0f );
+        pi0[ c ] = mod289( pi0[ c ] );
+    }
+    return perlin( p, pi0, pi1 );
+}
+
+float pnoise( float x, float y, float z, float repX, float repY, float repZ )
+{
+    using namespace detail;
+    const float p[ 3 ] = { x, y, z };
+    const float rep[ 3 ] = { repX, repY, repZ };
+    float pi0[ 3 ], pi1[ 3 ];
+    for( int c = 0; c < 3; ++c )
+    {
+        pi0[ c ] = mod( std::floor( p[ c ] ), rep[ c ] );
+        pi1[ c ] = mod289( mod( pi0[ c ] + 1.0f, rep[ c ] ) );
+        pi0[ c ] = mod289( pi0[ c ] );
+    }
+    return perlin( p, pi0, pi1 );
+}
+
+} // namespace noise
+
+namespace kernels {
+
+//! out[i] = noise::snoise( x[i], y[i], z[i] ) for i < count, four or eight points at a time, to the bit.
+void snoise( float const * x, float const * y, float const * z, float * out, size_t count );
+//! out[i] = noise::cnoise( x[i], y[i], z[i] ) for i < count, likewise.
+void cnoise( float const * x, float const * y, float const * z, float * out, size_t count );
+
+namespace detail {
+
+void snoiseScalar( float const * x, float const * y, float const * z, float * out, size_t count )
+{
+    for( size_t i = 0; i < count; ++i )
+    {
+        out[ i ] = noise::snoise( x[ i ], y[ i ], z[ i ] );
+    }
+}
+
+void cnoiseScalar( float const * x, float const * y, float const * z, float * out, size_t count )
+{
+    for( size_t i = 0; i < count; ++i )
+    {
+        out[ i ] = noise::cnoise( x[ i ], y[ i ], z[ i ] );
+    }
+}
+
+#if DSP_KERNELS_X86
+
+// One point per lane. The helpers are overloaded for __m128 and __m256 so the bodies below can be
+// written once for both; each matches the scalar operation it stands for bit for bit (min and max
+// keep std::min and std::max's choice of operand, floor keeps the sign of -0).
+namespace lanes {
+
+inline __m128 add( __m128 a, __m128 b ) { return _mm_add_ps( a, b ); }
+inline __m128 sub( __m128 a, __m128 b ) { return _mm_sub_ps( a, b ); }
+inline __m128 mul( __m128 a, __m128 b ) { return _mm_mul_ps( a, b ); }
+inline __m128 min( __m128 a, __m128 b ) { return _mm_min_ps( b, a ); }
+inline __m128 max( __m128 a, __m128 b ) { return _mm_max_ps( b, a ); }
+inline __m128 neg( __m128 a ) { return _mm_xor_ps( a, _mm_set1_ps( -0.0f ) ); }
+inline __m128 abs( __m128 a ) { return _mm_andnot_ps( _mm_set1_ps( -0.0f ), a ); }
+//! GLSL step( edge, x ).
+inline __m128 step( __m128 edge, __m128 x ) { return _mm_andnot_ps( _mm_cmplt_ps( x, edge ), _mm_set1_ps( 1.0f ) ); }
+
+//! SSE2 has no floor: truncate, step down where that rounded up, and leave alone anything too
+//! big to have a fraction (or NaN).
+inline __m128 floor( __m128 x )
+{
+    const __m128 truncated = _mm_cvtepi32_ps( _mm_cvttps_epi32( x ) );
+    const __m128 floored = _mm_sub_ps( truncated, _mm_and_ps( _mm_cmpgt_ps( truncated, x ), _mm_set1_ps( 1.0f ) ) );
+    const __m128 whole = _mm_cmpnlt_ps( abs( x ), _mm_set1_ps( 8388608.0f ) );
+    return _mm_or_ps( _mm_or_ps( _mm_and_ps( whole, x ), _mm_andnot_ps( whole, floored ) ), _mm_and_ps( x, _mm_set1_ps( -0.0f ) ) );
+}
+
+inline __m128 mod289( __m128 x ) { return _mm_sub_ps( x, _mm_mul_ps( floor( _mm_mul_ps( x, _mm_set1_ps( 1.0f / 289.0f ) ) ), _mm_set1_ps( 289.0f ) ) ); }
+inline __m128 permute( __m128 x ) { return mod289( _mm_mul_ps( _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( 34.0f ) ), _mm_set1_ps( 1.0f ) ), x ) ); }
+inline __m128 taylorInvSqrt( __m128 r ) { return _mm_sub_ps( _mm_set1_ps( 1.79284291400159f ), _mm_mul_ps( _mm_set1_ps( 0.85373472095314f ), r ) ); }
+inline __m128 fract( __m128 x ) { return _mm_sub_ps( x, floor( x ) ); }
+inline __m128 mix( __m128 x, __m128 y, __m128 a ) { return _mm_add_ps( _mm_mul_ps( x, _mm_sub_ps( _mm_set1_ps( 1.0f ), a ) ), _mm_mul_ps( y, a ) ); }
+inline __m128 fade( __m128 t ) { return _mm_mul_ps( _mm_mul_ps( _mm_mul_ps( t, t ), t ), _mm_add_ps( _mm_mul_ps( t, _mm_sub_ps( _mm_mul_ps( t, _mm_set1_ps( 6.0f ) ), _mm_set1_ps( 15.0f ) ) ), _mm_set1_ps( 10.0f ) ) ); }
+
+__attribute__(( target( "avx2" ) )) inline __m256 add( __m256 a, __m256 b ) { return _mm256_add_ps( a, b ); }
+__attribute__(( target( "avx2" ) )) inline __m256 sub( __m256 a, __m256 b ) { return _mm256_sub_ps( a, b ); }
+__attribute__(( target( "avx2" ) )) inline __m256 mul( __m256 a, __m256 b ) { return _mm256_mul_ps( a, b ); }
+__attribute__(( target( "avx2" ) )) inline __m256 min( __m256 a, __m256 b ) { return _mm256_min_ps( b, a ); }
+__attribute__(( target( "avx2" ) )) inline __m256 max( __m256 a, __m256 b ) { return _mm256_max_ps( b, a ); }
+__attribute__(( target( "avx2" ) )) inline __m256 neg( __m256 a ) { return _mm256_xor_ps( a, _mm256_set1_ps( -0.0f ) ); }
+__attribute__(( target( "avx2" ) )) inline __m256 abs( __m256 a ) { return _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), a ); }
+__attribute__(( target( "avx2" ) )) inline __m256 step( __m256 edge, __m256 x ) { return _mm256_andnot_ps( _mm256_cmp_ps( x, edge, _CMP_LT_OQ ), _mm256_set1_ps( 1.0f ) ); }
+__attribute__(( target( "avx2" ) )) inline __m256 floor( __m256 x ) { return _mm256_floor_ps( x ); }
+__attribute__(( target( "avx2" ) )) inline __m256 mod289( __m256 x ) { return _mm256_sub_ps( x, _mm256_mul_ps( _mm256_floor_ps( _mm256_mul_ps( x, _mm256_set1_ps( 1.0f / 289.0f ) ) ), _mm256_set1_ps( 289.0f ) ) ); }
+__attribute__(( target( "avx2" ) )) inline __m256 permute( __m256 x ) { return mod289( _mm256_mul_ps( _mm256_add_ps( _mm256_mul_ps( x, _mm256_set1_ps( 34.0f ) ), _mm256_set1_ps( 1.0f ) ), x ) ); }
+__attribute__(( target( "avx2" ) )) inline __m256 taylorInvSqrt( __m256 r ) { return _mm256_sub_ps( _mm256_set1_ps( 1.79284291400159f ), _mm256_mul_ps( _mm256_set1_ps( 0.85373472095314f ), r ) ); }
+__attribute__(( target( "avx2" ) )) inline __m256 fract( __m256 x ) { return _mm256_sub_ps( x, _mm256_floor_ps( x ) ); }
+__attribute__(( target( "avx2" ) )) inline __m256 mix( __m256 x, __m256 y, __m256 a ) { return _mm256_add_ps( _mm256_mul_ps( x, _mm256_sub_ps( _mm256_set1_ps( 1.0f ), a ) ), _mm256_mul_ps( y, a ) ); }
+__attribute__(( target( "avx2" ) )) inline __m256 fade( __m256 t ) { return _mm256_mul_ps( _mm256_mul_ps( _mm256_mul_ps( t, t ), t ), _mm256_add_ps( _mm256_mul_ps( t, _mm256_sub_ps( _mm256_mul_ps( t, _mm256_set1_ps( 6.0f ) ), _mm256_set1_ps( 15.0f ) ) ), _mm256_set1_ps( 10.0f ) ) ); }
+
+} // namespace lanes
+
+// noise::snoise() on vx, vy, vz, one point per lane of V; leaves the noise in result.
+#define NOISE_SNOISE_LANES( V, SET1, vx, vy, vz, result ) \
+    using namespace lanes; \
+    const V one = SET1( 1.0f ), zero = SET1( 0.0f ); \
+    const V Cx = SET1( 1.0f / 6.0f ), Cy = SET1( 1.0f / 3.0f ); \
+    const V s = add( add( mul( vx, Cy ), mul( vy, Cy ) ), mul( vz, Cy ) ); \
+    V ix = floor( add( vx, s ) ), iy = floor( add( vy, s ) ), iz = floor( add( vz, s ) ); \
+    const V t = add( add( mul( ix, Cx ), mul( iy, Cx ) ), mul( iz, Cx ) ); \
+    const V x0[ 3 ] = { add( sub( vx, ix ), t ), add( sub( vy, iy ), t ), add( sub( vz, iz ), t ) }; \
+    const V gx = step( x0[ 1 ], x0[ 0 ] ), gy = step( x0[ 2 ], x0[ 1 ] ), gz = step( x0[ 0 ], x0[ 2 ] ); \
+    const V lx = sub( one, gx ), ly = sub( one, gy ), lz = sub( one, gz ); \
+    const V i1[ 3 ] = { min( gx, lz ), min( gy, lx ), min( gz, ly ) }; \
+    const V i2[ 3 ] = { max( gx, lz ), max( gy, lx ), max( gz, ly ) }; \
+    V corners[ 4 ][ 3 ]; \
+    for( int c = 0; c < 3; ++c ) \
+    { \
+        corners[ 0 ][ c ] = x0[ c ]; \
+        corners[ 1 ][ c ] = add( sub( x0[ c ], i1[ c ] ), Cx ); \
+        corners[ 2 ][ c ] = add( sub( x0[ c ], i2[ c ] ), Cy ); \
+        corners[ 3 ][ c ] = sub( x0[ c ], SET1( 0.5f ) ); \
+    } \
+    ix = mod289( ix ); \
+    iy = mod289( iy ); \
+    iz = mod289( iz ); \
+    const V ox[ 4 ] = { zero, i1[ 0 ], i2[ 0 ], one }; \
+    const V oy[ 4 ] = { zero, i1[ 1 ], i2[ 1 ], one }; \
+    const V oz[ 4 ] = { zero, i1[ 2 ], i2[ 2 ], one }; \
+    const float n_ = 0.142857142857f; \
+    const V nsx = SET1( n_ * 2.0f ), nsy = SET1( n_ * 0.5f - 1.0f ), nsz = SET1( n_ ); \
+    V result = zero; \
+    for( int k = 0; k < 4; ++k ) \
+    { \
+        const V p = permute( add( add( permute( add( add( permute( add( iz, oz[ k ] ) ), iy ), oy[ k ] ) ), ix ), ox[ k ] ) ); \
+        const V j = sub( p, mul( SET1( 49.0f ), floor( mul( mul( p, nsz ), nsz ) ) ) ); \
+        const V x_ = floor( mul( j, nsz ) ); \
+        const V y_ = floor( sub( j, mul( SET1( 7.0f ), x_ ) ) ); \
+        const V x = add( mul( x_, nsx ), nsy ); \
+        const V y = add( mul( y_, nsx ), nsy ); \
+        const V h = sub( sub( one, abs( x ) ), abs( y ) ); \
+        const V sh = neg( step( h, zero ) ); \
+        V gradient[ 3 ] = { \
+            add( x, mul( add( mul( floor( x ), SET1( 2.0f ) ), one ), sh ) ), \
+            add( y, mul( add( mul( floor( y ), SET1( 2.0f ) ), one ), sh ) ), \
+            h }; \
+        const V r = add( add( mul( gradient[ 0 ], gradient[ 0 ] ), mul( gradient[ 1 ], gradient[ 1 ] ) ), mul( gradient[ 2 ], gradient[ 2 ] ) ); \
+        const V norm = taylorInvSqrt( r ); \
+        gradient[ 0 ] = mul( gradient[ 0 ], norm ); \
+        gradient[ 1 ] = mul( gradient[ 1 ], norm ); \
+        gradient[ 2 ] = mul( gradient[ 2 ], norm ); \
+        V const * corner = corners[ k ]; \
+        V m = max( sub( SET1( 0.6f ), add( add( mul( corner[ 0 ], corner[ 0 ] ), mul( corner[ 1 ], corner[ 1 ] ) ), mul( corner[ 2 ], corner[ 2 ] ) ) ), zero ); \
+        m = mul( m, m ); \
+        result = add( result, mul( mul( m, m ), add( add( mul( gradient[ 0 ], corner[ 0 ] ), mul( gradient[ 1 ], corner[ 1 ] ) ), mul( gradient[ 2 ], corner[ 2 ] ) ) ) ); \
+    } \
+    result = mul( SET1( 42.0f ), result );
+
+// noise::cnoise() on vx, vy, vz, one point per lane of V; leaves the noise in result. The hashes
+// of the x and (x, y) edges are shared between the corners that use them.
+#define NOISE_CNOISE_LANES( V, SET1, vx, vy, vz, result ) \
+    using namespace lanes; \
+    const V one = SET1( 1.0f ), half = SET1( 0.5f ), zero = SET1( 0.0f ), seventh = SET1( 1.0f / 7.0f ); \
+    const V fx0 = floor( vx ), fy0 = floor( vy ), fz0 = floor( vz ); \
+    const V pi[ 2 ][ 3 ] = { { mod289( fx0 ), mod289( fy0 ), mod289( fz0 ) }, \
+                             { mod289( add( fx0, one ) ), mod289( add( fy0, one ) ), mod289( add( fz0, one ) ) } }; \
+    const V pf0[ 3 ] = { sub( vx, fx0 ), sub( vy, fy0 ), sub( vz, fz0 ) }; \
+    const V pf[ 2 ][ 3 ] = { { pf0[ 0 ], pf0[ 1 ], pf0[ 2 ] }, { sub( pf0[ 0 ], one ), sub( pf0[ 1 ], one ), sub( pf0[ 2 ], one ) } }; \
+    const V hx[ 2 ] = { permute( pi[ 0 ][ 0 ] ), permute( pi[ 1 ][ 0 ] ) }; \
+    V hxy[ 4 ]; \
+    for( int c = 0; c < 4; ++c ) \
+    { \
+        hxy[ c ] = permute( add( hx[ c & 1 ], pi[ c >> 1 ][ 1 ] ) ); \
+    } \
+    V n[ 8 ]; \
+    for( int corner = 0; corner < 8; ++corner ) \
+    { \
+        const int dx = corner & 1, dy = ( corner >> 1 ) & 1, dz = corner >> 2; \
+        const V hash = permute( add( hxy[ corner & 3 ], pi[ dz ][ 2 ] ) ); \
+        V gx = mul( hash, seventh ); \
+        V gy = sub( fract( mul( floor( gx ), seventh ) ), half ); \
+        gx = fract( gx ); \
+        const V gz = sub( sub( half, abs( gx ) ), abs( gy ) ); \
+        const V sz = step( gz, zero ); \
+        gx = sub( gx, mul( sz, sub( step( zero, gx ), half ) ) ); \
+        gy = sub( gy, mul( sz, sub( step( zero, gy ), half ) ) ); \
+        const V norm = taylorInvSqrt( add( add( mul( gx, gx ), mul( gy, gy ) ), mul( gz, gz ) ) ); \
+        n[ corner ] = add( add( mul( mul( gx, norm ), pf[ dx ][ 0 ] ), mul( mul( gy, norm ), pf[ dy ][ 1 ] ) ), mul( mul( gz, norm ), pf[ dz ][ 2 ] ) ); \
+    } \
+    const V fx = fade( pf0[ 0 ] ), fy = fade( pf0[ 1 ] ), fz = fade( pf0[ 2 ] ); \
+    V nz[ 4 ]; \
+    for( int c = 0; c < 4; ++c ) \
+    { \
+        nz[ c ] = mix( n[ c ], n[ c + 4 ], fz ); \
+    } \
+    const V result = mul( SET1( 2.2f ), mix( mix( nz[ 0 ], nz[ 2 ], fy ), mix( nz[ 1 ], nz[ 3 ], fy ), fx ) );
+
+void snoiseSse2( float const * x, float const * y, float const * z, float * out, size_t count )
+{
+    size_t i = 0;
+    for( ; i + 4 <= count; i += 4 )
+    {
+        const __m128 vx = _mm_loadu_ps( x + i ), vy = _mm_loadu_ps( y + i ), vz = _mm_loadu_ps( z + i );
+        NOISE_SNOISE_LANES( __m128, _mm_set1_ps, vx, vy, vz, result )
+        _mm_storeu_ps( out + i, result );
+    }
+    snoiseScalar( x + i, y + i, z + i, out + i, count - i );
+}
+
+void cnoiseSse2( float const * x, float const * y, float const * z, float * out, size_t count )
+{
+    size_t i = 0;
+    for( ; i + 4 <= count; i += 4 )
+    {
+        const __m128 vx = _mm_loadu_ps( x + i ), vy = _mm_loadu_ps( y + i ), vz = _mm_loadu_ps( z + i );
+        NOISE_CNOISE_LANES( __m128, _mm_set1_ps, vx, vy, vz, result )
+        _mm_storeu_ps( out + i, result );
+    }
+    cnoiseScalar( x + i, y + i, z + i, out + i, count - i );
+}
+
+__attribute__(( target( "avx2" ) ))
+void snoiseAvx2( float const * x, float const * y, float const * z, float * out, size_t count )
+{
+    size_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    {
+        const __m256 vx = _mm256_loadu_ps( x + i ), vy = _mm256_loadu_ps( y + i ), vz = _mm256_loadu_ps( z + i );
+        NOISE_SNOISE_LANES( __m256, _mm256_set1_ps, vx, vy, vz, result )
+        _mm256_storeu_ps( out + i, result );
+    }
+    snoiseSse2( x + i, y + i, z + i, out + i, count - i );
+}
+
+__attribute__(( target( "avx2" ) ))
+void cnoiseAvx2( float const * x, float const * y, float const * z, float * out, size_t count )
+{
+    size_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    {
+        const __m256 vx = _mm256_loadu_ps( x + i ), vy = _mm256_loadu_ps( y + i ), vz = _mm256_loadu_ps( z + i );
+        NOISE_CNOISE_LANES( __m256, _mm256_set1_ps, vx, vy, vz, result )
+        _mm256_storeu_ps( out + i, result );
+    }
+    cnoiseSse2( x + i, y + i, z + i, out + i, count - i );
+}
+
+#undef NOISE_SNOISE_LANES
+#undef NOISE_CNOISE_LANES
+
+#endif
+
+} // namespace detail
+
+void snoise( float const * x, float const * y, float const * z, float * out, size_t count )
+{
+    switch( getIsa() )
+    {
+#if DSP_KERNELS_X86
+        case Isa::AVX2: detail::snoiseAvx2( x, y, z, out, count ); break;
+        case Isa::SSE2: detail::snoiseSse2( x, y, z, out, count ); break;
+#endif
+        default: detail::snoiseScalar( x, y, z, out, count ); break;
+    }
+}
+
+void cnoise( float const * x, float const * y, float const * z, float * out, size_t count )
+{
+    switch( getIsa() )
+    {
+#if DSP_KERNELS_X86
+        case Isa::AVX2: detail::cnoiseAvx2( x, y, z, out, count ); break;
+        case Isa::SSE2: detail::cnoiseSse2( x, y, z, out, count ); break;
+#endif
+        default: detail::cnoiseScalar( x, y, z, out, count ); break;
+    }
+}
+
+} // namespace kernels
+
+#endif
@@ -0,0 +1,312 @@
+//
+//  SpatialHash.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_SpatialHash_h
+#define AudioVertexDisplacement_SpatialHash_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Particle.h"
+#include "ThreadPool.h"
+
+/**
+ Uniform grid over the particles' x and y, for finding neighbours without testing every pair. z is
+ ignored: the scene is flat, and its z only carries noise. The grid covers fixed bounds (the window,
+ for the app), and a particle's key is its cell's row-major index; particles outside the bounds
+ share the edge cells, which keeps queries exact since clamping never reorders cells.
+
+ rebuild() sorts the particles by key with a parallel, stable radix sort, then records where each
+ cell's run starts. Every pass is linear in the particles plus the cells, and the result doesn't
+ depend on the number of threads: within a cell, particles stay in index order. Positions are
+ copied into sorted order too, so the cells of one grid row are one contiguous run, and a query
+ reads one run per row it spans.
+ */
+class SpatialHash
+{
+public:
+    //! Positions [begin, end) of the sorted order.
+    struct Range
+    {
+        size_t begin;
+        size_t end;
+    };
+
+    //! cellSize should be about the largest radius neighbours are looked for in.
+    explicit SpatialHash( float cellSize = 16.0f );
+
+    //! Both take effect at the next rebuild().
+    void setCellSize( float cellSize ) { this->mCellSize = cellSize; }
+    float getCellSize() const { return this->mCellSize; }
+    //! Area the grid covers, in the particles' units; the app passes the window.
+    void setBounds( float minX, float minY, float maxX, float maxY );
+
+    //! Sorts count particles, at ( x[ i ], y[ i ] ), into cells. ParticleSimulator's POS_X and POS_Y fields fit as they are.
+    void rebuild( float const * x, float const * y, size_t count, ThreadPool & threads );
+    //! The same, from interleaved particles' pos.
+    void rebuild( Particle const * particles, size_t count, ThreadPool & threads );
+
+    size_t getNumParticles() const { return this->mNumParticles; }
+    size_t getNumCells() const { return this->mCellStart.size() - 1; }
+    //! Particle index at each sorted position, and its position, as of the last rebuild().
+    std::uint32_t const * getSortedIndices() const { return this->mIndices.data(); }
+    float const * getSortedX() const { return this->mSortedX.data(); }
+    float const * getSortedY() const { return this->mSortedY.data(); }
+
+    //! Sorted positions of every particle in the cell ( x, y ) falls in.
+    Range getCellRange( float x, float y ) const;
+
+    //! Calls fn( index, dx, dy, distanceSquared ) for every particle within radius of ( x, y ), where
+    //! ( dx, dy ) is the particle's offset from it. Visits each particle once, row by row in sorted
+    //! order; a particle at ( x, y ) itself is included, with a distance of 0.
+    template<typename F>
+    void forEachNeighbour( float x, float y, float radius, F fn ) const;
+
+    //! Digit size of the radix sort: 2048 counters per chunk, which stay in L1.
+    static const int RADIX_BITS = 11;
+    //! Fewest particles worth a chunk of their own in rebuild().
+    static const size_t MIN_CHUNK_SIZE = 4096;
+
+private:
+    float mCellSize;
+    float mMinX;
+    float mMinY;
+    float mMaxX;
+    float mMaxY;
+    // Grid of the last rebuild; the settings may have changed since.
+    float mOriginX;
+    float mOriginY;
+    float mInvCellSize;
+    int mColumns;
+    int mRows;
+    int mKeyBits;
+    size_t mNumParticles;
+    // Cell of each sorted position, and its particle index.
+    std::vector<std::uint32_t> mKeys;
+    std::vector<std::uint32_t> mIndices;
+    // The other half of each radix pass.
+    std::vector<std::uint32_t> mScratchKeys;
+    std::vector<std::uint32_t> mScratchIndices;
+    std::vector<float> mSortedX;
+    std::vector<float> mSortedY;
+    // Cell c holds sorted positions [ mCellStart[ c ], mCellStart[ c + 1 ] ).
+    std::vector<std::uint32_t> mCellStart;
+    // One row of digit counts per chunk, turned into scatter offsets in place.
+    std::vector<std::uint32_t> mHistograms;
+
+    //! Both public rebuild()s: x( i ) and y( i ) give particle i's position.
+    template<typename X, typename Y>
+    void rebuild( size_t count, ThreadPool & threads, X x, Y y );
+    //! Lays the grid out from the current settings and sizes the arrays for count particles.
+    void resize( size_t count );
+    //! Sorts mKeys and mIndices, which rebuild() has filled in particle order, and indexes the cells.
+    void sort( ThreadPool & threads );
+    //! Column or row of a coordinate, clamped to the grid.
+    int cellOf( float coordinate, float origin, int numCells ) const;
+    int columnOf( float x ) const { return this->cellOf( x, this->mOriginX, this->mColumns ); }
+    int rowOf( float y ) const { return this->cellOf( y, this->mOriginY, this->mRows ); }
+};
+
+const int SpatialHash::RADIX_BITS;
+const size_t SpatialHash::MIN_CHUNK_SIZE;
+
+SpatialHash::SpatialHash( float cellSize ) :
+    mCellSize( cellSize ),
+    mMinX( 0.0f ),
+    mMinY( 0.0f ),
+    mMaxX( 1280.0f ),
+    mMaxY( 720.0f ),
+    mOriginX( 0.0f ),
+    mOriginY( 0.0f ),
+    mInvCellSize( 1.0f / cellSize ),
+    mColumns( 1 ),
+    mRows( 1 ),
+    mKeyBits( 0 ),
+    mNumParticles( 0 ),
+    mCellStart( 2, 0 )
+{
+}
+
+void SpatialHash::setBounds( float minX, float minY, float maxX, float maxY )
+{
+    this->mMinX = minX;
+    this->mMinY = minY;
+    this->mMaxX = maxX;
+    this->mMaxY = maxY;
+}
+
+void SpatialHash::rebuild( float const * x, float const * y, size_t count, ThreadPool & threads )
+{
+    this->rebuild( count, threads, [=]( size_t i ) { return x[ i ]; }, [=]( size_t i ) { return y[ i ]; } );
+}
+
+void SpatialHash::rebuild( Particle const * particles, size_t count, ThreadPool & threads )
+{
+    this->rebuild( count, threads, [=]( size_t i ) { return particles[ i ].pos.x; }, [=]( size_t i ) { return particles[ i ].pos.y; } );
+}
+
+template<typename X, typename Y>
+void SpatialHash::rebuild( size_t count, ThreadPool & threads, X x, Y y )
+{
+    this->resize( count );
+    threads.parallelFor( count, MIN_CHUNK_SIZE, [&]( size_t begin, size_t end )
+    {
+        for( size_t i = begin; i < end; ++i )
+        {
+            this->mKeys[ i ] = static_cast<std::uint32_t>( this->rowOf( y( i ) ) * this->mColumns + this->columnOf( x( i ) ) );
+            this->mIndices[ i ] = static_cast<std::uint32_t>( i );
+        }
+    } );
+    this->sort( threads );
+    threads.parallelFor( count, MIN_CHUNK_SIZE, [&]( size_t begin, size_t end )
+    {
+        for( size_t i = begin; i < end; ++i )
+        {
+            this->mSortedX[ i ] = x( this->mIndices[ i ] );
+            this->mSortedY[ i ] = y( this->mIndices[ i ] );
+        }
+    } );
+}
+
+SpatialHash::Range SpatialHash::getCellRange( float x, float y ) const
+{
+    const size_t cell = static_cast<size_t>( this->rowOf( y ) ) * this->mColumns + this->columnOf( x );
+    Range range = { this->mCellStart[ cell ], this->mCellStart[ cell + 1 ] };
+    return range;
+}
+
+template<typename F>
+void SpatialHash::forEachNeighbour( float x, float y, float radius, F fn ) const
+{
+    const int left = this->columnOf( x - radius ), right = this->columnOf( x + radius );
+    const int bottom = this->rowOf( y - radius ), top = this->rowOf( y + radius );
+    const float radiusSquared = radius * radius;
+    for( int row = bottom; row <= top; ++row )
+    {
+        // Adjacent cells of a row are adjacent in the sorted order.
+        const size_t first = static_cast<size_t>( row ) * this->mColumns;
+        const std::uint32_t end = this->mCellStart[ first + right + 1 ];
+        for( std::uint32_t j = this->mCellStart[ first + left ]; j < end; ++j )
+        {
+            const float dx = this->mSortedX[ j ] - x;
+            const float dy = this->mSortedY[ j ] - y;
+            const float distanceSquared = dx * dx + dy * dy;
+            if( distanceSquared <= radiusSquared )
+            {
+                fn( this->mIndices[ j ], dx, dy, distanceSquared );
+            }
+        }
+    }
+}
+
+void SpatialHash::resize( size_t count )
+{
+    this->mNumParticles = count;
+    this->mOriginX = this->mMinX;
+    this->mOriginY = this->mMinY;
+    this->mInvCellSize = 1.0f / this->mCellSize;
+    this->mColumns = std::max( static_cast<int>( std::ceil( ( this->mMaxX - this->mMinX ) * this->mInvCellSize ) ), 1 );
+    this->mRows = std::max( static_cast<int>( std::ceil( ( this->mMaxY - this->mMinY ) * this->mInvCellSize ) ), 1 );
+    const size_t numCells = static_cast<size_t>( this->mColumns ) * this->mRows;
+    this->mKeyBits = 0;
+    while( ( size_t( 1 ) << this->mKeyBits ) < numCells )
+    {
+        ++this->mKeyBits;
+    }
+    for( auto * array : { &this->mKeys, &this->mIndices, &this->mScratchKeys, &this->mScratchIndices } )
+    {
+        array->resize( count );
+    }
+    this->mSortedX.resize( count );
+    this->mSortedY.resize( count );
+    this->mCellStart.resize( numCells + 1 );
+}
+
+void SpatialHash::sort( ThreadPool & threads )
+{
+    const size_t count = this->mNumParticles;
+    const size_t radix = size_t( 1 ) << RADIX_BITS;
+    // Fixed chunks rather than parallelFor()'s ranges, so each one has a histogram row to itself.
+    const size_t numChunks = std::max<size_t>( std::min( threads.getNumThreads(), count / MIN_CHUNK_SIZE ), 1 );
+    this->mHistograms.resize( numChunks * radix );
+    auto chunkBegin = [&]( size_t chunk ) { return count * chunk / numChunks; };
+
+    // Least significant digit first; each pass is stable, so particles end up in index order within a cell.
+    for( int shift = 0; shift < this->mKeyBits; shift += RADIX_BITS )
+    {
+        const std::uint32_t mask = static_cast<std::uint32_t>( radix - 1 );
+        threads.parallelFor( numChunks, 1, [&]( size_t first, size_t last )
+        {
+            for( size_t chunk = first; chunk < last; ++chunk )
+            {
+                std::uint32_t * histogram = this->mHistograms.data() + chunk * radix;
+                std::fill( histogram, histogram + radix, 0 );
+                for( size_t i = chunkBegin( chunk ); i < chunkBegin( chunk + 1 ); ++i )
+                {
+                    ++histogram[ ( this->mKeys[ i ] >> shift ) & mask ];
+                }
+            }
+        } );
+
+        // Digit-major, then chunk: each chunk scatters each digit after every earlier chunk's.
+        std::uint32_t offset = 0;
+        for( size_t digit = 0; digit < radix; ++digit )
+        {
+            for( size_t chunk = 0; chunk < numChunks; ++chunk )
+            {
+                std::uint32_t & entry = this->mHistograms[ chunk * radix + digit ];
+                const std::uint32_t n = entry;
+                entry = offset;
+                offset += n;
+            }
+        }
+
+        threads.parallelFor( numChunks, 1, [&]( size_t first, size_t last )
+        {
+            for( size_t chunk = first; chunk < last; ++chunk )
+            {
+                std::uint32_t * cursor = this->mHistograms.data() + chunk * radix;
+                for( size_t i = chunkBegin( chunk ); i < chunkBegin( chunk + 1 ); ++i )
+                {
+                    const std::uint32_t key = this->mKeys[ i ];
+                    const std::uint32_t to = cursor[ ( key >> shift ) & mask ]++;
+                    this->mScratchKeys[ to ] = key;
+                    this->mScratchIndices[ to ] = this->mIndices[ i ];
+                }
+            }
+        } );
+        this->mKeys.swap( this->mScratchKeys );
+        this->mIndices.swap( this->mScratchIndices );
+    }
+
+    // Particle i starts every cell after the previous particle's, up to its own; the cells past the
+    // last particle start (and end) at count.
+    const size_t numCells = this->mCellStart.size() - 1;
+    std::uint32_t const * keys = this->mKeys.data();
+    std::uint32_t * start = this->mCellStart.data();
+    threads.parallelFor( count, MIN_CHUNK_SIZE, [&]( size_t begin, size_t end )
+    {
+        for( size_t i = begin; i < end; ++i )
+        {
+            const std::uint32_t from = i == 0 ? 0 : keys[ i - 1 ] + 1;
+            std::fill( start + from, start + keys[ i ] + 1, static_cast<std::uint32_t>( i ) );
+        }
+    } );
+    std::fill( start + ( count == 0 ? 0 : keys[ count - 1 ] + 1 ), start + numCells + 1, static_cast<std::uint32_t>( count ) );
+}
+
+int SpatialHash::cellOf( float coordinate, float origin, int numCells ) const
+{
+    // Compared as floats so far-off positions can't overflow the conversion; NaN goes to the first cell.
+    const float cell = std::floor( ( coordinate - origin ) * this->mInvCellSize );
+    return cell >= static_cast<float>( numCells - 1 ) ? numCells - 1 : ( cell >= 0.0f ? static_cast<int>( cell ) : 0 );
+}
+
+#endif
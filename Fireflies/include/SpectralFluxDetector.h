@@ -0,0 +1,188 @@
+//
+//  SpectralFluxDetector.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_SpectralFluxDetector_h
+#define AudioVertexDisplacement_SpectralFluxDetector_h
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <cstddef>
+#include "DspKernels.h"
+
+/**
+ Onset detector built on half-wave-rectified spectral flux over log- or Bark-spaced bands.
+ Each band's flux is compared against an adaptive threshold (scaled median of its recent flux),
+ so quiet bands react as readily as the bass. Band edges are precomputed in setup(); process()
+ never allocates.
+ */
+class SpectralFluxDetector
+{
+public:
+    enum class BandScale { LOG, BARK };
+
+    SpectralFluxDetector();
+
+    //! Preallocates for up to maxBands bands over numBins bins, so setup() within that never allocates.
+    void reserve( size_t maxBands, size_t numBins );
+    //! Builds the band edge table and clears all history.
+    void setup( size_t numBins, float sampleRate, size_t numBands, BandScale scale );
+
+    //! Consumes one magnitude spectrum (getNumBins() values) and writes one onset strength per band,
+    //! in the same [0, 0.35] range as the energy detector.
+    void process( const float * magSpectrum, float * beats );
+
+    size_t getNumBands() const { return this->mNumBands; }
+    size_t getNumBins() const { return this->mNumBins; }
+    BandScale getBandScale() const { return this->mScale; }
+    //! getNumBands() + 1 bin indices; band b covers [edges[b], edges[b + 1]).
+    std::vector<size_t> const & getBandEdges() const { return this->mBandEdges; }
+
+    //! Number of past flux values the median threshold is taken over.
+    static const size_t MEDIAN_WINDOW = 16;
+    //! Threshold is median * THRESHOLD_SCALE + THRESHOLD_OFFSET.
+    static const float THRESHOLD_SCALE;
+    static const float THRESHOLD_OFFSET;
+    //! Lowest band edge, in Hz; everything below is rumble.
+    static const float MIN_FREQUENCY;
+    //! Magnitudes are compressed as ln( 1 + COMPRESSION * x ) before differencing.
+    static const float COMPRESSION;
+
+private:
+    size_t mNumBins;
+    size_t mNumBands;
+    BandScale mScale;
+    std::vector<size_t> mBandEdges;
+    // Log-compressed magnitudes of the current and previous spectrum.
+    std::vector<float> mLogMags;
+    std::vector<float> mPrevLogMags;
+    // Band-major ring of the last MEDIAN_WINDOW flux values.
+    std::vector<float> mFluxHistory;
+    size_t mHead;
+    float mMedianScratch[ MEDIAN_WINDOW ];
+    bool mHasPrevious;
+
+    static float hzToBark( float hz );
+};
+
+const float SpectralFluxDetector::THRESHOLD_SCALE = 2.5f;
+const float SpectralFluxDetector::THRESHOLD_OFFSET = 0.2f;
+const float SpectralFluxDetector::MIN_FREQUENCY = 30.0f;
+const float SpectralFluxDetector::COMPRESSION = 1000.0f;
+
+SpectralFluxDetector::SpectralFluxDetector() :
+    mNumBins( 0 ),
+    mNumBands( 0 ),
+    mScale( BandScale::LOG ),
+    mHead( 0 ),
+    mHasPrevious( false )
+{
+}
+
+float SpectralFluxDetector::hzToBark( float hz )
+{
+    // Zwicker & Terhardt.
+    return 13.0f * std::atan( 0.00076f * hz ) + 3.5f * std::atan( ( hz / 7500.0f ) * ( hz / 7500.0f ) );
+}
+
+void SpectralFluxDetector::reserve( size_t maxBands, size_t numBins )
+{
+    this->mBandEdges.reserve( maxBands + 1 );
+    this->mLogMags.reserve( numBins );
+    this->mPrevLogMags.reserve( numBins );
+    this->mFluxHistory.reserve( maxBands * MEDIAN_WINDOW );
+}
+
+void SpectralFluxDetector::setup( size_t numBins, float sampleRate, size_t numBands, BandScale scale )
+{
+    this->mNumBins = numBins;
+    this->mNumBands = std::max<size_t>( std::min( numBands, numBins ), 1 );
+    this->mScale = scale;
+
+    const float binWidth = sampleRate / ( 2.0f * numBins );
+    const float minHz = std::min( MIN_FREQUENCY, sampleRate * 0.25f );
+    const float maxHz = sampleRate * 0.5f;
+    const float minBark = hzToBark( minHz );
+    const float maxBark = hzToBark( maxHz );
+
+    // Edge b sits at the b-th of mNumBands equal steps along the chosen scale.
+    this->mBandEdges.resize( this->mNumBands + 1 );
+    size_t bin = 0;
+    for( size_t b = 0; b <= this->mNumBands; ++b )
+    {
+        float t = static_cast<float>( b ) / this->mNumBands;
+        size_t edge = 0;
+        if( scale == BandScale::LOG )
+        {
+            edge = static_cast<size_t>( minHz * std::pow( maxHz / minHz, t ) / binWidth + 0.5f );
+        }
+        else
+        {
+            float targetBark = minBark + ( maxBark - minBark ) * t;
+            while( bin < numBins && hzToBark( bin * binWidth ) < targetBark ) { ++bin; }
+            edge = bin;
+        }
+        this->mBandEdges[ b ] = edge;
+    }
+
+    // Every band gets at least one bin, and the table ends exactly at numBins.
+    this->mBandEdges[ this->mNumBands ] = numBins;
+    for( size_t b = this->mNumBands; b-- > 0; )
+    {
+        size_t limit = this->mBandEdges[ b + 1 ] - 1;
+        this->mBandEdges[ b ] = std::min( this->mBandEdges[ b ], limit );
+    }
+    for( size_t b = 1; b <= this->mNumBands; ++b )
+    {
+        this->mBandEdges[ b ] = std::max( this->mBandEdges[ b ], this->mBandEdges[ b - 1 ] + 1 );
+    }
+    this->mBandEdges[ this->mNumBands ] = numBins;
+
+    this->mLogMags.assign( numBins, 0.0f );
+    this->mPrevLogMags.assign( numBins, 0.0f );
+    this->mFluxHistory.assign( this->mNumBands * MEDIAN_WINDOW, 0.0f );
+    this->mHead = 0;
+    this->mHasPrevious = false;
+}
+
+void SpectralFluxDetector::process( const float * magSpectrum, float * beats )
+{
+    const size_t half = MEDIAN_WINDOW / 2;
+    kernels::logCompress( magSpectrum, this->mLogMags.data(), this->mNumBins, COMPRESSION );
+
+    for( size_t band = 0; band < this->mNumBands; ++band )
+    {
+        // Half-wave-rectified flux: only rising bins count as onset energy.
+        float flux = 0.0f;
+        for( size_t i = this->mBandEdges[ band ], end = this->mBandEdges[ band + 1 ]; i < end; ++i )
+        {
+            float rise = this->mLogMags[ i ] - this->mPrevLogMags[ i ];
+            flux += rise > 0.0f ? rise : 0.0f;
+        }
+        flux /= static_cast<float>( this->mBandEdges[ band + 1 ] - this->mBandEdges[ band ] );
+
+        // The first spectrum has nothing to rise from.
+        if( !this->mHasPrevious ) { flux = 0.0f; }
+
+        float * history = &this->mFluxHistory[ band * MEDIAN_WINDOW ];
+        std::copy( history, history + MEDIAN_WINDOW, this->mMedianScratch );
+        std::nth_element( this->mMedianScratch, this->mMedianScratch + half, this->mMedianScratch + MEDIAN_WINDOW );
+        float threshold = this->mMedianScratch[ half ] * THRESHOLD_SCALE + THRESHOLD_OFFSET;
+
+        float strength = ( flux / threshold ) - 1.0f;
+        beats[ band ] = std::min( std::max( strength, 0.0f ), 0.35f );
+
+        history[ this->mHead ] = flux;
+    }
+
+    this->mLogMags.swap( this->mPrevLogMags );
+    this->mHead = ( this->mHead + 1 ) % MEDIAN_WINDOW;
+    this->mHasPrevious = true;
+}
+
+#endif
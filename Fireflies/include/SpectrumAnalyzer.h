@@ -0,0 +1,499 @@
+//
+//  SpectrumAnalyzer.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_SpectrumAnalyzer_h
+#define AudioVertexDisplacement_SpectrumAnalyzer_h
+
+#include "DspKernels.h"
+#include "EnergyHistory.h"
+#include "Filterbank.h"
+#include "SpectralFluxDetector.h"
+#include "StereoFft.h"
+#include "cinder/audio/Buffer.h"
+#include "cinder/audio/Utilities.h"
+#include "cinder/audio/dsp/Dsp.h"
+#include "cinder/audio/dsp/Fft.h"
+#include "cinder/CinderMath.h"
+
+/**
+ One analysis frame's (or, once AnalysisNode has merged them, one block's) worth of analysis.
+ Vectors are sized once by SpectrumAnalyzer::makeFrame() and only overwritten afterwards.
+ */
+struct AnalysisFrame
+{
+    AnalysisFrame() : numBands( 0 ), volume( 0.0f ), sampleTime( 0 ), time( 0.0 ), sequence( 0 ), bpm( 0.0f ), tempoConfidence( 0.0f ), nextBeatTime( 0.0 ) {}
+
+    //! The mono mix's spectrum; for a stereo analyzer, the mid spectrum, which is the same thing.
+    std::vector<float> magSpectrum;
+    //! Empty unless the analyzer is stereo; smoothed and scaled like magSpectrum.
+    std::vector<float> leftSpectrum;
+    std::vector<float> rightSpectrum;
+    std::vector<float> sideSpectrum;
+    //! Sized to one band per bin up front; only the first numBands entries are valid.
+    std::vector<float> bandEnergies;
+    //! Per-band beat strength in [0, 0.35]; same layout as bandEnergies.
+    std::vector<float> beats;
+    size_t numBands;
+    float volume;
+    //! Context sample clock when the block was analysed, and the same in seconds.
+    std::uint64_t sampleTime;
+    double time;
+    std::uint64_t sequence;
+    //! Tempo estimate (0 until one is found), its confidence in [0, 1], and when the next beat is
+    //! predicted to land, on the same clock as time.
+    float bpm;
+    float tempoConfidence;
+    double nextBeatTime;
+};
+
+//! How beats are derived from spectra: linear-band energy against its average, or spectral flux over log- or Bark-spaced bands.
+enum class BeatEngine { ENERGY, SPECTRAL_FLUX };
+
+//! Analysis window. Blackman-Harris trades a wider main lobe for far lower leakage than Hann.
+enum class AnalysisWindow { HANN, BLACKMAN, BLACKMAN_HARRIS };
+
+//! Which of a stereo analysis's spectra to read. Mid is ( L + R ) / 2 and side is ( L - R ) / 2.
+enum class StereoChannel { LEFT, RIGHT, MID, SIDE };
+
+/**
+ The FFT, volume, band energy and beat analysis behind AnalysisNode, without the audio graph.
+ Feed it consecutive blocks of audio and it fills one AnalysisFrame per block, or, with
+ processHops(), one per hop of its own, however the input is blocked. The FFT plan, window and
+ every buffer are made once in setup(). Offline baking runs several of these side by side over
+ one decoded file. In stereo, the first two channels are transformed together by one StereoFft
+ and left, right, mid and side spectra all come out of it. StereoBenchmark times it against the mono path.
+ */
+class SpectrumAnalyzer
+{
+public:
+    SpectrumAnalyzer();
+
+    //! Allocates everything for one analysis frame every hopSize input frames and for up to
+    //! maxHistoryDuration seconds of beat history; neither process() allocates afterwards.
+    //! fftSize is rounded up to a power of two.
+    void setup( size_t fftSize, size_t windowSize, AnalysisWindow window, float smoothingFactor, float sampleRate, size_t hopSize, float maxHistoryDuration );
+    //! Clears all history, as if no audio had been seen yet.
+    void reset();
+    //! Call before setup(). Analyses the first two channels (or the one, twice) as a stereo pair.
+    void setStereo( bool stereo ) { this->mStereo = stereo; }
+    bool isStereo() const { return this->mStereo; }
+    //! Sizes frame's vectors for this analyzer.
+    void makeFrame( AnalysisFrame & frame ) const;
+
+    //! Mixes numFrames frames of every channel, starting at offset, into the window and analyses it.
+    //! Fills everything in frame except the timestamps and sequence number.
+    void process( const ci::audio::Buffer & buffer, size_t offset, size_t numFrames, AnalysisFrame & frame, float gain = 1.0f );
+    //! Streaming form: mixes the frames in and analyses every time another hopSize frames have
+    //! arrived, filling frames[ 0 ] onwards. Every hop is analysed, so beat history sees them all;
+    //! past maxFrames the last slot is overwritten. Returns how many hops completed.
+    size_t processHops( const ci::audio::Buffer & buffer, size_t offset, size_t numFrames, AnalysisFrame * frames, size_t maxFrames, float gain = 1.0f );
+    //! Folds count (at least one) consecutive frames into merged: the latest spectrum, energies and
+    //! volume, and the strongest beats of any of them. merged may be the last of frames.
+    static void merge( AnalysisFrame const * frames, size_t count, AnalysisFrame & merged );
+
+    size_t getFftSize() const { return this->mFftSize; }
+    size_t getWindowSize() const { return this->mWindowSize; }
+    size_t getHopSize() const { return this->mHopSize; }
+    AnalysisWindow getWindow() const { return this->mWindow; }
+    size_t getNumBins() const { return this->mFftSize / 2; }
+    //! Analysis frames after reset() before the window, beat history and magnitude smoothing have all settled,
+    //! i.e. before results match those of an analyzer that had been running all along.
+    size_t getWarmupBlocks() const;
+
+    size_t getNumBands() const { return this->mNumBands; }
+    //! Takes effect from the next process() call; never allocates.
+    void setNumBands( size_t numBands ) { this->mNumBands = std::max<size_t>( numBands, 1 ); }
+    float getHistoryDuration() const { return this->mHistoryDuration; }
+    //! Takes effect from the next process() call. Clamped to the setup() maximum.
+    void setHistoryDuration( float seconds ) { this->mHistoryDuration = ci::math<float>::clamp( seconds, 0.0f, this->mMaxHistoryDuration ); }
+    BeatEngine getBeatEngine() const { return this->mBeatEngine; }
+    void setBeatEngine( BeatEngine engine ) { this->mBeatEngine = engine; }
+    SpectralFluxDetector::BandScale getFluxBandScale() const { return this->mFluxBandScale; }
+    //! How the spectral flux engine spaces its bands. Takes effect from the next process() call; never allocates.
+    void setFluxBandScale( SpectralFluxDetector::BandScale scale ) { this->mFluxBandScale = scale; }
+
+private:
+    size_t mFftSize;
+    size_t mWindowSize;
+    AnalysisWindow mWindow;
+    float mSmoothingFactor;
+    float mSampleRate;
+    size_t mHopSize;
+    float mMaxHistoryDuration;
+    bool mStereo;
+
+    size_t mNumBands;
+    float mHistoryDuration;
+    BeatEngine mBeatEngine;
+    SpectralFluxDetector::BandScale mFluxBandScale;
+
+    std::unique_ptr<ci::audio::dsp::Fft> mFft;
+    ci::audio::Buffer mFftBuffer;
+    ci::audio::BufferSpectral mBufferSpectral;
+    ci::audio::AlignedArrayPtr mWindowingTable;
+
+    // Mono mix of the last mWindowSize input frames, written circularly.
+    std::vector<float> mSamples;
+    size_t mWritePos;
+    // Input frames still to come before processHops() analyses again.
+    size_t mHopCountdown;
+    std::vector<float> mMagSpectrum;
+    std::vector<float> mDecibels;
+    // Equal runs of bins summed into bands; rebuilt only when the band count changes.
+    Filterbank mBandFilter;
+
+    // Stereo only: the channels' circular windows, their windowed and zero padded copies, the
+    // transform and its split output, and the smoothed spectra other than mid.
+    std::vector<float> mLeftSamples;
+    std::vector<float> mRightSamples;
+    std::vector<float> mLeftInput;
+    std::vector<float> mRightInput;
+    StereoFft mStereoFft;
+    std::vector<float> mLeftReal;
+    std::vector<float> mLeftImag;
+    std::vector<float> mRightReal;
+    std::vector<float> mRightImag;
+    std::vector<float> mLeftSpectrum;
+    std::vector<float> mRightSpectrum;
+    std::vector<float> mSideSpectrum;
+
+    EnergyHistory mEnergyHistory;
+    SpectralFluxDetector mFluxDetector;
+    // Engine used for the previous block; the flux detector restarts clean when switched to.
+    BeatEngine mActiveEngine;
+
+    size_t getHistoryBlocks() const;
+    //! Appends numFrames frames, mixed to mono, to the circular window.
+    void mix( const ci::audio::Buffer & buffer, size_t offset, size_t numFrames, float gain );
+    //! Analyses the current window into frame.
+    void analyze( AnalysisFrame & frame );
+    //! Fills mMagSpectrum (and, in stereo, the other spectra in frame) from the current window and returns its RMS.
+    float transformMono();
+    float transformStereo( AnalysisFrame & frame );
+};
+
+SpectrumAnalyzer::SpectrumAnalyzer() :
+    mFftSize( 0 ),
+    mWindowSize( 0 ),
+    mWindow( AnalysisWindow::BLACKMAN ),
+    mSmoothingFactor( 0.5f ),
+    mSampleRate( 44100.0f ),
+    mHopSize( 512 ),
+    mMaxHistoryDuration( 0.0f ),
+    mStereo( false ),
+    mNumBands( 4 ),
+    mHistoryDuration( 1.0f ),
+    mBeatEngine( BeatEngine::ENERGY ),
+    mFluxBandScale( SpectralFluxDetector::BandScale::LOG ),
+    mWritePos( 0 ),
+    mHopCountdown( 512 ),
+    mActiveEngine( BeatEngine::ENERGY )
+{
+}
+
+void SpectrumAnalyzer::setup( size_t fftSize, size_t windowSize, AnalysisWindow window, float smoothingFactor, float sampleRate, size_t hopSize, float maxHistoryDuration )
+{
+    this->mFftSize = ci::isPowerOf2( fftSize ) ? fftSize : ci::nextPowerOf2( static_cast<uint32_t>( fftSize ) );
+    this->mWindowSize = ( windowSize == 0 || windowSize > this->mFftSize ) ? this->mFftSize : windowSize;
+    this->mWindow = window;
+    this->mSmoothingFactor = smoothingFactor;
+    this->mSampleRate = sampleRate;
+    this->mHopSize = std::max<size_t>( hopSize, 1 );
+    this->mMaxHistoryDuration = maxHistoryDuration;
+    this->mHistoryDuration = std::min( this->mHistoryDuration, maxHistoryDuration );
+
+    // Resolve the kernel dispatch here rather than on the first audio callback.
+    kernels::getIsa();
+
+    this->mFft.reset( new ci::audio::dsp::Fft( this->mFftSize ) );
+    this->mFftBuffer = ci::audio::Buffer( this->mFftSize );
+    this->mBufferSpectral = ci::audio::BufferSpectral( this->mFftSize );
+    this->mWindowingTable = ci::audio::makeAlignedArray<float>( this->mWindowSize );
+    float * table = this->mWindowingTable.get();
+    switch( window )
+    {
+        case AnalysisWindow::HANN:
+            ci::audio::dsp::generateWindow( ci::audio::dsp::WindowType::HANN, table, this->mWindowSize );
+            break;
+        case AnalysisWindow::BLACKMAN:
+            ci::audio::dsp::generateWindow( ci::audio::dsp::WindowType::BLACKMAN, table, this->mWindowSize );
+            break;
+        case AnalysisWindow::BLACKMAN_HARRIS:
+        {
+            // Cinder has no Blackman-Harris; this is the 4-term, -92 dB sidelobe form.
+            const double scale = 2.0 * M_PI / this->mWindowSize;
+            for( size_t i = 0; i < this->mWindowSize; ++i )
+            {
+                table[ i ] = static_cast<float>( 0.35875 - 0.48829 * std::cos( scale * i ) + 0.14128 * std::cos( 2.0 * scale * i ) - 0.01168 * std::cos( 3.0 * scale * i ) );
+            }
+            break;
+        }
+    }
+
+    this->mSamples.resize( this->mWindowSize );
+    this->mMagSpectrum.resize( this->getNumBins() );
+    this->mDecibels.resize( this->getNumBins() );
+
+    const size_t stereoBins = this->mStereo ? this->getNumBins() : 0;
+    this->mLeftSamples.resize( this->mStereo ? this->mWindowSize : 0 );
+    this->mRightSamples.resize( this->mStereo ? this->mWindowSize : 0 );
+    this->mLeftInput.assign( this->mStereo ? this->mFftSize : 0, 0.0f );
+    this->mRightInput.assign( this->mStereo ? this->mFftSize : 0, 0.0f );
+    this->mStereoFft.setup( this->mStereo ? this->mFftSize : 0 );
+    this->mLeftReal.resize( stereoBins );
+    this->mLeftImag.resize( stereoBins );
+    this->mRightReal.resize( stereoBins );
+    this->mRightImag.resize( stereoBins );
+    this->mLeftSpectrum.resize( stereoBins );
+    this->mRightSpectrum.resize( stereoBins );
+    this->mSideSpectrum.resize( stereoBins );
+
+    // Worst case storage for band and history changes, so process() never allocates.
+    size_t maxHistoryBlocks = static_cast<size_t>( std::ceil( maxHistoryDuration * sampleRate / this->mHopSize ) );
+    this->mEnergyHistory.reserve( this->getNumBins(), std::max<size_t>( maxHistoryBlocks, 1 ) );
+    this->mFluxDetector.reserve( this->getNumBins(), this->getNumBins() );
+    this->mBandFilter.reserve( this->getNumBins(), this->getNumBins() );
+
+    this->reset();
+}
+
+void SpectrumAnalyzer::reset()
+{
+    std::fill( this->mSamples.begin(), this->mSamples.end(), 0.0f );
+    std::fill( this->mMagSpectrum.begin(), this->mMagSpectrum.end(), 0.0f );
+    std::fill( this->mLeftSamples.begin(), this->mLeftSamples.end(), 0.0f );
+    std::fill( this->mRightSamples.begin(), this->mRightSamples.end(), 0.0f );
+    std::fill( this->mLeftSpectrum.begin(), this->mLeftSpectrum.end(), 0.0f );
+    std::fill( this->mRightSpectrum.begin(), this->mRightSpectrum.end(), 0.0f );
+    std::fill( this->mSideSpectrum.begin(), this->mSideSpectrum.end(), 0.0f );
+    this->mWritePos = 0;
+    this->mHopCountdown = this->mHopSize;
+    this->mNumBands = std::min( this->mNumBands, this->getNumBins() );
+    this->mEnergyHistory.resize( this->mNumBands, this->getHistoryBlocks() );
+    this->mFluxDetector.setup( this->getNumBins(), this->mSampleRate, this->mNumBands, this->mFluxBandScale );
+    this->mActiveEngine = this->mBeatEngine;
+}
+
+void SpectrumAnalyzer::makeFrame( AnalysisFrame & frame ) const
+{
+    frame.magSpectrum.assign( this->getNumBins(), 0.0f );
+    const size_t stereoBins = this->mStereo ? this->getNumBins() : 0;
+    frame.leftSpectrum.assign( stereoBins, 0.0f );
+    frame.rightSpectrum.assign( stereoBins, 0.0f );
+    frame.sideSpectrum.assign( stereoBins, 0.0f );
+    // Room for a band per bin so setNumBands() never allocates.
+    frame.bandEnergies.assign( this->getNumBins(), 0.0f );
+    frame.beats.assign( this->getNumBins(), 0.0f );
+    frame.numBands = this->mNumBands;
+}
+
+size_t SpectrumAnalyzer::getHistoryBlocks() const
+{
+    float blocks = this->mHistoryDuration * this->mSampleRate / this->mHopSize;
+    return std::max<size_t>( static_cast<size_t>( blocks + 0.5f ), 1 );
+}
+
+size_t SpectrumAnalyzer::getWarmupBlocks() const
+{
+    return ( this->mWindowSize + this->mHopSize - 1 ) / this->mHopSize
+        + this->getHistoryBlocks() + SpectralFluxDetector::MEDIAN_WINDOW + 32;
+}
+
+void SpectrumAnalyzer::process( const ci::audio::Buffer & buffer, size_t offset, size_t numFrames, AnalysisFrame & frame, float gain )
+{
+    this->mix( buffer, offset, numFrames, gain );
+    this->analyze( frame );
+}
+
+size_t SpectrumAnalyzer::processHops( const ci::audio::Buffer & buffer, size_t offset, size_t numFrames, AnalysisFrame * frames, size_t maxFrames, float gain )
+{
+    size_t count = 0;
+    while( numFrames > 0 )
+    {
+        const size_t chunk = std::min( numFrames, this->mHopCountdown );
+        this->mix( buffer, offset, chunk, gain );
+        offset += chunk;
+        numFrames -= chunk;
+        this->mHopCountdown -= chunk;
+        if( this->mHopCountdown > 0 ) { continue; }
+
+        this->analyze( frames[ std::min( count, maxFrames - 1 ) ] );
+        ++count;
+        this->mHopCountdown = this->mHopSize;
+    }
+    return count;
+}
+
+void SpectrumAnalyzer::merge( AnalysisFrame const * frames, size_t count, AnalysisFrame & merged )
+{
+    AnalysisFrame const & latest = frames[ count - 1 ];
+    if( &latest != &merged )
+    {
+        std::copy( latest.magSpectrum.begin(), latest.magSpectrum.end(), merged.magSpectrum.begin() );
+        std::copy( latest.leftSpectrum.begin(), latest.leftSpectrum.end(), merged.leftSpectrum.begin() );
+        std::copy( latest.rightSpectrum.begin(), latest.rightSpectrum.end(), merged.rightSpectrum.begin() );
+        std::copy( latest.sideSpectrum.begin(), latest.sideSpectrum.end(), merged.sideSpectrum.begin() );
+        std::copy( latest.bandEnergies.begin(), latest.bandEnergies.begin() + latest.numBands, merged.bandEnergies.begin() );
+        std::copy( latest.beats.begin(), latest.beats.begin() + latest.numBands, merged.beats.begin() );
+        merged.numBands = latest.numBands;
+        merged.volume = latest.volume;
+    }
+    // A transient only lifts the hop it lands in; keep it rather than whichever hop came last.
+    for( size_t i = 0; i + 1 < count; ++i )
+    {
+        for( size_t band = 0; band < std::min( frames[ i ].numBands, merged.numBands ); ++band )
+        {
+            merged.beats[ band ] = std::max( merged.beats[ band ], frames[ i ].beats[ band ] );
+        }
+    }
+}
+
+void SpectrumAnalyzer::mix( const ci::audio::Buffer & buffer, size_t offset, size_t numFrames, float gain )
+{
+    const size_t numChannels = buffer.getNumChannels();
+    if( this->mStereo )
+    {
+        const float * left = buffer.getChannel( 0 ) + offset;
+        const float * right = buffer.getChannel( numChannels > 1 ? 1 : 0 ) + offset;
+        for( size_t i = 0; i < numFrames; ++i )
+        {
+            this->mLeftSamples[ this->mWritePos ] = left[ i ] * gain;
+            this->mRightSamples[ this->mWritePos ] = right[ i ] * gain;
+            this->mWritePos = ( this->mWritePos + 1 ) % this->mWindowSize;
+        }
+        return;
+    }
+
+    const float channelScale = gain / numChannels;
+    for( size_t i = offset; i < offset + numFrames; ++i )
+    {
+        float sample = 0.0f;
+        for( size_t ch = 0; ch < numChannels; ++ch )
+        {
+            sample += buffer.getChannel( ch )[ i ];
+        }
+        this->mSamples[ this->mWritePos ] = sample * channelScale;
+        this->mWritePos = ( this->mWritePos + 1 ) % this->mWindowSize;
+    }
+}
+
+float SpectrumAnalyzer::transformMono()
+{
+    // Unroll oldest-first into the (zero padded) FFT input and apply the window.
+    float * fftInput = this->mFftBuffer.getData();
+    const size_t tail = this->mWindowSize - this->mWritePos;
+    std::copy( this->mSamples.begin() + this->mWritePos, this->mSamples.end(), fftInput );
+    std::copy( this->mSamples.begin(), this->mSamples.begin() + this->mWritePos, fftInput + tail );
+    float volume = ci::audio::dsp::rms( fftInput, this->mWindowSize );
+    ci::audio::dsp::mul( fftInput, this->mWindowingTable.get(), fftInput, this->mWindowSize );
+
+    this->mFft->forward( &this->mFftBuffer, &this->mBufferSpectral );
+
+    // Normalized, smoothed magnitudes; same as MonitorSpectralNode.
+    float * real = this->mBufferSpectral.getReal();
+    float * imag = this->mBufferSpectral.getImag();
+    imag[ 0 ] = 0.0f;
+    const float magScale = 1.0f / this->mFftSize;
+    for( size_t i = 0; i < this->mMagSpectrum.size(); ++i )
+    {
+        float magnitude = std::sqrt( real[ i ] * real[ i ] + imag[ i ] * imag[ i ] ) * magScale;
+        this->mMagSpectrum[ i ] = this->mMagSpectrum[ i ] * this->mSmoothingFactor + magnitude * ( 1.0f - this->mSmoothingFactor );
+    }
+    return volume;
+}
+
+float SpectrumAnalyzer::transformStereo( AnalysisFrame & frame )
+{
+    float * left = this->mLeftInput.data();
+    float * right = this->mRightInput.data();
+    const size_t tail = this->mWindowSize - this->mWritePos;
+    std::copy( this->mLeftSamples.begin() + this->mWritePos, this->mLeftSamples.end(), left );
+    std::copy( this->mLeftSamples.begin(), this->mLeftSamples.begin() + this->mWritePos, left + tail );
+    std::copy( this->mRightSamples.begin() + this->mWritePos, this->mRightSamples.end(), right );
+    std::copy( this->mRightSamples.begin(), this->mRightSamples.begin() + this->mWritePos, right + tail );
+
+    // Volume of the mid signal, which is what the mono path would have mixed down.
+    float sumSquares = 0.0f;
+    for( size_t i = 0; i < this->mWindowSize; ++i )
+    {
+        float mid = 0.5f * ( left[ i ] + right[ i ] );
+        sumSquares += mid * mid;
+    }
+    ci::audio::dsp::mul( left, this->mWindowingTable.get(), left, this->mWindowSize );
+    ci::audio::dsp::mul( right, this->mWindowingTable.get(), right, this->mWindowSize );
+
+    this->mStereoFft.forward( left, right, this->mLeftReal.data(), this->mLeftImag.data(), this->mRightReal.data(), this->mRightImag.data() );
+
+    // Cinder's real transform returns twice the DFT; scale to match the mono path. Mid and side
+    // come from the channels' complex spectra, so each is exactly what transforming it would give.
+    const float magScale = 2.0f / this->mFftSize;
+    const float smoothing = this->mSmoothingFactor;
+    for( size_t i = 0; i < this->mMagSpectrum.size(); ++i )
+    {
+        const float lr = this->mLeftReal[ i ], li = this->mLeftImag[ i ];
+        const float rr = this->mRightReal[ i ], ri = this->mRightImag[ i ];
+        float leftMagnitude = std::sqrt( lr * lr + li * li ) * magScale;
+        float rightMagnitude = std::sqrt( rr * rr + ri * ri ) * magScale;
+        float midMagnitude = 0.5f * std::sqrt( ( lr + rr ) * ( lr + rr ) + ( li + ri ) * ( li + ri ) ) * magScale;
+        float sideMagnitude = 0.5f * std::sqrt( ( lr - rr ) * ( lr - rr ) + ( li - ri ) * ( li - ri ) ) * magScale;
+        this->mMagSpectrum[ i ] = this->mMagSpectrum[ i ] * smoothing + midMagnitude * ( 1.0f - smoothing );
+        this->mLeftSpectrum[ i ] = this->mLeftSpectrum[ i ] * smoothing + leftMagnitude * ( 1.0f - smoothing );
+        this->mRightSpectrum[ i ] = this->mRightSpectrum[ i ] * smoothing + rightMagnitude * ( 1.0f - smoothing );
+        this->mSideSpectrum[ i ] = this->mSideSpectrum[ i ] * smoothing + sideMagnitude * ( 1.0f - smoothing );
+    }
+    std::copy( this->mLeftSpectrum.begin(), this->mLeftSpectrum.end(), frame.leftSpectrum.begin() );
+    std::copy( this->mRightSpectrum.begin(), this->mRightSpectrum.end(), frame.rightSpectrum.begin() );
+    std::copy( this->mSideSpectrum.begin(), this->mSideSpectrum.end(), frame.sideSpectrum.begin() );
+    return std::sqrt( sumSquares / this->mWindowSize );
+}
+
+void SpectrumAnalyzer::analyze( AnalysisFrame & frame )
+{
+    float volume = this->mStereo ? this->transformStereo( frame ) : this->transformMono();
+    std::copy( this->mMagSpectrum.begin(), this->mMagSpectrum.end(), frame.magSpectrum.begin() );
+
+    // Band energy is the squared sum of the band's decibel magnitudes.
+    const size_t numBands = std::min( this->mNumBands, this->mMagSpectrum.size() );
+    this->mBandFilter.setup( this->mMagSpectrum.size(), this->mSampleRate, numBands, FilterScale::LINEAR, false );
+    kernels::linearToDecibel( this->mMagSpectrum.data(), this->mDecibels.data(), this->mDecibels.size() );
+    this->mBandFilter.apply( this->mDecibels.data(), frame.bandEnergies.data() );
+    kernels::square( frame.bandEnergies.data(), frame.bandEnergies.data(), numBands );
+    frame.numBands = numBands;
+
+    const BeatEngine engine = this->mBeatEngine;
+    if( engine == BeatEngine::SPECTRAL_FLUX )
+    {
+        if( numBands != this->mFluxDetector.getNumBands() || this->mFluxBandScale != this->mFluxDetector.getBandScale() || engine != this->mActiveEngine )
+        {
+            this->mFluxDetector.setup( this->getNumBins(), this->mSampleRate, numBands, this->mFluxBandScale );
+        }
+        this->mFluxDetector.process( this->mMagSpectrum.data(), frame.beats.data() );
+    }
+    this->mActiveEngine = engine;
+
+    // Beat strength is how far each band's instant energy rises above its recent average.
+    // The history keeps running under the flux engine so switching back doesn't start cold.
+    const size_t historyBlocks = this->getHistoryBlocks();
+    if( numBands != this->mEnergyHistory.getNumBands() || historyBlocks != this->mEnergyHistory.getHistorySize() )
+    {
+        this->mEnergyHistory.resize( numBands, historyBlocks );
+    }
+    this->mEnergyHistory.push( frame.bandEnergies.data() );
+    for( size_t band = 0; band < numBands && engine == BeatEngine::ENERGY; ++band )
+    {
+        float instantEnergy = this->mEnergyHistory.getInstant( band );
+        float averageEnergy = this->mEnergyHistory.getAverage( band );
+
+        float energyRatio = averageEnergy > 0.0f ? ( instantEnergy / averageEnergy ) - 1.0f : 0.0f;
+        frame.beats[ band ] = ci::math<float>::clamp( energyRatio, 0.0f, 0.35f );
+    }
+
+    frame.volume = volume;
+}
+
+#endif
@@ -0,0 +1,64 @@
+//
+//  SpectrumSnapshot.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_SpectrumSnapshot_h
+#define AudioVertexDisplacement_SpectrumSnapshot_h
+
+#include "cinder/audio/MonitorNode.h"
+
+/**
+ Frame-scoped copy of a MonitorSpectralNode's magnitude spectrum and volume.
+ MonitorSpectralNode::getMagSpectrum() runs an FFT under the monitor's lock on every call,
+ so the snapshot owns the monitor, capture() is called once per update() and everyone else
+ reads the copy. getFftCount() counts the getMagSpectrum() calls themselves, so a caller can
+ check it against the frames elapsed since getFirstFrame().
+ */
+class SpectrumSnapshot
+{
+public:
+    SpectrumSnapshot() : mVolume( 0.0f ), mFftCount( 0 ), mFirstFrame( 0 ), mLastFrame( 0 ) {}
+
+    //! The monitor to read from. The snapshot is the only thing that should call its getMagSpectrum().
+    void setMonitor( const ci::audio::MonitorSpectralNodeRef & monitor ) { this->mMonitor = monitor; }
+    ci::audio::MonitorSpectralNodeRef const & getMonitor() const { return this->mMonitor; }
+
+    //! Pulls one spectrum and one volume reading from the monitor. Repeat calls within the same frame are no-ops.
+    void capture( std::uint32_t frame );
+
+    std::vector<float> const & getMagSpectrum() const { return this->mMagSpectrum; }
+    float getVolume() const { return this->mVolume; }
+    //! The monitor's sample rate, or 0 before setMonitor().
+    size_t getSampleRate() const { return this->mMonitor ? this->mMonitor->getSampleRate() : 0; }
+
+    //! MonitorSpectralNode::getMagSpectrum() calls made so far.
+    std::uint64_t getFftCount() const { return this->mFftCount; }
+    //! The frame of the first capture; meaningless while getFftCount() is 0.
+    std::uint32_t getFirstFrame() const { return this->mFirstFrame; }
+
+private:
+    ci::audio::MonitorSpectralNodeRef mMonitor;
+    std::vector<float> mMagSpectrum;
+    float mVolume;
+    std::uint64_t mFftCount;
+    std::uint32_t mFirstFrame;
+    std::uint32_t mLastFrame;
+};
+
+void SpectrumSnapshot::capture( std::uint32_t frame )
+{
+    if( !this->mMonitor || ( this->mFftCount > 0 && frame == this->mLastFrame ) ) { return; }
+    if( this->mFftCount == 0 ) { this->mFirstFrame = frame; }
+    this->mLastFrame = frame;
+
+    std::vector<float> const & magSpectrum = this->mMonitor->getMagSpectrum();
+    ++this->mFftCount;
+    this->mMagSpectrum.assign( magSpectrum.begin(), magSpectrum.end() );
+    this->mVolume = this->mMonitor->getVolume();
+}
+
+#endif
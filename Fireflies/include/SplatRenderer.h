@@ -0,0 +1,474 @@
+//
+//  SplatRenderer.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_SplatRenderer_h
+#define AudioVertexDisplacement_SplatRenderer_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "DspKernels.h"
+#include "PackedParticle.h"
+#include "ThreadPool.h"
+#include "cinder/Surface.h"
+
+/**
+ Software stand-in for drawing the particles through render.vs and render.fs, for rendering
+ without a GPU: offline, on a render farm, or for golden-image tests. Each particle is projected
+ as render.vs does it and becomes a square sprite, size * pointScale / w pixels across, covering
+ the pixels whose centres it covers, as GL rasterizes points. Over that square the sprite texture
+ is sampled bilinearly, clamped to its edges, and multiplied by the particle's color with alpha
+ scaled by 0.7, as render.fs does. Then it is blended with GL_SRC_ALPHA, GL_ONE into a float
+ framebuffer, which saturates only when it is copied out to a Surface.
+
+ A frame runs in three passes. Particles are projected in parallel. Their sprites are binned by
+ the screen tiles they touch, keeping submission order within each bin. Then the tiles are
+ cleared and rasterized in parallel, each by one thread. The order of the additions within a
+ pixel is fixed, and every instruction set does the same arithmetic, so a frame comes out the
+ same bit for bit on any number of threads and any CPU.
+ */
+class SplatRenderer
+{
+public:
+    SplatRenderer();
+
+    //! Framebuffer size in pixels; the viewport covers all of it.
+    void setSize( size_t width, size_t height );
+    size_t getWidth() const { return this->mWidth; }
+    size_t getHeight() const { return this->mHeight; }
+    //! The sprite every particle draws, smoke_blur.png in the app. Until set, sprites are solid white squares.
+    void setSprite( ci::Surface8u const & sprite );
+    //! viewProjection is the column-major matrix the particles are drawn with (ciModelViewProjection);
+    //! pointScale is render.vs's uPointScale.
+    void setView( float const * viewProjection, float pointScale );
+
+    //! Draws count particles over black, alpha of the way from their previous positions to their
+    //! current ones, as render.vs places them.
+    void render( PackedParticle const * particles, size_t count, float alpha, ThreadPool & threads );
+    //! The framebuffer: getWidth() * getHeight() pixels of red, green, blue and alpha, top row first.
+    float const * getPixels() const { return this->mPixels.data(); }
+    //! The framebuffer clamped to [0, 1] and rounded to 8 bits per channel, as an 8-bit GL framebuffer
+    //! holds it. A surface without alpha gets red, green and blue only.
+    void copyTo( ci::Surface8u & surface ) const;
+
+    //! Sprites drawn by the last render(), and the pixels they covered in all.
+    size_t getNumSprites() const { return this->mNumSprites; }
+    std::uint64_t getNumFragments() const { return this->mNumFragments; }
+
+    //! Side of the square tiles the framebuffer is binned and rasterized in.
+    static const size_t TILE_SIZE = 64;
+    //! render.fs's scaling of the particle's alpha.
+    static const float ALPHA_SCALE;
+
+private:
+    //! A projected particle: the pixels it covers and how to sample and weight it over them.
+    struct Sprite
+    {
+        // Top left corner and one over the side, in pixels.
+        float left, top, inverseSize;
+        // Pixel rows and columns covered, clipped to the framebuffer; empty if the particle isn't drawn.
+        std::int32_t column0, column1, row0, row1;
+        // Color times alpha for red, green and blue; alpha squared for alpha (GL_SRC_ALPHA).
+        float weight[ 4 ];
+    };
+
+    size_t mWidth;
+    size_t mHeight;
+    size_t mNumTilesX;
+    size_t mNumTilesY;
+    // The sprite texture as floats in [0, 1], RGBA, with a border of copied edge texels all round,
+    // so bilinear filtering reads a clamped neighbour without checking.
+    std::vector<float> mTexels;
+    size_t mSpriteWidth;
+    size_t mSpriteHeight;
+    float mViewProjection[ 16 ];
+    float mPointScale;
+    std::vector<float> mPixels;
+    std::vector<Sprite> mSprites;
+    // Sprite indices binned by tile: tile t's are mBins[ mBinStarts[ t ] ] to mBins[ mBinStarts[ t + 1 ] ].
+    std::vector<std::uint32_t> mBinStarts;
+    std::vector<std::uint32_t> mBins;
+    size_t mNumSprites;
+    std::uint64_t mNumFragments;
+    // Fragments each tile rasterized, summed after the pass.
+    std::vector<std::uint64_t> mTileFragments;
+
+    //! Projects particles [begin, end) into mSprites.
+    void project( PackedParticle const * particles, size_t begin, size_t end, float alpha );
+    //! Fills mBinStarts and mBins from mSprites.
+    void bin();
+    //! Clears tile ( x, y ) and draws its bin into it; returns the pixels drawn.
+    std::uint64_t rasterize( size_t x, size_t y );
+};
+
+namespace kernels {
+
+//! Adds count pixels of one sprite row into out, an RGBA float row. Pixel j samples the texel pairs
+//! at float offsets columns[ j ] and columns[ j ] + 4 of rows top and bottom (RGBA floats), blending
+//! across by fractions[ j ] and down by fy; then adds sample * sample.a * weight.
+void splatSpan( float * out, size_t count, float const * top, float const * bottom, float fy,
+                std::int32_t const * columns, float const * fractions, float const * weight );
+
+namespace detail {
+
+void splatSpanScalar( float * out, size_t count, float const * top, float const * bottom, float fy,
+                      std::int32_t const * columns, float const * fractions, float const * weight )
+{
+    for( size_t j = 0; j < count; ++j )
+    {
+        float const * a = top + columns[ j ];
+        float const * b = bottom + columns[ j ];
+        const float fx = fractions[ j ];
+        float sample[ 4 ];
+        for( int c = 0; c < 4; ++c )
+        {
+            const float upper = a[ c ] + ( a[ c + 4 ] - a[ c ] ) * fx;
+            const float lower = b[ c ] + ( b[ c + 4 ] - b[ c ] ) * fx;
+            sample[ c ] = upper + ( lower - upper ) * fy;
+        }
+        for( int c = 0; c < 4; ++c )
+        {
+            out[ 4 * j + c ] += sample[ c ] * sample[ 3 ] * weight[ c ];
+        }
+    }
+}
+
+#if DSP_KERNELS_X86
+
+void splatSpanSse2( float * out, size_t count, float const * top, float const * bottom, float fy,
+                    std::int32_t const * columns, float const * fractions, float const * weight )
+{
+    const __m128 w = _mm_loadu_ps( weight );
+    const __m128 down = _mm_set1_ps( fy );
+    for( size_t j = 0; j < count; ++j )
+    {
+        float const * a = top + columns[ j ];
+        float const * b = bottom + columns[ j ];
+        const __m128 across = _mm_set1_ps( fractions[ j ] );
+        const __m128 a0 = _mm_loadu_ps( a ), b0 = _mm_loadu_ps( b );
+        const __m128 upper = _mm_add_ps( a0, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( a + 4 ), a0 ), across ) );
+        const __m128 lower = _mm_add_ps( b0, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( b + 4 ), b0 ), across ) );
+        const __m128 sample = _mm_add_ps( upper, _mm_mul_ps( _mm_sub_ps( lower, upper ), down ) );
+        const __m128 sampleAlpha = _mm_shuffle_ps( sample, sample, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+        _mm_storeu_ps( out + 4 * j, _mm_add_ps( _mm_loadu_ps( out + 4 * j ), _mm_mul_ps( _mm_mul_ps( sample, sampleAlpha ), w ) ) );
+    }
+}
+
+//! Two pixels per register: the low half is pixel j, the high half pixel j + 1.
+__attribute__(( target( "avx2" ) ))
+void splatSpanAvx2( float * out, size_t count, float const * top, float const * bottom, float fy,
+                    std::int32_t const * columns, float const * fractions, float const * weight )
+{
+    const __m256 w = _mm256_broadcast_ps( reinterpret_cast<__m128 const *>( weight ) );
+    const __m256 down = _mm256_set1_ps( fy );
+    size_t j = 0;
+    for( ; j + 2 <= count; j += 2 )
+    {
+        float const * a = top + columns[ j ];
+        float const * b = bottom + columns[ j ];
+        float const * c = top + columns[ j + 1 ];
+        float const * d = bottom + columns[ j + 1 ];
+        // Two broadcasts rather than _mm256_setr_ps(), which goes through the stack and stalls.
+        const __m256 across = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm_set1_ps( fractions[ j ] ) ), _mm_set1_ps( fractions[ j + 1 ] ), 1 );
+        const __m256 a0 = _mm256_loadu2_m128( c, a ), a1 = _mm256_loadu2_m128( c + 4, a + 4 );
+        const __m256 b0 = _mm256_loadu2_m128( d, b ), b1 = _mm256_loadu2_m128( d + 4, b + 4 );
+        const __m256 upper = _mm256_add_ps( a0, _mm256_mul_ps( _mm256_sub_ps( a1, a0 ), across ) );
+        const __m256 lower = _mm256_add_ps( b0, _mm256_mul_ps( _mm256_sub_ps( b1, b0 ), across ) );
+        const __m256 sample = _mm256_add_ps( upper, _mm256_mul_ps( _mm256_sub_ps( lower, upper ), down ) );
+        const __m256 sampleAlpha = _mm256_permute_ps( sample, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+        _mm256_storeu_ps( out + 4 * j, _mm256_add_ps( _mm256_loadu_ps( out + 4 * j ), _mm256_mul_ps( _mm256_mul_ps( sample, sampleAlpha ), w ) ) );
+    }
+    // The odd pixel here rather than through splatSpanSse2(): legacy SSE code straight after
+    // 256-bit code pays a state transition, costing more than the whole span.
+    if( j < count )
+    {
+        float const * a = top + columns[ j ];
+        float const * b = bottom + columns[ j ];
+        const __m128 across = _mm_set1_ps( fractions[ j ] );
+        const __m128 a0 = _mm_loadu_ps( a ), b0 = _mm_loadu_ps( b );
+        const __m128 upper = _mm_add_ps( a0, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( a + 4 ), a0 ), across ) );
+        const __m128 lower = _mm_add_ps( b0, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( b + 4 ), b0 ), across ) );
+        const __m128 sample = _mm_add_ps( upper, _mm_mul_ps( _mm_sub_ps( lower, upper ), _mm256_castps256_ps128( down ) ) );
+        const __m128 sampleAlpha = _mm_shuffle_ps( sample, sample, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+        _mm_storeu_ps( out + 4 * j, _mm_add_ps( _mm_loadu_ps( out + 4 * j ), _mm_mul_ps( _mm_mul_ps( sample, sampleAlpha ), _mm256_castps256_ps128( w ) ) ) );
+    }
+}
+
+#endif
+
+} // namespace detail
+
+void splatSpan( float * out, size_t count, float const * top, float const * bottom, float fy,
+                std::int32_t const * columns, float const * fractions, float const * weight )
+{
+    switch( getIsa() )
+    {
+#if DSP_KERNELS_X86
+        case Isa::AVX2: detail::splatSpanAvx2( out, count, top, bottom, fy, columns, fractions, weight ); break;
+        case Isa::SSE2: detail::splatSpanSse2( out, count, top, bottom, fy, columns, fractions, weight ); break;
+#endif
+        default: detail::splatSpanScalar( out, count, top, bottom, fy, columns, fractions, weight ); break;
+    }
+}
+
+} // namespace kernels
+
+const size_t SplatRenderer::TILE_SIZE;
+const float SplatRenderer::ALPHA_SCALE = 0.7f;
+
+SplatRenderer::SplatRenderer() :
+    mWidth( 0 ),
+    mHeight( 0 ),
+    mNumTilesX( 0 ),
+    mNumTilesY( 0 ),
+    mSpriteWidth( 1 ),
+    mSpriteHeight( 1 ),
+    mPointScale( 1.0f ),
+    mNumSprites( 0 ),
+    mNumFragments( 0 )
+{
+    // One white texel, bordered.
+    this->mTexels.assign( 3 * 3 * 4, 1.0f );
+    for( int i = 0; i < 16; ++i )
+    {
+        this->mViewProjection[ i ] = i % 5 == 0 ? 1.0f : 0.0f;
+    }
+}
+
+void SplatRenderer::setSize( size_t width, size_t height )
+{
+    this->mWidth = width;
+    this->mHeight = height;
+    this->mNumTilesX = ( width + TILE_SIZE - 1 ) / TILE_SIZE;
+    this->mNumTilesY = ( height + TILE_SIZE - 1 ) / TILE_SIZE;
+    this->mPixels.assign( width * height * 4, 0.0f );
+}
+
+void SplatRenderer::setSprite( ci::Surface8u const & sprite )
+{
+    const size_t width = sprite.getWidth();
+    const size_t height = sprite.getHeight();
+    if( width == 0 || height == 0 ) { return; }
+
+    const size_t stride = width + 2;
+    this->mSpriteWidth = width;
+    this->mSpriteHeight = height;
+    this->mTexels.resize( stride * ( height + 2 ) * 4 );
+    const std::uint8_t offsets[ 4 ] = { sprite.getRedOffset(), sprite.getGreenOffset(), sprite.getBlueOffset(), sprite.getAlphaOffset() };
+    for( size_t y = 0; y < height + 2; ++y )
+    {
+        // The border repeats the nearest edge texel.
+        std::uint8_t const * row = sprite.getData() + std::min( std::max<std::ptrdiff_t>( y, 1 ) - 1, static_cast<std::ptrdiff_t>( height ) - 1 ) * sprite.getRowBytes();
+        for( size_t x = 0; x < stride; ++x )
+        {
+            std::uint8_t const * texel = row + ( std::min( std::max<size_t>( x, 1 ) - 1, width - 1 ) ) * sprite.getPixelInc();
+            float * out = this->mTexels.data() + ( y * stride + x ) * 4;
+            for( int c = 0; c < 4; ++c )
+            {
+                out[ c ] = c == 3 && !sprite.hasAlpha() ? 1.0f : texel[ offsets[ c ] ] / 255.0f;
+            }
+        }
+    }
+}
+
+void SplatRenderer::setView( float const * viewProjection, float pointScale )
+{
+    std::copy( viewProjection, viewProjection + 16, this->mViewProjection );
+    this->mPointScale = pointScale;
+}
+
+void SplatRenderer::project( PackedParticle const * particles, size_t begin, size_t end, float alpha )
+{
+    float const * m = this->mViewProjection;
+    const float beta = 1.0f - alpha;
+    const float width = static_cast<float>( this->mWidth );
+    const float height = static_cast<float>( this->mHeight );
+    for( size_t i = begin; i < end; ++i )
+    {
+        PackedParticle const & particle = particles[ i ];
+        Sprite & sprite = this->mSprites[ i ];
+        sprite.column0 = sprite.column1 = sprite.row0 = sprite.row1 = 0;
+
+        // As render.vs: dead slots are parked outside, and GL drops a point whose centre is outside.
+        const float size = packing::fromHalf( particle.size );
+        if( !( size > 0.0f ) ) { continue; }
+        float p[ 3 ];
+        for( int c = 0; c < 3; ++c )
+        {
+            p[ c ] = particle.ppos[ c ] * beta + particle.pos[ c ] * alpha;
+        }
+        const float cx = m[ 0 ] * p[ 0 ] + m[ 4 ] * p[ 1 ] + m[ 8 ] * p[ 2 ] + m[ 12 ];
+        const float cy = m[ 1 ] * p[ 0 ] + m[ 5 ] * p[ 1 ] + m[ 9 ] * p[ 2 ] + m[ 13 ];
+        const float cz = m[ 2 ] * p[ 0 ] + m[ 6 ] * p[ 1 ] + m[ 10 ] * p[ 2 ] + m[ 14 ];
+        const float cw = m[ 3 ] * p[ 0 ] + m[ 7 ] * p[ 1 ] + m[ 11 ] * p[ 2 ] + m[ 15 ];
+        if( !( cw > 0.0f && std::abs( cx ) <= cw && std::abs( cy ) <= cw && std::abs( cz ) <= cw ) ) { continue; }
+
+        // GL rounds point sizes under a pixel up to one. Window y runs up; rows run down.
+        const float pixels = std::max( size * this->mPointScale / cw, 1.0f );
+        const float x = ( cx / cw * 0.5f + 0.5f ) * width;
+        const float y = ( 0.5f - cy / cw * 0.5f ) * height;
+        sprite.left = x - pixels * 0.5f;
+        sprite.top = y - pixels * 0.5f;
+        sprite.inverseSize = 1.0f / pixels;
+        // Pixel c is covered when its centre, c + 0.5, is in [ left, left + size ).
+        auto first = []( float edge, float limit ) { return static_cast<std::int32_t>( std::min( std::max( std::ceil( edge - 0.5f ), 0.0f ), limit ) ); };
+        sprite.column0 = first( sprite.left, width );
+        sprite.column1 = first( sprite.left + pixels, width );
+        sprite.row0 = first( sprite.top, height );
+        sprite.row1 = first( sprite.top + pixels, height );
+
+        const float a = packing::fromHalf( particle.color[ 3 ] ) * ALPHA_SCALE;
+        for( int c = 0; c < 3; ++c )
+        {
+            sprite.weight[ c ] = packing::fromHalf( particle.color[ c ] ) * a;
+        }
+        sprite.weight[ 3 ] = a * a;
+    }
+}
+
+void SplatRenderer::bin()
+{
+    const size_t numTiles = this->mNumTilesX * this->mNumTilesY;
+    this->mBinStarts.assign( numTiles + 1, 0 );
+    this->mNumSprites = 0;
+
+    // Count, then lay the bins end to end and fill them in submission order.
+    for( Sprite const & sprite : this->mSprites )
+    {
+        if( sprite.column0 >= sprite.column1 || sprite.row0 >= sprite.row1 ) { continue; }
+        ++this->mNumSprites;
+        for( size_t ty = sprite.row0 / TILE_SIZE; ty <= ( sprite.row1 - 1 ) / TILE_SIZE; ++ty )
+        {
+            for( size_t tx = sprite.column0 / TILE_SIZE; tx <= ( sprite.column1 - 1 ) / TILE_SIZE; ++tx )
+            {
+                ++this->mBinStarts[ ty * this->mNumTilesX + tx + 1 ];
+            }
+        }
+    }
+    for( size_t t = 0; t < numTiles; ++t )
+    {
+        this->mBinStarts[ t + 1 ] += this->mBinStarts[ t ];
+    }
+    this->mBins.resize( this->mBinStarts[ numTiles ] );
+    for( size_t i = 0; i < this->mSprites.size(); ++i )
+    {
+        Sprite const & sprite = this->mSprites[ i ];
+        if( sprite.column0 >= sprite.column1 || sprite.row0 >= sprite.row1 ) { continue; }
+        for( size_t ty = sprite.row0 / TILE_SIZE; ty <= ( sprite.row1 - 1 ) / TILE_SIZE; ++ty )
+        {
+            for( size_t tx = sprite.column0 / TILE_SIZE; tx <= ( sprite.column1 - 1 ) / TILE_SIZE; ++tx )
+            {
+                this->mBins[ this->mBinStarts[ ty * this->mNumTilesX + tx ]++ ] = static_cast<std::uint32_t>( i );
+            }
+        }
+    }
+    // Filling moved each start up to the next tile's; put them back.
+    for( size_t t = numTiles; t > 0; --t )
+    {
+        this->mBinStarts[ t ] = this->mBinStarts[ t - 1 ];
+    }
+    this->mBinStarts[ 0 ] = 0;
+}
+
+std::uint64_t SplatRenderer::rasterize( size_t x, size_t y )
+{
+    const std::int32_t tileColumn0 = static_cast<std::int32_t>( x * TILE_SIZE );
+    const std::int32_t tileRow0 = static_cast<std::int32_t>( y * TILE_SIZE );
+    const std::int32_t tileColumn1 = static_cast<std::int32_t>( std::min( ( x + 1 ) * TILE_SIZE, this->mWidth ) );
+    const std::int32_t tileRow1 = static_cast<std::int32_t>( std::min( ( y + 1 ) * TILE_SIZE, this->mHeight ) );
+    for( std::int32_t row = tileRow0; row < tileRow1; ++row )
+    {
+        float * pixels = this->mPixels.data() + ( row * this->mWidth + tileColumn0 ) * 4;
+        std::fill( pixels, pixels + ( tileColumn1 - tileColumn0 ) * 4, 0.0f );
+    }
+
+    const size_t stride = ( this->mSpriteWidth + 2 ) * 4;
+    const float spriteWidth = static_cast<float>( this->mSpriteWidth );
+    const float spriteHeight = static_cast<float>( this->mSpriteHeight );
+    std::int32_t columns[ TILE_SIZE ];
+    float fractions[ TILE_SIZE ];
+    std::uint64_t fragments = 0;
+    const size_t tile = y * this->mNumTilesX + x;
+    for( std::uint32_t b = this->mBinStarts[ tile ]; b < this->mBinStarts[ tile + 1 ]; ++b )
+    {
+        Sprite const & sprite = this->mSprites[ this->mBins[ b ] ];
+        const std::int32_t column0 = std::max( sprite.column0, tileColumn0 ), column1 = std::min( sprite.column1, tileColumn1 );
+        const std::int32_t row0 = std::max( sprite.row0, tileRow0 ), row1 = std::min( sprite.row1, tileRow1 );
+        const size_t count = column1 - column0;
+
+        // gl_PointCoord of each pixel centre, then texel coordinates; the border shifts them along one.
+        // Covered centres are inside the sprite, so every sample lands within the border.
+        for( size_t j = 0; j < count; ++j )
+        {
+            const float u = ( column0 + j + 0.5f - sprite.left ) * sprite.inverseSize * spriteWidth + 0.5f;
+            const float texel = std::floor( u );
+            columns[ j ] = static_cast<std::int32_t>( texel ) * 4;
+            fractions[ j ] = u - texel;
+        }
+        for( std::int32_t row = row0; row < row1; ++row )
+        {
+            const float v = ( row + 0.5f - sprite.top ) * sprite.inverseSize * spriteHeight + 0.5f;
+            const float texel = std::floor( v );
+            float const * top = this->mTexels.data() + static_cast<size_t>( texel ) * stride;
+            kernels::splatSpan( this->mPixels.data() + ( row * this->mWidth + column0 ) * 4, count, top, top + stride, v - texel,
+                                columns, fractions, sprite.weight );
+        }
+        fragments += count * ( row1 - row0 );
+    }
+    return fragments;
+}
+
+void SplatRenderer::render( PackedParticle const * particles, size_t count, float alpha, ThreadPool & threads )
+{
+    this->mSprites.resize( count );
+    threads.parallelFor( count, 1024, [&]( size_t begin, size_t end )
+    {
+        this->project( particles, begin, end, alpha );
+    } );
+    this->bin();
+
+    const size_t numTiles = this->mNumTilesX * this->mNumTilesY;
+    this->mTileFragments.assign( numTiles, 0 );
+    threads.parallelFor( numTiles, 1, [&]( size_t begin, size_t end )
+    {
+        for( size_t t = begin; t < end; ++t )
+        {
+            this->mTileFragments[ t ] = this->rasterize( t % this->mNumTilesX, t / this->mNumTilesX );
+        }
+    } );
+    this->mNumFragments = 0;
+    for( std::uint64_t fragments : this->mTileFragments )
+    {
+        this->mNumFragments += fragments;
+    }
+}
+
+void SplatRenderer::copyTo( ci::Surface8u & surface ) const
+{
+    const size_t width = std::min<size_t>( surface.getWidth(), this->mWidth );
+    const size_t height = std::min<size_t>( surface.getHeight(), this->mHeight );
+    const std::uint8_t offsets[ 4 ] = { surface.getRedOffset(), surface.getGreenOffset(), surface.getBlueOffset(), surface.getAlphaOffset() };
+    const int numChannels = surface.hasAlpha() ? 4 : 3;
+    for( size_t y = 0; y < height; ++y )
+    {
+        std::uint8_t * row = surface.getData() + y * surface.getRowBytes();
+        float const * pixels = this->mPixels.data() + y * this->mWidth * 4;
+        for( size_t x = 0; x < width; ++x )
+        {
+            std::uint8_t * out = row + x * surface.getPixelInc();
+            for( int c = 0; c < numChannels; ++c )
+            {
+                out[ offsets[ c ] ] = static_cast<std::uint8_t>( std::min( std::max( pixels[ 4 * x + c ], 0.0f ), 1.0f ) * 255.0f + 0.5f );
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,145 @@
+//
+//  StereoFft.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_StereoFft_h
+#define AudioVertexDisplacement_StereoFft_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined( __APPLE__ )
+#include <Accelerate/Accelerate.h>
+#else
+#include "cinder/audio/dsp/ooura/fftsg.h"
+#endif
+
+/**
+ Spectra of two real signals from a single complex FFT.
+ The left signal goes in as the real part and the right as the imaginary part. Because each
+ real signal's spectrum is conjugate-symmetric, the two separate again from the combined
+ spectrum Z with
+    L[ k ] = ( Z[ k ] + conj( Z[ N - k ] ) ) / 2
+    R[ k ] = ( Z[ k ] - conj( Z[ N - k ] ) ) / 2i
+ so a stereo pair costs one N-point complex transform instead of two real ones.
+ The complex transform is the one under ci::audio::dsp::Fft on each platform: vDSP_fft_zip on
+ macOS, and Ooura's cdft, which cinder bundles, elsewhere. Both keep their tables from setup(),
+ so forward() never allocates.
+ */
+class StereoFft
+{
+public:
+    StereoFft();
+    ~StereoFft();
+    StereoFft( const StereoFft & ) = delete;
+    StereoFft & operator=( const StereoFft & ) = delete;
+
+    //! size must be a power of two.
+    void setup( size_t size );
+    size_t getSize() const { return this->mSize; }
+
+    //! Transforms size samples of left and right and writes bins 0 to size / 2 - 1 of each channel's
+    //! spectrum, as the plain DFT (unscaled). Outputs are size / 2 floats each.
+    void forward( const float * left, const float * right, float * leftReal, float * leftImag, float * rightReal, float * rightImag );
+
+private:
+    //! Separates the combined spectrum, whose parts are stride floats apart from one bin to the next.
+    void separate( const float * re, const float * im, size_t stride, float * leftReal, float * leftImag, float * rightReal, float * rightImag ) const;
+
+    size_t mSize;
+#if defined( __APPLE__ )
+    FFTSetup mSetup;
+    vDSP_Length mLog2Size;
+    // Combined spectrum, split into real and imaginary parts.
+    std::vector<float> mReal;
+    std::vector<float> mImag;
+#else
+    // Combined spectrum, interleaved real and imaginary as cdft() wants it, and cdft()'s work areas.
+    std::vector<float> mData;
+    std::vector<int> mOouraIp;
+    std::vector<float> mOouraW;
+#endif
+};
+
+#if defined( __APPLE__ )
+
+StereoFft::StereoFft() : mSize( 0 ), mSetup( nullptr ), mLog2Size( 0 ) {}
+
+StereoFft::~StereoFft()
+{
+    if( this->mSetup ) { vDSP_destroy_fftsetup( this->mSetup ); }
+}
+
+void StereoFft::setup( size_t size )
+{
+    if( this->mSetup ) { vDSP_destroy_fftsetup( this->mSetup ); }
+    this->mSetup = nullptr;
+    this->mSize = size;
+    this->mReal.resize( size );
+    this->mImag.resize( size );
+    if( size < 2 ) { return; }
+
+    this->mLog2Size = static_cast<vDSP_Length>( std::log2( size ) );
+    this->mSetup = vDSP_create_fftsetup( this->mLog2Size, kFFTRadix2 );
+}
+
+void StereoFft::forward( const float * left, const float * right, float * leftReal, float * leftImag, float * rightReal, float * rightImag )
+{
+    std::copy( left, left + this->mSize, this->mReal.begin() );
+    std::copy( right, right + this->mSize, this->mImag.begin() );
+    DSPSplitComplex combined = { this->mReal.data(), this->mImag.data() };
+    vDSP_fft_zip( this->mSetup, &combined, 1, this->mLog2Size, kFFTDirection_Forward );
+    this->separate( this->mReal.data(), this->mImag.data(), 1, leftReal, leftImag, rightReal, rightImag );
+}
+
+#else
+
+StereoFft::StereoFft() : mSize( 0 ) {}
+
+StereoFft::~StereoFft() {}
+
+void StereoFft::setup( size_t size )
+{
+    this->mSize = size;
+    this->mData.resize( 2 * size );
+    // Sizes from cdft()'s documentation; ip[ 0 ] = 0 makes the first call build the tables.
+    this->mOouraIp.assign( 2 + static_cast<size_t>( std::ceil( std::sqrt( static_cast<double>( size ) ) ) ), 0 );
+    this->mOouraW.resize( size / 2 );
+}
+
+void StereoFft::forward( const float * left, const float * right, float * leftReal, float * leftImag, float * rightReal, float * rightImag )
+{
+    float * data = this->mData.data();
+    for( size_t i = 0; i < this->mSize; ++i )
+    {
+        data[ 2 * i ] = left[ i ];
+        data[ 2 * i + 1 ] = right[ i ];
+    }
+    // isgn -1 is the forward transform, exp( -2 pi i j k / n ).
+    cinder::audio::dsp::ooura::cdft( static_cast<int>( 2 * this->mSize ), -1, data, this->mOouraIp.data(), this->mOouraW.data() );
+    this->separate( data, data + 1, 2, leftReal, leftImag, rightReal, rightImag );
+}
+
+#endif
+
+void StereoFft::separate( const float * re, const float * im, size_t stride, float * leftReal, float * leftImag, float * rightReal, float * rightImag ) const
+{
+    const size_t n = this->mSize;
+    for( size_t k = 0; k < n / 2; ++k )
+    {
+        const size_t a = k * stride;
+        const size_t b = ( ( n - k ) & ( n - 1 ) ) * stride;
+        leftReal[ k ] = 0.5f * ( re[ a ] + re[ b ] );
+        leftImag[ k ] = 0.5f * ( im[ a ] - im[ b ] );
+        rightReal[ k ] = 0.5f * ( im[ a ] + im[ b ] );
+        rightImag[ k ] = -0.5f * ( re[ a ] - re[ b ] );
+    }
+}
+
+#endif
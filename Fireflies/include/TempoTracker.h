@@ -0,0 +1,279 @@
+//
+//  TempoTracker.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_TempoTracker_h
+#define AudioVertexDisplacement_TempoTracker_h
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <cstddef>
+#include "DspKernels.h"
+#include "SpectralFluxDetector.h"
+#include "cinder/CinderMath.h"
+
+/**
+ Tempo and beat phase from per-block magnitude spectra.
+ Each block contributes one onset value to a few seconds of history: the spectral flux of the
+ log-compressed spectrum, weighted so that every octave counts equally. Summing bins unweighted
+ would let broadband hats and snares, which fill far more bins than a kick, set the phase. Every UPDATE_INTERVAL blocks the history is autocorrelated to find the beat
+ period, weighted towards moderate tempos, and a comb at that period picks the phase. Between
+ updates the phase just advances, so the next beat can be predicted rather than detected late.
+ All storage is allocated in setup(); process() never allocates.
+ */
+class TempoTracker
+{
+public:
+    TempoTracker();
+
+    //! blockRate is blocks per second. latency is how far behind the end of a block its onset value
+    //! lies, in seconds (typically half the analysis window), and is subtracted from beat times.
+    void setup( size_t numBins, float blockRate, float latency );
+    void reset();
+
+    //! Feeds one block's magnitude spectrum (numBins values). Call exactly once per analysed block, in order.
+    void process( const float * magSpectrum );
+
+    //! 0 until a tempo has been found.
+    float getBpm() const { return this->mPeriod > 0.0f ? 60.0f * this->mBlockRate / this->mPeriod : 0.0f; }
+    //! Periodicity strength of the current estimate, 0 to 1.
+    float getConfidence() const { return this->mConfidence; }
+    //! Position within the current beat at the end of the latest block, 0 to 1.
+    float getBeatPhase() const;
+    //! Seconds from the end of the latest block to the next predicted beat.
+    float getTimeToNextBeat() const;
+
+    static const float MIN_BPM;
+    static const float MAX_BPM;
+    //! Centre of the tempo prior; octave errors resolve towards it.
+    static const float PREFERRED_BPM;
+    //! Seconds of onset history the period is estimated over.
+    static const float HISTORY_DURATION;
+    //! Blocks between period and phase re-estimates.
+    static const size_t UPDATE_INTERVAL = 8;
+
+private:
+    float mBlockRate;
+    float mLatency;
+
+    // Log-compressed magnitudes of this and the previous block, and the per-bin flux weights.
+    std::vector<float> mLogMags;
+    std::vector<float> mPrevLogMags;
+    std::vector<float> mWeights;
+    bool mHasPrevious;
+
+    // Onset values, written circularly.
+    std::vector<float> mOnsets;
+    size_t mHead;
+    size_t mCount;
+    size_t mBlocksSinceUpdate;
+
+    // Oldest-first, mean-removed copy of mOnsets, and autocorrelation by lag.
+    std::vector<float> mScratch;
+    std::vector<float> mCorrelation;
+    // Tempo prior by lag.
+    std::vector<float> mPrior;
+    size_t mMinLag;
+    size_t mMaxLag;
+
+    // Beat period in blocks, and blocks since the last beat (as of the end of the latest block).
+    float mPeriod;
+    float mSinceBeat;
+    float mConfidence;
+
+    void estimate();
+};
+
+const float TempoTracker::MIN_BPM = 60.0f;
+const float TempoTracker::MAX_BPM = 180.0f;
+const float TempoTracker::PREFERRED_BPM = 120.0f;
+const float TempoTracker::HISTORY_DURATION = 6.0f;
+
+TempoTracker::TempoTracker() :
+    mBlockRate( 1.0f ),
+    mLatency( 0.0f ),
+    mHasPrevious( false ),
+    mHead( 0 ),
+    mCount( 0 ),
+    mBlocksSinceUpdate( 0 ),
+    mMinLag( 1 ),
+    mMaxLag( 1 ),
+    mPeriod( 0.0f ),
+    mSinceBeat( 0.0f ),
+    mConfidence( 0.0f )
+{
+}
+
+void TempoTracker::setup( size_t numBins, float blockRate, float latency )
+{
+    this->mBlockRate = blockRate;
+    this->mLatency = latency;
+
+    this->mLogMags.assign( numBins, 0.0f );
+    this->mPrevLogMags.assign( numBins, 0.0f );
+    // 1 / bin sums to about the same over every octave. DC gets nothing.
+    this->mWeights.assign( numBins, 0.0f );
+    for( size_t bin = 1; bin < numBins; ++bin )
+    {
+        this->mWeights[ bin ] = 1.0f / bin;
+    }
+
+    size_t historySize = static_cast<size_t>( std::ceil( HISTORY_DURATION * blockRate ) );
+    this->mMinLag = std::max<size_t>( static_cast<size_t>( std::floor( 60.0f * blockRate / MAX_BPM ) ), 1 );
+    this->mMaxLag = std::max<size_t>( static_cast<size_t>( std::ceil( 60.0f * blockRate / MIN_BPM ) ), this->mMinLag + 2 );
+    historySize = std::max( historySize, 2 * this->mMaxLag );
+
+    this->mOnsets.assign( historySize, 0.0f );
+    this->mScratch.assign( historySize, 0.0f );
+    this->mCorrelation.assign( this->mMaxLag + 2, 0.0f );
+
+    // Log-normal in tempo, one octave wide, so 2x and 0.5x the true tempo lose to it.
+    this->mPrior.assign( this->mMaxLag + 2, 0.0f );
+    for( size_t lag = 1; lag < this->mPrior.size(); ++lag )
+    {
+        float octaves = std::log2( 60.0f * blockRate / lag / PREFERRED_BPM );
+        this->mPrior[ lag ] = std::exp( -0.5f * octaves * octaves );
+    }
+
+    this->reset();
+}
+
+void TempoTracker::reset()
+{
+    std::fill( this->mOnsets.begin(), this->mOnsets.end(), 0.0f );
+    this->mHasPrevious = false;
+    this->mHead = 0;
+    this->mCount = 0;
+    this->mBlocksSinceUpdate = 0;
+    this->mPeriod = 0.0f;
+    this->mSinceBeat = 0.0f;
+    this->mConfidence = 0.0f;
+}
+
+float TempoTracker::getBeatPhase() const
+{
+    if( this->mPeriod <= 0.0f ) { return 0.0f; }
+    // Onsets are mLatency behind the audio, so the audio is that much further into the beat.
+    return std::fmod( this->mSinceBeat + this->mLatency * this->mBlockRate, this->mPeriod ) / this->mPeriod;
+}
+
+float TempoTracker::getTimeToNextBeat() const
+{
+    if( this->mPeriod <= 0.0f ) { return 0.0f; }
+    return ( 1.0f - this->getBeatPhase() ) * this->mPeriod / this->mBlockRate;
+}
+
+void TempoTracker::process( const float * magSpectrum )
+{
+    kernels::logCompress( magSpectrum, this->mLogMags.data(), this->mLogMags.size(), SpectralFluxDetector::COMPRESSION );
+    float onset = 0.0f;
+    for( size_t bin = 0; bin < this->mLogMags.size(); ++bin )
+    {
+        float rise = this->mLogMags[ bin ] - this->mPrevLogMags[ bin ];
+        onset += rise > 0.0f ? rise * this->mWeights[ bin ] : 0.0f;
+    }
+    // The first spectrum has nothing to rise from.
+    if( !this->mHasPrevious ) { onset = 0.0f; }
+    this->mLogMags.swap( this->mPrevLogMags );
+    this->mHasPrevious = true;
+
+    this->mOnsets[ this->mHead ] = onset;
+    this->mHead = ( this->mHead + 1 ) % this->mOnsets.size();
+    this->mCount = std::min( this->mCount + 1, this->mOnsets.size() );
+
+    if( this->mPeriod > 0.0f )
+    {
+        this->mSinceBeat = std::fmod( this->mSinceBeat + 1.0f, this->mPeriod );
+    }
+    if( ++this->mBlocksSinceUpdate >= UPDATE_INTERVAL && this->mCount >= 2 * this->mMaxLag )
+    {
+        this->mBlocksSinceUpdate = 0;
+        this->estimate();
+    }
+}
+
+void TempoTracker::estimate()
+{
+    const size_t n = this->mCount;
+    const size_t size = this->mOnsets.size();
+    const size_t oldest = ( this->mHead + size - n ) % size;
+
+    float mean = 0.0f;
+    for( size_t i = 0; i < n; ++i )
+    {
+        this->mScratch[ i ] = this->mOnsets[ ( oldest + i ) % size ];
+        mean += this->mScratch[ i ];
+    }
+    mean /= n;
+    for( size_t i = 0; i < n; ++i )
+    {
+        this->mScratch[ i ] -= mean;
+    }
+
+    const float * x = this->mScratch.data();
+    float energy = 0.0f;
+    for( size_t i = 0; i < n; ++i )
+    {
+        energy += x[ i ] * x[ i ];
+    }
+    if( energy <= 0.0f ) { return; }
+
+    // Unbiased autocorrelation over the tempo range (plus a lag either side for interpolation).
+    size_t bestLag = 0;
+    float bestScore = 0.0f;
+    for( size_t lag = this->mMinLag - 1; lag <= this->mMaxLag + 1; ++lag )
+    {
+        float sum = 0.0f;
+        for( size_t i = lag; i < n; ++i )
+        {
+            sum += x[ i ] * x[ i - lag ];
+        }
+        this->mCorrelation[ lag ] = sum / ( n - lag );
+        if( lag < this->mMinLag || lag > this->mMaxLag ) { continue; }
+
+        float score = this->mCorrelation[ lag ] * this->mPrior[ lag ];
+        if( score > bestScore )
+        {
+            bestScore = score;
+            bestLag = lag;
+        }
+    }
+    if( bestLag == 0 ) { return; }
+
+    // Parabolic interpolation for a fractional period.
+    float left = this->mCorrelation[ bestLag - 1 ];
+    float centre = this->mCorrelation[ bestLag ];
+    float right = this->mCorrelation[ bestLag + 1 ];
+    float curvature = left - 2.0f * centre + right;
+    float offset = curvature < 0.0f ? ci::math<float>::clamp( 0.5f * ( left - right ) / curvature, -0.5f, 0.5f ) : 0.0f;
+    float period = bestLag + offset;
+    this->mConfidence = ci::math<float>::clamp( centre / ( energy / n ), 0.0f, 1.0f );
+
+    // Comb at that period: the offset, back from the newest block, whose beats line up with the most onset.
+    size_t bestPhase = 0;
+    float bestComb = -1.0f;
+    const size_t numPhases = static_cast<size_t>( std::ceil( period ) );
+    for( size_t phase = 0; phase < numPhases; ++phase )
+    {
+        float comb = 0.0f;
+        for( float back = static_cast<float>( phase ); back + 0.5f < n; back += period )
+        {
+            comb += x[ n - 1 - static_cast<size_t>( back + 0.5f ) ];
+        }
+        if( comb > bestComb )
+        {
+            bestComb = comb;
+            bestPhase = phase;
+        }
+    }
+
+    this->mPeriod = period;
+    this->mSinceBeat = std::fmod( static_cast<float>( bestPhase ), period );
+}
+
+#endif
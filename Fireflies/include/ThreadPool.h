@@ -0,0 +1,140 @@
+//
+//  ThreadPool.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_ThreadPool_h
+#define AudioVertexDisplacement_ThreadPool_h
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ Fixed set of worker threads for data-parallel loops that run every frame.
+ Workers are started once and sleep between jobs, so parallelFor() costs a wake-up rather
+ than a thread launch. The calling thread takes a share of the work too, and a pool of one
+ thread runs everything inline.
+ */
+class ThreadPool
+{
+public:
+    //! numThreads counts the calling thread; 0 uses every hardware thread.
+    explicit ThreadPool( size_t numThreads = 0 );
+    ~ThreadPool();
+
+    size_t getNumThreads() const { return this->mWorkers.size() + 1; }
+
+    //! Splits [0, count) into one contiguous range per thread, at least minPerThread long, and calls
+    //! fn( begin, end ) on each. Blocks until every range is done. Not reentrant.
+    void parallelFor( size_t count, size_t minPerThread, std::function<void( size_t, size_t )> const & fn );
+
+private:
+    std::vector<std::thread> mWorkers;
+    std::mutex mMutex;
+    std::condition_variable mStart;
+    std::condition_variable mDone;
+    // Bumped once per job; workers run each generation once.
+    std::uint64_t mGeneration;
+    size_t mPending;
+    bool mStopping;
+
+    // Current job.
+    std::function<void( size_t, size_t )> const * mJob;
+    size_t mCount;
+    size_t mNumRanges;
+
+    void run( size_t index );
+    void runRange( size_t range ) const;
+};
+
+ThreadPool::ThreadPool( size_t numThreads ) :
+    mGeneration( 0 ),
+    mPending( 0 ),
+    mStopping( false ),
+    mJob( nullptr ),
+    mCount( 0 ),
+    mNumRanges( 0 )
+{
+    if( numThreads == 0 ) { numThreads = std::max<size_t>( std::thread::hardware_concurrency(), 1 ); }
+    for( size_t i = 1; i < numThreads; ++i )
+    {
+        this->mWorkers.push_back( std::thread( &ThreadPool::run, this, i ) );
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( this->mMutex );
+        this->mStopping = true;
+    }
+    this->mStart.notify_all();
+    for( auto & worker : this->mWorkers )
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::runRange( size_t range ) const
+{
+    if( range >= this->mNumRanges ) { return; }
+    size_t begin = this->mCount * range / this->mNumRanges;
+    size_t end = this->mCount * ( range + 1 ) / this->mNumRanges;
+    ( *this->mJob )( begin, end );
+}
+
+void ThreadPool::run( size_t index )
+{
+    std::uint64_t seen = 0;
+    for( ;; )
+    {
+        {
+            std::unique_lock<std::mutex> lock( this->mMutex );
+            this->mStart.wait( lock, [&] { return this->mStopping || this->mGeneration != seen; } );
+            if( this->mStopping ) { return; }
+            seen = this->mGeneration;
+        }
+
+        this->runRange( index );
+
+        std::lock_guard<std::mutex> lock( this->mMutex );
+        if( --this->mPending == 0 ) { this->mDone.notify_one(); }
+    }
+}
+
+void ThreadPool::parallelFor( size_t count, size_t minPerThread, std::function<void( size_t, size_t )> const & fn )
+{
+    size_t numRanges = std::min( this->getNumThreads(), std::max<size_t>( count / std::max<size_t>( minPerThread, 1 ), 1 ) );
+    if( numRanges == 1 )
+    {
+        fn( 0, count );
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( this->mMutex );
+        this->mJob = &fn;
+        this->mCount = count;
+        this->mNumRanges = numRanges;
+        this->mPending = this->mWorkers.size();
+        ++this->mGeneration;
+    }
+    this->mStart.notify_all();
+
+    this->runRange( 0 );
+
+    std::unique_lock<std::mutex> lock( this->mMutex );
+    this->mDone.wait( lock, [&] { return this->mPending == 0; } );
+    this->mJob = nullptr;
+}
+
+#endif
@@ -0,0 +1,81 @@
+//
+//  TripleBuffer.h
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+
+#ifndef AudioVertexDisplacement_TripleBuffer_h
+#define AudioVertexDisplacement_TripleBuffer_h
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ Lock-free single-producer/single-consumer triple buffer.
+ The producer always owns one slot and the consumer another; the third slot is swapped between
+ them through a single atomic index, so neither side ever waits on the other. The consumer sees
+ the most recently published value and skips any it was too slow to read.
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : mWriteIndex( 0 ), mReadIndex( 1 ), mMiddle( 2 ) {}
+
+    //! Copies value into all three slots. Only call while neither side is running.
+    void reset( T const & value );
+
+    //! Producer: the slot to fill before calling publish().
+    T & getWriteBuffer() { return this->mBuffers[ this->mWriteIndex ]; }
+    //! Producer: hands the write slot to the consumer and takes back whichever slot was idle.
+    void publish();
+
+    //! Consumer: swaps in the latest published slot. Returns false if nothing new was published.
+    bool update();
+    //! Consumer: the slot obtained by the last update(). Stable until the next update().
+    T const & getReadBuffer() const { return this->mBuffers[ this->mReadIndex ]; }
+
+private:
+    static const std::uint8_t INDEX_MASK = 0x3;
+    static const std::uint8_t DIRTY = 0x4;
+
+    T mBuffers[ 3 ];
+    std::uint8_t mWriteIndex;
+    std::uint8_t mReadIndex;
+    // Index of the idle slot, plus DIRTY while it holds a value the consumer has not taken yet.
+    // Kept on its own cache line so producer and consumer don't false-share with the slot indices.
+    alignas( 64 ) std::atomic<std::uint8_t> mMiddle;
+};
+
+template<typename T>
+void TripleBuffer<T>::reset( T const & value )
+{
+    for( int i = 0; i < 3; ++i )
+    {
+        this->mBuffers[ i ] = value;
+    }
+    this->mWriteIndex = 0;
+    this->mReadIndex = 1;
+    this->mMiddle.store( 2, std::memory_order_relaxed );
+}
+
+template<typename T>
+void TripleBuffer<T>::publish()
+{
+    std::uint8_t previous = this->mMiddle.exchange( this->mWriteIndex | DIRTY, std::memory_order_acq_rel );
+    this->mWriteIndex = previous & INDEX_MASK;
+}
+
+template<typename T>
+bool TripleBuffer<T>::update()
+{
+    if( ( this->mMiddle.load( std::memory_order_relaxed ) & DIRTY ) == 0 ) { return false; }
+
+    std::uint8_t previous = this->mMiddle.exchange( this->mReadIndex, std::memory_order_acq_rel );
+    this->mReadIndex = previous & INDEX_MASK;
+    return true;
+}
+
+#endif
@@ -63,8 +63,45 @@ private:
 void TransformFeedbackParticlesApp::setup()
 {
     this->mAudio.reset( new AudioComponent() );
+    // Run with --timeline to play from a pre-baked feature timeline instead of analysing live,
+    // with --stream to stream the track from disk instead of decoding it up front, with --latency
+    // to time injected clicks from the audio graph to the draw call, with --stereo to analyse
+    // left and right (and mid and side) separately, with --cpu-sim to simulate the particles
+    // on the CPU instead of through transform feedback (S toggles it at runtime), with
+    // --cached-noise to have the CPU simulation sample a precomputed noise volume, with
+    // --step-rate N to simulate N steps a second whatever the refresh rate, with --no-cull to have
+    // the CPU backend draw every particle rather than those in view (V toggles it at runtime), with
+    // --particles N to size the particle population for the machine (+ and - change it at runtime),
+    // and with --seed N to lay the particles out from another seed (the same seed, the same scene).
+    auto const & args = getCommandLineArgs();
+    this->mAudio->setUseTimeline( std::find( args.begin(), args.end(), "--timeline" ) != args.end() );
+    this->mAudio->setStreaming( std::find( args.begin(), args.end(), "--stream" ) != args.end() );
+    this->mAudio->setMeasureLatency( std::find( args.begin(), args.end(), "--latency" ) != args.end() );
+    this->mAudio->setStereo( std::find( args.begin(), args.end(), "--stereo" ) != args.end() );
     this->mCam.reset( new CamComponent( this ) );
     this->mScene.reset( new SceneComponent( this ) );
+    this->mScene->setAudio( this->mAudio );
+    if( std::find( args.begin(), args.end(), "--cpu-sim" ) != args.end() )
+    {
+        this->mScene->setBackend( SimulationBackend::CPU );
+    }
+    this->mScene->setCachedNoise( std::find( args.begin(), args.end(), "--cached-noise" ) != args.end() );
+    this->mScene->setCulling( std::find( args.begin(), args.end(), "--no-cull" ) == args.end() );
+    auto particles = std::find( args.begin(), args.end(), "--particles" );
+    if( particles != args.end() && particles + 1 != args.end() )
+    {
+        this->mScene->setNumParticles( std::max( std::atoi( ( particles + 1 )->c_str() ), 1 ) );
+    }
+    auto stepRate = std::find( args.begin(), args.end(), "--step-rate" );
+    if( stepRate != args.end() && stepRate + 1 != args.end() )
+    {
+        this->mScene->setStepRate( std::max( std::atof( ( stepRate + 1 )->c_str() ), 1.0 ) );
+    }
+    auto seed = std::find( args.begin(), args.end(), "--seed" );
+    if( seed != args.end() && seed + 1 != args.end() )
+    {
+        this->mScene->setSeed( std::strtoull( ( seed + 1 )->c_str(), nullptr, 0 ) );
+    }
     
     this->mComponents.push_back( this->mAudio );
     this->mComponents.push_back( this->mCam );
@@ -102,10 +139,6 @@ void TransformFeedbackParticlesApp::mouseDrag( MouseEvent event )
 
 void TransformFeedbackParticlesApp::update()
 {
-    this->mScene->setMagSpectrum( this->mAudio->getMagSpectrum() );
-    this->mScene->setBeats( this->mAudio->getBeats() );
-    this->mScene->setVolume( this->mAudio->getVolume() );
-    
     for( auto c : this->mComponents )
     {
         c->update();
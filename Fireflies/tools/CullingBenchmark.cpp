@@ -0,0 +1,321 @@
+//
+//  CullingBenchmark.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Culls a stepped particle layout from a few cameras: the app's own window view, zoomed in on a
+//  corner, pulled far back, and grazing the particles' plane from its edge. Checks each draw list
+//  against classifying every particle by hand and packing it with ParticleSimulator::store(), the
+//  scalar classifier against the same reference, and that 1 and 4 threads pack the same list.
+//  Reports what was culled and how well thinning keeps the area the sprites cover, then times a cull
+//  against storing every particle. Not part of the app target; build like ParticleBenchmark:
+//      g++ -std=c++11 -O2 -I../include -I$CINDER_PATH/include CullingBenchmark.cpp -o CullingBenchmark
+//          -L$CINDER_PATH/lib/linux/x86_64/ogl/Release -lcinder -lpthread  (plus cinder's own link deps)
+//
+//  Usage: CullingBenchmark [largest particle count, default 1000000] [frames per run, default 10]
+//  Exits non-zero if a draw list differs from the reference, threads change it, or the counts don't add up.
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "ParticleCuller.h"
+#include "ParticleFactory.h"
+#include "ParticleSimulator.h"
+
+const float WINDOW_WIDTH = 1280.0f;
+const float WINDOW_HEIGHT = 720.0f;
+const float ALPHA = 0.375f;
+
+//! Column-major 4x4 matrix, as GL and glm lay them out.
+struct Matrix
+{
+    float m[ 16 ];
+};
+
+Matrix multiply( Matrix const & a, Matrix const & b )
+{
+    Matrix c;
+    for( int col = 0; col < 4; ++col )
+    {
+        for( int row = 0; row < 4; ++row )
+        {
+            float sum = 0.0f;
+            for( int k = 0; k < 4; ++k ) { sum += a.m[ k * 4 + row ] * b.m[ col * 4 + k ]; }
+            c.m[ col * 4 + row ] = sum;
+        }
+    }
+    return c;
+}
+
+//! glm::perspective.
+Matrix perspective( float fovDegrees, float aspect, float nearPlane, float farPlane )
+{
+    const float f = 1.0f / std::tan( fovDegrees * 3.14159265f / 360.0f );
+    Matrix p = {};
+    p.m[ 0 ] = f / aspect;
+    p.m[ 5 ] = f;
+    p.m[ 10 ] = ( farPlane + nearPlane ) / ( nearPlane - farPlane );
+    p.m[ 11 ] = -1.0f;
+    p.m[ 14 ] = 2.0f * farPlane * nearPlane / ( nearPlane - farPlane );
+    return p;
+}
+
+//! glm::lookAt.
+Matrix lookAt( float const eye[ 3 ], float const center[ 3 ], float const up[ 3 ] )
+{
+    float f[ 3 ], s[ 3 ], u[ 3 ];
+    for( int i = 0; i < 3; ++i ) { f[ i ] = center[ i ] - eye[ i ]; }
+    auto normalize = []( float * v ) { const float l = std::sqrt( v[ 0 ] * v[ 0 ] + v[ 1 ] * v[ 1 ] + v[ 2 ] * v[ 2 ] ); for( int i = 0; i < 3; ++i ) { v[ i ] /= l; } };
+    auto cross = []( float const * a, float const * b, float * out ) { out[ 0 ] = a[ 1 ] * b[ 2 ] - a[ 2 ] * b[ 1 ]; out[ 1 ] = a[ 2 ] * b[ 0 ] - a[ 0 ] * b[ 2 ]; out[ 2 ] = a[ 0 ] * b[ 1 ] - a[ 1 ] * b[ 0 ]; };
+    normalize( f );
+    cross( f, up, s );
+    normalize( s );
+    cross( s, f, u );
+    Matrix v = {};
+    for( int i = 0; i < 3; ++i )
+    {
+        v.m[ i * 4 + 0 ] = s[ i ];
+        v.m[ i * 4 + 1 ] = u[ i ];
+        v.m[ i * 4 + 2 ] = -f[ i ];
+    }
+    v.m[ 12 ] = -( s[ 0 ] * eye[ 0 ] + s[ 1 ] * eye[ 1 ] + s[ 2 ] * eye[ 2 ] );
+    v.m[ 13 ] = -( u[ 0 ] * eye[ 0 ] + u[ 1 ] * eye[ 1 ] + u[ 2 ] * eye[ 2 ] );
+    v.m[ 14 ] = f[ 0 ] * eye[ 0 ] + f[ 1 ] * eye[ 1 ] + f[ 2 ] * eye[ 2 ];
+    v.m[ 15 ] = 1.0f;
+    return v;
+}
+
+//! What gl::setMatricesWindowPersp() sets for the window, with the eye moved to eye instead of
+//! straight out from the window's centre (eye == nullptr), looking at center.
+Matrix windowView( float const * eye, float const * center )
+{
+    const float fov = 60.0f;
+    const float distance = WINDOW_HEIGHT / 2.0f / std::tan( fov * 3.14159265f / 360.0f );
+    const float defaultEye[ 3 ] = { WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f, distance };
+    const float defaultCenter[ 3 ] = { WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f, 0.0f };
+    const float up[ 3 ] = { 0.0f, 1.0f, 0.0f };
+    // Far enough back for the pulled-back camera; the app keeps cinder's 1000.
+    Matrix projection = perspective( fov, WINDOW_WIDTH / WINDOW_HEIGHT, 1.0f, eye ? 100000.0f : 1000.0f );
+    Matrix view = lookAt( eye ? eye : defaultEye, center ? center : defaultCenter, up );
+    // Origin in the upper left: flip y and move it down a window.
+    Matrix flip = {};
+    flip.m[ 0 ] = 1.0f;
+    flip.m[ 5 ] = -1.0f;
+    flip.m[ 10 ] = 1.0f;
+    flip.m[ 13 ] = WINDOW_HEIGHT;
+    flip.m[ 15 ] = 1.0f;
+    return multiply( projection, multiply( view, flip ) );
+}
+
+//! uPointScale, as SceneComponent::draw() works it out: the window view's distance to the z = 0 plane,
+//! whichever camera is drawing.
+float pointScale()
+{
+    return WINDOW_HEIGHT * 0.5f / std::tan( 30.0f * 3.14159265f / 180.0f );
+}
+
+struct Reference
+{
+    std::vector<PackedParticle> drawList;
+    ParticleCuller::Stats stats;
+    // Pixel area of every sprite that would be drawn without thinning, and of those drawn with it.
+    double unthinnedArea, thinnedArea;
+};
+
+//! The draw list by the letter of ParticleCuller's description, one particle at a time.
+Reference cullByHand( ParticleSimulator & simulator, Matrix const & viewProjection, float scale, ParticleCuller const & culler )
+{
+    typedef ParticleSimulator F;
+    const size_t count = simulator.getNumParticles();
+    std::vector<PackedParticle> packed( count );
+    simulator.store( packed.data() );
+    Reference reference = { {}, ParticleCuller::Stats(), 0.0, 0.0 };
+    reference.stats.numParticles = count;
+    float const * m = viewProjection.m;
+    for( size_t i = 0; i < count; ++i )
+    {
+        const float size = simulator.getField( F::SIZE )[ i ];
+        if( !( size > 0.0f ) ) { ++reference.stats.numEmpty; continue; }
+        float clip[ 4 ];
+        for( int r = 0; r < 4; ++r )
+        {
+            float p[ 3 ];
+            for( int c = 0; c < 3; ++c )
+            {
+                p[ c ] = simulator.getField( static_cast<F::Field>( F::PPOS_X + c ) )[ i ] * ( 1.0f - ALPHA )
+                    + simulator.getField( static_cast<F::Field>( F::POS_X + c ) )[ i ] * ALPHA;
+            }
+            clip[ r ] = m[ r ] * p[ 0 ] + m[ 4 + r ] * p[ 1 ] + m[ 8 + r ] * p[ 2 ] + m[ 12 + r ];
+        }
+        bool inside = clip[ 3 ] > 0.0f;
+        for( int r = 0; r < 3; ++r ) { inside = inside && -clip[ 3 ] <= clip[ r ] && clip[ r ] <= clip[ 3 ]; }
+        if( !inside ) { ++reference.stats.numOutside; continue; }
+        const float pixels = size * scale / clip[ 3 ];
+        if( pixels < culler.getMinPixelSize() ) { ++reference.stats.numSubPixel; continue; }
+        reference.unthinnedArea += pixels * pixels;
+
+        // Doublings until it reaches the LOD size, and one in four of the slots kept per doubling.
+        int level = 0;
+        while( pixels * ( 1 << level ) < culler.getLodPixelSize() && level < culler.getMaxLodLevel() ) { ++level; }
+        const std::uint32_t hash = static_cast<std::uint32_t>( i ) * 0x9E3779B9u;
+        if( level > 0 && hash >> ( 32 - 2 * level ) != 0 ) { ++reference.stats.numMerged; continue; }
+        PackedParticle p = packed[ i ];
+        p.size = packing::toHalf( size * ( 1 << level ) );
+        reference.drawList.push_back( p );
+        reference.thinnedArea += static_cast<double>( pixels * ( 1 << level ) ) * ( pixels * ( 1 << level ) );
+    }
+    reference.stats.numDrawn = reference.drawList.size();
+    return reference;
+}
+
+//! factory's layout for count particles, stepped a second so they have left the z = 0 plane, with
+//! every tenth slot emptied as dead pool slots are and one position broken.
+void makeScene( size_t count, ParticleSimulator & simulator )
+{
+    ParticleFactory factory;
+    factory.setLayout( WINDOW_WIDTH, WINDOW_HEIGHT, 4 );
+    std::vector<Particle> particles( count );
+    factory.makeParticles( 0, count, particles.data() );
+    for( size_t i = 0; i < count; i += 10 ) { particles[ i ].size = 0.0f; }
+    simulator.load( particles.data(), count );
+    const float beats[ 4 ] = { 0.1f, 0.45f, 0.1f, 0.3f };
+    for( int step = 0; step < 60; ++step )
+    {
+        simulator.step( step * 0.001f / 60.0f, ParticleSimulator::DT2, 2.0f, beats, 4, WINDOW_WIDTH, WINDOW_HEIGHT );
+    }
+    if( count > 1 )
+    {
+        particles.resize( 1 );
+        simulator.store( particles.data() );
+        particles[ 0 ].pos.x = std::numeric_limits<float>::quiet_NaN();
+        simulator.write( 1, particles.data(), 1 );
+    }
+}
+
+struct View
+{
+    std::string name;
+    Matrix viewProjection;
+};
+
+std::vector<View> makeViews()
+{
+    const float corner[ 3 ] = { WINDOW_WIDTH * 0.2f, WINDOW_HEIGHT * 0.2f, 150.0f };
+    const float cornerCenter[ 3 ] = { WINDOW_WIDTH * 0.2f, WINDOW_HEIGHT * 0.2f, 0.0f };
+    const float far[ 3 ] = { WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f, 25000.0f };
+    const float middle[ 3 ] = { WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f, 0.0f };
+    const float edge[ 3 ] = { WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT + 400.0f, 60.0f };
+    const float across[ 3 ] = { WINDOW_WIDTH / 2.0f, 0.0f, 0.0f };
+    std::vector<View> views;
+    views.push_back( { "window", windowView( nullptr, nullptr ) } );
+    views.push_back( { "corner", windowView( corner, cornerCenter ) } );
+    views.push_back( { "far", windowView( far, middle ) } );
+    views.push_back( { "grazing", windowView( edge, across ) } );
+    return views;
+}
+
+bool sameList( PackedParticle const * a, std::vector<PackedParticle> const & b, size_t count )
+{
+    return count == b.size() && ( count == 0 || std::memcmp( a, b.data(), count * sizeof(PackedParticle) ) == 0 );
+}
+
+bool checkViews()
+{
+    size_t failures = 0;
+    // Not a multiple of eight, so the SIMD classifier leaves a tail.
+    const size_t count = 49999;
+    ParticleSimulator simulator( 1 );
+    makeScene( count, simulator );
+    ThreadPool one( 1 ), four( 4 );
+    ParticleCuller culler;
+    std::vector<PackedParticle> drawList( count ), otherList( count );
+
+    std::cout << count << " particles, a tenth of them empty slots, drawn at alpha " << ALPHA << std::endl;
+    std::cout << std::setw( 10 ) << "view" << std::setw( 10 ) << "outside" << std::setw( 11 ) << "sub-pixel" << std::setw( 10 ) << "merged"
+        << std::setw( 10 ) << "drawn" << std::setw( 13 ) << "area kept" << std::setw( 12 ) << "reference" << std::setw( 10 ) << "threads" << std::endl;
+    for( View const & view : makeViews() )
+    {
+        culler.setView( view.viewProjection.m, pointScale() );
+        const size_t drawn = culler.cull( simulator, ALPHA, drawList.data(), one );
+        ParticleCuller::Stats stats = culler.getStats();
+        const size_t otherDrawn = culler.cull( simulator, ALPHA, otherList.data(), four );
+        Reference reference = cullByHand( simulator, view.viewProjection, pointScale(), culler );
+
+        // The scalar classifier on its own, wherever the SIMD one ran above.
+        typedef ParticleSimulator F;
+        float const * pos[ 3 ] = { simulator.getField( F::POS_X ), simulator.getField( F::POS_Y ), simulator.getField( F::POS_Z ) };
+        float const * ppos[ 3 ] = { simulator.getField( F::PPOS_X ), simulator.getField( F::PPOS_Y ), simulator.getField( F::PPOS_Z ) };
+        std::vector<std::uint32_t> indices( count );
+        std::vector<std::uint8_t> levels( count );
+        ParticleCuller::Stats scalar = ParticleCuller::Stats();
+        kernels::detail::classifyParticlesScalar( pos, ppos, simulator.getField( F::SIZE ), 0, count, view.viewProjection.m, ALPHA, pointScale(),
+                                                  culler.getMinPixelSize(), culler.getLodPixelSize(), culler.getMaxLodLevel(), indices.data(), levels.data(), scalar );
+
+        auto sameStats = []( ParticleCuller::Stats const & a, ParticleCuller::Stats const & b )
+        {
+            return a.numEmpty == b.numEmpty && a.numOutside == b.numOutside && a.numSubPixel == b.numSubPixel
+                && a.numMerged == b.numMerged && a.numDrawn == b.numDrawn;
+        };
+        const bool matches = sameList( drawList.data(), reference.drawList, drawn ) && sameStats( stats, reference.stats ) && sameStats( scalar, reference.stats );
+        const bool threadsAgree = otherDrawn == drawn && std::memcmp( drawList.data(), otherList.data(), drawn * sizeof(PackedParticle) ) == 0;
+        const bool addsUp = stats.numEmpty + stats.numOutside + stats.numSubPixel + stats.numMerged + stats.numDrawn == count;
+        std::cout << std::setw( 10 ) << view.name << std::setw( 10 ) << stats.numOutside << std::setw( 11 ) << stats.numSubPixel
+            << std::setw( 10 ) << stats.numMerged << std::setw( 10 ) << stats.numDrawn << std::fixed << std::setprecision( 3 )
+            << std::setw( 13 ) << ( reference.unthinnedArea > 0.0 ? reference.thinnedArea / reference.unthinnedArea : 1.0 )
+            << std::setw( 12 ) << ( matches ? "same" : "DIFFERENT" ) << std::setw( 10 ) << ( threadsAgree ? "same" : "DIFFERENT" ) << std::endl;
+        failures += !matches + !threadsAgree + !addsUp;
+    }
+    return failures == 0;
+}
+
+double seconds( std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end )
+{
+    return std::chrono::duration<double>( end - start ).count();
+}
+
+int main( int argc, char * argv[] )
+{
+    const size_t maxParticles = argc > 1 ? std::atol( argv[ 1 ] ) : 1000000;
+    const size_t numFrames = argc > 2 ? std::atol( argv[ 2 ] ) : 10;
+
+    if( !checkViews() ) { return 1; }
+
+    std::cout << std::setw( 10 ) << "particles" << std::setw( 10 ) << "view" << std::setw( 10 ) << "drawn" << std::setw( 10 ) << "cull ms"
+        << std::setw( 10 ) << "store ms" << std::setw( 12 ) << "upload MB" << std::setw( 10 ) << "was MB" << std::endl;
+    for( size_t count = 10000; count <= maxParticles; count *= 10 )
+    {
+        ParticleSimulator simulator;
+        makeScene( count, simulator );
+        ParticleCuller culler;
+        std::vector<PackedParticle> drawList( count );
+        for( View const & view : makeViews() )
+        {
+            culler.setView( view.viewProjection.m, pointScale() );
+            double cull = 0.0, store = 0.0;
+            size_t drawn = 0;
+            for( size_t frame = 0; frame < numFrames; ++frame )
+            {
+                auto t0 = std::chrono::steady_clock::now();
+                drawn = culler.cull( simulator, ALPHA, drawList.data(), simulator.getThreadPool() );
+                auto t1 = std::chrono::steady_clock::now();
+                simulator.store( drawList.data() );
+                auto t2 = std::chrono::steady_clock::now();
+                cull += seconds( t0, t1 );
+                store += seconds( t1, t2 );
+            }
+            std::cout << std::setw( 10 ) << count << std::setw( 10 ) << view.name << std::setw( 10 ) << drawn << std::fixed << std::setprecision( 3 )
+                << std::setw( 10 ) << 1e3 * cull / numFrames << std::setw( 10 ) << 1e3 * store / numFrames << std::setprecision( 2 )
+                << std::setw( 12 ) << drawn * sizeof(PackedParticle) / 1e6 << std::setw( 10 ) << count * sizeof(PackedParticle) / 1e6 << std::endl;
+        }
+    }
+    return 0;
+}
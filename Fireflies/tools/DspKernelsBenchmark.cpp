@@ -0,0 +1,262 @@
+//
+//  DspKernelsBenchmark.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Runs every variant of each kernel in DspKernels.h that this CPU can run (scalar, SSE2 and,
+//  where supported, AVX2) against the scalar reference, on random inputs over the ranges the
+//  analysis feeds them plus the edge cases (the decibel floor, zeros, exact clamp limits), at
+//  lengths that leave every vector tail. Each kernel's error has to stay within its bound, in
+//  ulps of the reference plus an absolute allowance where the reference itself rounds away the
+//  small values. Then times each variant on a spectrum-sized buffer. Not part of the app target,
+//  and needs nothing from cinder:
+//      g++ -std=c++11 -O2 -I../include DspKernelsBenchmark.cpp -o DspKernelsBenchmark
+//
+//  Usage: DspKernelsBenchmark [buffer length, default 1024] [calls per timing, default 20000]
+//  Exits non-zero if any variant strays past a kernel's bound.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "DspKernels.h"
+
+using kernels::detail::Table;
+
+//! Every table this CPU can run, scalar first.
+std::vector<Table> makeTables()
+{
+    using namespace kernels::detail;
+    std::vector<Table> tables;
+    Table scalar = { kernels::Isa::SCALAR, linearToDecibelScalar, sparseMultiplyScalar, squareScalar, mapClampedScalar, logCompressScalar };
+    tables.push_back( scalar );
+#if DSP_KERNELS_X86
+    Table sse2 = { kernels::Isa::SSE2, linearToDecibelSse2, sparseMultiplySse2, squareSse2, mapClampedSse2, logCompressSse2 };
+    tables.push_back( sse2 );
+    if( __builtin_cpu_supports( "avx2" ) )
+    {
+        Table avx2 = { kernels::Isa::AVX2, linearToDecibelAvx2, sparseMultiplyAvx2, squareAvx2, mapClampedAvx2, logCompressAvx2 };
+        tables.push_back( avx2 );
+    }
+#endif
+    return tables;
+}
+
+const char * nameOf( kernels::Isa isa )
+{
+    switch( isa )
+    {
+        case kernels::Isa::AVX2: return "AVX2";
+        case kernels::Isa::SSE2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+//! Distance between two floats in units in the last place; infinite if one is NaN and the other isn't.
+double ulpDistance( float a, float b )
+{
+    if( std::isnan( a ) || std::isnan( b ) ) { return std::isnan( a ) && std::isnan( b ) ? 0.0 : std::numeric_limits<double>::infinity(); }
+    auto ordered = []( float x )
+    {
+        std::int32_t bits;
+        std::memcpy( &bits, &x, sizeof(bits) );
+        return bits < 0 ? static_cast<std::int64_t>( std::numeric_limits<std::int32_t>::min() ) - bits : static_cast<std::int64_t>( bits );
+    };
+    return static_cast<double>( std::abs( ordered( a ) - ordered( b ) ) );
+}
+
+//! How far a kernel may stray from the scalar reference: absolute + ulps of the reference.
+struct Bound
+{
+    double ulps;
+    double absolute;
+};
+
+struct Error
+{
+    // Largest ulps where the difference is past the absolute allowance; near zero, ulps say little.
+    double ulps;
+    double absolute;
+    size_t outside;
+};
+
+void accumulate( Error & error, float const * out, float const * reference, size_t length, Bound const & bound )
+{
+    for( size_t i = 0; i < length; ++i )
+    {
+        const double difference = std::abs( static_cast<double>( out[ i ] ) - reference[ i ] );
+        const double ulps = ulpDistance( out[ i ], reference[ i ] );
+        if( difference > bound.absolute ) { error.ulps = std::max( error.ulps, ulps ); }
+        error.absolute = std::max( error.absolute, difference );
+        error.outside += !( ulps <= bound.ulps || difference <= bound.absolute );
+    }
+}
+
+//! Inputs for one trial: magnitudes spread over many decades, with the edge cases sprinkled in.
+std::vector<float> makeInputs( std::mt19937 & random, size_t length, float lowest, float highest, std::vector<float> const & specials )
+{
+    std::uniform_real_distribution<float> exponent( std::log10( lowest ), std::log10( highest ) );
+    std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+    std::vector<float> inputs( length );
+    for( size_t i = 0; i < length; ++i )
+    {
+        inputs[ i ] = unit( random ) < 0.1f && !specials.empty() ? specials[ random() % specials.size() ] : std::pow( 10.0f, exponent( random ) );
+    }
+    return inputs;
+}
+
+struct Sparse
+{
+    std::vector<float> weights;
+    std::vector<std::uint32_t> starts;
+    std::vector<std::uint32_t> offsets;
+};
+
+//! Rows of 0 to 40 contiguous columns, like the filterbank's, within numColumns.
+Sparse makeSparse( std::mt19937 & random, size_t numRows, size_t numColumns )
+{
+    std::uniform_real_distribution<float> weight( 0.0f, 1.0f );
+    Sparse sparse;
+    sparse.offsets.push_back( 0 );
+    for( size_t row = 0; row < numRows; ++row )
+    {
+        const size_t count = std::min<size_t>( random() % 41, numColumns );
+        sparse.starts.push_back( static_cast<std::uint32_t>( random() % ( numColumns - count + 1 ) ) );
+        for( size_t j = 0; j < count; ++j ) { sparse.weights.push_back( weight( random ) ); }
+        sparse.offsets.push_back( static_cast<std::uint32_t>( sparse.weights.size() ) );
+    }
+    return sparse;
+}
+
+enum Kernel { LINEAR_TO_DECIBEL, SPARSE_MULTIPLY, SQUARE, MAP_CLAMPED, LOG_COMPRESS, NUM_KERNELS };
+const char * KERNEL_NAMES[ NUM_KERNELS ] = { "linearToDecibel", "sparseMultiply", "square", "mapClamped", "logCompress" };
+
+// Decibels: a few ulps from the log polynomial, and an allowance near 0 dB where ulps are tiny.
+// Sparse rows: summed in a different order, so up to a row's length of roundings, against the sum's size.
+// Square and the clamped map are the same arithmetic in every variant.
+// Log compression: a few ulps from the polynomial, and ln( 1 + x ) rounds 1 + x where log1p() doesn't.
+const Bound BOUNDS[ NUM_KERNELS ] = { { 4.0, 2e-5 }, { 0.0, 0.0 }, { 0.0, 0.0 }, { 0.0, 0.0 }, { 4.0, 1.2e-7 } };
+
+//! Runs kernel of table over one trial's inputs into out.
+void run( Table const & table, Kernel kernel, std::vector<float> const & in, Sparse const & sparse, std::vector<float> & out )
+{
+    switch( kernel )
+    {
+        case LINEAR_TO_DECIBEL: table.linearToDecibel( in.data(), out.data(), in.size() ); break;
+        case SPARSE_MULTIPLY: table.sparseMultiply( in.data(), sparse.weights.data(), sparse.starts.data(), sparse.offsets.data(), sparse.starts.size(), out.data() ); break;
+        case SQUARE: table.square( in.data(), out.data(), in.size() ); break;
+        case MAP_CLAMPED: table.mapClamped( in.data(), out.data(), in.size(), 0.0f, 100.0f, 0.0f, 1.0f ); break;
+        case LOG_COMPRESS: table.logCompress( in.data(), out.data(), in.size(), 100.0f ); break;
+        default: break;
+    }
+}
+
+//! Inputs suited to kernel: spectrum magnitudes, decibels for the map.
+std::vector<float> inputsFor( Kernel kernel, std::mt19937 & random, size_t length )
+{
+    const float floor = kernels::detail::DECIBEL_FLOOR;
+    switch( kernel )
+    {
+        case LINEAR_TO_DECIBEL:
+            return makeInputs( random, length, 1e-8f, 1e3f, { 0.0f, floor, std::nextafter( floor, 0.0f ), std::nextafter( floor, 1.0f ), 1.0f } );
+        case MAP_CLAMPED:
+        {
+            std::vector<float> inputs = makeInputs( random, length, 1e-3f, 200.0f, { 0.0f, 100.0f, -1.0f, 50.0f } );
+            for( size_t i = 0; i < length; i += 3 ) { inputs[ i ] = -inputs[ i ]; }
+            return inputs;
+        }
+        default:
+            return makeInputs( random, length, 1e-8f, 1e3f, { 0.0f, 1.0f } );
+    }
+}
+
+//! For sparse rows, bound each output by the rounding of its row's sum: count * eps * sum |w x|.
+void accumulateSparse( Error & error, float const * out, float const * reference, Sparse const & sparse, std::vector<float> const & in )
+{
+    for( size_t row = 0; row + 1 < sparse.offsets.size(); ++row )
+    {
+        double magnitude = 0.0;
+        const size_t count = sparse.offsets[ row + 1 ] - sparse.offsets[ row ];
+        for( size_t j = 0; j < count; ++j ) { magnitude += std::abs( sparse.weights[ sparse.offsets[ row ] + j ] * in[ sparse.starts[ row ] + j ] ); }
+        const double difference = std::abs( static_cast<double>( out[ row ] ) - reference[ row ] );
+        error.ulps = std::max( error.ulps, ulpDistance( out[ row ], reference[ row ] ) );
+        error.absolute = std::max( error.absolute, magnitude > 0.0 ? difference / magnitude : difference );
+        error.outside += difference > count * std::numeric_limits<float>::epsilon() * magnitude;
+    }
+}
+
+double seconds( std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end )
+{
+    return std::chrono::duration<double>( end - start ).count();
+}
+
+int main( int argc, char * argv[] )
+{
+    const size_t length = argc > 1 ? std::max<long>( std::atol( argv[ 1 ] ), 1 ) : 1024;
+    const size_t numCalls = argc > 2 ? std::atol( argv[ 2 ] ) : 20000;
+    std::vector<Table> tables = makeTables();
+
+    size_t failures = 0;
+    std::cout << "dispatching to " << kernels::getIsaName() << "; errors against scalar over lengths 0 to 67 and " << length << std::endl;
+    std::cout << std::setw( 16 ) << "kernel" << std::setw( 8 ) << "isa" << std::setw( 12 ) << "max ulps" << std::setw( 14 ) << "max abs"
+        << std::setw( 12 ) << "outside" << std::endl;
+    for( int k = 0; k < NUM_KERNELS; ++k )
+    {
+        const Kernel kernel = static_cast<Kernel>( k );
+        for( size_t t = 1; t < tables.size(); ++t )
+        {
+            std::mt19937 random( 11 + k );
+            Error error = { 0.0, 0.0, 0 };
+            for( size_t trial = 0; trial <= 68; ++trial )
+            {
+                const size_t n = trial == 68 ? length : trial;
+                std::vector<float> in = inputsFor( kernel, random, n );
+                Sparse sparse = makeSparse( random, n, std::max<size_t>( n, 1 ) );
+                if( kernel == SPARSE_MULTIPLY && n == 0 ) { continue; }
+                std::vector<float> reference( n ), out( n );
+                run( tables[ 0 ], kernel, in, sparse, reference );
+                run( tables[ t ], kernel, in, sparse, out );
+                if( kernel == SPARSE_MULTIPLY ) { accumulateSparse( error, out.data(), reference.data(), sparse, in ); }
+                else { accumulate( error, out.data(), reference.data(), n, BOUNDS[ kernel ] ); }
+            }
+            std::cout << std::setw( 16 ) << KERNEL_NAMES[ kernel ] << std::setw( 8 ) << nameOf( tables[ t ].isa ) << std::setw( 12 ) << error.ulps
+                << std::setw( 14 ) << std::setprecision( 3 ) << error.absolute << std::setw( 12 ) << error.outside << std::endl;
+            failures += error.outside;
+        }
+    }
+
+    std::cout << length << " elements per call (rows for sparseMultiply), " << numCalls << " calls" << std::endl;
+    std::cout << std::setw( 16 ) << "kernel";
+    for( Table const & table : tables ) { std::cout << std::setw( 12 ) << nameOf( table.isa ); }
+    std::cout << "   ns/element" << std::endl;
+    for( int k = 0; k < NUM_KERNELS; ++k )
+    {
+        const Kernel kernel = static_cast<Kernel>( k );
+        std::mt19937 random( 3 );
+        std::vector<float> in = inputsFor( kernel, random, length );
+        Sparse sparse = makeSparse( random, length, length );
+        std::vector<float> out( length );
+        std::cout << std::setw( 16 ) << KERNEL_NAMES[ kernel ] << std::fixed << std::setprecision( 3 );
+        for( Table const & table : tables )
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            for( size_t call = 0; call < numCalls; ++call ) { run( table, kernel, in, sparse, out ); }
+            auto t1 = std::chrono::steady_clock::now();
+            std::cout << std::setw( 12 ) << 1e9 * seconds( t0, t1 ) / ( numCalls * length );
+        }
+        std::cout.unsetf( std::ios::fixed );
+        std::cout << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
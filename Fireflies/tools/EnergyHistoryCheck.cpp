@@ -0,0 +1,167 @@
+//
+//  EnergyHistoryCheck.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Feeds EnergyHistory and the history AudioComponent used to keep (a std::map of std::vectors,
+//  erase at the front, push_back, re-sum the average every frame) the same random band energies,
+//  and compares them after every push: the instant energy exactly, the average against the old
+//  float average, and both the average and the variance against sums taken exactly over the old
+//  history. The energies swing between loud passages and near silence, so the running sums have
+//  large values to cancel, and the once-a-lap resum has to keep them from drifting. Then times a
+//  push either way. Not part of the app target, and needs nothing from cinder:
+//      g++ -std=c++11 -O2 -I../include EnergyHistoryCheck.cpp -o EnergyHistoryCheck
+//
+//  Usage: EnergyHistoryCheck [frames per run, default 100000]
+//  Exits non-zero if any instant energy differs, or an average or variance strays past its bound.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+#include "EnergyHistory.h"
+
+//! AudioComponent's history before EnergyHistory, as it was written.
+class OldHistory
+{
+public:
+    OldHistory( int numBands, size_t historySize ) : mHistorySize( historySize ), mAverages( numBands, 0.0f )
+    {
+        for( int i = 0; i < numBands; ++i ) { this->mHistory[ i ] = std::vector<float>( historySize, 0.0f ); }
+    }
+
+    void push( float const * energies )
+    {
+        for( int i = 0; i < static_cast<int>( this->mAverages.size() ); ++i )
+        {
+            std::vector<float> & history = this->mHistory[ i ];
+            if( history.size() + 1 > this->mHistorySize ) { history.erase( history.begin() ); }
+            history.push_back( energies[ i ] );
+            float average = 0.0f;
+            for( size_t j = 0; j < history.size(); ++j ) { average += history[ j ]; }
+            this->mAverages[ i ] = average / history.size();
+        }
+    }
+
+    float getInstant( int band ) { return this->mHistory[ band ][ this->mHistorySize - 1 ]; }
+    float getAverage( int band ) const { return this->mAverages[ band ]; }
+    std::vector<float> const & getValues( int band ) { return this->mHistory[ band ]; }
+
+private:
+    size_t mHistorySize;
+    std::map<int, std::vector<float>> mHistory;
+    std::vector<float> mAverages;
+};
+
+struct Errors
+{
+    size_t instants;
+    // Largest relative difference from the old float average, and from the exact mean.
+    double fromOldAverage, fromExactAverage;
+    // Largest difference from the exact variance, relative to the exact mean square.
+    double fromExactVariance;
+};
+
+//! Energies for frame: mostly noise around a level that drifts between near silence and loud.
+void makeEnergies( std::mt19937 & random, size_t frame, int numBands, float * energies )
+{
+    std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+    const float level = std::pow( 10.0f, 4.0f * std::sin( frame * 0.003f ) - 1.0f );
+    for( int band = 0; band < numBands; ++band )
+    {
+        energies[ band ] = unit( random ) < 0.05f ? 0.0f : level * ( 0.5f + unit( random ) ) * ( band + 1 );
+    }
+}
+
+Errors compare( int numBands, size_t historySize, size_t numFrames )
+{
+    EnergyHistory history( numBands, historySize );
+    OldHistory old( numBands, historySize );
+    std::mt19937 random( static_cast<unsigned>( historySize ) );
+    std::vector<float> energies( numBands );
+    Errors errors = { 0, 0.0, 0.0, 0.0 };
+    for( size_t frame = 0; frame < numFrames; ++frame )
+    {
+        makeEnergies( random, frame, numBands, energies.data() );
+        history.push( energies.data() );
+        old.push( energies.data() );
+        for( int band = 0; band < numBands; ++band )
+        {
+            errors.instants += history.getInstant( band ) != old.getInstant( band );
+            double sum = 0.0, sumSquares = 0.0;
+            for( float value : old.getValues( band ) )
+            {
+                sum += value;
+                sumSquares += static_cast<double>( value ) * value;
+            }
+            const double mean = sum / historySize;
+            const double meanSquare = sumSquares / historySize;
+            const double variance = std::max( meanSquare - mean * mean, 0.0 );
+            const double average = history.getAverage( band );
+            if( mean > 0.0 )
+            {
+                errors.fromOldAverage = std::max( errors.fromOldAverage, std::abs( average - old.getAverage( band ) ) / mean );
+                errors.fromExactAverage = std::max( errors.fromExactAverage, std::abs( average - mean ) / mean );
+                errors.fromExactVariance = std::max( errors.fromExactVariance, std::abs( history.getVariance( band ) - variance ) / meanSquare );
+            }
+        }
+    }
+    return errors;
+}
+
+double seconds( std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end )
+{
+    return std::chrono::duration<double>( end - start ).count();
+}
+
+int main( int argc, char * argv[] )
+{
+    const size_t numFrames = argc > 1 ? std::atol( argv[ 1 ] ) : 100000;
+    const int numBands = 4;
+    // The old float sum rounds once per entry; the running doubles are rounded to float once.
+    const double averageBound = 1e-6, varianceBound = 1e-6;
+
+    size_t failures = 0;
+    std::cout << numFrames << " frames of " << numBands << " bands" << std::endl;
+    std::cout << std::setw( 10 ) << "history" << std::setw( 10 ) << "instants" << std::setw( 14 ) << "vs old avg"
+        << std::setw( 14 ) << "vs exact avg" << std::setw( 14 ) << "vs exact var" << std::endl;
+    const size_t historySizes[] = { 1, 2, 43, 100, 512 };
+    for( size_t historySize : historySizes )
+    {
+        // The old history re-sums every frame, so the long ones get fewer frames.
+        Errors errors = compare( numBands, historySize, std::min<size_t>( numFrames, 4000000 / historySize ) );
+        const double oldBound = averageBound + historySize * 6e-8;
+        std::cout << std::setw( 10 ) << historySize << std::setw( 10 ) << errors.instants << std::scientific << std::setprecision( 2 )
+            << std::setw( 14 ) << errors.fromOldAverage << std::setw( 14 ) << errors.fromExactAverage << std::setw( 14 ) << errors.fromExactVariance << std::endl;
+        std::cout.unsetf( std::ios::scientific );
+        failures += errors.instants + ( errors.fromOldAverage > oldBound ) + ( errors.fromExactAverage > averageBound )
+            + ( errors.fromExactVariance > varianceBound );
+    }
+
+    std::vector<float> energies( numBands );
+    std::mt19937 random( 1 );
+    std::cout << std::setw( 10 ) << "history" << std::setw( 14 ) << "old ns/push" << std::setw( 14 ) << "ring ns/push" << std::endl;
+    for( size_t historySize : historySizes )
+    {
+        EnergyHistory history( numBands, historySize );
+        OldHistory old( numBands, historySize );
+        const size_t frames = std::min<size_t>( numFrames, 4000000 / historySize );
+        auto t0 = std::chrono::steady_clock::now();
+        for( size_t frame = 0; frame < frames; ++frame ) { energies[ 0 ] = frame; old.push( energies.data() ); }
+        auto t1 = std::chrono::steady_clock::now();
+        for( size_t frame = 0; frame < frames; ++frame ) { energies[ 0 ] = frame; history.push( energies.data() ); }
+        auto t2 = std::chrono::steady_clock::now();
+        std::cout << std::setw( 10 ) << historySize << std::fixed << std::setprecision( 1 ) << std::setw( 14 ) << 1e9 * seconds( t0, t1 ) / frames
+            << std::setw( 14 ) << 1e9 * seconds( t1, t2 ) / frames << ( history.getAverage( 0 ) < 0.0f ? " " : "" ) << std::endl;
+        std::cout.unsetf( std::ios::fixed );
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+//
+//  LatencyHarness.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Headless audio-to-visual latency measurement, for build machines without an audio device or a
+//  display. An audio thread paced at the block rate stands in for the device callback and runs the
+//  same chain as the app's graph (ImpulseGenerator, SpectrumAnalyzer, TempoTracker, TripleBuffer);
+//  a render thread paced at the frame rate stands in for the app's update and draw. Both mark the
+//  shared LatencyProbe exactly where the app does, so the histograms cover everything except the
+//  GPU work and the swap.
+//
+//  Not part of the app target. Build against libcinder, e.g. on Linux:
+//      g++ -std=c++11 -O2 -I../include -I$CINDER_PATH/include LatencyHarness.cpp -o LatencyHarness
+//          -L$CINDER_PATH/lib/linux/x86_64/ogl/Release -lcinder -lpthread  (plus cinder's own link deps)
+//
+//  Usage: LatencyHarness [--input sample.mp3] [--seconds 30] [--fps 60] [--block 512] [--rate 44100] [--period 0.5]
+//  Without --input, a 120 BPM kick over low noise is generated.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ImpulseNode.h"
+#include "SpectrumAnalyzer.h"
+#include "TempoTracker.h"
+#include "TripleBuffer.h"
+#include "cinder/DataSource.h"
+#include "cinder/audio/Source.h"
+
+struct Options
+{
+    Options() : seconds( 30.0f ), fps( 60.0f ), framesPerBlock( 512 ), sampleRate( 44100.0f ), period( 0.5f ) {}
+
+    std::string input;
+    float seconds;
+    float fps;
+    size_t framesPerBlock;
+    float sampleRate;
+    float period;
+};
+
+//! Stereo kick drum at 120 BPM over quiet noise, long enough to loop without an audible seam.
+ci::audio::Buffer generateInput( float sampleRate )
+{
+    const size_t numFrames = static_cast<size_t>( 8.0f * sampleRate );
+    const size_t beatFrames = static_cast<size_t>( 0.5f * sampleRate );
+    ci::audio::Buffer buffer( numFrames, 2 );
+    std::srand( 1 );
+    for( size_t i = 0; i < numFrames; ++i )
+    {
+        float t = ( i % beatFrames ) / sampleRate;
+        float kick = std::sin( 2.0f * static_cast<float>( M_PI ) * 55.0f * t ) * std::exp( -t / 0.06f );
+        float noise = 0.02f * ( std::rand() / static_cast<float>( RAND_MAX ) - 0.5f );
+        buffer.getChannel( 0 )[ i ] = 0.6f * kick + noise;
+        buffer.getChannel( 1 )[ i ] = 0.6f * kick - noise;
+    }
+    return buffer;
+}
+
+int main( int argc, char * argv[] )
+{
+    Options options;
+    for( int i = 1; i + 1 < argc; i += 2 )
+    {
+        if( !std::strcmp( argv[ i ], "--input" ) ) { options.input = argv[ i + 1 ]; }
+        else if( !std::strcmp( argv[ i ], "--seconds" ) ) { options.seconds = std::atof( argv[ i + 1 ] ); }
+        else if( !std::strcmp( argv[ i ], "--fps" ) ) { options.fps = std::atof( argv[ i + 1 ] ); }
+        else if( !std::strcmp( argv[ i ], "--block" ) ) { options.framesPerBlock = std::atoi( argv[ i + 1 ] ); }
+        else if( !std::strcmp( argv[ i ], "--rate" ) ) { options.sampleRate = std::atof( argv[ i + 1 ] ); }
+        else if( !std::strcmp( argv[ i ], "--period" ) ) { options.period = std::atof( argv[ i + 1 ] ); }
+        else
+        {
+            std::cerr << "Unknown option " << argv[ i ] << std::endl;
+            return 1;
+        }
+    }
+
+    ci::audio::Buffer source = options.input.empty()
+        ? generateInput( options.sampleRate )
+        : *ci::audio::load( ci::loadFile( options.input ), options.sampleRate )->loadBuffer();
+    if( source.getNumFrames() < options.framesPerBlock )
+    {
+        std::cerr << "Input is shorter than a block" << std::endl;
+        return 1;
+    }
+
+    // Same settings as AudioComponent::setup().
+    const size_t fpb = options.framesPerBlock;
+    const float gain = 0.5f;
+    SpectrumAnalyzer analyzer;
+    const size_t hopSize = std::min<size_t>( 256, fpb );
+    analyzer.setup( 2048, 1024, AnalysisWindow::BLACKMAN, 0.5f, options.sampleRate, hopSize, 10.0f );
+    analyzer.setNumBands( 4 );
+    analyzer.setHistoryDuration( 1.0f );
+    analyzer.reset();
+    TempoTracker tempo;
+    tempo.setup( analyzer.getNumBins(), options.sampleRate / fpb, 0.5f * analyzer.getWindowSize() / options.sampleRate );
+    TripleBuffer<AnalysisFrame> frames;
+    AnalysisFrame initial;
+    analyzer.makeFrame( initial );
+    frames.reset( initial );
+    std::vector<AnalysisFrame> hopFrames( ( fpb + hopSize - 1 ) / hopSize, initial );
+
+    ImpulseGenerator impulses( static_cast<size_t>( options.period * options.sampleRate ) );
+    LatencyProbe & probe = LatencyProbe::instance();
+    probe.setEnabled( true );
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + std::chrono::microseconds( static_cast<long long>( options.seconds * 1e6f ) );
+    std::atomic<bool> running( true );
+
+    std::thread audio( [&]
+    {
+        ci::audio::Buffer block( fpb, source.getNumChannels() );
+        const std::chrono::nanoseconds blockDuration( static_cast<long long>( 1e9 * fpb / options.sampleRate ) );
+        size_t readPosition = 0;
+        for( std::uint64_t k = 0; running; ++k )
+        {
+            // A device calls back once it has room for another block.
+            std::this_thread::sleep_until( start + blockDuration * k );
+
+            for( size_t i = 0; i < fpb; ++i )
+            {
+                for( size_t ch = 0; ch < block.getNumChannels(); ++ch )
+                {
+                    block.getChannel( ch )[ i ] = source.getChannel( ch )[ readPosition ];
+                }
+                readPosition = ( readPosition + 1 ) % source.getNumFrames();
+            }
+
+            const std::uint64_t sampleTime = k * fpb;
+            impulses.process( &block, sampleTime );
+
+            AnalysisFrame & frame = frames.getWriteBuffer();
+            size_t numHops = analyzer.processHops( block, 0, fpb, hopFrames.data(), hopFrames.size(), gain );
+            SpectrumAnalyzer::merge( hopFrames.data(), std::min( numHops, hopFrames.size() ), frame );
+            frame.sampleTime = sampleTime;
+            frame.time = sampleTime / static_cast<double>( options.sampleRate );
+            tempo.process( frame.magSpectrum.data() );
+            frame.bpm = tempo.getBpm();
+            frame.tempoConfidence = tempo.getConfidence();
+            frame.nextBeatTime = frame.time + tempo.getTimeToNextBeat();
+            frames.publish();
+            probe.mark( LatencyProbe::ANALYSIS, sampleTime );
+        }
+    } );
+
+    // Render loop on the main thread, ticking like a vsynced window.
+    const std::chrono::nanoseconds frameDuration( static_cast<long long>( 1e9 / options.fps ) );
+    std::vector<float> beats;
+    for( std::uint64_t n = 1; Clock::now() < end; ++n )
+    {
+        std::this_thread::sleep_until( start + frameDuration * n );
+
+        frames.update();
+        AnalysisFrame const & frame = frames.getReadBuffer();
+        probe.mark( LatencyProbe::AUDIO_UPDATE, frame.sampleTime );
+
+        // What SceneComponent::update() does before uploading uniforms.
+        beats.assign( frame.beats.begin(), frame.beats.begin() + frame.numBands );
+        for( auto & beat : beats )
+        {
+            beat += 0.1f;
+        }
+        probe.mark( LatencyProbe::SCENE_UPDATE, frame.sampleTime );
+
+        probe.mark( LatencyProbe::DRAW, frame.sampleTime );
+    }
+    running = false;
+    audio.join();
+
+    std::cout << "Input: " << ( options.input.empty() ? "generated" : options.input ) << ", " << options.sampleRate << " Hz, "
+        << fpb << " frames per block, " << options.fps << " fps, " << options.seconds << "s" << std::endl;
+    probe.report( std::cout );
+    return 0;
+}
@@ -0,0 +1,430 @@
+//
+//  NoiseBenchmark.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Checks noise::snoise(), cnoise() and pnoise() and every width of the batch kernels against a
+//  line-by-line transcription of the shader's noise (vector types, swizzles and all), which they
+//  must match to the bit, then times evaluations per second for each, and for a NoiseVolume along
+//  with how far its samples stray from the pnoise() it caches. One thread throughout. Not part of
+//  the app target, and needs nothing from cinder:
+//      g++ -std=c++11 -O2 -I../include NoiseBenchmark.cpp -o NoiseBenchmark -lpthread
+//
+//  Usage: NoiseBenchmark [points per run, default 1000000] [runs, default 5]
+//  Exits non-zero if any evaluation differs from the transcription, or the volume doesn't wrap.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "NoiseVolume.h"
+#include "SimplexNoise.h"
+
+// The noise functions of particleUpdate.vs as written, on just enough GLSL to run them.
+namespace glsl {
+
+struct vec3
+{
+    float x, y, z;
+};
+
+struct vec4
+{
+    float x, y, z, w;
+};
+
+vec3 v3( float x, float y, float z ) { vec3 v = { x, y, z }; return v; }
+vec4 v4( float x, float y, float z, float w ) { vec4 v = { x, y, z, w }; return v; }
+vec3 operator+( vec3 a, vec3 b ) { return v3( a.x + b.x, a.y + b.y, a.z + b.z ); }
+vec3 operator-( vec3 a, vec3 b ) { return v3( a.x - b.x, a.y - b.y, a.z - b.z ); }
+vec3 operator*( vec3 a, vec3 b ) { return v3( a.x * b.x, a.y * b.y, a.z * b.z ); }
+vec3 operator+( vec3 a, float b ) { return v3( a.x + b, a.y + b, a.z + b ); }
+vec3 operator-( vec3 a, float b ) { return v3( a.x - b, a.y - b, a.z - b ); }
+vec3 operator*( vec3 a, float b ) { return v3( a.x * b, a.y * b, a.z * b ); }
+vec3 operator-( float a, vec3 b ) { return v3( a - b.x, a - b.y, a - b.z ); }
+vec3 & operator*=( vec3 & a, float b ) { a = a * b; return a; }
+vec4 operator+( vec4 a, vec4 b ) { return v4( a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w ); }
+vec4 operator-( vec4 a, vec4 b ) { return v4( a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w ); }
+vec4 operator*( vec4 a, vec4 b ) { return v4( a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w ); }
+vec4 operator+( vec4 a, float b ) { return v4( a.x + b, a.y + b, a.z + b, a.w + b ); }
+vec4 operator-( vec4 a, float b ) { return v4( a.x - b, a.y - b, a.z - b, a.w - b ); }
+vec4 operator*( vec4 a, float b ) { return v4( a.x * b, a.y * b, a.z * b, a.w * b ); }
+vec4 operator+( float a, vec4 b ) { return v4( a + b.x, a + b.y, a + b.z, a + b.w ); }
+vec4 operator-( float a, vec4 b ) { return v4( a - b.x, a - b.y, a - b.z, a - b.w ); }
+vec4 operator*( float a, vec4 b ) { return b * a; }
+vec4 operator-( vec4 a ) { return v4( -a.x, -a.y, -a.z, -a.w ); }
+vec4 & operator-=( vec4 & a, vec4 b ) { a = a - b; return a; }
+vec3 floor( vec3 a ) { return v3( std::floor( a.x ), std::floor( a.y ), std::floor( a.z ) ); }
+vec4 floor( vec4 a ) { return v4( std::floor( a.x ), std::floor( a.y ), std::floor( a.z ), std::floor( a.w ) ); }
+vec3 fract( vec3 a ) { return a - floor( a ); }
+vec4 fract( vec4 a ) { return a - floor( a ); }
+vec3 mod( vec3 a, vec3 b ) { return v3( a.x - b.x * std::floor( a.x / b.x ), a.y - b.y * std::floor( a.y / b.y ), a.z - b.z * std::floor( a.z / b.z ) ); }
+vec4 abs( vec4 a ) { return v4( std::fabs( a.x ), std::fabs( a.y ), std::fabs( a.z ), std::fabs( a.w ) ); }
+float step( float e, float x ) { return x < e ? 0.0f : 1.0f; }
+vec3 step( vec3 e, vec3 x ) { return v3( step( e.x, x.x ), step( e.y, x.y ), step( e.z, x.z ) ); }
+vec4 step( vec4 e, vec4 x ) { return v4( step( e.x, x.x ), step( e.y, x.y ), step( e.z, x.z ), step( e.w, x.w ) ); }
+vec4 step( float e, vec4 x ) { return step( v4( e, e, e, e ), x ); }
+vec3 min( vec3 a, vec3 b ) { return v3( std::min( a.x, b.x ), std::min( a.y, b.y ), std::min( a.z, b.z ) ); }
+vec3 max( vec3 a, vec3 b ) { return v3( std::max( a.x, b.x ), std::max( a.y, b.y ), std::max( a.z, b.z ) ); }
+vec4 max( vec4 a, float b ) { return v4( std::max( a.x, b ), std::max( a.y, b ), std::max( a.z, b ), std::max( a.w, b ) ); }
+float dot( vec3 a, vec3 b ) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+float dot( vec4 a, vec4 b ) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+float mix( float x, float y, float a ) { return x * ( 1.0f - a ) + y * a; }
+vec4 mix( vec4 x, vec4 y, float a ) { return v4( mix( x.x, y.x, a ), mix( x.y, y.y, a ), mix( x.z, y.z, a ), mix( x.w, y.w, a ) ); }
+
+vec3 mod289( vec3 x ) { return x - floor( x * ( 1.0f / 289.0f ) ) * 289.0f; }
+vec4 mod289( vec4 x ) { return x - floor( x * ( 1.0f / 289.0f ) ) * 289.0f; }
+vec4 permute( vec4 x ) { return mod289( ( ( x * 34.0f ) + 1.0f ) * x ); }
+vec4 taylorInvSqrt( vec4 r ) { return 1.79284291400159f - 0.85373472095314f * r; }
+vec3 fade( vec3 t ) { return t * t * t * ( t * ( t * 6.0f - 15.0f ) + 10.0f ); }
+
+float snoise( vec3 v )
+{
+    const float Cx = 1.0f / 6.0f, Cy = 1.0f / 3.0f;
+    const vec4 D = v4( 0.0f, 0.5f, 1.0f, 2.0f );
+
+    vec3 i = floor( v + dot( v, v3( Cy, Cy, Cy ) ) );
+    vec3 x0 = v - i + dot( i, v3( Cx, Cx, Cx ) );
+
+    vec3 g = step( v3( x0.y, x0.z, x0.x ), x0 );
+    vec3 l = 1.0f - g;
+    vec3 i1 = min( g, v3( l.z, l.x, l.y ) );
+    vec3 i2 = max( g, v3( l.z, l.x, l.y ) );
+
+    vec3 x1 = x0 - i1 + Cx;
+    vec3 x2 = x0 - i2 + Cy;
+    vec3 x3 = x0 - D.y;
+
+    i = mod289( i );
+    vec4 p = permute( permute( permute(
+                i.z + v4( 0.0f, i1.z, i2.z, 1.0f ) )
+              + i.y + v4( 0.0f, i1.y, i2.y, 1.0f ) )
+              + i.x + v4( 0.0f, i1.x, i2.x, 1.0f ) );
+
+    float n_ = 0.142857142857f;
+    vec3 ns = v3( n_ * D.w - D.x, n_ * D.y - D.z, n_ * D.z - D.x );
+
+    vec4 j = p - 49.0f * floor( p * ns.z * ns.z );
+    vec4 x_ = floor( j * ns.z );
+    vec4 y_ = floor( j - 7.0f * x_ );
+    vec4 x = x_ * ns.x + ns.y;
+    vec4 y = y_ * ns.x + ns.y;
+    vec4 h = 1.0f - abs( x ) - abs( y );
+
+    vec4 b0 = v4( x.x, x.y, y.x, y.y );
+    vec4 b1 = v4( x.z, x.w, y.z, y.w );
+    vec4 s0 = floor( b0 ) * 2.0f + 1.0f;
+    vec4 s1 = floor( b1 ) * 2.0f + 1.0f;
+    vec4 sh = -step( h, v4( 0.0f, 0.0f, 0.0f, 0.0f ) );
+
+    vec4 a0 = v4( b0.x, b0.z, b0.y, b0.w ) + v4( s0.x, s0.z, s0.y, s0.w ) * v4( sh.x, sh.x, sh.y, sh.y );
+    vec4 a1 = v4( b1.x, b1.z, b1.y, b1.w ) + v4( s1.x, s1.z, s1.y, s1.w ) * v4( sh.z, sh.z, sh.w, sh.w );
+
+    vec3 p0 = v3( a0.x, a0.y, h.x );
+    vec3 p1 = v3( a0.z, a0.w, h.y );
+    vec3 p2 = v3( a1.x, a1.y, h.z );
+    vec3 p3 = v3( a1.z, a1.w, h.w );
+
+    vec4 norm = taylorInvSqrt( v4( dot( p0, p0 ), dot( p1, p1 ), dot( p2, p2 ), dot( p3, p3 ) ) );
+    p0 = p0 * norm.x;
+    p1 = p1 * norm.y;
+    p2 = p2 * norm.z;
+    p3 = p3 * norm.w;
+
+    vec4 m = max( 0.6f - v4( dot( x0, x0 ), dot( x1, x1 ), dot( x2, x2 ), dot( x3, x3 ) ), 0.0f );
+    m = m * m;
+    return 42.0f * dot( m * m, v4( dot( p0, x0 ), dot( p1, x1 ), dot( p2, x2 ), dot( p3, x3 ) ) );
+}
+
+//! cnoise() and pnoise() from the line after Pi0 and Pi1 are reduced mod 289.
+float perlin( vec3 P, vec3 Pi0, vec3 Pi1 )
+{
+    vec3 Pf0 = fract( P );
+    vec3 Pf1 = Pf0 - 1.0f;
+    vec4 ix = v4( Pi0.x, Pi1.x, Pi0.x, Pi1.x );
+    vec4 iy = v4( Pi0.y, Pi0.y, Pi1.y, Pi1.y );
+    vec4 iz0 = v4( Pi0.z, Pi0.z, Pi0.z, Pi0.z );
+    vec4 iz1 = v4( Pi1.z, Pi1.z, Pi1.z, Pi1.z );
+
+    vec4 ixy = permute( permute( ix ) + iy );
+    vec4 ixy0 = permute( ixy + iz0 );
+    vec4 ixy1 = permute( ixy + iz1 );
+
+    vec4 gx0 = ixy0 * ( 1.0f / 7.0f );
+    vec4 gy0 = fract( floor( gx0 ) * ( 1.0f / 7.0f ) ) - 0.5f;
+    gx0 = fract( gx0 );
+    vec4 gz0 = v4( 0.5f, 0.5f, 0.5f, 0.5f ) - abs( gx0 ) - abs( gy0 );
+    vec4 sz0 = step( gz0, v4( 0.0f, 0.0f, 0.0f, 0.0f ) );
+    gx0 -= sz0 * ( step( 0.0f, gx0 ) - 0.5f );
+    gy0 -= sz0 * ( step( 0.0f, gy0 ) - 0.5f );
+
+    vec4 gx1 = ixy1 * ( 1.0f / 7.0f );
+    vec4 gy1 = fract( floor( gx1 ) * ( 1.0f / 7.0f ) ) - 0.5f;
+    gx1 = fract( gx1 );
+    vec4 gz1 = v4( 0.5f, 0.5f, 0.5f, 0.5f ) - abs( gx1 ) - abs( gy1 );
+    vec4 sz1 = step( gz1, v4( 0.0f, 0.0f, 0.0f, 0.0f ) );
+    gx1 -= sz1 * ( step( 0.0f, gx1 ) - 0.5f );
+    gy1 -= sz1 * ( step( 0.0f, gy1 ) - 0.5f );
+
+    vec3 g000 = v3( gx0.x, gy0.x, gz0.x );
+    vec3 g100 = v3( gx0.y, gy0.y, gz0.y );
+    vec3 g010 = v3( gx0.z, gy0.z, gz0.z );
+    vec3 g110 = v3( gx0.w, gy0.w, gz0.w );
+    vec3 g001 = v3( gx1.x, gy1.x, gz1.x );
+    vec3 g101 = v3( gx1.y, gy1.y, gz1.y );
+    vec3 g011 = v3( gx1.z, gy1.z, gz1.z );
+    vec3 g111 = v3( gx1.w, gy1.w, gz1.w );
+
+    vec4 norm0 = taylorInvSqrt( v4( dot( g000, g000 ), dot( g010, g010 ), dot( g100, g100 ), dot( g110, g110 ) ) );
+    g000 *= norm0.x;
+    g010 *= norm0.y;
+    g100 *= norm0.z;
+    g110 *= norm0.w;
+    vec4 norm1 = taylorInvSqrt( v4( dot( g001, g001 ), dot( g011, g011 ), dot( g101, g101 ), dot( g111, g111 ) ) );
+    g001 *= norm1.x;
+    g011 *= norm1.y;
+    g101 *= norm1.z;
+    g111 *= norm1.w;
+
+    float n000 = dot( g000, Pf0 );
+    float n100 = dot( g100, v3( Pf1.x, Pf0.y, Pf0.z ) );
+    float n010 = dot( g010, v3( Pf0.x, Pf1.y, Pf0.z ) );
+    float n110 = dot( g110, v3( Pf1.x, Pf1.y, Pf0.z ) );
+    float n001 = dot( g001, v3( Pf0.x, Pf0.y, Pf1.z ) );
+    float n101 = dot( g101, v3( Pf1.x, Pf0.y, Pf1.z ) );
+    float n011 = dot( g011, v3( Pf0.x, Pf1.y, Pf1.z ) );
+    float n111 = dot( g111, Pf1 );
+
+    vec3 fade_xyz = fade( Pf0 );
+    vec4 n_z = mix( v4( n000, n100, n010, n110 ), v4( n001, n101, n011, n111 ), fade_xyz.z );
+    float n_yz_x = mix( n_z.x, n_z.z, fade_xyz.y );
+    float n_yz_y = mix( n_z.y, n_z.w, fade_xyz.y );
+    float n_xyz = mix( n_yz_x, n_yz_y, fade_xyz.x );
+    return 2.2f * n_xyz;
+}
+
+float cnoise( vec3 P )
+{
+    vec3 Pi0 = floor( P );
+    vec3 Pi1 = Pi0 + 1.0f;
+    Pi0 = mod289( Pi0 );
+    Pi1 = mod289( Pi1 );
+    return perlin( P, Pi0, Pi1 );
+}
+
+float pnoise( vec3 P, vec3 rep )
+{
+    vec3 Pi0 = mod( floor( P ), rep );
+    vec3 Pi1 = mod( Pi0 + 1.0f, rep );
+    Pi0 = mod289( Pi0 );
+    Pi1 = mod289( Pi1 );
+    return perlin( P, Pi0, Pi1 );
+}
+
+} // namespace glsl
+
+typedef void ( *BatchNoise )( float const *, float const *, float const *, float *, size_t );
+
+struct Points
+{
+    std::vector<float> x, y, z;
+};
+
+//! Spots the simulation samples (pixels and seconds), plus negative, large, whole and half-way ones.
+Points makePoints( size_t count, unsigned seed )
+{
+    std::mt19937 random( seed );
+    std::uniform_real_distribution<float> pixels( -64.0f, 2048.0f ), seconds( 0.0f, 600.0f ), wide( -1e5f, 1e5f );
+    Points points;
+    points.x.resize( count );
+    points.y.resize( count );
+    points.z.resize( count );
+    for( size_t i = 0; i < count; ++i )
+    {
+        switch( i % 8 )
+        {
+            case 5: points.x[ i ] = wide( random ); points.y[ i ] = wide( random ); points.z[ i ] = wide( random ); break;
+            case 6: points.x[ i ] = std::floor( pixels( random ) ); points.y[ i ] = std::floor( pixels( random ) ); points.z[ i ] = 0.0f; break;
+            case 7: points.x[ i ] = std::floor( pixels( random ) ) + 0.5f; points.y[ i ] = -0.0f; points.z[ i ] = std::floor( seconds( random ) ) - 0.5f; break;
+            default: points.x[ i ] = pixels( random ); points.y[ i ] = pixels( random ); points.z[ i ] = seconds( random ); break;
+        }
+    }
+    return points;
+}
+
+//! How many of count values differ from reference in any bit.
+size_t countMismatches( float const * values, float const * reference, size_t count )
+{
+    size_t mismatches = 0;
+    for( size_t i = 0; i < count; ++i )
+    {
+        if( std::memcmp( values + i, reference + i, sizeof(float) ) != 0 ) { ++mismatches; }
+    }
+    return mismatches;
+}
+
+bool checkParity()
+{
+    // Odd, so every width has a tail to fall back on.
+    const size_t count = 200003;
+    const Points points = makePoints( count, 3 );
+    const float * x = points.x.data(), * y = points.y.data(), * z = points.z.data();
+    std::vector<float> simplex( count ), perlin( count ), periodic( count ), out( count );
+    for( size_t i = 0; i < count; ++i )
+    {
+        simplex[ i ] = glsl::snoise( glsl::v3( x[ i ], y[ i ], z[ i ] ) );
+        perlin[ i ] = glsl::cnoise( glsl::v3( x[ i ], y[ i ], z[ i ] ) );
+        periodic[ i ] = glsl::pnoise( glsl::v3( x[ i ], y[ i ], z[ i ] ), glsl::v3( 16.0f, 16.0f, 5.0f ) );
+    }
+
+    size_t failures = 0;
+    auto report = [&]( std::string const & name, size_t mismatches )
+    {
+        std::cout << std::setw( 16 ) << name << ": " << mismatches << " of " << count << " differ from the transcription" << std::endl;
+        failures += mismatches;
+    };
+    for( size_t i = 0; i < count; ++i ) { out[ i ] = noise::snoise( x[ i ], y[ i ], z[ i ] ); }
+    report( "snoise", countMismatches( out.data(), simplex.data(), count ) );
+    for( size_t i = 0; i < count; ++i ) { out[ i ] = noise::cnoise( x[ i ], y[ i ], z[ i ] ); }
+    report( "cnoise", countMismatches( out.data(), perlin.data(), count ) );
+    for( size_t i = 0; i < count; ++i ) { out[ i ] = noise::pnoise( x[ i ], y[ i ], z[ i ], 16.0f, 16.0f, 5.0f ); }
+    report( "pnoise", countMismatches( out.data(), periodic.data(), count ) );
+
+    struct Batch { std::string name; BatchNoise function; std::vector<float> const * reference; };
+    std::vector<Batch> batches;
+#if DSP_KERNELS_X86
+    batches.push_back( { "snoise SSE2", kernels::detail::snoiseSse2, &simplex } );
+    batches.push_back( { "cnoise SSE2", kernels::detail::cnoiseSse2, &perlin } );
+    if( kernels::getIsa() == kernels::Isa::AVX2 )
+    {
+        batches.push_back( { "snoise AVX2", kernels::detail::snoiseAvx2, &simplex } );
+        batches.push_back( { "cnoise AVX2", kernels::detail::cnoiseAvx2, &perlin } );
+    }
+#endif
+    for( auto const & batch : batches )
+    {
+        batch.function( x, y, z, out.data(), count );
+        report( batch.name, countMismatches( out.data(), batch.reference->data(), count ) );
+    }
+    return failures == 0;
+}
+
+//! Largest and root mean square difference between a volume's samples and the pnoise() it holds,
+//! and whether it wraps.
+bool checkVolume( NoiseVolume const & volume )
+{
+    const size_t count = 200000;
+    const Points points = makePoints( count, 5 );
+    std::vector<float> sampled( count );
+    volume.sample( points.x.data(), points.y.data(), points.z.data(), sampled.data(), count );
+    const float period = volume.getPeriod();
+    double maxError = 0.0, sumSquares = 0.0, sumSquaresNoise = 0.0, maxWrapError = 0.0;
+    for( size_t i = 0; i < count; ++i )
+    {
+        // Keep to coordinates small enough that adding a period is exact.
+        const float x = std::fmod( points.x[ i ], 4096.0f ), y = std::fmod( points.y[ i ], 4096.0f ), z = std::fmod( points.z[ i ], 4096.0f );
+        const float exact = noise::pnoise( x, y, z, period, period, period );
+        const double error = volume.sample( x, y, z ) - exact;
+        maxError = std::max( maxError, std::fabs( error ) );
+        sumSquares += error * error;
+        sumSquaresNoise += static_cast<double>( exact ) * exact;
+        maxWrapError = std::max( maxWrapError, static_cast<double>( std::fabs( volume.sample( x + period, y - period, z + 2.0f * period ) - volume.sample( x, y, z ) ) ) );
+    }
+    std::cout << "volume " << volume.getResolution() << "^3 over a period of " << period << " (" << volume.getSize() / 1024 << " KB): "
+        << "max error " << maxError << ", rms error " << std::sqrt( sumSquares / count ) << " against rms noise " << std::sqrt( sumSquaresNoise / count )
+        << ", max difference one period over " << maxWrapError << std::endl;
+    return maxWrapError < 1e-4;
+}
+
+double seconds( std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end )
+{
+    return std::chrono::duration<double>( end - start ).count();
+}
+
+//! Best of numRuns timings of fn over the points, in millions of evaluations per second.
+double measure( Points const & points, size_t numRuns, std::function<void ( float const *, float const *, float const *, float *, size_t )> const & fn )
+{
+    const size_t count = points.x.size();
+    std::vector<float> out( count );
+    double best = 1e30;
+    for( size_t run = 0; run < numRuns; ++run )
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        fn( points.x.data(), points.y.data(), points.z.data(), out.data(), count );
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min( best, seconds( t0, t1 ) );
+    }
+    return 1e-6 * count / best;
+}
+
+int main( int argc, char * argv[] )
+{
+    const size_t count = argc > 1 ? std::atol( argv[ 1 ] ) : 1000000;
+    const size_t numRuns = argc > 2 ? std::atol( argv[ 2 ] ) : 5;
+
+    if( !checkParity() ) { return 1; }
+
+    ThreadPool threads;
+    NoiseVolume volume;
+    auto t0 = std::chrono::steady_clock::now();
+    volume.build( threads );
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout << "volume built in " << std::fixed << std::setprecision( 1 ) << 1e3 * seconds( t0, t1 ) << " ms on "
+        << threads.getNumThreads() << " thread(s)" << std::endl << std::defaultfloat << std::setprecision( 6 );
+    if( !checkVolume( volume ) ) { return 1; }
+
+    const Points points = makePoints( count, 1 );
+    std::cout << std::setw( 28 ) << "path" << std::setw( 14 ) << "Mevals/s" << std::setw( 12 ) << "ns/eval" << std::endl;
+    auto row = [&]( std::string const & name, std::function<void ( float const *, float const *, float const *, float *, size_t )> const & fn )
+    {
+        const double rate = measure( points, numRuns, fn );
+        std::cout << std::setw( 28 ) << name << std::fixed << std::setprecision( 2 ) << std::setw( 14 ) << rate
+            << std::setw( 12 ) << 1e3 / rate << std::endl;
+    };
+    row( "snoise transcription", []( float const * x, float const * y, float const * z, float * out, size_t n )
+    {
+        for( size_t i = 0; i < n; ++i ) { out[ i ] = glsl::snoise( glsl::v3( x[ i ], y[ i ], z[ i ] ) ); }
+    } );
+    row( "snoise scalar", kernels::detail::snoiseScalar );
+#if DSP_KERNELS_X86
+    row( "snoise SSE2", kernels::detail::snoiseSse2 );
+    if( kernels::getIsa() == kernels::Isa::AVX2 ) { row( "snoise AVX2", kernels::detail::snoiseAvx2 ); }
+#endif
+    row( "cnoise transcription", []( float const * x, float const * y, float const * z, float * out, size_t n )
+    {
+        for( size_t i = 0; i < n; ++i ) { out[ i ] = glsl::cnoise( glsl::v3( x[ i ], y[ i ], z[ i ] ) ); }
+    } );
+    row( "cnoise scalar", kernels::detail::cnoiseScalar );
+#if DSP_KERNELS_X86
+    row( "cnoise SSE2", kernels::detail::cnoiseSse2 );
+    if( kernels::getIsa() == kernels::Isa::AVX2 ) { row( "cnoise AVX2", kernels::detail::cnoiseAvx2 ); }
+#endif
+    row( "volume", [&]( float const * x, float const * y, float const * z, float * out, size_t n )
+    {
+        volume.sample( x, y, z, out, n );
+    } );
+    row( "volume, one point at a time", [&]( float const * x, float const * y, float const * z, float * out, size_t n )
+    {
+        for( size_t i = 0; i < n; ++i ) { out[ i ] = volume.sample( x[ i ], y[ i ], z[ i ] ); }
+    } );
+    // As the simulation samples it: pixels across the window, all at one time.
+    Points window = makePoints( count, 2 );
+    std::fill( window.z.begin(), window.z.end(), 12.25f );
+    const double rate = measure( window, numRuns, [&]( float const * x, float const * y, float const * z, float * out, size_t n )
+    {
+        volume.sample( x, y, z, out, n );
+    } );
+    std::cout << std::setw( 28 ) << "volume, one time slice" << std::fixed << std::setprecision( 2 ) << std::setw( 14 ) << rate
+        << std::setw( 12 ) << 1e3 / rate << std::endl;
+    return 0;
+}
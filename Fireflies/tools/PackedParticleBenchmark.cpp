@@ -0,0 +1,191 @@
+//
+//  PackedParticleBenchmark.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Checks the PackedParticle conversions (every half float, against F16C where the CPU has it, and
+//  the worst quantization error per field), then compares a CPU backend frame in both layouts:
+//  step, store into the upload format, and copy out as bufferSubData would. Not part of the app
+//  target; build like ParticleBenchmark:
+//      g++ -std=c++11 -O2 -I../include -I$CINDER_PATH/include PackedParticleBenchmark.cpp -o PackedParticleBenchmark
+//          -L$CINDER_PATH/lib/linux/x86_64/ogl/Release -lcinder -lpthread  (plus cinder's own link deps)
+//
+//  Usage: PackedParticleBenchmark [largest particle count, default 1000000] [frames per run, default 10]
+//  Exits non-zero if a conversion is wrong or ParticleSimulator packs differently from encode().
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "ParticleSimulator.h"
+
+#if DSP_KERNELS_X86
+
+__attribute__(( target( "f16c" ) ))
+std::uint16_t toHalfF16c( float value )
+{
+    return static_cast<std::uint16_t>( _cvtss_sh( value, 0 ) );
+}
+
+__attribute__(( target( "f16c" ) ))
+float fromHalfF16c( std::uint16_t half )
+{
+    return _cvtsh_ss( half );
+}
+
+#endif
+
+//! The same particles ParticleBenchmark steps.
+std::vector<Particle> makeParticles( size_t count )
+{
+    const int numGroups = 4;
+    std::vector<Particle> particles( count );
+    std::srand( 1 );
+    for( size_t i = 0; i < count; ++i )
+    {
+        auto random = [] { return std::rand() / static_cast<float>( RAND_MAX ); };
+        Particle & p = particles[ i ];
+        p.groupId = static_cast<float>( i * numGroups / count );
+        p.pos = ci::vec3( random() * 1280.0f, random() * 720.0f, 0.0f );
+        p.home = ci::vec3( p.pos.x / 1280.0f, p.pos.y / 720.0f, 0.0f );
+        p.ppos = p.pos + ci::vec3( random() - 0.5f, random() - 0.5f, random() - 0.5f );
+        p.damping = 0.7f + 0.25f * random();
+        p.size = 2.0f + 62.0f * random();
+        p.color = ci::ColorA( 1.0f, 0.8f, 0.2f, std::min( 32.0f / p.size, 1.0f ) );
+    }
+    return particles;
+}
+
+bool checkConversions()
+{
+    using namespace packing;
+    size_t failures = 0;
+    for( std::uint32_t h = 0; h < 0x10000; ++h )
+    {
+        const std::uint16_t half = static_cast<std::uint16_t>( h );
+        const float value = fromHalf( half );
+        const bool roundTrips = std::isnan( value ) ? std::isnan( fromHalf( toHalf( value ) ) ) : toHalf( value ) == half;
+        if( !roundTrips ) { ++failures; }
+    }
+    std::cout << "half -> float -> half over all 65536 halves: " << failures << " failures" << std::endl;
+
+#if DSP_KERNELS_X86
+    if( __builtin_cpu_supports( "f16c" ) )
+    {
+        size_t mismatches = 0, checked = 0;
+        for( std::uint64_t bits = 0; bits <= 0xffffffffu; bits += 61 )
+        {
+            float value;
+            const std::uint32_t b = static_cast<std::uint32_t>( bits );
+            std::memcpy( &value, &b, sizeof(value) );
+            const std::uint16_t expected = toHalfF16c( value );
+            const std::uint16_t actual = toHalf( value );
+            // Any NaN will do for a NaN.
+            const bool same = std::isnan( value ) ? ( actual & 0x7c00u ) == 0x7c00u && ( actual & 0x3ffu ) != 0 : actual == expected;
+            if( !same ) { ++mismatches; }
+            ++checked;
+        }
+        for( std::uint32_t h = 0; h < 0x10000; ++h )
+        {
+            const float expected = fromHalfF16c( static_cast<std::uint16_t>( h ) );
+            const float actual = fromHalf( static_cast<std::uint16_t>( h ) );
+            if( std::memcmp( &expected, &actual, sizeof(float) ) != 0 && !( std::isnan( expected ) && std::isnan( actual ) ) ) { ++mismatches; }
+        }
+        std::cout << "against F16C over " << checked << " floats and every half: " << mismatches << " mismatches" << std::endl;
+        failures += mismatches;
+    }
+#endif
+
+    // Quantization error on the particles the app makes.
+    std::vector<Particle> particles = makeParticles( 100000 );
+    float maxError[ 6 ] = {};
+    for( Particle const & original : particles )
+    {
+        Particle decoded = decode( encode( original ) );
+        maxError[ 0 ] = std::max( { maxError[ 0 ], std::fabs( decoded.pos.x - original.pos.x ), std::fabs( decoded.ppos.x - original.ppos.x ) } );
+        maxError[ 1 ] = std::max( { maxError[ 1 ], std::fabs( decoded.home.x - original.home.x ), std::fabs( decoded.home.y - original.home.y ) } );
+        maxError[ 2 ] = std::max( { maxError[ 2 ], std::fabs( decoded.color.g - original.color.g ), std::fabs( decoded.color.a - original.color.a ) } );
+        maxError[ 3 ] = std::max( maxError[ 3 ], std::fabs( decoded.size - original.size ) );
+        maxError[ 4 ] = std::max( maxError[ 4 ], std::fabs( decoded.damping - original.damping ) );
+        maxError[ 5 ] = std::max( maxError[ 5 ], std::fabs( decoded.groupId - original.groupId ) );
+    }
+    std::cout << "encode/decode max error: pos " << maxError[ 0 ] << ", home " << maxError[ 1 ] << " (" << maxError[ 1 ] * 1280.0f << " px), color " << maxError[ 2 ]
+        << ", size " << maxError[ 3 ] << " px, damping " << maxError[ 4 ] << ", group " << maxError[ 5 ] << std::endl;
+    if( maxError[ 0 ] != 0.0f || maxError[ 5 ] != 0.0f ) { ++failures; }
+    return failures == 0;
+}
+
+int main( int argc, char * argv[] )
+{
+    const size_t maxParticles = argc > 1 ? std::atol( argv[ 1 ] ) : 1000000;
+    const size_t numFrames = argc > 2 ? std::atol( argv[ 2 ] ) : 10;
+
+    if( !checkConversions() ) { return 1; }
+
+    // The simulation's own arrays are the same in both layouts: a step reads pos, ppos, home,
+    // damping, groupId and alpha and writes pos, ppos and alpha back.
+    const size_t stepBytes = ( 12 + 7 ) * sizeof(float);
+    std::cout << "bytes per particle per frame (step + store + upload + draw fetch):" << std::endl;
+    std::cout << "    float  " << stepBytes << " + " << sizeof(Particle) << " + " << sizeof(Particle) << " + " << sizeof(Particle)
+        << " = " << stepBytes + 3 * sizeof(Particle) << std::endl;
+    std::cout << "    packed " << stepBytes << " + " << sizeof(PackedParticle) << " + " << sizeof(PackedParticle) << " + " << sizeof(PackedParticle)
+        << " = " << stepBytes + 3 * sizeof(PackedParticle) << std::endl;
+
+    std::cout << std::setw( 10 ) << "particles" << std::setw( 10 ) << "step ms" << std::setw( 14 ) << "float store" << std::setw( 10 ) << "upload"
+        << std::setw( 15 ) << "packed store" << std::setw( 10 ) << "upload" << std::setw( 16 ) << "frame Mp/s f/p" << std::endl;
+    ParticleSimulator simulator;
+    for( size_t count = 1000; count <= maxParticles; count *= 10 )
+    {
+        std::vector<Particle> particles = makeParticles( count );
+        std::vector<PackedParticle> packed( count );
+        // Stand-ins for the mapped GL buffers.
+        std::vector<char> uploadFloat( count * sizeof(Particle) ), uploadPacked( count * sizeof(PackedParticle) );
+        simulator.load( particles.data(), particles.size() );
+        const float beats[] = { 0.2f, 0.3f, 0.1f, 0.4f };
+
+        double seconds[ 5 ] = {};
+        for( size_t frame = 0; frame < numFrames; ++frame )
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            simulator.step( frame * 1e-5f, ParticleSimulator::DT2, 1.0f, beats, 4, 1280.0f, 720.0f );
+            auto t1 = std::chrono::steady_clock::now();
+            simulator.store( particles.data() );
+            auto t2 = std::chrono::steady_clock::now();
+            std::memcpy( uploadFloat.data(), particles.data(), uploadFloat.size() );
+            auto t3 = std::chrono::steady_clock::now();
+            simulator.store( packed.data() );
+            auto t4 = std::chrono::steady_clock::now();
+            std::memcpy( uploadPacked.data(), packed.data(), uploadPacked.size() );
+            auto t5 = std::chrono::steady_clock::now();
+            seconds[ 0 ] += std::chrono::duration<double>( t1 - t0 ).count();
+            seconds[ 1 ] += std::chrono::duration<double>( t2 - t1 ).count();
+            seconds[ 2 ] += std::chrono::duration<double>( t3 - t2 ).count();
+            seconds[ 3 ] += std::chrono::duration<double>( t4 - t3 ).count();
+            seconds[ 4 ] += std::chrono::duration<double>( t5 - t4 ).count();
+        }
+        for( double & s : seconds ) { s /= numFrames; }
+
+        // Both stores ran on the same state, so the vectorized packing has to agree with encode().
+        for( size_t i = 0; i < count; ++i )
+        {
+            PackedParticle expected = packing::encode( particles[ i ] );
+            if( std::memcmp( &expected, &packed[ i ], sizeof(PackedParticle) ) != 0 )
+            {
+                std::cout << "store( PackedParticle * ) differs from encode() at particle " << i << std::endl;
+                return 1;
+            }
+        }
+        std::cout << std::setw( 10 ) << count << std::fixed << std::setprecision( 3 )
+            << std::setw( 10 ) << 1e3 * seconds[ 0 ] << std::setw( 14 ) << 1e3 * seconds[ 1 ] << std::setw( 10 ) << 1e3 * seconds[ 2 ]
+            << std::setw( 15 ) << 1e3 * seconds[ 3 ] << std::setw( 10 ) << 1e3 * seconds[ 4 ]
+            << std::setw( 9 ) << std::setprecision( 2 ) << count / ( seconds[ 0 ] + seconds[ 1 ] + seconds[ 2 ] ) / 1e6
+            << " / " << count / ( seconds[ 0 ] + seconds[ 3 ] + seconds[ 4 ] ) / 1e6 << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,257 @@
+//
+//  ParticleBenchmark.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Checks ParticleSimulator against a line-by-line transcription of particleUpdate.vs (vector
+//  types, swizzles and all), then times a step from 1K up to 10M particles on one thread and on
+//  every hardware thread. Not part of the app target; build like LatencyHarness:
+//      g++ -std=c++11 -O2 -I../include -I$CINDER_PATH/include ParticleBenchmark.cpp -o ParticleBenchmark
+//          -L$CINDER_PATH/lib/linux/x86_64/ogl/Release -lcinder -lpthread  (plus cinder's own link deps)
+//
+//  Usage: ParticleBenchmark [largest particle count, default 10000000] [steps per run, default 10]
+//  Exits non-zero if the simulator and the transcription disagree.
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "ParticleSimulator.h"
+
+// particleUpdate.vs as written, on just enough GLSL to run it.
+namespace glsl {
+
+struct vec3
+{
+    float x, y, z;
+};
+
+struct vec4
+{
+    float x, y, z, w;
+};
+
+vec3 v3( float x, float y, float z ) { vec3 v = { x, y, z }; return v; }
+vec4 v4( float x, float y, float z, float w ) { vec4 v = { x, y, z, w }; return v; }
+vec3 operator+( vec3 a, vec3 b ) { return v3( a.x + b.x, a.y + b.y, a.z + b.z ); }
+vec3 operator-( vec3 a, vec3 b ) { return v3( a.x - b.x, a.y - b.y, a.z - b.z ); }
+vec3 operator*( vec3 a, vec3 b ) { return v3( a.x * b.x, a.y * b.y, a.z * b.z ); }
+vec3 operator+( vec3 a, float b ) { return v3( a.x + b, a.y + b, a.z + b ); }
+vec3 operator-( vec3 a, float b ) { return v3( a.x - b, a.y - b, a.z - b ); }
+vec3 operator*( vec3 a, float b ) { return v3( a.x * b, a.y * b, a.z * b ); }
+vec3 operator-( float a, vec3 b ) { return v3( a - b.x, a - b.y, a - b.z ); }
+vec4 operator+( vec4 a, vec4 b ) { return v4( a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w ); }
+vec4 operator-( vec4 a, vec4 b ) { return v4( a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w ); }
+vec4 operator*( vec4 a, vec4 b ) { return v4( a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w ); }
+vec4 operator+( vec4 a, float b ) { return v4( a.x + b, a.y + b, a.z + b, a.w + b ); }
+vec4 operator-( vec4 a, float b ) { return v4( a.x - b, a.y - b, a.z - b, a.w - b ); }
+vec4 operator*( vec4 a, float b ) { return v4( a.x * b, a.y * b, a.z * b, a.w * b ); }
+vec4 operator+( float a, vec4 b ) { return v4( a + b.x, a + b.y, a + b.z, a + b.w ); }
+vec4 operator-( float a, vec4 b ) { return v4( a - b.x, a - b.y, a - b.z, a - b.w ); }
+vec4 operator*( float a, vec4 b ) { return b * a; }
+vec4 operator-( vec4 a ) { return v4( -a.x, -a.y, -a.z, -a.w ); }
+vec3 floor( vec3 a ) { return v3( std::floor( a.x ), std::floor( a.y ), std::floor( a.z ) ); }
+vec4 floor( vec4 a ) { return v4( std::floor( a.x ), std::floor( a.y ), std::floor( a.z ), std::floor( a.w ) ); }
+vec4 abs( vec4 a ) { return v4( std::fabs( a.x ), std::fabs( a.y ), std::fabs( a.z ), std::fabs( a.w ) ); }
+float step( float e, float x ) { return x < e ? 0.0f : 1.0f; }
+vec3 step( vec3 e, vec3 x ) { return v3( step( e.x, x.x ), step( e.y, x.y ), step( e.z, x.z ) ); }
+vec4 step( vec4 e, vec4 x ) { return v4( step( e.x, x.x ), step( e.y, x.y ), step( e.z, x.z ), step( e.w, x.w ) ); }
+vec3 min( vec3 a, vec3 b ) { return v3( std::min( a.x, b.x ), std::min( a.y, b.y ), std::min( a.z, b.z ) ); }
+vec3 max( vec3 a, vec3 b ) { return v3( std::max( a.x, b.x ), std::max( a.y, b.y ), std::max( a.z, b.z ) ); }
+vec4 max( vec4 a, float b ) { return v4( std::max( a.x, b ), std::max( a.y, b ), std::max( a.z, b ), std::max( a.w, b ) ); }
+float dot( vec3 a, vec3 b ) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+float dot( vec4 a, vec4 b ) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+float mix( float x, float y, float a ) { return x * ( 1.0f - a ) + y * a; }
+
+vec3 mod289( vec3 x ) { return x - floor( x * ( 1.0f / 289.0f ) ) * 289.0f; }
+vec4 mod289( vec4 x ) { return x - floor( x * ( 1.0f / 289.0f ) ) * 289.0f; }
+vec4 permute( vec4 x ) { return mod289( ( ( x * 34.0f ) + 1.0f ) * x ); }
+vec4 taylorInvSqrt( vec4 r ) { return 1.79284291400159f - 0.85373472095314f * r; }
+
+float snoise( vec3 v )
+{
+    const float Cx = 1.0f / 6.0f, Cy = 1.0f / 3.0f;
+    const vec4 D = v4( 0.0f, 0.5f, 1.0f, 2.0f );
+
+    vec3 i = floor( v + dot( v, v3( Cy, Cy, Cy ) ) );
+    vec3 x0 = v - i + dot( i, v3( Cx, Cx, Cx ) );
+
+    vec3 g = step( v3( x0.y, x0.z, x0.x ), x0 );
+    vec3 l = 1.0f - g;
+    vec3 i1 = min( g, v3( l.z, l.x, l.y ) );
+    vec3 i2 = max( g, v3( l.z, l.x, l.y ) );
+
+    vec3 x1 = x0 - i1 + Cx;
+    vec3 x2 = x0 - i2 + Cy;
+    vec3 x3 = x0 - D.y;
+
+    i = mod289( i );
+    vec4 p = permute( permute( permute(
+                i.z + v4( 0.0f, i1.z, i2.z, 1.0f ) )
+              + i.y + v4( 0.0f, i1.y, i2.y, 1.0f ) )
+              + i.x + v4( 0.0f, i1.x, i2.x, 1.0f ) );
+
+    float n_ = 0.142857142857f;
+    vec3 ns = v3( n_ * D.w - D.x, n_ * D.y - D.z, n_ * D.z - D.x );
+
+    vec4 j = p - 49.0f * floor( p * ns.z * ns.z );
+    vec4 x_ = floor( j * ns.z );
+    vec4 y_ = floor( j - 7.0f * x_ );
+    vec4 x = x_ * ns.x + ns.y;
+    vec4 y = y_ * ns.x + ns.y;
+    vec4 h = 1.0f - abs( x ) - abs( y );
+
+    vec4 b0 = v4( x.x, x.y, y.x, y.y );
+    vec4 b1 = v4( x.z, x.w, y.z, y.w );
+    vec4 s0 = floor( b0 ) * 2.0f + 1.0f;
+    vec4 s1 = floor( b1 ) * 2.0f + 1.0f;
+    vec4 sh = -step( h, v4( 0.0f, 0.0f, 0.0f, 0.0f ) );
+
+    vec4 a0 = v4( b0.x, b0.z, b0.y, b0.w ) + v4( s0.x, s0.z, s0.y, s0.w ) * v4( sh.x, sh.x, sh.y, sh.y );
+    vec4 a1 = v4( b1.x, b1.z, b1.y, b1.w ) + v4( s1.x, s1.z, s1.y, s1.w ) * v4( sh.z, sh.z, sh.w, sh.w );
+
+    vec3 p0 = v3( a0.x, a0.y, h.x );
+    vec3 p1 = v3( a0.z, a0.w, h.y );
+    vec3 p2 = v3( a1.x, a1.y, h.z );
+    vec3 p3 = v3( a1.z, a1.w, h.w );
+
+    vec4 norm = taylorInvSqrt( v4( dot( p0, p0 ), dot( p1, p1 ), dot( p2, p2 ), dot( p3, p3 ) ) );
+    p0 = p0 * norm.x;
+    p1 = p1 * norm.y;
+    p2 = p2 * norm.z;
+    p3 = p3 * norm.w;
+
+    vec4 m = max( 0.6f - v4( dot( x0, x0 ), dot( x1, x1 ), dot( x2, x2 ), dot( x3, x3 ) ), 0.0f );
+    m = m * m;
+    return 42.0f * dot( m * m, v4( dot( p0, x0 ), dot( p1, x1 ), dot( p2, x2 ), dot( p3, x3 ) ) );
+}
+
+//! main() and applyBeat() for one particle.
+void update( Particle & particle, float uTime, float dt2, float activity, float const * beats, float windowWidth, float windowHeight )
+{
+    vec3 position = v3( particle.pos.x, particle.pos.y, particle.pos.z );
+    vec3 pposition = v3( particle.ppos.x, particle.ppos.y, particle.ppos.z );
+    vec3 home = v3( particle.home.x, particle.home.y, particle.home.z );
+    float damping = particle.damping;
+    vec3 windowSize = v3( windowWidth, windowHeight, 1.0f );
+
+    float xNoise = snoise( v3( position.x, position.y, uTime ) );
+    float yNoise = snoise( v3( position.y, position.z, uTime ) );
+    float zNoise = snoise( v3( position.x, position.z, uTime ) );
+
+    vec3 vel = ( position - pposition ) * damping;
+    pposition = position;
+    vec3 acc = ( ( home * windowSize - position ) * 32.0f );
+    position = position + ( ( vel + acc * dt2 ) + ( v3( xNoise, yNoise, zNoise ) * activity ) );
+
+    float beat = beats[ int( particle.groupId ) ];
+    if( beat < particle.color.a )
+    {
+        beat = mix( particle.color.a, beat, 0.065f );
+    }
+
+    particle.pos = ci::vec3( position.x, position.y, position.z );
+    particle.ppos = ci::vec3( pposition.x, pposition.y, pposition.z );
+    particle.color.a = beat;
+}
+
+} // namespace glsl
+
+//! The same layout SceneComponent::setup() makes, at any count.
+std::vector<Particle> makeParticles( size_t count )
+{
+    const int numGroups = 4;
+    std::vector<Particle> particles( count );
+    std::srand( 1 );
+    for( size_t i = 0; i < count; ++i )
+    {
+        auto random = [] { return std::rand() / static_cast<float>( RAND_MAX ); };
+        Particle & p = particles[ i ];
+        p.groupId = static_cast<float>( i * numGroups / count );
+        p.pos = ci::vec3( random() * 1280.0f, random() * 720.0f, 0.0f );
+        p.home = ci::vec3( p.pos.x / 1280.0f, p.pos.y / 720.0f, 0.0f );
+        p.ppos = p.pos + ci::vec3( random() - 0.5f, random() - 0.5f, random() - 0.5f );
+        p.damping = 0.7f + 0.25f * random();
+        p.size = 2.0f + 62.0f * random();
+        p.color = ci::ColorA( 1.0f, 0.8f, 0.2f, std::min( 32.0f / p.size, 1.0f ) );
+    }
+    return particles;
+}
+
+int main( int argc, char * argv[] )
+{
+    const size_t maxParticles = argc > 1 ? std::atol( argv[ 1 ] ) : 10000000;
+    const size_t numSteps = argc > 2 ? std::atol( argv[ 2 ] ) : 10;
+
+    // Parity: a few hundred steps with beats rising and falling, loud activity, and the window
+    // and the step rate changed halfway through.
+    {
+        std::vector<Particle> reference = makeParticles( 4096 );
+        std::vector<Particle> simulated( reference.size() );
+        ParticleSimulator simulator;
+        simulator.load( reference.data(), reference.size() );
+        float maxPositionError = 0.0f, maxAlphaError = 0.0f;
+        float uTime = 0.0f;
+        for( int s = 0; s < 300; ++s )
+        {
+            uTime += ( 1.0f / 60.0f ) * 0.001f;
+            float beats[ ParticleSimulator::MAX_BEATS ] = {};
+            for( int b = 0; b < 4; ++b )
+            {
+                beats[ b ] = 0.1f + 0.35f * ( ( s + 7 * b ) % 30 == 0 );
+            }
+            float activity = 0.5f + 2.0f * ( s % 50 ) / 50.0f;
+            float width = s < 150 ? 1280.0f : 1920.0f;
+            float height = s < 150 ? 720.0f : 1200.0f;
+            float dt2 = s < 150 ? ParticleSimulator::DT2 : 1.0f / ( 144.0f * 144.0f );
+
+            for( auto & particle : reference )
+            {
+                glsl::update( particle, uTime, dt2, activity, beats, width, height );
+            }
+            simulator.step( uTime, dt2, activity, beats, 4, width, height );
+        }
+        simulator.store( simulated.data() );
+        for( size_t i = 0; i < reference.size(); ++i )
+        {
+            maxPositionError = std::max( maxPositionError, std::fabs( simulated[ i ].pos.x - reference[ i ].pos.x ) );
+            maxPositionError = std::max( maxPositionError, std::fabs( simulated[ i ].pos.y - reference[ i ].pos.y ) );
+            maxPositionError = std::max( maxPositionError, std::fabs( simulated[ i ].pos.z - reference[ i ].pos.z ) );
+            maxAlphaError = std::max( maxAlphaError, std::fabs( simulated[ i ].color.a - reference[ i ].color.a ) );
+        }
+        std::cout << "parity with particleUpdate.vs over 300 steps of " << reference.size() << " particles ("
+            << kernels::getIsaName() << "): max position error " << maxPositionError << ", max alpha error " << maxAlphaError << std::endl;
+        if( maxPositionError > 1e-3f || maxAlphaError > 1e-6f ) { return 1; }
+    }
+
+    const size_t hardwareThreads = ParticleSimulator().getNumThreads();
+    std::cout << std::setw( 10 ) << "particles" << std::setw( 9 ) << "threads" << std::setw( 12 ) << "ms/step" << std::setw( 14 ) << "Mparticles/s" << std::endl;
+    for( size_t count = 1000; count <= maxParticles; count *= 10 )
+    {
+        std::vector<Particle> particles = makeParticles( count );
+        for( size_t threads : { static_cast<size_t>( 1 ), hardwareThreads } )
+        {
+            ParticleSimulator simulator( threads );
+            simulator.load( particles.data(), particles.size() );
+            const float beats[] = { 0.2f, 0.3f, 0.1f, 0.4f };
+            simulator.step( 0.0f, ParticleSimulator::DT2, 1.0f, beats, 4, 1280.0f, 720.0f );
+
+            auto start = std::chrono::steady_clock::now();
+            for( size_t s = 0; s < numSteps; ++s )
+            {
+                simulator.step( s * 1e-5f, ParticleSimulator::DT2, 1.0f, beats, 4, 1280.0f, 720.0f );
+            }
+            double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() / numSteps;
+            std::cout << std::setw( 10 ) << count << std::setw( 9 ) << simulator.getNumThreads()
+                << std::setw( 12 ) << std::fixed << std::setprecision( 3 ) << 1e3 * elapsed
+                << std::setw( 14 ) << std::setprecision( 1 ) << count / elapsed / 1e6 << std::endl;
+            if( hardwareThreads == 1 ) { break; }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,239 @@
+//
+//  ParticleInitBenchmark.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Checks CounterRng against the published Philox4x32-10 answers and its vector kernels against the
+//  scalar one, checks that ParticleFactory makes the same particles however the range is split, then
+//  times laying out the steady population: the old serial Rand path against ParticleFactory one at a
+//  time, in batches, and in batches across threads. Not part of the app target; build like
+//  ParticleBenchmark:
+//      g++ -std=c++11 -O2 -I../include -I$CINDER_PATH/include ParticleInitBenchmark.cpp -o ParticleInitBenchmark
+//          -L$CINDER_PATH/lib/linux/x86_64/ogl/Release -lcinder -lpthread  (plus cinder's own link deps)
+//
+//  Usage: ParticleInitBenchmark [particle count, default 10000000] [threads, default every hardware thread]
+//  Exits non-zero if a check fails.
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "ParticleFactory.h"
+
+const float WINDOW_WIDTH = 1280.0f;
+const float WINDOW_HEIGHT = 720.0f;
+const int NUM_GROUPS = 4;
+
+//! What SceneComponent::makeParticle() did before: the same formulas, drawn from one global
+//! generator the way ci::Rand draws them (a std::mt19937 behind uniform_real_distribution).
+struct SerialRand
+{
+    std::mt19937 base;
+    std::uniform_real_distribution<float> unit;
+
+    float randFloat() { return this->unit( this->base ); }
+    float randFloat( float from, float to ) { return from + ( to - from ) * this->randFloat(); }
+    ci::vec3 randVec3()
+    {
+        const float phi = this->randFloat( 0.0f, 2.0f * static_cast<float>( M_PI ) );
+        const float cosTheta = this->randFloat( -1.0f, 1.0f );
+        const float rho = std::sqrt( 1.0f - cosTheta * cosTheta );
+        return ci::vec3( rho * std::cos( phi ), rho * std::sin( phi ), cosTheta );
+    }
+
+    Particle makeParticle( int group )
+    {
+        Particle p;
+        p.groupId = group;
+        p.pos = ci::vec3( this->randFloat() * WINDOW_WIDTH, this->randFloat() * WINDOW_HEIGHT, 0.0f );
+        p.home = ci::vec3( p.pos.x / WINDOW_WIDTH, p.pos.y / WINDOW_HEIGHT, p.pos.z );
+        p.ppos = p.pos + this->randVec3();
+        p.damping = this->randFloat( 0.7f, 0.95f );
+        p.size = this->randFloat( 2.0f, 64.0f );
+        float hue = ci::lmap<float>( ( (float)group / (float)NUM_GROUPS ), 0.0f, (float)NUM_GROUPS, 0.14f, 0.4f );
+        p.color = ci::Color( ci::CM_HSV, hue, 1.0f, ci::math<float>::clamp( 32.0f / p.size ) );
+        return p;
+    }
+};
+
+//! FNV-1a over the particles' bytes.
+std::uint64_t hashParticles( Particle const * particles, size_t count )
+{
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    unsigned char const * bytes = reinterpret_cast<unsigned char const *>( particles );
+    for( size_t i = 0; i < count * sizeof(Particle); ++i )
+    {
+        hash = ( hash ^ bytes[ i ] ) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool checkGenerator()
+{
+    size_t failures = 0;
+
+    // Known answers from the Random123 distribution (kat_vectors, philox4x32 10 rounds).
+    struct Answer { std::uint32_t counter[ 4 ]; std::uint64_t key; std::uint32_t expected[ 4 ]; };
+    const Answer answers[] = {
+        { { 0, 0, 0, 0 }, 0, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+        { { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, 0xffffffffffffffffull, { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+        { { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, 0x299f31d0a4093822ull, { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } }
+    };
+    size_t wrong = 0;
+    for( Answer const & answer : answers )
+    {
+        std::uint32_t out[ 4 ];
+        kernels::detail::philox4x32( answer.counter, answer.key, out );
+        if( std::memcmp( out, answer.expected, sizeof(out) ) != 0 ) { ++wrong; }
+    }
+    std::cout << "Philox4x32-10 known answers: " << wrong << " of 3 wrong" << std::endl;
+    failures += wrong;
+
+    // Every kernel against the scalar one, including batches where the low index word wraps.
+    const size_t count = 1 << 20;
+    std::vector<float> expected( 4 * count ), actual( 4 * count );
+    const std::uint64_t firsts[] = { 0, 5, 0xfffffff0ull, 0x123456789ull };
+    for( std::uint64_t first : firsts )
+    {
+        kernels::detail::philoxUniformScalar( 42, first, 3, 1, count, expected.data() );
+#if DSP_KERNELS_X86
+        kernels::detail::philoxUniformSse2( 42, first, 3, 1, count, actual.data() );
+        if( std::memcmp( expected.data(), actual.data(), expected.size() * sizeof(float) ) != 0 ) { ++failures; std::cout << "SSE2 kernel differs from scalar" << std::endl; }
+        if( kernels::getIsa() == kernels::Isa::AVX2 )
+        {
+            kernels::detail::philoxUniformAvx2( 42, first, 3, 1, count, actual.data() );
+            if( std::memcmp( expected.data(), actual.data(), expected.size() * sizeof(float) ) != 0 ) { ++failures; std::cout << "AVX2 kernel differs from scalar" << std::endl; }
+        }
+#endif
+    }
+
+    // Rough uniformity: mean and a 64-bin chi-square (63 degrees of freedom: 63 +- 11 is typical).
+    const size_t numBins = 64;
+    std::vector<size_t> bins( numBins, 0 );
+    double sum = 0.0;
+    for( float value : expected )
+    {
+        sum += value;
+        ++bins[ static_cast<size_t>( value * numBins ) ];
+    }
+    double chiSquare = 0.0;
+    const double perBin = static_cast<double>( expected.size() ) / numBins;
+    for( size_t n : bins )
+    {
+        chiSquare += ( n - perBin ) * ( n - perBin ) / perBin;
+    }
+    std::cout << "uniform floats over " << expected.size() << " draws: mean " << std::setprecision( 5 ) << sum / expected.size()
+        << ", chi-square " << std::setprecision( 4 ) << chiSquare << " over 63 dof" << std::endl;
+    if( chiSquare > 120.0 ) { ++failures; }
+    return failures == 0;
+}
+
+bool checkFactory( ThreadPool & threads )
+{
+    size_t failures = 0;
+    const size_t count = 100003;
+    ParticleFactory factory;
+    factory.setLayout( WINDOW_WIDTH, WINDOW_HEIGHT, NUM_GROUPS );
+
+    std::vector<Particle> single( count ), batched( count ), split( count ), parallel( count );
+    for( size_t i = 0; i < count; ++i )
+    {
+        single[ i ] = factory.makeParticle( i );
+    }
+    factory.makeParticles( 0, count, batched.data() );
+    // An awkward split: a range that starts off a batch boundary.
+    factory.makeParticles( 0, 777, split.data() );
+    factory.makeParticles( 777, count - 777, split.data() + 777 );
+    factory.makeParticles( 0, count, parallel.data(), threads );
+
+    const std::uint64_t hash = hashParticles( single.data(), count );
+    const bool same = hash == hashParticles( batched.data(), count ) && hash == hashParticles( split.data(), count ) && hash == hashParticles( parallel.data(), count );
+    std::cout << "one at a time, batched, split at 777 and across " << threads.getNumThreads() << " threads: " << ( same ? "identical" : "DIFFERENT" )
+        << " (hash " << std::hex << hash << std::dec << ")" << std::endl;
+    if( !same ) { ++failures; }
+
+    factory.setSeed( DEFAULT_PARTICLE_SEED + 1 );
+    factory.makeParticles( 0, count, batched.data() );
+    const bool reseeded = hash != hashParticles( batched.data(), count );
+    std::cout << "another seed: " << ( reseeded ? "different particles" : "SAME particles" ) << std::endl;
+    if( !reseeded ) { ++failures; }
+
+    // Ranges the app relies on.
+    size_t outside = 0;
+    for( Particle const & p : single )
+    {
+        const float speed = std::sqrt( ( p.ppos.x - p.pos.x ) * ( p.ppos.x - p.pos.x ) + ( p.ppos.y - p.pos.y ) * ( p.ppos.y - p.pos.y ) + p.ppos.z * p.ppos.z );
+        if( p.pos.x < 0.0f || p.pos.x >= WINDOW_WIDTH || p.pos.y < 0.0f || p.pos.y >= WINDOW_HEIGHT || p.home.x >= 1.0f || p.home.y >= 1.0f
+            || std::fabs( speed - 1.0f ) > 1e-2f || p.damping < 0.7f || p.damping >= 0.95f || p.size < 2.0f || p.size >= 64.0f )
+        {
+            ++outside;
+        }
+    }
+    std::cout << "particles out of range: " << outside << std::endl;
+    if( outside != 0 ) { ++failures; }
+    return failures == 0;
+}
+
+double timeIt( std::function<void()> const & fn )
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+int main( int argc, char * argv[] )
+{
+    const size_t count = argc > 1 ? std::atol( argv[ 1 ] ) : 10000000;
+    ThreadPool threads( argc > 2 ? std::atol( argv[ 2 ] ) : 0 );
+
+    if( !checkGenerator() || !checkFactory( threads ) ) { return 1; }
+
+    std::vector<Particle> particles( count );
+    ParticleFactory factory;
+    factory.setLayout( WINDOW_WIDTH, WINDOW_HEIGHT, NUM_GROUPS );
+    std::vector<float> uniforms( 4 * 4096 );
+
+    std::cout << std::fixed << std::setprecision( 1 );
+    std::cout << "raw Philox, ns per 4 floats:";
+    const kernels::Isa isas[] = { kernels::Isa::SCALAR, kernels::Isa::SSE2, kernels::Isa::AVX2 };
+    const char * names[] = { "scalar", "SSE2", "AVX2" };
+    for( int i = 0; i < 3; ++i )
+    {
+        void ( *kernel )( std::uint64_t, std::uint64_t, std::uint32_t, std::uint32_t, size_t, float * ) = kernels::detail::philoxUniformScalar;
+#if DSP_KERNELS_X86
+        if( isas[ i ] == kernels::Isa::SSE2 ) { kernel = kernels::detail::philoxUniformSse2; }
+        if( isas[ i ] == kernels::Isa::AVX2 ) { kernel = kernels::detail::philoxUniformAvx2; }
+#endif
+        if( isas[ i ] != kernels::Isa::SCALAR && static_cast<int>( kernels::getIsa() ) < static_cast<int>( isas[ i ] ) ) { continue; }
+        const size_t batches = 2000;
+        const double seconds = timeIt( [&] { for( size_t b = 0; b < batches; ++b ) { kernel( 1, b * 4096, 0, 0, 4096, uniforms.data() ); } } );
+        std::cout << "  " << names[ i ] << " " << 1e9 * seconds / ( batches * 4096 );
+    }
+    std::cout << std::endl;
+
+    std::cout << "laying out " << count << " particles:" << std::endl;
+    SerialRand serial;
+    const double serialSeconds = timeIt( [&] { for( size_t i = 0; i < count; ++i ) { particles[ i ] = serial.makeParticle( i % NUM_GROUPS ); } } );
+    const double singleSeconds = timeIt( [&] { for( size_t i = 0; i < count; ++i ) { particles[ i ] = factory.makeParticle( i ); } } );
+    const double batchedSeconds = timeIt( [&] { factory.makeParticles( 0, count, particles.data() ); } );
+    const double parallelSeconds = timeIt( [&] { factory.makeParticles( 0, count, particles.data(), threads ); } );
+    auto row = [&]( char const * name, double seconds )
+    {
+        std::cout << "    " << std::left << std::setw( 34 ) << name << std::right << std::setw( 9 ) << 1e3 * seconds << " ms"
+            << std::setw( 8 ) << 1e9 * seconds / count << " ns each" << std::setw( 8 ) << std::setprecision( 2 ) << serialSeconds / seconds << "x" << std::setprecision( 1 ) << std::endl;
+    };
+    row( "serial Rand (mt19937)", serialSeconds );
+    row( "ParticleFactory, one at a time", singleSeconds );
+    row( "ParticleFactory, batched", batchedSeconds );
+    std::cout << "    " << threads.getNumThreads() << " thread(s):" << std::endl;
+    row( "ParticleFactory, batched, threaded", parallelSeconds );
+    return 0;
+}
@@ -0,0 +1,223 @@
+//
+//  SpatialHashBenchmark.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Checks SpatialHash's neighbour queries against testing every pair, and that a rebuild comes out
+//  the same on any number of threads, then times a rebuild and a neighbour pass (a separation force:
+//  every particle visits everything within one cell size) from 1K particles up, at several
+//  densities. All pairs is timed too, for scale. Not part of the app target; build like
+//  ParticleBenchmark:
+//      g++ -std=c++11 -O2 -I../include -I$CINDER_PATH/include SpatialHashBenchmark.cpp -o SpatialHashBenchmark
+//          -L$CINDER_PATH/lib/linux/x86_64/ogl/Release -lcinder -lpthread  (plus cinder's own link deps)
+//
+//  Usage: SpatialHashBenchmark [largest particle count, default 1000000] [steps per run, default 5]
+//  Exits non-zero if a query misses or repeats a neighbour, or threads change the result.
+//
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+#include "SpatialHash.h"
+
+const float CELL_SIZE = 16.0f;
+
+//! count positions spread evenly over a square holding density particles per cell on average; returns its side.
+float scatter( size_t count, float density, std::vector<float> & x, std::vector<float> & y, unsigned seed )
+{
+    std::mt19937 random( seed );
+    const float side = std::sqrt( count * CELL_SIZE * CELL_SIZE / density );
+    std::uniform_real_distribution<float> coordinate( 0.0f, side );
+    x.resize( count );
+    y.resize( count );
+    for( size_t i = 0; i < count; ++i )
+    {
+        x[ i ] = coordinate( random );
+        y[ i ] = coordinate( random );
+    }
+    return side;
+}
+
+//! Adds a push away from every neighbour within CELL_SIZE, falling off linearly, to each particle's
+//! force; returns how many neighbours there were in all. Goes through the particles in sorted order,
+//! so consecutive queries read the same cells.
+size_t separate( SpatialHash const & hash, ThreadPool & threads, std::vector<float> & forceX, std::vector<float> & forceY )
+{
+    const size_t count = hash.getNumParticles();
+    std::atomic<size_t> found( 0 );
+    threads.parallelFor( count, SpatialHash::MIN_CHUNK_SIZE, [&]( size_t begin, size_t end )
+    {
+        size_t neighbours = 0;
+        for( size_t i = begin; i < end; ++i )
+        {
+            float fx = 0.0f, fy = 0.0f;
+            hash.forEachNeighbour( hash.getSortedX()[ i ], hash.getSortedY()[ i ], CELL_SIZE, [&]( std::uint32_t, float dx, float dy, float distanceSquared )
+            {
+                if( distanceSquared > 0.0f )
+                {
+                    const float distance = std::sqrt( distanceSquared );
+                    const float push = ( CELL_SIZE - distance ) / ( CELL_SIZE * distance );
+                    fx -= dx * push;
+                    fy -= dy * push;
+                }
+                ++neighbours;
+            } );
+            forceX[ hash.getSortedIndices()[ i ] ] = fx;
+            forceY[ hash.getSortedIndices()[ i ] ] = fy;
+        }
+        found += neighbours;
+    } );
+    return found;
+}
+
+bool checkQueries()
+{
+    size_t failures = 0;
+    ThreadPool threads;
+    SpatialHash hash( CELL_SIZE );
+
+    // Negative coordinates, a clump and a few far-off or broken positions, as well as the usual spread.
+    // The bounds leave some of them, and some queries, outside the grid.
+    const size_t count = 20000;
+    std::vector<float> x, y;
+    const float side = scatter( count, 4.0f, x, y, 7 );
+    hash.setBounds( -300.0f, 0.0f, side, side );
+    for( size_t i = 0; i < count; i += 5 ) { x[ i ] -= 700.0f; }
+    for( size_t i = 1; i < count; i += 50 ) { x[ i ] = 100.0f + 0.01f * ( i % 97 ); y[ i ] = 100.0f; }
+    x[ 2 ] = 1e12f;
+    y[ 3 ] = -1e12f;
+    x[ 4 ] = std::numeric_limits<float>::quiet_NaN();
+    hash.rebuild( x.data(), y.data(), count, threads );
+
+    std::mt19937 random( 11 );
+    std::uniform_real_distribution<float> coordinate( -800.0f, 1200.0f );
+    const float radii[] = { 0.3f * CELL_SIZE, CELL_SIZE, 1.7f * CELL_SIZE, 4.0f * CELL_SIZE };
+    size_t queries = 0, misses = 0, visited = 0;
+    std::vector<int> seen( count, -1 );
+    for( int q = 0; q < 4000; ++q )
+    {
+        const float qx = q % 10 == 0 ? 100.0f : coordinate( random ), qy = q % 10 == 0 ? 100.0f : coordinate( random );
+        const float radius = radii[ q % 4 ];
+        size_t found = 0;
+        hash.forEachNeighbour( qx, qy, radius, [&]( std::uint32_t index, float, float, float )
+        {
+            // A repeat or an out-of-range visit counts as a miss.
+            if( seen[ index ] == q ) { ++misses; }
+            seen[ index ] = q;
+            ++found;
+        } );
+        size_t expected = 0;
+        for( size_t i = 0; i < count; ++i )
+        {
+            const float dx = x[ i ] - qx, dy = y[ i ] - qy;
+            if( dx * dx + dy * dy <= radius * radius )
+            {
+                ++expected;
+                if( seen[ i ] != q ) { ++misses; }
+            }
+        }
+        if( found != expected ) { ++misses; }
+        visited += found;
+        ++queries;
+    }
+    std::cout << queries << " queries against all pairs: " << visited << " neighbours, " << misses << " missed or repeated" << std::endl;
+    failures += misses;
+
+    // Threads mustn't change the order, and both layouts must sort alike.
+    ThreadPool one( 1 ), four( 4 );
+    SpatialHash other( CELL_SIZE );
+    other.setBounds( -300.0f, 0.0f, side, side );
+    hash.rebuild( x.data(), y.data(), count, one );
+    other.rebuild( x.data(), y.data(), count, four );
+    bool same = std::memcmp( hash.getSortedIndices(), other.getSortedIndices(), count * sizeof(std::uint32_t) ) == 0;
+    std::vector<Particle> particles( count );
+    for( size_t i = 0; i < count; ++i ) { particles[ i ].pos = ci::vec3( x[ i ], y[ i ], 0.0f ); }
+    other.rebuild( particles.data(), count, four );
+    same = same && std::memcmp( hash.getSortedIndices(), other.getSortedIndices(), count * sizeof(std::uint32_t) ) == 0;
+    std::cout << "sorted order on 1 and 4 threads, from arrays and from particles: " << ( same ? "identical" : "DIFFERENT" ) << std::endl;
+    if( !same ) { ++failures; }
+    return failures == 0;
+}
+
+double seconds( std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end )
+{
+    return std::chrono::duration<double>( end - start ).count();
+}
+
+int main( int argc, char * argv[] )
+{
+    const size_t maxParticles = argc > 1 ? std::atol( argv[ 1 ] ) : 1000000;
+    const size_t numSteps = argc > 2 ? std::atol( argv[ 2 ] ) : 5;
+
+    if( !checkQueries() ) { return 1; }
+
+    ThreadPool threads;
+    std::cout << "cell " << CELL_SIZE << " px, query radius " << CELL_SIZE << " px, " << threads.getNumThreads() << " thread(s)" << std::endl;
+    std::cout << std::setw( 10 ) << "particles" << std::setw( 10 ) << "per cell" << std::setw( 12 ) << "neighbours"
+        << std::setw( 12 ) << "rebuild ms" << std::setw( 10 ) << "query ms" << std::setw( 12 ) << "ns/particle" << std::setw( 14 ) << "all pairs ms" << std::endl;
+    const float densities[] = { 0.5f, 2.0f, 8.0f, 32.0f };
+    for( size_t count = 1000; count <= maxParticles; count *= 10 )
+    {
+        for( float density : densities )
+        {
+            std::vector<float> x, y, forceX( count ), forceY( count );
+            const float side = scatter( count, density, x, y, 1 );
+            SpatialHash hash( CELL_SIZE );
+            hash.setBounds( 0.0f, 0.0f, side, side );
+            // The first rebuild allocates; the app's steps don't.
+            hash.rebuild( x.data(), y.data(), count, threads );
+
+            double rebuild = 0.0, query = 0.0;
+            size_t neighbours = 0;
+            for( size_t step = 0; step < numSteps; ++step )
+            {
+                auto t0 = std::chrono::steady_clock::now();
+                hash.rebuild( x.data(), y.data(), count, threads );
+                auto t1 = std::chrono::steady_clock::now();
+                neighbours = separate( hash, threads, forceX, forceY );
+                auto t2 = std::chrono::steady_clock::now();
+                rebuild += seconds( t0, t1 );
+                query += seconds( t1, t2 );
+            }
+            rebuild /= numSteps;
+            query /= numSteps;
+
+            // All pairs, on one thread, while it is still affordable.
+            std::string allPairs = "-";
+            if( count <= 10000 )
+            {
+                auto t0 = std::chrono::steady_clock::now();
+                size_t pairs = 0;
+                for( size_t i = 0; i < count; ++i )
+                {
+                    float fx = 0.0f;
+                    for( size_t j = 0; j < count; ++j )
+                    {
+                        const float dx = x[ j ] - x[ i ], dy = y[ j ] - y[ i ];
+                        const float distanceSquared = dx * dx + dy * dy;
+                        if( distanceSquared <= CELL_SIZE * CELL_SIZE ) { fx += dx; ++pairs; }
+                    }
+                    forceX[ i ] = fx;
+                }
+                auto t1 = std::chrono::steady_clock::now();
+                if( pairs != neighbours ) { std::cout << "all pairs found " << pairs << " neighbours, the hash " << neighbours << std::endl; return 1; }
+                allPairs = std::to_string( static_cast<long long>( 1e3 * seconds( t0, t1 ) + 0.5 ) );
+            }
+
+            std::cout << std::setw( 10 ) << count << std::fixed << std::setprecision( 1 ) << std::setw( 10 ) << density
+                << std::setw( 12 ) << static_cast<double>( neighbours ) / count << std::setprecision( 3 )
+                << std::setw( 12 ) << 1e3 * rebuild << std::setw( 10 ) << 1e3 * query << std::setprecision( 1 )
+                << std::setw( 12 ) << 1e9 * ( rebuild + query ) / count << std::setw( 14 ) << allPairs << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,244 @@
+//
+//  SpectralFluxCheck.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Runs SpectralFluxDetector, with log and with Bark spaced bands, over a generated click track
+//  and checks the onsets it finds against the click times stored below. The track has clicks at
+//  three levels, down to -6 dB, over a quiet noise floor and a held chord that swells and fades,
+//  so a detector that fires on loudness rather than on onsets finds extra ones. Spectra are made
+//  the way SpectrumAnalyzer makes them at the app's settings (2048-point FFT of a 1024-frame
+//  Blackman window every 256 frames, magnitudes smoothed by half). Then times a frame of each
+//  detector against the energy detector SpectrumAnalyzer::analyze() runs on the same spectra.
+//  Not part of the app target. StereoFft needs Accelerate on macOS and cinder's bundled Ooura FFT
+//  elsewhere, but nothing else from cinder:
+//      g++ -std=c++11 -O2 -I../include SpectralFluxCheck.cpp -o SpectralFluxCheck -framework Accelerate
+//      g++ -std=c++11 -O2 -I../include -I$CINDER_PATH/include SpectralFluxCheck.cpp
+//          $CINDER_PATH/src/cinder/audio/dsp/ooura/fftsg.cpp -o SpectralFluxCheck
+//
+//  Usage: SpectralFluxCheck [timed runs over the track, default 20]
+//  Exits non-zero if the flux detector misses a click or finds an onset where there is none.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "EnergyHistory.h"
+#include "Filterbank.h"
+#include "SpectralFluxDetector.h"
+#include "StereoFft.h"
+
+// When each click starts, in seconds, and how loud it is. These are the expected onsets.
+const float CLICK_TIMES[] = { 0.50f, 0.93f, 1.20f, 1.71f, 2.05f, 2.64f, 3.00f, 3.25f, 3.90f, 4.31f, 4.58f, 5.40f,
+    6.02f, 6.27f, 6.85f, 7.33f, 7.60f, 8.44f, 9.10f, 9.31f, 10.02f, 10.75f, 11.20f, 11.64f };
+const float CLICK_LEVELS[] = { 1.0f, 0.7f, 0.5f };
+const size_t NUM_CLICKS = sizeof( CLICK_TIMES ) / sizeof( CLICK_TIMES[ 0 ] );
+
+const float SAMPLE_RATE = 44100.0f;
+const float TRACK_SECONDS = 12.5f;
+const size_t FFT_SIZE = 2048, WINDOW_SIZE = 1024, HOP_SIZE = 256, NUM_BINS = FFT_SIZE / 2, NUM_BANDS = 4;
+const float SMOOTHING_FACTOR = 0.5f;
+const float HISTORY_DURATION = 1.0f;
+// An onset is reported at the end of the hop that brought it into the window, and the smoothing
+// can hold it back one more hop.
+const float MAX_LATENCY = 2.0f * HOP_SIZE / SAMPLE_RATE + 0.002f;
+// Beats of a click stay up for a few hops; rises closer than this to the last onset are part of it.
+const float MIN_ONSET_GAP = 0.1f;
+
+std::vector<float> makeTrack()
+{
+    std::vector<float> track( static_cast<size_t>( TRACK_SECONDS * SAMPLE_RATE ) );
+    std::uint32_t seed = 1;
+    auto noise = [&seed] { seed = seed * 1664525u + 1013904223u; return ( seed >> 8 ) / 8388608.0f - 1.0f; };
+    const float twoPi = 2.0f * static_cast<float>( M_PI );
+    for( size_t i = 0; i < track.size(); ++i )
+    {
+        const float t = i / SAMPLE_RATE;
+        // A chord that swells over four seconds and fades again, under a noise floor.
+        const float swell = 0.15f * ( 0.5f - 0.5f * std::cos( twoPi * t / 8.0f ) );
+        const float chord = std::sin( twoPi * 220.0f * t ) + std::sin( twoPi * 277.2f * t ) + std::sin( twoPi * 329.6f * t );
+        track[ i ] = swell * chord / 3.0f + 0.003f * noise();
+    }
+    for( size_t c = 0; c < NUM_CLICKS; ++c )
+    {
+        // 10 ms of noise decaying from the click's level.
+        const size_t start = static_cast<size_t>( CLICK_TIMES[ c ] * SAMPLE_RATE );
+        const float level = CLICK_LEVELS[ c % 3 ];
+        for( size_t i = 0; i < static_cast<size_t>( 0.01f * SAMPLE_RATE ) && start + i < track.size(); ++i )
+        {
+            track[ start + i ] += level * std::exp( -static_cast<float>( i ) / ( 0.002f * SAMPLE_RATE ) ) * noise();
+        }
+    }
+    return track;
+}
+
+//! Magnitude spectrum of each hop of track, as SpectrumAnalyzer::transformMono() makes it.
+std::vector<std::vector<float>> makeSpectra( std::vector<float> const & track )
+{
+    // Cinder's Blackman window.
+    std::vector<float> window( WINDOW_SIZE );
+    for( size_t i = 0; i < WINDOW_SIZE; ++i )
+    {
+        const double phase = 2.0 * M_PI * i / WINDOW_SIZE;
+        window[ i ] = static_cast<float>( 0.42 - 0.5 * std::cos( phase ) + 0.08 * std::cos( 2.0 * phase ) );
+    }
+
+    StereoFft fft;
+    fft.setup( FFT_SIZE );
+    std::vector<float> input( FFT_SIZE, 0.0f ), silence( FFT_SIZE, 0.0f );
+    std::vector<float> real( NUM_BINS ), imag( NUM_BINS ), otherReal( NUM_BINS ), otherImag( NUM_BINS );
+    std::vector<float> magnitudes( NUM_BINS, 0.0f );
+    std::vector<std::vector<float>> spectra;
+    for( size_t end = HOP_SIZE; end <= track.size(); end += HOP_SIZE )
+    {
+        // The window is the WINDOW_SIZE frames up to end, zero padded before the track starts.
+        for( size_t i = 0; i < WINDOW_SIZE; ++i )
+        {
+            const size_t frame = end + i;
+            input[ i ] = frame >= WINDOW_SIZE ? track[ frame - WINDOW_SIZE ] * window[ i ] : 0.0f;
+        }
+        fft.forward( input.data(), silence.data(), real.data(), imag.data(), otherReal.data(), otherImag.data() );
+        imag[ 0 ] = 0.0f;
+        for( size_t i = 0; i < NUM_BINS; ++i )
+        {
+            const float magnitude = std::sqrt( real[ i ] * real[ i ] + imag[ i ] * imag[ i ] ) / FFT_SIZE;
+            magnitudes[ i ] = magnitudes[ i ] * SMOOTHING_FACTOR + magnitude * ( 1.0f - SMOOTHING_FACTOR );
+        }
+        spectra.push_back( magnitudes );
+    }
+    return spectra;
+}
+
+//! The energy detector from SpectrumAnalyzer::analyze(): squared sums of each linear band's
+//! decibels, against their average over the history.
+class EnergyDetector
+{
+public:
+    EnergyDetector() : mHistory( NUM_BANDS, static_cast<size_t>( std::ceil( HISTORY_DURATION * SAMPLE_RATE / HOP_SIZE ) ) ), mDecibels( NUM_BINS ), mEnergies( NUM_BANDS )
+    {
+        this->mFilter.setup( NUM_BINS, SAMPLE_RATE, NUM_BANDS, FilterScale::LINEAR, false );
+    }
+
+    void process( const float * magSpectrum, float * beats )
+    {
+        kernels::linearToDecibel( magSpectrum, this->mDecibels.data(), NUM_BINS );
+        this->mFilter.apply( this->mDecibels.data(), this->mEnergies.data() );
+        kernels::square( this->mEnergies.data(), this->mEnergies.data(), NUM_BANDS );
+        this->mHistory.push( this->mEnergies.data() );
+        for( size_t band = 0; band < NUM_BANDS; ++band )
+        {
+            float averageEnergy = this->mHistory.getAverage( band );
+            float energyRatio = averageEnergy > 0.0f ? ( this->mHistory.getInstant( band ) / averageEnergy ) - 1.0f : 0.0f;
+            beats[ band ] = std::min( std::max( energyRatio, 0.0f ), 0.35f );
+        }
+    }
+
+private:
+    Filterbank mFilter;
+    EnergyHistory mHistory;
+    std::vector<float> mDecibels;
+    std::vector<float> mEnergies;
+};
+
+//! Times, in seconds, of the hops where any band's beat rises from nothing, at least MIN_ONSET_GAP apart.
+template<typename Detector>
+std::vector<float> findOnsets( Detector & detector, std::vector<std::vector<float>> const & spectra )
+{
+    std::vector<float> onsets;
+    std::vector<float> beats( NUM_BANDS );
+    bool wasBeat = false;
+    for( size_t hop = 0; hop < spectra.size(); ++hop )
+    {
+        detector.process( spectra[ hop ].data(), beats.data() );
+        const bool isBeat = *std::max_element( beats.begin(), beats.end() ) > 0.0f;
+        const float time = ( hop + 1 ) * HOP_SIZE / SAMPLE_RATE;
+        if( isBeat && !wasBeat && ( onsets.empty() || time - onsets.back() >= MIN_ONSET_GAP ) ) { onsets.push_back( time ); }
+        wasBeat = isBeat;
+    }
+    return onsets;
+}
+
+//! Counts the clicks with no onset within MAX_LATENCY after them, and the onsets that follow no click.
+void score( std::vector<float> const & onsets, size_t & missed, size_t & extra )
+{
+    std::vector<bool> used( onsets.size(), false );
+    missed = 0;
+    for( size_t c = 0; c < NUM_CLICKS; ++c )
+    {
+        bool found = false;
+        for( size_t o = 0; o < onsets.size() && !found; ++o )
+        {
+            const float latency = onsets[ o ] - CLICK_TIMES[ c ];
+            found = !used[ o ] && latency >= 0.0f && latency <= MAX_LATENCY;
+            if( found ) { used[ o ] = true; }
+        }
+        missed += !found;
+    }
+    extra = std::count( used.begin(), used.end(), false );
+}
+
+template<typename Detector>
+double nsPerFrame( Detector & detector, std::vector<std::vector<float>> const & spectra, size_t runs, float & sink )
+{
+    std::vector<float> beats( NUM_BANDS );
+    auto start = std::chrono::steady_clock::now();
+    for( size_t run = 0; run < runs; ++run )
+    {
+        for( std::vector<float> const & spectrum : spectra )
+        {
+            detector.process( spectrum.data(), beats.data() );
+            sink += beats[ 0 ];
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return 1e9 * std::chrono::duration<double>( end - start ).count() / ( runs * spectra.size() );
+}
+
+int main( int argc, char * argv[] )
+{
+    const size_t runs = argc > 1 ? std::max<long>( std::atol( argv[ 1 ] ), 1 ) : 20;
+    const std::vector<std::vector<float>> spectra = makeSpectra( makeTrack() );
+
+    SpectralFluxDetector logFlux, barkFlux;
+    logFlux.setup( NUM_BINS, SAMPLE_RATE, NUM_BANDS, SpectralFluxDetector::BandScale::LOG );
+    barkFlux.setup( NUM_BINS, SAMPLE_RATE, NUM_BANDS, SpectralFluxDetector::BandScale::BARK );
+    EnergyDetector energy;
+
+    struct Engine { const char * name; bool checked; std::vector<float> onsets; };
+    Engine engines[] = {
+        { "flux, log bands", true, findOnsets( logFlux, spectra ) },
+        { "flux, Bark bands", true, findOnsets( barkFlux, spectra ) },
+        { "energy (not checked)", false, findOnsets( energy, spectra ) }
+    };
+
+    size_t failures = 0;
+    std::cout << NUM_CLICKS << " clicks in " << TRACK_SECONDS << " s, " << spectra.size() << " frames of " << NUM_BANDS << " bands" << std::endl;
+    std::cout << std::setw( 22 ) << "detector" << std::setw( 8 ) << "onsets" << std::setw( 8 ) << "missed" << std::setw( 8 ) << "extra" << std::endl;
+    for( Engine const & engine : engines )
+    {
+        size_t missed, extra;
+        score( engine.onsets, missed, extra );
+        std::cout << std::setw( 22 ) << engine.name << std::setw( 8 ) << engine.onsets.size() << std::setw( 8 ) << missed << std::setw( 8 ) << extra << std::endl;
+        if( engine.checked ) { failures += missed + extra; }
+    }
+
+    // Fresh detectors, so the timed runs start from the same state as the app's.
+    float sink = 0.0f;
+    SpectralFluxDetector timedLog, timedBark;
+    timedLog.setup( NUM_BINS, SAMPLE_RATE, NUM_BANDS, SpectralFluxDetector::BandScale::LOG );
+    timedBark.setup( NUM_BINS, SAMPLE_RATE, NUM_BANDS, SpectralFluxDetector::BandScale::BARK );
+    EnergyDetector timedEnergy;
+    const double energyNs = nsPerFrame( timedEnergy, spectra, runs, sink );
+    const double logNs = nsPerFrame( timedLog, spectra, runs, sink );
+    const double barkNs = nsPerFrame( timedBark, spectra, runs, sink );
+    std::cout << std::fixed << std::setprecision( 0 ) << "ns per frame: energy " << energyNs << ", flux log " << logNs
+        << ", flux Bark " << barkNs << ( sink < 0.0f ? " " : "" ) << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,351 @@
+//
+//  SplatBenchmark.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Renders a stepped particle layout with SplatRenderer, over a soft round stand-in for
+//  smoke_blur.png. Checks a frame against drawing every sprite by hand by the letter of its
+//  description, the SIMD span kernels against the scalar one, and that 1 and 4 threads render the
+//  same frame bit for bit. Then times whole frames at 1920x1080 with 100K particles, from the app's
+//  window view and from closer in, where the sprites grow and overdraw climbs. Not part of the app
+//  target; build like ParticleBenchmark:
+//      g++ -std=c++11 -O2 -I../include -I$CINDER_PATH/include SplatBenchmark.cpp -o SplatBenchmark
+//          -L$CINDER_PATH/lib/linux/x86_64/ogl/Release -lcinder -lpthread  (plus cinder's own link deps)
+//
+//  Usage: SplatBenchmark [particles, default 100000] [frames per run, default 10] [frame.ppm to write]
+//  Exits non-zero if a frame differs from the hand-drawn one, a SIMD kernel from the scalar one, or threads change a frame.
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "ParticleFactory.h"
+#include "ParticleSimulator.h"
+#include "SplatRenderer.h"
+
+const float WINDOW_WIDTH = 1920.0f;
+const float WINDOW_HEIGHT = 1080.0f;
+const float ALPHA = 0.375f;
+const int SPRITE_SIZE = 128;
+
+//! Column-major 4x4 matrix, as GL and glm lay them out.
+struct Matrix
+{
+    float m[ 16 ];
+};
+
+Matrix multiply( Matrix const & a, Matrix const & b )
+{
+    Matrix c;
+    for( int col = 0; col < 4; ++col )
+    {
+        for( int row = 0; row < 4; ++row )
+        {
+            float sum = 0.0f;
+            for( int k = 0; k < 4; ++k ) { sum += a.m[ k * 4 + row ] * b.m[ col * 4 + k ]; }
+            c.m[ col * 4 + row ] = sum;
+        }
+    }
+    return c;
+}
+
+//! What gl::setMatricesWindowPersp() sets for the window, with the eye distance times closer:
+//! glm::perspective times glm::lookAt straight down at the window's centre, times the flip that
+//! puts the origin in the upper left.
+Matrix windowView( float closer )
+{
+    const float f = 1.0f / std::tan( 30.0f * 3.14159265f / 180.0f );
+    const float nearPlane = 1.0f, farPlane = 1000.0f;
+    const float distance = WINDOW_HEIGHT / 2.0f * f * closer;
+    Matrix projection = {};
+    projection.m[ 0 ] = f / ( WINDOW_WIDTH / WINDOW_HEIGHT );
+    projection.m[ 5 ] = f;
+    projection.m[ 10 ] = ( farPlane + nearPlane ) / ( nearPlane - farPlane );
+    projection.m[ 11 ] = -1.0f;
+    projection.m[ 14 ] = 2.0f * farPlane * nearPlane / ( nearPlane - farPlane );
+    Matrix view = {};
+    view.m[ 0 ] = view.m[ 5 ] = view.m[ 10 ] = view.m[ 15 ] = 1.0f;
+    view.m[ 12 ] = -WINDOW_WIDTH / 2.0f;
+    view.m[ 13 ] = -WINDOW_HEIGHT / 2.0f;
+    view.m[ 14 ] = -distance;
+    Matrix flip = {};
+    flip.m[ 0 ] = 1.0f;
+    flip.m[ 5 ] = -1.0f;
+    flip.m[ 10 ] = 1.0f;
+    flip.m[ 13 ] = WINDOW_HEIGHT;
+    flip.m[ 15 ] = 1.0f;
+    return multiply( projection, multiply( view, flip ) );
+}
+
+//! uPointScale, as SceneComponent::draw() works it out.
+float pointScale()
+{
+    return WINDOW_HEIGHT * 0.5f / std::tan( 30.0f * 3.14159265f / 180.0f );
+}
+
+//! A stand-in for smoke_blur.png: white, with alpha falling off from the middle like a blurred puff.
+ci::Surface8u makeSprite()
+{
+    ci::Surface8u sprite( SPRITE_SIZE, SPRITE_SIZE, true, ci::SurfaceChannelOrder::RGBA );
+    for( int y = 0; y < SPRITE_SIZE; ++y )
+    {
+        for( int x = 0; x < SPRITE_SIZE; ++x )
+        {
+            const float dx = ( x + 0.5f ) / SPRITE_SIZE - 0.5f, dy = ( y + 0.5f ) / SPRITE_SIZE - 0.5f;
+            std::uint8_t * texel = sprite.getData() + y * sprite.getRowBytes() + x * sprite.getPixelInc();
+            texel[ sprite.getRedOffset() ] = texel[ sprite.getGreenOffset() ] = texel[ sprite.getBlueOffset() ] = 255;
+            texel[ sprite.getAlphaOffset() ] = static_cast<std::uint8_t>( 255.0f * std::exp( -( dx * dx + dy * dy ) * 20.0f ) + 0.5f );
+        }
+    }
+    return sprite;
+}
+
+//! factory's layout for count particles, stepped a second so they have spread and taken on color,
+//! with every tenth slot emptied as dead pool slots are; packed as the CPU backend uploads them.
+std::vector<PackedParticle> makeScene( size_t count )
+{
+    ParticleFactory factory;
+    factory.setLayout( WINDOW_WIDTH, WINDOW_HEIGHT, 4 );
+    std::vector<Particle> particles( count );
+    factory.makeParticles( 0, count, particles.data() );
+    for( size_t i = 0; i < count; i += 10 ) { particles[ i ].size = 0.0f; }
+    ParticleSimulator simulator( 1 );
+    simulator.load( particles.data(), count );
+    const float beats[ 4 ] = { 0.1f, 0.45f, 0.1f, 0.3f };
+    for( int step = 0; step < 60; ++step )
+    {
+        simulator.step( step * 0.001f / 60.0f, ParticleSimulator::DT2, 2.0f, beats, 4, WINDOW_WIDTH, WINDOW_HEIGHT );
+    }
+    std::vector<PackedParticle> packed( count );
+    simulator.store( packed.data() );
+    return packed;
+}
+
+//! The frame by the letter of SplatRenderer's description, one sprite and one pixel at a time.
+std::vector<float> drawByHand( std::vector<PackedParticle> const & particles, Matrix const & viewProjection, ci::Surface8u const & sprite,
+                               std::uint64_t & fragments )
+{
+    const int width = static_cast<int>( WINDOW_WIDTH ), height = static_cast<int>( WINDOW_HEIGHT );
+    std::vector<float> pixels( width * height * 4, 0.0f );
+    auto texel = [&]( int x, int y, int c )
+    {
+        x = std::min( std::max( x, 0 ), sprite.getWidth() - 1 );
+        y = std::min( std::max( y, 0 ), sprite.getHeight() - 1 );
+        return sprite.getData()[ y * sprite.getRowBytes() + x * sprite.getPixelInc() + c ] / 255.0f;
+    };
+    fragments = 0;
+    float const * m = viewProjection.m;
+    for( PackedParticle const & particle : particles )
+    {
+        const float size = packing::fromHalf( particle.size );
+        if( !( size > 0.0f ) ) { continue; }
+        float clip[ 4 ];
+        for( int r = 0; r < 4; ++r )
+        {
+            float p[ 3 ];
+            for( int c = 0; c < 3; ++c ) { p[ c ] = particle.ppos[ c ] * ( 1.0f - ALPHA ) + particle.pos[ c ] * ALPHA; }
+            clip[ r ] = m[ r ] * p[ 0 ] + m[ 4 + r ] * p[ 1 ] + m[ 8 + r ] * p[ 2 ] + m[ 12 + r ];
+        }
+        bool inside = clip[ 3 ] > 0.0f;
+        for( int r = 0; r < 3; ++r ) { inside = inside && -clip[ 3 ] <= clip[ r ] && clip[ r ] <= clip[ 3 ]; }
+        if( !inside ) { continue; }
+
+        const float side = std::max( size * pointScale() / clip[ 3 ], 1.0f );
+        const float left = ( clip[ 0 ] / clip[ 3 ] * 0.5f + 0.5f ) * width - side * 0.5f;
+        const float top = ( 0.5f - clip[ 1 ] / clip[ 3 ] * 0.5f ) * height - side * 0.5f;
+        const float a = packing::fromHalf( particle.color[ 3 ] ) * SplatRenderer::ALPHA_SCALE;
+        for( int y = 0; y < height; ++y )
+        {
+            if( !( y + 0.5f >= top && y + 0.5f < top + side ) ) { continue; }
+            for( int x = 0; x < width; ++x )
+            {
+                if( !( x + 0.5f >= left && x + 0.5f < left + side ) ) { continue; }
+                // gl_PointCoord, then GL_LINEAR with GL_CLAMP_TO_EDGE.
+                const float u = ( x + 0.5f - left ) / side * sprite.getWidth() - 0.5f;
+                const float v = ( y + 0.5f - top ) / side * sprite.getHeight() - 0.5f;
+                const int tu = static_cast<int>( std::floor( u ) ), tv = static_cast<int>( std::floor( v ) );
+                const float fu = u - tu, fv = v - tv;
+                float sample[ 4 ];
+                for( int c = 0; c < 4; ++c )
+                {
+                    sample[ c ] = ( texel( tu, tv, c ) * ( 1.0f - fu ) + texel( tu + 1, tv, c ) * fu ) * ( 1.0f - fv )
+                        + ( texel( tu, tv + 1, c ) * ( 1.0f - fu ) + texel( tu + 1, tv + 1, c ) * fu ) * fv;
+                }
+                // render.fs, then GL_SRC_ALPHA, GL_ONE.
+                float color[ 4 ];
+                for( int c = 0; c < 3; ++c ) { color[ c ] = sample[ c ] * packing::fromHalf( particle.color[ c ] ); }
+                color[ 3 ] = sample[ 3 ] * a;
+                for( int c = 0; c < 4; ++c ) { pixels[ ( y * width + x ) * 4 + c ] += color[ c ] * color[ 3 ]; }
+                ++fragments;
+            }
+        }
+    }
+    return pixels;
+}
+
+bool checkKernels()
+{
+    std::mt19937 random( 5 );
+    std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+    const size_t stride = 4 * 20;
+    std::vector<float> texels( 2 * stride );
+    for( float & t : texels ) { t = unit( random ); }
+    std::vector<std::int32_t> columns( SplatRenderer::TILE_SIZE );
+    std::vector<float> fractions( SplatRenderer::TILE_SIZE );
+    const float weight[ 4 ] = { 0.3f, 0.6f, 0.9f, 0.49f };
+    size_t failures = 0;
+    for( size_t count = 0; count <= SplatRenderer::TILE_SIZE; ++count )
+    {
+        for( size_t j = 0; j < count; ++j )
+        {
+            columns[ j ] = 4 * static_cast<std::int32_t>( random() % 19 );
+            fractions[ j ] = unit( random );
+        }
+        const float fy = unit( random );
+        std::vector<float> scalar( 4 * count, 0.25f ), simd( 4 * count, 0.25f );
+        kernels::detail::splatSpanScalar( scalar.data(), count, texels.data(), texels.data() + stride, fy, columns.data(), fractions.data(), weight );
+#if DSP_KERNELS_X86
+        kernels::detail::splatSpanSse2( simd.data(), count, texels.data(), texels.data() + stride, fy, columns.data(), fractions.data(), weight );
+        failures += simd != scalar;
+        if( kernels::getIsa() == kernels::Isa::AVX2 )
+        {
+            simd.assign( 4 * count, 0.25f );
+            kernels::detail::splatSpanAvx2( simd.data(), count, texels.data(), texels.data() + stride, fy, columns.data(), fractions.data(), weight );
+            failures += simd != scalar;
+        }
+#endif
+    }
+    std::cout << "span kernels against scalar (" << kernels::getIsaName() << "): " << ( failures == 0 ? "same" : "DIFFERENT" ) << std::endl;
+    return failures == 0;
+}
+
+bool checkFrames( ci::Surface8u const & sprite )
+{
+    size_t failures = 0;
+    // Few enough for drawing by hand, scanning the whole window per sprite, to finish.
+    const size_t count = 2000;
+    std::vector<PackedParticle> particles = makeScene( count );
+    ThreadPool one( 1 ), four( 4 );
+    SplatRenderer renderer;
+    renderer.setSize( static_cast<size_t>( WINDOW_WIDTH ), static_cast<size_t>( WINDOW_HEIGHT ) );
+    renderer.setSprite( sprite );
+    const size_t numPixels = renderer.getWidth() * renderer.getHeight() * 4;
+
+    std::cout << count << " particles at " << renderer.getWidth() << "x" << renderer.getHeight() << ", drawn at alpha " << ALPHA << std::endl;
+    std::cout << std::setw( 10 ) << "closer" << std::setw( 10 ) << "sprites" << std::setw( 12 ) << "fragments"
+        << std::setw( 14 ) << "max error" << std::setw( 12 ) << "reference" << std::setw( 10 ) << "threads" << std::endl;
+    const float closer[] = { 1.0f, 0.25f };
+    for( float c : closer )
+    {
+        Matrix viewProjection = windowView( c );
+        renderer.setView( viewProjection.m, pointScale() );
+        renderer.render( particles.data(), count, ALPHA, one );
+        std::vector<float> frame( renderer.getPixels(), renderer.getPixels() + numPixels );
+        renderer.render( particles.data(), count, ALPHA, four );
+        const bool threadsAgree = std::memcmp( frame.data(), renderer.getPixels(), numPixels * sizeof(float) ) == 0;
+
+        // The renderer folds alpha into the weight and samples a bordered copy, so the roundings differ a little.
+        std::uint64_t fragments = 0;
+        std::vector<float> reference = drawByHand( particles, viewProjection, sprite, fragments );
+        float maxError = 0.0f;
+        for( size_t i = 0; i < numPixels; ++i )
+        {
+            maxError = std::max( maxError, std::abs( frame[ i ] - reference[ i ] ) / std::max( reference[ i ], 1.0f ) );
+        }
+        const bool matches = fragments == renderer.getNumFragments() && maxError < 1e-4f;
+        std::cout << std::setw( 10 ) << c << std::setw( 10 ) << renderer.getNumSprites() << std::setw( 12 ) << renderer.getNumFragments()
+            << std::setw( 14 ) << maxError << std::setw( 12 ) << ( matches ? "same" : "DIFFERENT" )
+            << std::setw( 10 ) << ( threadsAgree ? "same" : "DIFFERENT" ) << std::endl;
+        failures += !matches + !threadsAgree;
+    }
+    return failures == 0;
+}
+
+void writePpm( ci::Surface8u const & surface, std::string const & path )
+{
+    std::ofstream file( path.c_str(), std::ios::binary );
+    file << "P6\n" << surface.getWidth() << " " << surface.getHeight() << "\n255\n";
+    for( int y = 0; y < surface.getHeight(); ++y )
+    {
+        for( int x = 0; x < surface.getWidth(); ++x )
+        {
+            std::uint8_t const * pixel = surface.getData() + y * surface.getRowBytes() + x * surface.getPixelInc();
+            const char rgb[ 3 ] = { static_cast<char>( pixel[ surface.getRedOffset() ] ), static_cast<char>( pixel[ surface.getGreenOffset() ] ),
+                                    static_cast<char>( pixel[ surface.getBlueOffset() ] ) };
+            file.write( rgb, 3 );
+        }
+    }
+}
+
+double seconds( std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end )
+{
+    return std::chrono::duration<double>( end - start ).count();
+}
+
+int main( int argc, char * argv[] )
+{
+    const size_t numParticles = argc > 1 ? std::atol( argv[ 1 ] ) : 100000;
+    const size_t numFrames = argc > 2 ? std::atol( argv[ 2 ] ) : 10;
+
+    ci::Surface8u sprite = makeSprite();
+    if( !checkKernels() || !checkFrames( sprite ) ) { return 1; }
+
+    std::vector<PackedParticle> particles = makeScene( numParticles );
+    SplatRenderer renderer;
+    renderer.setSize( static_cast<size_t>( WINDOW_WIDTH ), static_cast<size_t>( WINDOW_HEIGHT ) );
+    renderer.setSprite( sprite );
+    ci::Surface8u surface( renderer.getWidth(), renderer.getHeight(), false, ci::SurfaceChannelOrder::RGB );
+    const size_t hardwareThreads = std::max<size_t>( std::thread::hardware_concurrency(), 1 );
+    std::vector<size_t> threadCounts( 1, 1 );
+    if( hardwareThreads > 1 ) { threadCounts.push_back( hardwareThreads ); }
+
+    std::cout << numParticles << " particles at " << renderer.getWidth() << "x" << renderer.getHeight() << std::endl;
+    std::cout << std::setw( 10 ) << "closer" << std::setw( 9 ) << "threads" << std::setw( 10 ) << "sprites" << std::setw( 11 ) << "overdraw"
+        << std::setw( 11 ) << "render ms" << std::setw( 9 ) << "copy ms" << std::setw( 8 ) << "fps" << std::setw( 14 ) << "ns/fragment" << std::endl;
+    const float closer[] = { 1.0f, 0.5f };
+    for( float c : closer )
+    {
+        Matrix viewProjection = windowView( c );
+        renderer.setView( viewProjection.m, pointScale() );
+        for( size_t threads : threadCounts )
+        {
+            ThreadPool pool( threads );
+            double render = 0.0, copy = 0.0;
+            for( size_t frame = 0; frame < numFrames; ++frame )
+            {
+                auto t0 = std::chrono::steady_clock::now();
+                renderer.render( particles.data(), particles.size(), ALPHA, pool );
+                auto t1 = std::chrono::steady_clock::now();
+                renderer.copyTo( surface );
+                auto t2 = std::chrono::steady_clock::now();
+                render += seconds( t0, t1 );
+                copy += seconds( t1, t2 );
+            }
+            std::cout << std::setw( 10 ) << c << std::setw( 9 ) << threads << std::setw( 10 ) << renderer.getNumSprites() << std::fixed << std::setprecision( 2 )
+                << std::setw( 11 ) << static_cast<double>( renderer.getNumFragments() ) / ( renderer.getWidth() * renderer.getHeight() )
+                << std::setw( 11 ) << 1e3 * render / numFrames << std::setw( 9 ) << 1e3 * copy / numFrames << std::setprecision( 1 )
+                << std::setw( 8 ) << numFrames / ( render + copy ) << std::setprecision( 2 )
+                << std::setw( 14 ) << 1e9 * render / numFrames / std::max<double>( renderer.getNumFragments(), 1.0 ) << std::endl;
+            std::cout.unsetf( std::ios::fixed );
+        }
+    }
+    if( argc > 3 )
+    {
+        ThreadPool pool;
+        renderer.setView( windowView( 1.0f ).m, pointScale() );
+        renderer.render( particles.data(), particles.size(), ALPHA, pool );
+        renderer.copyTo( surface );
+        writePpm( surface, argv[ 3 ] );
+        std::cout << "wrote " << argv[ 3 ] << std::endl;
+    }
+    return 0;
+}
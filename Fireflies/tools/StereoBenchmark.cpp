@@ -0,0 +1,129 @@
+//
+//  StereoBenchmark.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Cost per block of stereo analysis with one paired transform (SpectrumAnalyzer::setStereo()),
+//  against two independent mono analyzers, one per channel, as two spectral monitors would run,
+//  and against the plain mono mix-down. Then times the bare transforms: StereoFft::forward()
+//  against one and two calls of cinder's real ci::audio::dsp::Fft::forward(). Also checks that the
+//  paired spectra match the separate ones. Only meaningful linked against cinder itself, whose
+//  Fft is vDSP on macOS and Ooura elsewhere; not part of the app target; build like LatencyHarness:
+//      g++ -std=c++11 -O2 -I../include -I$CINDER_PATH/include StereoBenchmark.cpp -o StereoBenchmark
+//          -L$CINDER_PATH/lib/linux/x86_64/ogl/Release -lcinder -lpthread  (plus cinder's own link deps)
+//  and on macOS add -framework Accelerate.
+//
+//  Usage: StereoBenchmark [seconds of audio, default 60]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "SpectrumAnalyzer.h"
+
+int main( int argc, char * argv[] )
+{
+    const float sampleRate = 44100.0f;
+    const size_t framesPerBlock = 512;
+    const float seconds = argc > 1 ? std::atof( argv[ 1 ] ) : 60.0f;
+    const size_t numBlocks = static_cast<size_t>( seconds * sampleRate / framesPerBlock );
+
+    // A different tone and noise level per side, so left and right really differ.
+    const size_t numFrames = 64 * framesPerBlock;
+    ci::audio::Buffer stereo( numFrames, 2 );
+    ci::audio::Buffer left( numFrames, 1 );
+    ci::audio::Buffer right( numFrames, 1 );
+    std::srand( 1 );
+    for( size_t i = 0; i < numFrames; ++i )
+    {
+        float t = i / sampleRate;
+        float noise = std::rand() / static_cast<float>( RAND_MAX ) - 0.5f;
+        left.getChannel( 0 )[ i ] = stereo.getChannel( 0 )[ i ] = 0.5f * std::sin( 2.0f * static_cast<float>( M_PI ) * 440.0f * t ) + 0.2f * noise;
+        right.getChannel( 0 )[ i ] = stereo.getChannel( 1 )[ i ] = 0.3f * std::sin( 2.0f * static_cast<float>( M_PI ) * 1000.0f * t ) - 0.1f * noise;
+    }
+
+    SpectrumAnalyzer mono, paired, leftOnly, rightOnly;
+    paired.setStereo( true );
+    AnalysisFrame monoFrame, pairedFrame, leftFrame, rightFrame;
+    SpectrumAnalyzer * analyzers[] = { &mono, &paired, &leftOnly, &rightOnly };
+    AnalysisFrame * frames[] = { &monoFrame, &pairedFrame, &leftFrame, &rightFrame };
+    for( size_t i = 0; i < 4; ++i )
+    {
+        analyzers[ i ]->setup( 2048, 1024, AnalysisWindow::BLACKMAN, 0.5f, sampleRate, framesPerBlock, 10.0f );
+        analyzers[ i ]->setNumBands( 4 );
+        analyzers[ i ]->reset();
+        analyzers[ i ]->makeFrame( *frames[ i ] );
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    double monoSeconds = 0.0, pairedSeconds = 0.0, separateSeconds = 0.0;
+    float maxError = 0.0f, peak = 0.0f;
+    for( size_t b = 0; b < numBlocks; ++b )
+    {
+        const size_t offset = ( b % 64 ) * framesPerBlock;
+        Clock::time_point t0 = Clock::now();
+        mono.process( stereo, offset, framesPerBlock, monoFrame );
+        Clock::time_point t1 = Clock::now();
+        paired.process( stereo, offset, framesPerBlock, pairedFrame );
+        Clock::time_point t2 = Clock::now();
+        leftOnly.process( left, offset, framesPerBlock, leftFrame );
+        rightOnly.process( right, offset, framesPerBlock, rightFrame );
+        Clock::time_point t3 = Clock::now();
+        monoSeconds += std::chrono::duration<double>( t1 - t0 ).count();
+        pairedSeconds += std::chrono::duration<double>( t2 - t1 ).count();
+        separateSeconds += std::chrono::duration<double>( t3 - t2 ).count();
+
+        for( size_t i = 0; i < pairedFrame.magSpectrum.size(); ++i )
+        {
+            maxError = std::max( maxError, std::fabs( pairedFrame.magSpectrum[ i ] - monoFrame.magSpectrum[ i ] ) );
+            maxError = std::max( maxError, std::fabs( pairedFrame.leftSpectrum[ i ] - leftFrame.magSpectrum[ i ] ) );
+            maxError = std::max( maxError, std::fabs( pairedFrame.rightSpectrum[ i ] - rightFrame.magSpectrum[ i ] ) );
+            peak = std::max( peak, leftFrame.magSpectrum[ i ] );
+        }
+    }
+
+    // The transforms alone, on the first window of each side.
+    const size_t fftSize = 2048;
+    const size_t numTransforms = numBlocks;
+    ci::audio::dsp::Fft realFft( fftSize );
+    ci::audio::Buffer realInput( fftSize );
+    ci::audio::BufferSpectral realOutput( fftSize );
+    StereoFft stereoFft;
+    stereoFft.setup( fftSize );
+    std::vector<float> pairedOutput( 2 * fftSize );
+    float * half[ 4 ];
+    for( size_t c = 0; c < 4; ++c ) { half[ c ] = pairedOutput.data() + c * fftSize / 2; }
+    std::copy( left.getChannel( 0 ), left.getChannel( 0 ) + fftSize, realInput.getData() );
+
+    Clock::time_point t4 = Clock::now();
+    for( size_t i = 0; i < numTransforms; ++i )
+    {
+        realFft.forward( &realInput, &realOutput );
+    }
+    Clock::time_point t5 = Clock::now();
+    for( size_t i = 0; i < numTransforms; ++i )
+    {
+        stereoFft.forward( left.getChannel( 0 ), right.getChannel( 0 ), half[ 0 ], half[ 1 ], half[ 2 ], half[ 3 ] );
+    }
+    Clock::time_point t6 = Clock::now();
+    const double realFftSeconds = std::chrono::duration<double>( t5 - t4 ).count();
+    const double stereoFftSeconds = std::chrono::duration<double>( t6 - t5 ).count();
+
+    std::cout << "fft 2048, window 1024, " << framesPerBlock << "-frame blocks, " << seconds << "s of audio\n"
+        << std::fixed << std::setprecision( 2 )
+        << "  mono mix-down         " << std::setw( 8 ) << 1e6 * monoSeconds / numBlocks << " us/block\n"
+        << "  paired stereo         " << std::setw( 8 ) << 1e6 * pairedSeconds / numBlocks << " us/block (left, right, mid, side)\n"
+        << "  two mono analyzers    " << std::setw( 8 ) << 1e6 * separateSeconds / numBlocks << " us/block (left, right)\n"
+        << "  dsp::Fft::forward     " << std::setw( 8 ) << 1e6 * realFftSeconds / numTransforms << " us (one real transform; two is "
+        << 2e6 * realFftSeconds / numTransforms << ")\n"
+        << "  StereoFft::forward    " << std::setw( 8 ) << 1e6 * stereoFftSeconds / numTransforms << " us (one complex transform, both sides)\n"
+        << std::scientific << std::setprecision( 1 )
+        << "  max spectrum mismatch " << maxError << " (peak magnitude " << peak << ")" << std::endl;
+    return 0;
+}
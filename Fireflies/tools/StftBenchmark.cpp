@@ -0,0 +1,82 @@
+//
+//  StftBenchmark.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Analysis frames per second of SpectrumAnalyzer::processHops() against hop size, for each
+//  window, at the app's FFT settings. Input is generated and fed in 512-frame blocks, as the
+//  audio graph would. Not part of the app target; build like LatencyHarness:
+//      g++ -std=c++11 -O2 -I../include -I$CINDER_PATH/include StftBenchmark.cpp -o StftBenchmark
+//          -L$CINDER_PATH/lib/linux/x86_64/ogl/Release -lcinder -lpthread  (plus cinder's own link deps)
+//
+//  Usage: StftBenchmark [seconds of audio per run, default 60]
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "SpectrumAnalyzer.h"
+
+int main( int argc, char * argv[] )
+{
+    const float sampleRate = 44100.0f;
+    const size_t framesPerBlock = 512;
+    const float seconds = argc > 1 ? std::atof( argv[ 1 ] ) : 60.0f;
+    const size_t numBlocks = static_cast<size_t>( seconds * sampleRate / framesPerBlock );
+
+    // Noise with a thump every half second, so the beat paths do real work.
+    ci::audio::Buffer block( framesPerBlock, 2 );
+    std::vector<ci::audio::Buffer> blocks( 64, block );
+    std::srand( 1 );
+    for( size_t b = 0; b < blocks.size(); ++b )
+    {
+        for( size_t i = 0; i < framesPerBlock; ++i )
+        {
+            float t = std::fmod( ( b * framesPerBlock + i ) / sampleRate, 0.5f );
+            float sample = 0.6f * std::sin( 2.0f * static_cast<float>( M_PI ) * 55.0f * t ) * std::exp( -t / 0.06f )
+                + 0.05f * ( std::rand() / static_cast<float>( RAND_MAX ) - 0.5f );
+            blocks[ b ].getChannel( 0 )[ i ] = sample;
+            blocks[ b ].getChannel( 1 )[ i ] = sample;
+        }
+    }
+
+    const AnalysisWindow windows[] = { AnalysisWindow::HANN, AnalysisWindow::BLACKMAN, AnalysisWindow::BLACKMAN_HARRIS };
+    const char * windowNames[] = { "hann", "blackman", "blackman-harris" };
+    const size_t hops[] = { 64, 128, 256, 512 };
+
+    std::cout << "fft 2048, window 1024, " << framesPerBlock << "-frame blocks, " << seconds << "s of audio per run\n"
+        << std::left << std::setw( 17 ) << "window" << std::right << std::setw( 6 ) << "hop"
+        << std::setw( 14 ) << "frames/s" << std::setw( 12 ) << "us/frame" << std::setw( 12 ) << "x realtime" << std::endl;
+    for( size_t w = 0; w < 3; ++w )
+    {
+        for( size_t hop : hops )
+        {
+            SpectrumAnalyzer analyzer;
+            analyzer.setup( 2048, 1024, windows[ w ], 0.5f, sampleRate, hop, 10.0f );
+            analyzer.setNumBands( 4 );
+            analyzer.reset();
+            AnalysisFrame frame;
+            analyzer.makeFrame( frame );
+            std::vector<AnalysisFrame> frames( ( framesPerBlock + hop - 1 ) / hop, frame );
+
+            size_t numAnalysed = 0;
+            auto start = std::chrono::steady_clock::now();
+            for( size_t b = 0; b < numBlocks; ++b )
+            {
+                numAnalysed += analyzer.processHops( blocks[ b % blocks.size() ], 0, framesPerBlock, frames.data(), frames.size() );
+            }
+            double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+            std::cout << std::left << std::setw( 17 ) << windowNames[ w ] << std::right << std::setw( 6 ) << hop
+                << std::setw( 14 ) << std::fixed << std::setprecision( 0 ) << numAnalysed / elapsed
+                << std::setw( 12 ) << std::setprecision( 2 ) << 1e6 * elapsed / numAnalysed
+                << std::setw( 12 ) << std::setprecision( 0 ) << seconds / elapsed << std::endl;
+        }
+    }
+    return 0;
+}
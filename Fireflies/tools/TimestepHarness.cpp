@@ -0,0 +1,158 @@
+//
+//  TimestepHarness.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Runs ParticleSimulator under FixedTimestep as SceneComponent does, rendering at 30, 60 and
+//  144 Hz and at an uneven rate, and checks that the particles come out identical after the same
+//  simulated time whatever the frame rate. The inputs (activity, beats) follow the simulated clock
+//  here, as the simulation itself does; in the app they are the audio features of the frame that
+//  runs the step. Then shows a stall hitting the substep cap, and what stepping once per frame
+//  used to do to the speed of the show. Not part of the app target; build like ParticleBenchmark:
+//      g++ -std=c++11 -O2 -I../include -I$CINDER_PATH/include TimestepHarness.cpp -o TimestepHarness
+//          -L$CINDER_PATH/lib/linux/x86_64/ogl/Release -lcinder -lpthread  (plus cinder's own link deps)
+//
+//  Usage: TimestepHarness [particles, default 20000] [simulated seconds, default 10]
+//  Exits non-zero if any render rate changes a trajectory, or the interpolation leaves [0, 1).
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "FixedTimestep.h"
+#include "ParticleFactory.h"
+#include "ParticleSimulator.h"
+
+const float WINDOW_WIDTH = 1280.0f;
+const float WINDOW_HEIGHT = 720.0f;
+// As SceneComponent: uTime per simulated second.
+const double NOISE_TIME_SCALE = 0.001;
+
+//! The uniforms for step index: a swell of activity and a beat on each group now and then.
+void inputsFor( std::uint64_t index, float & activity, float * beats )
+{
+    activity = 0.5f + 2.0f * ( index % 50 ) / 50.0f;
+    for( int b = 0; b < 4; ++b )
+    {
+        beats[ b ] = 0.1f + 0.35f * ( ( index + 7 * b ) % 30 == 0 );
+    }
+}
+
+struct Run
+{
+    std::vector<Particle> particles;
+    size_t numFrames;
+    size_t minSteps, maxSteps;
+    float minAlpha, maxAlpha;
+};
+
+//! Steps numSteps fixed steps from initial, with frame durations from nextFrame(), the way
+//! SceneComponent::update() does; the frame that takes the total past numSteps runs only up to it.
+template<typename NextFrame>
+Run simulate( std::vector<Particle> const & initial, std::uint64_t numSteps, NextFrame nextFrame )
+{
+    ParticleSimulator simulator( 1 );
+    simulator.load( initial.data(), initial.size() );
+    FixedTimestep timestep;
+    const float dt2 = static_cast<float>( 1.0 / ( timestep.getStepRate() * timestep.getStepRate() ) );
+    Run run = { {}, 0, ~size_t( 0 ), 0, 1.0f, 0.0f };
+    while( timestep.getNumSteps() < numSteps )
+    {
+        const std::uint64_t first = timestep.getNumSteps();
+        const size_t steps = timestep.advance( nextFrame() );
+        for( size_t i = 0; i < steps && first + i < numSteps; ++i )
+        {
+            float activity, beats[ ParticleSimulator::MAX_BEATS ] = {};
+            inputsFor( first + i, activity, beats );
+            const float time = static_cast<float>( timestep.getStepTime( first + i ) * NOISE_TIME_SCALE );
+            simulator.step( time, dt2, activity, beats, 4, WINDOW_WIDTH, WINDOW_HEIGHT );
+        }
+        ++run.numFrames;
+        run.minSteps = std::min( run.minSteps, steps );
+        run.maxSteps = std::max( run.maxSteps, steps );
+        run.minAlpha = std::min( run.minAlpha, timestep.getAlpha() );
+        run.maxAlpha = std::max( run.maxAlpha, timestep.getAlpha() );
+    }
+    run.particles.resize( initial.size() );
+    simulator.store( run.particles.data() );
+    return run;
+}
+
+//! How many floats of the particles' simulated state differ from reference's in any bit.
+size_t countDifferences( std::vector<Particle> const & particles, std::vector<Particle> const & reference )
+{
+    size_t differences = 0;
+    for( size_t i = 0; i < particles.size(); ++i )
+    {
+        Particle const & a = particles[ i ];
+        Particle const & b = reference[ i ];
+        differences += std::memcmp( &a.pos, &b.pos, sizeof(a.pos) ) != 0;
+        differences += std::memcmp( &a.ppos, &b.ppos, sizeof(a.ppos) ) != 0;
+        differences += std::memcmp( &a.color, &b.color, sizeof(a.color) ) != 0;
+    }
+    return differences;
+}
+
+int main( int argc, char * argv[] )
+{
+    const size_t numParticles = argc > 1 ? std::atol( argv[ 1 ] ) : 20000;
+    const double seconds = argc > 2 ? std::atof( argv[ 2 ] ) : 10.0;
+
+    ParticleFactory factory;
+    factory.setLayout( WINDOW_WIDTH, WINDOW_HEIGHT, 4 );
+    std::vector<Particle> initial( numParticles );
+    factory.makeParticles( 0, numParticles, initial.data() );
+
+    FixedTimestep timestep;
+    const std::uint64_t numSteps = static_cast<std::uint64_t>( std::llround( seconds * timestep.getStepRate() ) );
+    std::cout << numParticles << " particles, " << numSteps << " steps at " << timestep.getStepRate() << " Hz" << std::endl;
+
+    size_t failures = 0;
+    std::vector<Particle> reference;
+    const double rates[] = { 60.0, 30.0, 144.0, 0.0 };
+    std::cout << std::setw( 12 ) << "render Hz" << std::setw( 10 ) << "frames" << std::setw( 14 ) << "steps/frame"
+        << std::setw( 18 ) << "alpha" << std::setw( 14 ) << "differences" << std::endl;
+    for( double rate : rates )
+    {
+        // 0: uneven frames between 4 and 40 ms, as a busy machine might deliver them.
+        std::mt19937 random( 3 );
+        std::uniform_real_distribution<double> uneven( 0.004, 0.040 );
+        Run run = simulate( initial, numSteps, [&]() { return rate > 0.0 ? 1.0 / rate : uneven( random ); } );
+        if( reference.empty() ) { reference = run.particles; }
+        const size_t differences = countDifferences( run.particles, reference );
+        std::ostringstream stepRange, alphaRange;
+        stepRange << run.minSteps << " to " << run.maxSteps;
+        alphaRange << std::fixed << std::setprecision( 3 ) << run.minAlpha << " to " << run.maxAlpha;
+        std::cout << std::setw( 12 ) << ( rate > 0.0 ? std::to_string( static_cast<int>( rate ) ) : std::string( "uneven" ) )
+            << std::setw( 10 ) << run.numFrames << std::setw( 14 ) << stepRange.str() << std::setw( 18 ) << alphaRange.str()
+            << std::setw( 14 ) << differences << std::endl;
+        failures += differences;
+        if( run.minAlpha < 0.0f || run.maxAlpha >= 1.0f ) { ++failures; }
+    }
+
+    // A half-second stall: the cap runs eight steps and lets the rest go.
+    FixedTimestep stalled;
+    stalled.advance( 1.0 / 60.0 );
+    const size_t steps = stalled.advance( 0.5 );
+    std::cout << "a 500 ms frame runs " << steps << " steps and drops " << stalled.getNumDropped() << ", leaving alpha " << stalled.getAlpha() << std::endl;
+
+    // The old way, one step per frame whatever the frame rate: the show runs at frame rate / 60 speed.
+    for( double rate : rates )
+    {
+        if( rate > 0.0 )
+        {
+            std::cout << "stepping once a frame at " << static_cast<int>( rate ) << " Hz ran " << std::fixed << std::setprecision( 2 )
+                << rate / timestep.getStepRate() << " simulated seconds a second; fixed steps run 1.00" << std::endl;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
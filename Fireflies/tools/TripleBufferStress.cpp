@@ -0,0 +1,101 @@
+//
+//  TripleBufferStress.cpp
+//  AudioVertexDisplacement
+//
+//  Created by Arris Ray on 10/17/26.
+//
+//
+//  Runs a producer and a consumer flat out on a TripleBuffer, as AnalysisNode and the render
+//  thread use it. Every word of each payload is stamped with its sequence number, so a frame read
+//  while it was half rewritten shows up as words from two frames. Checks that the consumer never
+//  sees a mixed frame, never sees one twice or out of order, and that update() says false only
+//  when nothing new was published. Not part of the app target, and needs nothing from cinder:
+//      g++ -std=c++11 -O2 -I../include TripleBufferStress.cpp -o TripleBufferStress -lpthread
+//
+//  Usage: TripleBufferStress [seconds, default 5] [words per payload, default 1024]
+//  Exits non-zero if the consumer ever reads a mixed, repeated or out-of-order frame.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "TripleBuffer.h"
+
+//! Word i of frame sequence. Word 0 is the sequence itself; the rest differ per word too, so a
+//! shifted or partial copy doesn't pass either.
+std::uint64_t stampFor( std::uint64_t sequence, size_t i )
+{
+    return i == 0 ? sequence : sequence * 0x9E3779B97F4A7C15ull ^ i;
+}
+
+int main( int argc, char * argv[] )
+{
+    const double seconds = argc > 1 ? std::atof( argv[ 1 ] ) : 5.0;
+    const size_t numWords = argc > 2 ? std::max<long>( std::atol( argv[ 2 ] ), 1 ) : 1024;
+
+    // Sequence 0 is the reset value; the producer publishes from 1.
+    TripleBuffer<std::vector<std::uint64_t>> buffer;
+    std::vector<std::uint64_t> initial( numWords );
+    for( size_t i = 0; i < numWords; ++i ) { initial[ i ] = stampFor( 0, i ); }
+    buffer.reset( initial );
+
+    std::atomic<bool> done( false );
+    std::atomic<std::uint64_t> published( 0 );
+    std::thread producer( [&]
+    {
+        for( std::uint64_t sequence = 1; !done.load( std::memory_order_relaxed ); ++sequence )
+        {
+            std::vector<std::uint64_t> & frame = buffer.getWriteBuffer();
+            for( size_t i = 0; i < numWords; ++i ) { frame[ i ] = stampFor( sequence, i ); }
+            buffer.publish();
+            published.store( sequence, std::memory_order_release );
+        }
+    } );
+
+    std::uint64_t reads = 0, fresh = 0, stale = 0, mixed = 0, backwards = 0, missed = 0;
+    std::uint64_t last = 0;
+    const auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>( seconds );
+    while( std::chrono::steady_clock::now() < end )
+    {
+        // Whatever was published before update() must be visible to it.
+        const std::uint64_t before = published.load( std::memory_order_acquire );
+        const bool updated = buffer.update();
+        std::vector<std::uint64_t> const & frame = buffer.getReadBuffer();
+        const std::uint64_t sequence = frame[ 0 ];
+        ++reads;
+
+        // Every other word has to come from the same frame as word 0.
+        bool whole = true;
+        for( size_t i = 1; i < numWords && whole; ++i ) { whole = frame[ i ] == stampFor( sequence, i ); }
+        mixed += !whole;
+        if( !whole ) { continue; }
+
+        if( updated )
+        {
+            ++fresh;
+            backwards += sequence <= last;
+        }
+        else
+        {
+            ++stale;
+            // Nothing new: still the frame from the last update(), and nothing newer was published before it.
+            backwards += sequence != last;
+            missed += before > last;
+        }
+        last = sequence;
+        std::this_thread::yield();
+    }
+    done = true;
+    producer.join();
+
+    std::cout << published.load() << " frames of " << numWords << " words published, " << reads << " reads: "
+        << fresh << " new, " << stale << " nothing new" << std::endl;
+    std::cout << mixed << " mixed frames, " << backwards << " repeated or out of order, "
+        << missed << " updates that missed a published frame" << std::endl;
+    return mixed == 0 && backwards == 0 && missed == 0 && fresh > 0 ? 0 : 1;
+}
@@ -9,6 +9,10 @@
 #include "cinder/audio/Utilities.h"
 #include "cinder/qtime/QuickTime.h"
 #include "cinder/ip/Resize.h"
+#include "AssetLoader.h"
+#include "SpectrumSnapshot.h"
+#include "DspKernels.h"
+#include "Filterbank.h"
 
 using namespace ci;
 using namespace ci::app;
@@ -38,16 +42,26 @@ public:
     void draw();
     
 private:
-    MonitorSpectralNodeRef mSpectralMonitor;
     InputDeviceNodeRef mInputDeviceNode;
+    SpectrumSnapshot mSpectrum;
+    //! @brief Frames since the first capture that ran no FFT, as last reported by update().
+    std::uint64_t mMissedFfts = 0;
+    Filterbank mColumnFilter;
+    std::vector<float> mColumnLevels;
+    std::vector<float> mColumnAlphas;
     qtime::MovieSurfaceRef m_movie;
+    //! @brief The movie being opened on the AssetLoader; picked up by update() when it's ready.
+    std::future<qtime::MovieSurfaceRef> m_movieLoad;
     Surface8uRef m_surface;
     
     //! @brief Create audio nodes for audio stream processing.
     void setupAudio();
     
-    //! @brief Load a sample movie to freak out.
+    //! @brief Start opening a sample movie to freak out, off the main thread.
     void setupVideo( const fs::path &path );
+    
+    //! @brief Finish setting up the movie once it has opened.
+    void finishVideo();
 
     //! @brief Draw stereo waveform in the center of our screen.
     void drawWaveForm();
@@ -93,16 +107,17 @@ void SoundflowerApp::setupAudio()
     }
     std::cout << std::endl;
     
-    mSpectralMonitor = ctx->makeNode( new MonitorSpectralNode( MonitorSpectralNode::Format()
-                                                              .fftSize( 2048 )
-                                                              .windowSize( 1024 ) ) );
+    auto spectralMonitor = ctx->makeNode( new MonitorSpectralNode( MonitorSpectralNode::Format()
+                                                                  .fftSize( 2048 )
+                                                                  .windowSize( 1024 ) ) );
     
     // The InputDeviceNode is platform-specific, so you create it using a special method on the Context
     auto inputDevice = Device::findDeviceByName( SoundflowerApp::SOUNDFLOWER_DEVICE_NAME );
     mInputDeviceNode = ctx->createInputDeviceNode( inputDevice );
     
     // connect and enable the Context
-    mInputDeviceNode >> mSpectralMonitor;
+    mInputDeviceNode >> spectralMonitor;
+    this->mSpectrum.setMonitor( spectralMonitor );
     
     ctx->enable();
     mInputDeviceNode->enable();
@@ -112,9 +127,35 @@ void SoundflowerApp::setupAudio()
 //------------------------------------------------------------------------------
 void SoundflowerApp::setupVideo( const fs::path &moviePath )
 {
+    // Opening the movie reads and parses the file, so it happens on a worker and audio starts meanwhile;
+    // the waveform draws on its own until the first frame arrives.
     try
     {
-        this->m_movie = qtime::MovieSurface::create( loadResource( moviePath )->getFilePath() );
+        fs::path filePath = loadResource( moviePath )->getFilePath();
+        this->m_movieLoad = AssetLoader::instance().load<qtime::MovieSurfaceRef>( SoundflowerApp::SAMPLE_MOVIE, [filePath]
+        {
+            return qtime::MovieSurface::create( filePath );
+        } );
+    }
+    catch( ... )
+    {
+        console() << "Unable to load the movie." << std::endl;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+void SoundflowerApp::finishVideo()
+{
+    try
+    {
+        AssetLoader::instance().finalize( SoundflowerApp::SAMPLE_MOVIE, [this]
+        {
+            this->m_movie = this->m_movieLoad.get();
+            this->m_movie->setLoop( true, true );
+            this->m_movie->seekToStart();
+            this->setWindowSize( this->m_movie->getWidth(), this->m_movie->getHeight() );
+        } );
         
         console() << "Dimensions:" << this->m_movie->getWidth() << " x " << this->m_movie->getHeight() << std::endl;
         console() << "Duration:  " << this->m_movie->getDuration() << " seconds" << std::endl;
@@ -122,11 +163,6 @@ void SoundflowerApp::setupVideo( const fs::path &moviePath )
         console() << "Framerate: " << this->m_movie->getFramerate() << std::endl;
         // console() << "Alpha channel: " << this->m_movie->hasAlpha() << std::endl;
         console() << "Has audio: " << this->m_movie->hasAudio() << " Has visuals: " << this->m_movie->hasVisuals() << std::endl;
-        
-        this->m_movie->setLoop( true, true );
-        this->m_movie->seekToStart();
-        
-        this->setWindowSize( this->m_movie->getWidth(), this->m_movie->getHeight() );
     }
     catch( ... )
     {
@@ -138,6 +174,35 @@ void SoundflowerApp::setupVideo( const fs::path &moviePath )
 //------------------------------------------------------------------------------
 void SoundflowerApp::update()
 {
+    if( !this->m_movie && AssetLoader::isReady( this->m_movieLoad ) )
+    {
+        this->finishVideo();
+    }
+    
+    // Run the frame's only FFT; draw() and drawWaveForm() share the result.
+    this->mSpectrum.capture( getElapsedFrames() );
+    
+    // Every getMagSpectrum() goes through the snapshot, so its count is the number of FFTs run.
+    // Anything but one per frame since the first capture means a frame ran none; report each new shortfall once.
+    std::uint64_t expectedFfts = getElapsedFrames() - this->mSpectrum.getFirstFrame() + 1;
+    std::uint64_t missedFfts = this->mSpectrum.getFftCount() > 0 ? expectedFfts - this->mSpectrum.getFftCount() : 0;
+    if( missedFfts != this->mMissedFfts )
+    {
+        this->mMissedFfts = missedFfts;
+        console() << "Ran " << this->mSpectrum.getFftCount() << " FFTs over " << expectedFfts << " frames." << std::endl;
+    }
+    
+    // Average the spectrum into one mel-spaced level per window column, then convert to decibels.
+    // The filterbank's weights are only rebuilt when the window is resized.
+    std::vector<float> const & magSpectrum = this->mSpectrum.getMagSpectrum();
+    if( !magSpectrum.empty() )
+    {
+        this->mColumnFilter.setup( magSpectrum.size(), this->mSpectrum.getSampleRate(), getWindowWidth(), FilterScale::MEL );
+        this->mColumnLevels.resize( this->mColumnFilter.getNumOutputs() );
+        this->mColumnFilter.apply( magSpectrum.data(), this->mColumnLevels.data() );
+        kernels::linearToDecibel( this->mColumnLevels.data(), this->mColumnLevels.data(), this->mColumnLevels.size() );
+    }
+    
     // Sample video for the current frame
     if( this->m_movie )
     {
@@ -175,19 +240,20 @@ void SoundflowerApp::draw()
         Surface8u::Iter cloneIter = cloneSurface.getIter();
         Surface8u::Iter iter = this->m_surface->getIter();
     
+        // Every row uses the same per-column alpha, so work it out once per column.
+        int width = iter.getWidth();
+        this->mColumnLevels.resize( width, 0.0f );
+        this->mColumnAlphas.resize( width );
+        kernels::mapClamped( this->mColumnLevels.data(), this->mColumnAlphas.data(), width, 0.0f, 50.0f, 0.0f, 255.0f );
+        
         // Foreach row...
-        std::vector<float> const & magSpectrum = this->mSpectralMonitor->getMagSpectrum();
         while( iter.line() && cloneIter.line() )
         {
             // Foreach column...
             while( iter.pixel() && cloneIter.pixel() )
             {
-                uint32_t bufferIndex = (uint32_t)lmap<float>( col, 0, iter.getWidth(), 0, magSpectrum.size() );
-                float magnitude = ci::audio::linearToDecibel( magSpectrum[ bufferIndex ] );
-                
                 // Modulate the alpha of the current column by the magnitude of its associated frequency band
-                unsigned char v = (unsigned char)( lmap<float>(magnitude, 0.0f, 50.0f, 0.0f, 255.0f ) );
-                cloneIter.a() = v;
+                cloneIter.a() = (unsigned char)this->mColumnAlphas[ col ];
                 
                 ++col;
             }
@@ -207,7 +273,7 @@ void SoundflowerApp::draw()
 //------------------------------------------------------------------------------
 void SoundflowerApp::drawWaveForm()
 {
-    uint32_t bufferLength = this->mSpectralMonitor->getMagSpectrum().size();
+    uint32_t bufferLength = this->mColumnLevels.size();
     
     int displaySize = getWindowWidth();
     float scale = displaySize / (float)bufferLength;
@@ -220,7 +286,7 @@ void SoundflowerApp::drawWaveForm()
         float x = ( i * scale );
         
         //get the PCM value from the left channel buffer
-        float decibels = -1.0f * ci::audio::linearToDecibel( this->mSpectralMonitor->getMagSpectrum()[ i ] );
+        float decibels = -1.0f * this->mColumnLevels[ i ];
         // std::cout << decibels << " ";
         float y = ( decibels + VERTICAL_CENTER );
         vec2 coords = vec2( x, y );